@@ -38,6 +38,7 @@
 #include "openchronos.h"
 #include "drivers/pmm.h"
 #include "drivers/wdt.h"
+#include "drivers/stack.h"
 
 /* Entry point of of the Flash Updater in BSL memory */
 #define CALL_RFSBL()   ((void (*)())0x1000)()
@@ -211,11 +212,20 @@ static void crt_0042(void)
 
     /* Disable them again, they will be re-enabled later on in main() */
     __disable_interrupt();
+
+#ifdef CONFIG_MOD_DIAG
+    /* Mark the free RAM, modules/diag.c shows how much the stack used */
+    stack_paint();
+#endif
 }
 
+#ifndef CONFIG_CRASH_LOG
+/* with CONFIG_CRASH_LOG drivers/crashlog.c handles the interrupt, also
+   for the boot menu */
 __attribute__ ((interrupt(WDT_VECTOR)))
 void WDT_ISR(void)
 {
     /* exit from LPM3 after interrupt */
     _BIC_SR_IRQ(LPM3_bits);
 }
+#endif
@@ -46,7 +46,7 @@
 # *************************************************************************************************
 #
 ###################################################################################################
-version = "0.3"
+version = "0.4"
 # Changelog:
 #   0.1 - public preview version
 #   0.2 - import rewritten
@@ -54,6 +54,9 @@ version = "0.3"
 #   0.3 - verbosity option
 #       - noreset option
 #       - acceleration data streaming
+#   0.4 - packed acceleration stream decoding, loopback access point
+#       - delta images for rfbsl, bootloader simulation
+#       - diagnostics report of the DIAG module
 ###################################################################################################
 
 import sys
@@ -61,6 +64,11 @@ import os
 import serial
 import time
 import datetime
+import shutil
+
+sys.path.insert( 0, os.path.dirname( os.path.abspath( __file__ ) ) )
+sys.path.insert( 0, os.path.join( os.path.dirname( os.path.abspath( __file__ ) ), "..", "tools" ) )
+import accelstream
 
 ###################################################################################################
 class CBMcmd():
@@ -215,6 +223,10 @@ class CBMdata:
                 print >> sys.stderr, "Chunk at address @" + hex(address) + ", length", len(data)
             self.chunks.append( CBMchunk( address, data ) )
 
+    def importchunks( self, chunks ):
+        for address, data in chunks:
+            self.chunks.append( CBMchunk( address, data ) )
+
     def tochunks( self ):
         return self.chunks
 
@@ -438,6 +450,7 @@ class CBM:
         for chunk in chunklist:
             burstlist += chunk.tobursts()
 
+        status = 0
         for burst in burstlist:
             done = 0
             while not done:
@@ -456,12 +469,14 @@ class CBM:
                         if opt.verbose:
                             print >> sys.stderr, "WARNING: Burstlist underflow"
                         time.sleep(0.05)
-                else:           #WBSL_COMPLETE
+                else:           #WBSL_COMPLETE, or an error
                     done = 1
                     break
         self.wbsl_stop()
+        # 3 is WBSL_ERROR and 0x20 WBSL_CONNECTIONLOST
+        return not burstlist and status not in ( 3, 0x20 )
 
-    def wbsl_download( self, txtdata ):
+    def wbsl_download( self, data ):
 
         #Prepare data for downloading to watch
         updater = CBMdata()
@@ -648,18 +663,16 @@ B6 27 3D 40 6C 1E 5C 43 80 00 78 25 B2 B0 20 00
 @FFFE
 30 1D 
 q""")
-        data = CBMdata()
-        print("Reading firmware file")
-        data.importtxt( txtdata )
-
         raw_input("Hit enter to start update process. (or Ctrl+C to exit)")
 
         print("Ready to update. Set your watch in  rfbsl \"open\" mode.")
         self.transmitburst( updater )
         print("Sending new firmware..")
-        self.transmitburst( data )
+        ok = self.transmitburst( data )
         time.sleep( 1 )
-        print("Done!")
+        if ok:
+            print("Done!")
+        return ok
 
 ###################################################################################################
 # main
@@ -667,13 +680,18 @@ q""")
 from optparse import OptionParser
 
 usage = """
-       %prog [options] rfbsl|sync|prg|accel [<arguments> ...]
+       %prog [options] rfbsl|sync|prg|accel|stream|diag [<arguments> ...]
 
        %prog [options] rfbsl <firmware file>
+       %prog [options] --delta --bootloader segment [--simulate] rfbsl <firmware file>
        %prog [options] sync [temperature] [altitude]
        prg   = rfbsl followed by sync
        %prog [options] prg <firmware file> [temperature] [altitude]
-       accel = read accelrometer data"""
+       accel = read accelrometer data
+       stream = decode the packed accelerometer stream of the ASTRM module
+       %prog [options] stream [<number of packets>]
+       diag  = wait for the report sent by the DIAG module (NUM button)
+       %prog [options] diag"""
 parser = OptionParser( usage=usage, version="%prog "+version )
 parser.add_option( "-d", "--device", dest="device", metavar="DEVICE",
         help="specify USB device of Base Module, will guess if ommited" )
@@ -683,9 +701,114 @@ parser.add_option( "-r", "--raw", action="store_true", dest="raw", default=False
         help="output raw sensor data" )
 parser.add_option( "-v", "--verbose", action="store_true", dest="verbose", default=False,
         help="show CBM communication" )
+parser.add_option( "-l", "--loopback", action="store_true", dest="loopback", default=False,
+        help="stream: use a simulated access point instead of the Base Module" )
+
+parser.add_option( "-D", "--delta", action="store_true", dest="delta", default=False,
+        help="rfbsl: only send the flash segments that changed since the last update. "
+             "Needs --bootloader segment, the full image is sent otherwise" )
+parser.add_option( "-B", "--bootloader", dest="bootloader", default="mass", choices=[ "mass", "segment" ],
+        help="rfbsl: how the bootloader erases flash, mass (all main flash at the start, "
+             "the default) or segment (each segment when it is first written)" )
+parser.add_option( "-b", "--base", dest="base", metavar="FILE",
+        help="rfbsl: image flashed last, defaults to the firmware file with .flashed "
+             "in front of its extension" )
+parser.add_option( "-s", "--simulate", action="store_true", dest="simulate", default=False,
+        help="rfbsl: replay the update on a simulated bootloader instead of a watch" )
 
 (opt, args) = parser.parse_args()
 
+def load_firmware( file ):
+    "Returns the sections of the firmware file, the CBMdata to send and the base image file"
+    # imagediff and elf.py are python2 only, the other commands don't need them
+    import imagediff
+    print("Reading firmware file")
+    sections = imagediff.load_sections( file )
+    # keep the extension, the TI-Text and Intel-Hex readers go by it
+    root, ext = os.path.splitext( file )
+    basefile = opt.base or root + ".flashed" + ext
+    base = None
+    if opt.delta and opt.bootloader != "segment":
+        # a mass erase wipes the unchanged segments a delta leaves out
+        print >> sys.stderr, "WARNING: --delta needs --bootloader segment, sending the full image"
+    elif opt.delta:
+        if os.path.isfile( basefile ):
+            base = imagediff.load_sections( basefile )
+        else:
+            print >> sys.stderr, "WARNING: no base image", basefile, "sending the full image"
+    if base is not None:
+        chunks = imagediff.delta_chunks( base, sections )
+        print("Changed sections: %s" % ", ".join( imagediff.changed_sections( base, sections ) ))
+        print("Sending %d of %d bytes" % ( sum( len( c[1] ) for c in chunks ),
+                                           sum( len( s.data ) for s in sections ) ))
+    else:
+        chunks = imagediff.full_chunks( sections )
+    data = CBMdata()
+    data.importchunks( chunks )
+    return sections, base, data, basefile
+
+def simulate_firmware( file ):
+    "Replays the bursts on a simulated bootloader, verifies the result and reports bytes on air"
+    import imagediff
+    sections, base, data, basefile = load_firmware( file )
+    bursts = []
+    for chunk in data.tochunks():
+        bursts += [( b.type, b.data ) for b in chunk.tobursts()]
+    bsl = imagediff.SimulatedBSL( base or [], opt.bootloader )
+    for burst in bursts:
+        bsl.burst( *burst )
+    full = imagediff.tobursts( imagediff.full_chunks( sections ), CBMburst.maxlen() )
+    print("Full image: %d bytes on air, %d bursts" % ( imagediff.bytes_on_air( full ), len( full ) ))
+    print("This update: %d bytes on air, %d bursts" % ( imagediff.bytes_on_air( bursts ), len( bursts ) ))
+    errors = bsl.mismatches( sections )
+    if errors:
+        print >> sys.stderr, "ERROR: verification failed at %d addresses, first 0x%04x" % ( len( errors ), errors[0] )
+        sys.exit( 8 )
+    print("Verification ok")
+
+def download_firmware( bm, file ):
+    sections, base, data, basefile = load_firmware( file )
+    if not bm.wbsl_download( data ):
+        print >> sys.stderr, "ERROR: update failed,", basefile, "left as it was"
+        sys.exit( 10 )
+    # the base of the next delta is what the watch runs now
+    shutil.copyfile( file, basefile )
+
+def decode_diag( packet ):
+    "Returns the report sent by modules/diag.c as a list of lines, None if packet is something else"
+    packet = bytearray( packet )
+    if len( packet ) < 13 or packet[0] != ord( 'D' ) or packet[1] not in ( 1, 2, 3 ):
+        return None
+    word = lambda i: packet[i] | ( packet[i+1] << 8 )
+    lines = [ "stack:  %d of %d bytes" % ( word( 4 ), word( 2 ) ),
+              "wakeups: %d since boot, %d in the last minute" % ( word( 6 ) | ( word( 8 ) << 16 ), word( 10 ) ) ]
+    pos = 13
+    for i in range( packet[12] ):
+        if pos + 8 > len( packet ):
+            return None
+        name = packet[pos:pos+5].decode( "ascii" ).strip()
+        lines.append( "pool %-5s %d used, peak %d of %d" % ( name, packet[pos+5], packet[pos+6], packet[pos+7] ) )
+        pos += 8
+    if packet[1] >= 2:
+        ms = lambda ticks: ticks * 1000.0 / 16384
+        if pos >= len( packet ) or pos + 1 + packet[pos] * 4 + 2 > len( packet ):
+            return None
+        names = [ "input", "display", "background" ]
+        for i in range( packet[pos] ):
+            p = pos + 1 + i * 4
+            name = names[i] if i < len( names ) else str( i )
+            lines.append( "bus %-10s worst %.1f ms, %d over budget" % ( name, ms( word( p ) ), word( p + 2 ) ) )
+        pos += 1 + packet[pos] * 4
+        lines.append( "button: %.1f ms worst" % ms( word( pos ) ) )
+        pos += 2
+    if packet[1] >= 3:
+        if pos + 9 > len( packet ):
+            return None
+        if packet[pos]:
+            lines.append( "reset:  SYSRSTIV 0x%02x after %d s, pc 0x%04x, callback 0x%04x (tools/crashlog.py -a)" % \
+                ( packet[pos], word( pos + 5 ) | ( word( pos + 7 ) << 16 ), word( pos + 1 ), word( pos + 3 ) ) )
+    return lines
+
 #Command must be given
 if len( args ) == 0:
     print >> sys.stderr, "ERROR: you must specify a command"
@@ -693,14 +816,14 @@ if len( args ) == 0:
     sys.exit( 5 )
 
 #If no device option given, try to guess
-if not opt.device:
+if not opt.device and not opt.loopback and not opt.simulate:
     device_guess = ["/dev/ttyACM0", "/dev/ttyUSB0", "/dev/cu.usbmodem001"]
     for path in device_guess:
         if os.path.exists( path ):
             opt.device = path
             break
 #Check for device
-if (not opt.device) or (not os.path.exists( opt.device )):
+if not opt.loopback and not opt.simulate and ((not opt.device) or (not os.path.exists( opt.device ))):
     print >> sys.stderr, "ERROR: no Base Module device found, please specify as option"
     sys.exit( 6 )
 
@@ -713,8 +836,11 @@ if command == "rfbsl":
     if not os.path.isfile( file ):
         print >> sys.stderr, "ERROR: cannot open", file
         sys.exit( 7 )
-    bm = CBM( opt.device )
-    bm.wbsl_download( file )
+    if opt.simulate:
+        simulate_firmware( file )
+    else:
+        bm = CBM( opt.device )
+        download_firmware( bm, file )
 elif command == "sync":
     bm = CBM( opt.device )
     temp = 0
@@ -739,7 +865,7 @@ elif command == "prg":
     if len(args) == 4  and args[3].isdigit():
         alt = int(args[3])
     bm = CBM( opt.device )
-    bm.wbsl_download( file )
+    download_firmware( bm, file )
     bm.spl_sync(celsius=temp, meters=alt)
 elif command == "accel":
         bm = CBM( opt.device )
@@ -748,6 +874,38 @@ elif command == "accel":
                 data = bm.spl_getaccel()
                 if data[0]:
                         print(str( data[1] ) + " " + str( data[2] ) + " " + str( data[3] ))
+elif command == "stream":
+    if opt.loopback:
+        ap = accelstream.LoopbackAccessPoint()
+    else:
+        ap = accelstream.SerialAccessPoint( serial.Serial( opt.device, 115200, timeout = 1 ) )
+    count = -1
+    if len(args) >= 2 and args[1].isdigit():
+        count = int(args[1])
+    decoder = accelstream.StreamDecoder()
+    start = time.time()
+    while count != 0:
+        packet = ap.read_packet()
+        if not packet:
+            continue
+        try:
+            samples = decoder.feed( packet )
+        except ValueError as e:
+            print >> sys.stderr, "WARNING: dropping packet,", e
+            continue
+        for sample in samples:
+            print("%.3f %.3f %.3f" % sample)
+        count -= 1
+    if opt.verbose:
+        print >> sys.stderr, "%d packets, %d samples, %d lost packets in %.1fs" % \
+            ( decoder.packets, decoder.samples, decoder.lost, time.time() - start )
+elif command == "diag":
+    ap = accelstream.SerialAccessPoint( serial.Serial( opt.device, 115200, timeout = 1 ) )
+    while True:
+        lines = decode_diag( ap.read_packet() or [] )
+        if lines:
+            print("\n".join( lines ))
+            break
 else:
     print >> sys.stderr, "ERROR: invalid command:", command
     sys.exit( 4 )
@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Copyright (C) 2026 openchronos-ng contributors
+#
+# openchronos-ng is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# openchronos-ng is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""
+    Codec for the packed accelerometer stream sent by modules/accelstream.c.
+
+    Every packet holds a 3 byte header (sequence number, sample count,
+    range index << 4 | delta width) followed by a bitstream: the first sample
+    as three 10 bit two's complement values, then the per-axis differences
+    of the following samples, 'width' bits each.
+"""
+
+import math
+import random
+
+MAX_PAYLOAD = 61
+MAX_SAMPLES = 24
+HEADER_LEN = 3
+KEYFRAME_BITS = 30
+
+# BMA250 sensitivity in g per LSB for the 2g, 4g, 8g and 16g ranges
+G_PER_LSB = (0.00391, 0.00781, 0.01563, 0.03125)
+
+
+def packed_len(count, width):
+    return HEADER_LEN + (KEYFRAME_BITS + 3 * width * (count - 1) + 7) // 8
+
+
+def delta_width(d):
+    """Number of bits needed to store d as two's complement, 0 if d is 0"""
+    if d == 0:
+        return 0
+    if d < 0:
+        d = ~d
+    return d.bit_length() + 1
+
+
+def to_signed(v, bits):
+    if bits and v & (1 << (bits - 1)):
+        return v - (1 << bits)
+    return v
+
+
+class BitWriter:
+    def __init__(self):
+        self.data = bytearray()
+        self.pos = 0
+
+    def put(self, value, bits):
+        for n in reversed(range(bits)):
+            if self.pos % 8 == 0:
+                self.data.append(0)
+            if (value >> n) & 1:
+                self.data[-1] |= 0x80 >> (self.pos % 8)
+            self.pos += 1
+
+
+class BitReader:
+    def __init__(self, data):
+        self.data = bytearray(data)
+        self.pos = 0
+
+    def get(self, bits):
+        value = 0
+        for _ in range(bits):
+            byte = self.data[self.pos // 8]
+            value = (value << 1) | ((byte >> (7 - self.pos % 8)) & 1)
+            self.pos += 1
+        return value
+
+
+def encode_packet(seq, grange, samples):
+    """Pack samples the same way stream_flush() does on the watch"""
+    width = 0
+    for prev, cur in zip(samples, samples[1:]):
+        for i in range(3):
+            width = max(width, delta_width(cur[i] - prev[i]))
+
+    bits = BitWriter()
+    for v in samples[0]:
+        bits.put(v & 0x3ff, 10)
+    for prev, cur in zip(samples, samples[1:]):
+        for i in range(3):
+            bits.put((cur[i] - prev[i]) & ((1 << width) - 1), width)
+
+    payload = bytearray([seq & 0xff, len(samples), (grange << 4) | width]) + bits.data
+    assert len(payload) == packed_len(len(samples), width)
+    return payload
+
+
+def encode_stream(samples, grange=0, seq=0):
+    """
+        Split samples into packets with the greedy rule used by stream_push():
+        a packet is sent as soon as the next sample would not fit anymore.
+    """
+    packets = []
+    pending = []
+    width = 0
+    for sample in samples:
+        if pending:
+            w = width
+            for i in range(3):
+                w = max(w, delta_width(sample[i] - pending[-1][i]))
+            if len(pending) == MAX_SAMPLES or packed_len(len(pending) + 1, w) > MAX_PAYLOAD:
+                packets.append(encode_packet(seq, grange, pending))
+                seq += 1
+                pending = []
+                w = 0
+            width = w
+        pending.append(tuple(sample))
+    if pending:
+        packets.append(encode_packet(seq, grange, pending))
+    return packets
+
+
+def decode_packet(payload):
+    """Returns (sequence number, range index, list of (x, y, z) raw samples)"""
+    payload = bytearray(payload)
+    if len(payload) < packed_len(1, 0):
+        raise ValueError("packet too short")
+    seq, count, info = payload[0], payload[1], payload[2]
+    grange, width = info >> 4, info & 0x0f
+    if count == 0 or width > 11 or len(payload) < packed_len(count, width):
+        raise ValueError("malformed packet")
+
+    bits = BitReader(payload[HEADER_LEN:])
+    sample = [to_signed(bits.get(10), 10) for _ in range(3)]
+    samples = [tuple(sample)]
+    for _ in range(count - 1):
+        for i in range(3):
+            sample[i] += to_signed(bits.get(width), width)
+        samples.append(tuple(sample))
+    return seq, grange, samples
+
+
+class StreamDecoder:
+    "Reassembles the sample stream and counts packets lost on air"
+
+    def __init__(self):
+        self.expected = None
+        self.lost = 0
+        self.packets = 0
+        self.samples = 0
+
+    def feed(self, payload):
+        seq, grange, samples = decode_packet(payload)
+        if self.expected is not None:
+            self.lost += (seq - self.expected) & 0xff
+        self.expected = (seq + 1) & 0xff
+        self.packets += 1
+        self.samples += len(samples)
+        scale = G_PER_LSB[grange & 3]
+        return [(x * scale, y * scale, z * scale) for (x, y, z) in samples]
+
+
+class LoopbackAccessPoint:
+    """
+        Stand-in for the access point: synthesizes a wrist motion, runs it
+        through the firmware packing rules and hands out the packets as if
+        they had been received over the air. 'loss' drops packets at random.
+    """
+
+    def __init__(self, grange=0, loss=0.0, seed=0):
+        self.grange = grange
+        self.loss = loss
+        self.random = random.Random(seed)
+        self.t = 0
+        self.queue = []
+        self.seq = 0
+
+    def _motion(self, n):
+        samples = []
+        for _ in range(n):
+            t = self.t / 125.0
+            x = int(200 * math.sin(2 * math.pi * 1.3 * t)) + self.random.randint(-2, 2)
+            y = int(120 * math.cos(2 * math.pi * 0.7 * t)) + self.random.randint(-2, 2)
+            z = 256 + int(40 * math.sin(2 * math.pi * 3.1 * t)) + self.random.randint(-2, 2)
+            samples.append((x, y, z))
+            self.t += 1
+        return samples
+
+    def read_packet(self):
+        while not self.queue:
+            self.queue = encode_stream(self._motion(MAX_SAMPLES * 4), self.grange, self.seq)
+            self.seq = (self.seq + len(self.queue)) & 0xff
+            self.queue = [p for p in self.queue if self.random.random() >= self.loss]
+        return self.queue.pop(0)
+
+
+class SerialAccessPoint:
+    """
+        Reads raw packets forwarded by an access point running a passthrough
+        firmware: each packet is preceded by its length byte, as in the TX FIFO.
+    """
+
+    def __init__(self, device):
+        self.device = device
+
+    def read_packet(self):
+        length = bytearray(self.device.read(1))
+        if not length:
+            return None
+        return bytearray(self.device.read(length[0]))
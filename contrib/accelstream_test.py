@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+## -*- coding: utf-8 -*-
+
+# Copyright (C) 2026 openchronos-ng contributors
+#
+# openchronos-ng is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# openchronos-ng is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+import unittest
+import accelstream
+
+class AccelStreamTests(unittest.TestCase):
+    def test_delta_width(self):
+        self.assertEqual(accelstream.delta_width(0), 0)
+        self.assertEqual(accelstream.delta_width(-1), 1)
+        self.assertEqual(accelstream.delta_width(1), 2)
+        self.assertEqual(accelstream.delta_width(-512), 10)
+        self.assertEqual(accelstream.delta_width(1023), 11)
+
+    def test_still_packet(self):
+        """A watch lying still needs no delta bits at all"""
+        packet = accelstream.encode_packet(7, 1, [(0, -1, 256)] * 24)
+        self.assertEqual(len(packet), 3 + 4)
+        self.assertEqual(accelstream.decode_packet(packet), (7, 1, [(0, -1, 256)] * 24))
+
+    def test_extremes_roundtrip(self):
+        samples = [(-512, 511, 0), (511, -512, 0), (-512, 511, -1)]
+        packet = accelstream.encode_packet(0, 0, samples)
+        self.assertEqual(packet[2] & 0x0f, 11)
+        self.assertEqual(accelstream.decode_packet(packet)[2], samples)
+
+    def test_stream_fits_fifo(self):
+        """Every packet fits the payload limit and the stream decodes losslessly"""
+        ap = accelstream.LoopbackAccessPoint()
+        samples = ap._motion(1000)
+        packets = accelstream.encode_stream(samples)
+        decoded = []
+        for seq, packet in enumerate(packets):
+            self.assertLessEqual(len(packet), accelstream.MAX_PAYLOAD)
+            s, grange, chunk = accelstream.decode_packet(packet)
+            self.assertEqual(s, seq & 0xff)
+            decoded += chunk
+        self.assertEqual(decoded, samples)
+        # one sample per poll used to cost a 3 byte payload per round trip
+        self.assertLess(sum(len(p) for p in packets), 3 * len(samples))
+
+    def test_decoder_counts_lost_packets(self):
+        ap = accelstream.LoopbackAccessPoint(grange=2, loss=0.2, seed=1)
+        decoder = accelstream.StreamDecoder()
+        for _ in range(50):
+            values = decoder.feed(ap.read_packet())
+            self.assertAlmostEqual(values[0][2], 256 * 0.01563, delta=60 * 0.01563)
+        self.assertEqual(decoder.packets, 50)
+        self.assertGreater(decoder.lost, 0)
+
+    def test_malformed_packet(self):
+        self.assertRaises(ValueError, accelstream.decode_packet, bytearray([0, 0, 0, 0, 0, 0, 0]))
+        self.assertRaises(ValueError, accelstream.decode_packet, bytearray([0, 2, 4, 0, 0, 0, 0]))
+
+if __name__ == '__main__':
+    unittest.main()
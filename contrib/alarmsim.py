@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Copyright (C) 2026 openchronos-ng contributors
+#
+# openchronos-ng is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# openchronos-ng is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+"""
+    Model of the alarm scheduler in modules/alarm.c.
+
+    Times are minutes since sunday 00:00, like on the watch. The simulator
+    jumps from one programmed RTC_A alarm to the next, runs the same checks
+    as alarm_event() and records every wakeup with what rang, so a schedule
+    can be fast-forwarded over weeks without a watch.
+"""
+
+import datetime
+
+DAY = 24 * 60
+WEEK = 7 * DAY
+
+# bit n of days rings on day of week n, 0 being sunday
+DAILY = 0x7f
+WEEKDAYS = 0x3e
+WEEKEND = 0x41
+ONCE = 0x80
+
+SNOOZE = 5
+
+
+class Alarm:
+    def __init__(self, hour, minute, days=DAILY, on=True):
+        self.hour = hour
+        self.min = minute
+        self.days = days
+        self.on = on
+
+    def __repr__(self):
+        return "Alarm(%02u:%02u, days=0x%02x, on=%r)" % (self.hour, self.min, self.days, self.on)
+
+
+def dow(time):
+    """RTC day of week, 0 being sunday"""
+    return (time.weekday() + 1) % 7
+
+
+def week_minutes(time):
+    return dow(time) * DAY + time.hour * 60 + time.minute
+
+
+def minutes_until(t, now):
+    """minutes from now until t, a full week if t is now"""
+    return (t if t > now else t + WEEK) - now
+
+
+def next_alarm(alarms, chime, snooze, now):
+    """minutes until the RTC_A alarm programmed by alarm_schedule(), None when disabled"""
+    candidates = []
+    for a in alarms:
+        if a.on:
+            candidates += [minutes_until(d * DAY + a.hour * 60 + a.min, now)
+                           for d in range(7) if a.days & (1 << d)]
+    if snooze is not None:
+        candidates.append(minutes_until(snooze, now))
+    if chime:
+        candidates.append(60 - now % 60)
+    return candidates and min(candidates) or None
+
+
+def rings(alarms, time):
+    """alarms due at time, like the loop at the start of alarm_event()"""
+    return [a for a in alarms if a.on and a.days & (1 << dow(time))
+            and a.hour == time.hour and a.min == time.minute]
+
+
+class Simulator:
+    """
+        Fast-forwards the watch from wakeup to wakeup. 'snooze' decides for
+        every ringing alarm whether the user snoozes it.
+    """
+
+    def __init__(self, alarms, chime=False, start=None, snooze=None):
+        self.alarms = alarms
+        self.chime = chime
+        self.time = start or datetime.datetime(2026, 1, 1)
+        self.snooze_policy = snooze or (lambda time: False)
+        self.snooze = None
+        self.log = []
+
+    def run(self, until):
+        while True:
+            now = week_minutes(self.time)
+            delta = next_alarm(self.alarms, self.chime, self.snooze, now)
+            if delta is None:
+                break
+            time = self.time.replace(second=0) + datetime.timedelta(minutes=delta)
+            if time > until:
+                break
+            self.time = time
+            self.log.append((time, self._fire(week_minutes(time))))
+        self.time = until
+        return self.log
+
+    def _fire(self, now):
+        what = None
+        for a in rings(self.alarms, self.time):
+            what = "alarm"
+            if a.days & ONCE:
+                a.on = False
+        if self.snooze == now:
+            self.snooze = None
+            what = "snooze"
+        if what and self.snooze_policy(self.time):
+            self.snooze = (now + SNOOZE) % WEEK
+        if what is None and self.chime and self.time.minute == 0:
+            what = "chime"
+        return what
+
+    @property
+    def wakeups(self):
+        return len(self.log)
+
+
+def expected_rings(alarms, start, until):
+    """minutes between start and until at which an alarm rings, found by brute force"""
+    res = []
+    time = start.replace(second=0) + datetime.timedelta(minutes=1)
+    once_done = set()
+    while time <= until:
+        due = [a for a in rings(alarms, time) if id(a) not in once_done]
+        if due:
+            res.append(time)
+            once_done |= set(id(a) for a in due if a.days & ONCE)
+        time += datetime.timedelta(minutes=1)
+    return res
+
+
+if __name__ == "__main__":
+    start = datetime.datetime(2026, 3, 1)
+    until = datetime.datetime(2026, 4, 1)
+    sim = Simulator([Alarm(7, 0, WEEKDAYS), Alarm(9, 30, WEEKEND), Alarm(12, 15, ONCE | DAILY)],
+                    chime=True, start=start)
+    for time, what in sim.run(until):
+        print("%s %s" % (time.strftime("%a %Y-%m-%d %H:%M"), what))
+    print("%d wakeups from %s to %s" % (sim.wakeups, start.date(), until.date()))
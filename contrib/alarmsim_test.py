@@ -0,0 +1,240 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Copyright (C) 2026 openchronos-ng contributors
+#
+# openchronos-ng is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# openchronos-ng is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+import datetime
+import os
+import sys
+import unittest
+
+import alarmsim
+from alarmsim import Alarm, Simulator
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "tools"))
+import hostcc
+
+# March 2026 starts on a sunday: 22 weekdays and 9 weekend days
+START = datetime.datetime(2026, 3, 1)
+UNTIL = datetime.datetime(2026, 4, 1)
+
+
+class AlarmSimTests(unittest.TestCase):
+    def test_minutes_until(self):
+        """Testing if an alarm at the current minute waits a week"""
+        self.assertEqual(alarmsim.minutes_until(10, 5), 5)
+        self.assertEqual(alarmsim.minutes_until(5, 10), alarmsim.WEEK - 5)
+        self.assertEqual(alarmsim.minutes_until(5, 5), alarmsim.WEEK)
+
+    def test_month_wakes_only_for_alarms(self):
+        """Fast-forwarding a month wakes up exactly when an alarm rings"""
+        alarms = [Alarm(7, 0, alarmsim.WEEKDAYS), Alarm(9, 30, alarmsim.WEEKEND),
+                  Alarm(22, 45, 1 << 3), Alarm(6, 0, on=False)]
+        sim = Simulator(alarms, start=START)
+        log = sim.run(UNTIL)
+        self.assertEqual(sim.wakeups, 22 + 9 + 4)
+        self.assertEqual([t for t, what in log], alarmsim.expected_rings(alarms, START, UNTIL))
+        self.assertEqual(set(what for t, what in log), set(["alarm"]))
+
+    def test_shared_minute_wakes_once(self):
+        """Two alarms at the same minute take a single wakeup"""
+        sim = Simulator([Alarm(7, 0), Alarm(7, 0, alarmsim.WEEKDAYS)], start=START)
+        sim.run(UNTIL)
+        self.assertEqual(sim.wakeups, 31)
+
+    def test_once(self):
+        """A one shot alarm rings at its next occurrence only"""
+        alarms = [Alarm(12, 15, alarmsim.ONCE | alarmsim.DAILY)]
+        sim = Simulator(alarms, start=START.replace(hour=13))
+        log = sim.run(UNTIL)
+        self.assertEqual(log, [(datetime.datetime(2026, 3, 2, 12, 15), "alarm")])
+        self.assertFalse(alarms[0].on)
+
+    def test_chime(self):
+        """The hourly chime shares the wakeups of alarms on the full hour"""
+        alarms = [Alarm(7, 0, alarmsim.WEEKDAYS), Alarm(9, 30, alarmsim.WEEKEND)]
+        sim = Simulator(alarms, chime=True, start=START)
+        log = sim.run(UNTIL)
+        self.assertEqual(sim.wakeups, 31 * 24 + 9)
+        self.assertEqual(sum(1 for t, what in log if what == "alarm"), 22 + 9)
+        self.assertTrue(all(what for t, what in log))
+
+    def test_snooze(self):
+        """Snoozing wakes up once more, SNOOZE minutes later"""
+        alarms = [Alarm(7, 0, alarmsim.WEEKDAYS)]
+        sim = Simulator(alarms, start=START, snooze=lambda time: time.minute == 0)
+        log = sim.run(UNTIL)
+        self.assertEqual(sim.wakeups, 2 * 22)
+        snoozes = [t for t, what in log if what == "snooze"]
+        self.assertEqual(len(snoozes), 22)
+        self.assertTrue(all(t.hour == 7 and t.minute == alarmsim.SNOOZE for t in snoozes))
+
+    def test_no_alarms(self):
+        """Without alarms the RTC alarm stays disabled"""
+        sim = Simulator([Alarm(7, 0, on=False)], start=START)
+        sim.run(UNTIL)
+        self.assertEqual(sim.wakeups, 0)
+
+
+# alarm_schedule() of modules/alarm.c built for the host. Each case on the
+# command line is the time (dow hour min), chime, snooze (0xffff for none)
+# and ALARM_COUNT alarms (hour min days on); the RTC_A alarm it programs is
+# printed as "dow hour min", or "none" when it disables the alarm.
+# "event dow hour min set" instead calls alarm_event() at that time, after a
+# clock change if set is 1, and prints "rings snooze dow hour min".
+ALARM_COUNT = 4
+
+SCHEDULE_MAIN = r"""
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "modules/alarm.c"
+
+const uint8_t tune_alarm[1], tune_chime[1];
+
+static int alarm_dow = -1, alarm_hour, alarm_min, rings;
+volatile uint8_t rtca_sets;
+
+void rtca_set_alarm_at(uint8_t dow, uint8_t hour, uint8_t min)
+{
+	alarm_dow = dow;
+	alarm_hour = hour;
+	alarm_min = min;
+}
+
+void rtca_disable_alarm()
+{
+	alarm_dow = -1;
+}
+
+char *_sprintf(const char *fmt, int16_t n) { return ""; }
+void display_chars(uint8_t scr_nr, enum display_segment_array segments, char const *str,
+		   enum display_segstate state) { }
+void display_symbol(uint8_t scr_nr, enum display_segment symbol, enum display_segstate state) { }
+void display_pattern(uint8_t scr_nr, struct display_pattern const *pattern,
+		     enum display_segstate state) { }
+void display_clear(uint8_t scr_nr, uint8_t line) { }
+uint8_t ports_button_pressed_peek(uint8_t btn, uint8_t with_longpress) { return 0; }
+void ports_buttons_clear(void) { }
+void sys_messagebus_register(void (*callback) (enum sys_message), enum sys_message listens) { }
+void sys_messagebus_unregister(void (*callback) (enum sys_message), enum sys_message listens) { }
+void sys_messagebus_set_priority(void (*callback) (enum sys_message), enum sys_priority prio,
+				 uint16_t budget_us) { }
+void buzzer_play(const uint8_t *tune) { rings++; }
+void helpers_loop(uint8_t *value, uint8_t lower, uint8_t upper, int8_t step) { }
+void menu_editmode_start(void (*complete_fn) (void), void (*cancel_fn) (void),
+			 struct menu_editmode_item *items) { }
+
+int main(int argc, char **argv)
+{
+	int i = 1, n;
+
+	if (argc > 1 && strcmp(argv[1], "event") == 0) {
+		/* a daily alarm at 7:00, the last one snoozed until 6:55 */
+		alarm_cfg.alarms[0] = (struct alarm) { 7, 0, ALARM_DAILY, 1 };
+		snooze = 1 * ALARM_DAY + 6 * 60 + 55;
+		for (i = 2; i + 4 <= argc; i += 4) {
+			rtca_time.dow = atoi(argv[i]);
+			rtca_time.hour = atoi(argv[i + 1]);
+			rtca_time.min = atoi(argv[i + 2]);
+			rtca_sets += atoi(argv[i + 3]);
+			rings = 0;
+			alarm_event(SYS_MSG_RTC_ALARM);
+			printf("%d %u %d %d %d\n", rings, snooze, alarm_dow, alarm_hour, alarm_min);
+		}
+		return 0;
+	}
+
+	while (i + 5 + 4 * CONFIG_MOD_ALARM_COUNT <= argc) {
+		rtca_time.dow = atoi(argv[i++]);
+		rtca_time.hour = atoi(argv[i++]);
+		rtca_time.min = atoi(argv[i++]);
+		alarm_cfg.chime = atoi(argv[i++]);
+		snooze = atoi(argv[i++]);
+		for (n = 0; n < CONFIG_MOD_ALARM_COUNT; n++) {
+			alarm_cfg.alarms[n].hour = atoi(argv[i++]);
+			alarm_cfg.alarms[n].min = atoi(argv[i++]);
+			alarm_cfg.alarms[n].days = atoi(argv[i++]);
+			alarm_cfg.alarms[n].on = atoi(argv[i++]);
+		}
+		alarm_schedule();
+		if (alarm_dow < 0)
+			printf("none\n");
+		else
+			printf("%d %d %d\n", alarm_dow, alarm_hour, alarm_min);
+	}
+	return 0;
+}
+"""
+
+# the alarm sets of the simulator tests above
+ALARM_SETS = [
+    [Alarm(7, 0, alarmsim.WEEKDAYS), Alarm(9, 30, alarmsim.WEEKEND),
+     Alarm(22, 45, 1 << 3), Alarm(6, 0, on=False)],
+    [Alarm(7, 0), Alarm(7, 0, alarmsim.WEEKDAYS)],
+    [Alarm(12, 15, alarmsim.ONCE | alarmsim.DAILY)],
+    [Alarm(23, 59, 1 << 6), Alarm(0, 0, 1 << 0)],
+    [Alarm(7, 0, on=False)],
+]
+
+
+@unittest.skipIf(hostcc.compiler() is None, "no host C compiler")
+class AlarmScheduleTests(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.build = hostcc.HostBuild(SCHEDULE_MAIN, [], ["CONFIG_MOD_ALARM_COUNT %d" % ALARM_COUNT],
+                                     {"tunes.h": "#include <stdint.h>\n"
+                                                 "extern const uint8_t tune_alarm[], tune_chime[];\n"})
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.build.close()
+
+    def test_schedule_matches_model(self):
+        """alarm_schedule() programs the alarm the model wakes up for"""
+        cases = []
+        args = []
+        for alarms in ALARM_SETS:
+            padded = alarms + [Alarm(0, 0, on=False)] * (ALARM_COUNT - len(alarms))
+            # every day and hour, the minute moving along, a week's last minute too
+            for now in list(range(0, alarmsim.WEEK, 97)) + [alarmsim.WEEK - 1]:
+                for chime in (False, True):
+                    for snooze in (None, (now + alarmsim.SNOOZE) % alarmsim.WEEK, now):
+                        cases.append((alarms, chime, snooze, now))
+                        args += [now // alarmsim.DAY, now // 60 % 24, now % 60, int(chime),
+                                 0xffff if snooze is None else snooze]
+                        for a in padded:
+                            args += [a.hour, a.min, a.days, int(a.on)]
+        lines = self.build.run(*[str(v) for v in args])
+        self.assertEqual(len(lines), len(cases))
+        for (alarms, chime, snooze, now), line in zip(cases, lines):
+            delta = alarmsim.next_alarm(alarms, chime, snooze, now)
+            if delta is None:
+                expected = "none"
+            else:
+                t = (now + delta) % alarmsim.WEEK
+                expected = "%d %d %d" % (t // alarmsim.DAY, t // 60 % 24, t % 60)
+            self.assertEqual(line, expected, "%r chime=%r snooze=%r now=%d" % (alarms, chime, snooze, now))
+
+    def test_clock_change(self):
+        """Setting the clock onto the alarm doesn't ring it and drops the snooze"""
+        lines = self.build.run("event", "1", "7", "0", "1", "2", "7", "0", "0")
+        # monday 7:00 by a clock change, then tuesday 7:00 reached by the RTC
+        self.assertEqual(lines, ["0 65535 2 7 0", "1 65535 3 7 0"])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -16,6 +16,7 @@
 # You should have received a copy of the GNU General Public License
 # along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+import os
 import re
 
 notes_translate = ('p', 'a', 'a#', 'b', 'c', 'c#', 'd', 'd#', 'e', 'f', 'f#', 'g', 'g#')
@@ -47,31 +48,186 @@ def parse_ringtone(ringtone):
     return {"title": match.group(1), "melody": notes, "whole": whole}
 
 
-def generate_binary_ringtone(ringtone):
+# Tune format played by drivers/buzzer.c: the whole note length in ms as a
+# little endian uint16, then one byte per event. The high nibble is the pitch
+# (0 rest, 1-12 A to G#) or one of the control events below, bit 3 makes the
+# note dotted and bits 0-2 give its length as whole >> n.
+TUNE_OCTAVE = 0xd
+TUNE_VOLUME = 0xe
+TUNE_END = 0xf
+TUNE_DOT = 0x08
+
+# Lowest RTTTL octave, it maps to the unshifted base_notes[] of the driver
+FIRST_OCTAVE = 4
+MAX_VOLUME = 3
+
+# Must match drivers/buzzer.c
+SMCLK_HZ = 12000000
+TICKS_PER_MS = SMCLK_HZ // 1000
+BASE_NOTES = (0, 27273, 25742, 24397, 22934, 21646, 20431, 19285, 18202, 17181, 16216, 15306, 14447)
+
+
+def parse_tune(ringtone):
+    """
+        Parses a RTTTL ringtone into a dictionary with the title, the whole note
+        length in ms, the volume (0-3, an optional v= header field) and the notes
+        as (divider, dotted, pitch, octave) tuples.
+    """
+    title, header, body = ringtone.split(':', 2)
+    fields = {'d': 4, 'o': 6, 'b': 63, 'v': MAX_VOLUME}
+    for field in header.split(','):
+        if field.strip():
+            key, value = field.split('=')
+            fields[key.strip().lower()] = int(value)
+    notes = []
+    for note in body.split(','):
+        if not note.strip():
+            continue
+        match = re.match('(^[0-9]{0,2})([a-gp]#?)([4-9]?)(\\.?)$', note.strip(), flags=re.IGNORECASE)
+        if match is None:
+            raise ValueError("bad note %r" % note)
+        duration, pitch, octave, dot = match.groups()
+        notes.append((duration and int(duration) or fields['d'], dot == '.', pitch.lower(),
+                      octave and int(octave) or fields['o']))
+    return {"title": title.strip(), "whole": 60 * 1000 * 4 // fields['b'],
+            "volume": fields['v'], "melody": notes}
+
+
+def encode_tune(tune):
+    """
+        Converts a tune as parsed by parse_tune into the byte string played by
+        buzzer_play(). Octave and volume events are only emitted on changes.
+    """
+    if not 0 < tune["whole"] <= 0xffff:
+        raise ValueError("tempo out of range")
+    data = bytearray([tune["whole"] & 0xff, tune["whole"] >> 8])
+    if not 0 <= tune["volume"] <= MAX_VOLUME:
+        raise ValueError("volume out of range")
+    if tune["volume"] != MAX_VOLUME:
+        data.append(TUNE_VOLUME << 4 | tune["volume"])
+    octave = 0
+    for divider, dotted, pitch, note_octave in tune["melody"]:
+        shift = divider.bit_length() - 1
+        if divider != 1 << shift or shift > 7:
+            raise ValueError("note length 1/%d is not supported" % divider)
+        tone = notes_translate.index(pitch)
+        if tone:
+            if not 0 <= note_octave - FIRST_OCTAVE <= 3:
+                raise ValueError("octave %d out of range" % note_octave)
+            if note_octave - FIRST_OCTAVE != octave:
+                octave = note_octave - FIRST_OCTAVE
+                data.append(TUNE_OCTAVE << 4 | octave)
+        data.append(tone << 4 | (dotted and TUNE_DOT or 0) | shift)
+    data.append(TUNE_END << 4)
+    return data
+
+
+def tune_events(data):
     """
-        This method converts a ringtone as parsed by parse_ringtone in the binary representation,
-        converting each note using generate_binary_note()
+        Replays the integer math of the TA1 interrupt: returns (period, duty, periods)
+        for every note or rest, in SMCLK ticks. A rest has a duty of 0.
     """
-    melody_real = list()
-    melody = ringtone["melody"]
-    for note in melody:
-        melody_real.append(hex(generate_binary_note(note, ringtone["whole"])))
-    melody_real.append("0x000F")
-    return "static note %s[%d] = {%s};" % (ringtone["title"], len(ringtone["melody"]) + 1, ', '.join(melody_real))
+    data = bytearray(data)
+    whole = data[0] | data[1] << 8
+    octave, volume = 0, MAX_VOLUME
+    events = []
+    for event in data[2:]:
+        pitch = event >> 4
+        if pitch == TUNE_OCTAVE:
+            octave = event & 3
+        elif pitch == TUNE_VOLUME:
+            volume = event & 3
+        elif pitch == TUNE_END:
+            return events
+        else:
+            ms = whole >> (event & 7)
+            if event & TUNE_DOT:
+                ms += ms >> 1
+            if pitch == 0:
+                period, duty = TICKS_PER_MS, 0
+            else:
+                period = (BASE_NOTES[pitch] >> octave) << 1
+                duty = (period >> 1) >> (MAX_VOLUME - volume)
+            events.append((period, duty, max(1, ms * TICKS_PER_MS // period)))
+    raise ValueError("tune is not terminated")
 
 
-def generate_binary_note(note, whole_note):
+def render_tune(data, rate=22050):
     """
-        This method converts a tuple note as parsed by parse_note to the binary representation.
+        Samples the buzzer pin while the tune plays, as unsigned 8 bit PCM:
+        0xff while the output is high, 0x80 otherwise.
     """
-    duration = int(whole_note / note[0])
-    if duration > 1023:
-        raise Exception("note duration too long")
-    tone = notes_translate.index(note[1])
-    octave = note[2] - 4
-    return (duration << 6) | (octave << 4) | tone
+    samples = bytearray()
+    start = 0
+    n = 0
+    for period, duty, periods in tune_events(data):
+        end = start + period * periods
+        t = n * SMCLK_HZ // rate
+        while t < end:
+            samples.append((t - start) % period < duty and 0xff or 0x80)
+            n += 1
+            t = n * SMCLK_HZ // rate
+        start = end
+    return samples
+
+
+def write_wav(filename, data, rate=22050):
+    import wave
+    wav = wave.open(filename, "wb")
+    wav.setnchannels(1)
+    wav.setsampwidth(1)
+    wav.setframerate(rate)
+    wav.writeframes(bytes(render_tune(data, rate)))
+    wav.close()
+
+
+def tune_name(tune):
+    return "tune_" + re.sub('[^0-9a-z_]', '_', tune["title"].lower())
+
+
+def generate_tune_sources(tunes, header="tunes.h"):
+    """
+        Returns the C source and header declaring one const tune per RTTTL
+        ringtone, each in its own section so unused ones are dropped at link time.
+    """
+    c = ["/* This file is autogenerated by contrib/rtttl2bin.py, do not edit! */", "",
+         "#include \"%s\"" % header, ""]
+    h = ["/* This file is autogenerated by contrib/rtttl2bin.py, do not edit! */", "",
+         "#ifndef TUNES_H_", "#define TUNES_H_", "", "#include <stdint.h>", ""]
+    for tune in tunes:
+        data = encode_tune(tune)
+        c.append("const uint8_t %s[%d] = {%s};" % (tune_name(tune), len(data),
+                                                   ", ".join("0x%02x" % b for b in data)))
+        h.append("extern const uint8_t %s[%d];" % (tune_name(tune), len(data)))
+    h += ["", "#endif /* TUNES_H_ */"]
+    return "\n".join(c) + "\n", "\n".join(h) + "\n"
 
 
 if __name__ == '__main__':
-    import sys
-    print(generate_binary_ringtone(parse_ringtone(sys.argv[1])))
+    from optparse import OptionParser
+    parser = OptionParser(usage="%prog [options] <ringtone or .rtttl file>...")
+    parser.add_option("-o", "--output", dest="output",
+                      help="write OUTPUT.c and OUTPUT.h with all the tunes")
+    parser.add_option("-w", "--wav", dest="wav",
+                      help="render the first tune into a WAV file")
+    (options, args) = parser.parse_args()
+    if not args:
+        parser.error("no ringtone given")
+
+    tunes = []
+    for arg in args:
+        if arg.endswith(".rtttl"):
+            with open(arg) as f:
+                arg = f.read()
+        tunes.append(parse_tune(arg))
+
+    if options.wav:
+        write_wav(options.wav, encode_tune(tunes[0]))
+    if options.output:
+        source, header = generate_tune_sources(tunes, os.path.basename(options.output) + ".h")
+        with open(options.output + ".c", "w") as f:
+            f.write(source)
+        with open(options.output + ".h", "w") as f:
+            f.write(header)
+    if not options.output and not options.wav:
+        print(generate_tune_sources(tunes)[0])
@@ -21,15 +21,6 @@ import unittest
 import rtttl2bin
 
 class RTTTLTests(unittest.TestCase):
-    def test_generate_binary_note(self):
-        """Testing if generate_binary_note generates binary notes correctly"""
-        self.assertEqual(rtttl2bin.generate_binary_note((8, 'e',  4), 2664), 21320)
-
-    def test_generate_binary_ringtone(self):
-        self.assertEqual(rtttl2bin.generate_binary_ringtone(
-            {'title': 'welcome', 'melody': [(16, 'a', 4), (16, 'c', 4), (16, 'e', 4)], 'whole': 1600}),
-            "static note welcome[4] = {0x1901, 0x1904, 0x1908, 0x000F};")
-
     def test_parse_note(self):
         """Testing if parse_note parses notes correctly"""
         self.assertEqual(rtttl2bin.parse_note("1e4",   32, 4), (1, 'e',  4))
@@ -61,11 +52,51 @@ class RTTTLTests(unittest.TestCase):
         self.assertEqual(rtttl2bin.parse_ringtone("Test: d=8,o=4,b=90: 2d#6., 2d"),
             {'title': 'Test', 'melody': [(3, 'd#', 6), (2, 'd', 4)], "whole": 2664})
 
-    def test_ringtone_generation(self):
+    def test_parse_tune(self):
+        """Testing if parse_tune keeps dots apart and reads the optional volume"""
+        self.assertEqual(rtttl2bin.parse_tune("Test: d=8,o=4,b=120,v=1: 2d#6., p, 16c"),
+            {'title': 'Test', 'whole': 2000, 'volume': 1,
+             'melody': [(2, True, 'd#', 6), (8, False, 'p', 4), (16, False, 'c', 4)]})
+        self.assertEqual(rtttl2bin.parse_tune("Test: d=8,o=4,b=120: a")["volume"], 3)
+
+    def test_encode_tune(self):
+        """Testing if octave changes and the end marker are emitted"""
+        self.assertEqual(rtttl2bin.encode_tune(rtttl2bin.parse_tune(
+            "welcome: d=16,o=7,b=150: a, c, e")),
+            bytearray([0x40, 0x06, 0xd3, 0x14, 0x44, 0x84, 0xf0]))
+        self.assertEqual(rtttl2bin.encode_tune(rtttl2bin.parse_tune(
+            "Test: d=4,o=4,b=150,v=0: 8a., 2p, a5")),
+            bytearray([0x40, 0x06, 0xe0, 0x1b, 0x01, 0xd1, 0x12, 0xf0]))
+
+    def test_encode_tune_limits(self):
+        """Testing if notes the driver cannot play are refused"""
+        self.assertRaises(ValueError, rtttl2bin.encode_tune, rtttl2bin.parse_tune("T: d=4,o=4,b=150: 3a"))
+        self.assertRaises(ValueError, rtttl2bin.encode_tune, rtttl2bin.parse_tune("T: d=4,o=8,b=150: a"))
+
+    def test_tune_events(self):
+        """Testing if note lengths and volume follow the driver"""
+        events = rtttl2bin.tune_events(bytearray([0x40, 0x06, 0xe1, 0x13, 0x0c, 0xf0]))
+        # 200ms of A: 54546 ticks per period, a quarter of it high at volume 1
+        self.assertEqual(events[0], (54546, 6818, 200 * 12000 // 54546))
+        # dotted 1/16: 150ms of silence in 1ms steps
+        self.assertEqual(events[1], (12000, 0, 150))
+        self.assertRaises(ValueError, rtttl2bin.tune_events, bytearray([0x40, 0x06, 0x13]))
+
+    def test_render_tune(self):
+        """Testing if the rendered tune has the expected length and pitch"""
+        tune = rtttl2bin.encode_tune(rtttl2bin.parse_tune("Test: d=4,o=6,b=60: a, p"))
+        samples = rtttl2bin.render_tune(tune, 8000)
+        self.assertEqual(len(samples), 16000)
+        rising = sum(1 for a, b in zip(samples, samples[1:]) if a == 0x80 and b == 0xff)
+        self.assertTrue(879 <= rising <= 880)
+        self.assertEqual(set(samples[8000:]), set([0x80]))
+
+    def test_generate_tune_sources(self):
         """This tests the complete generation sequence"""
-        self.assertEqual(rtttl2bin.generate_binary_ringtone(rtttl2bin.parse_ringtone(
-            "welcome: d=16,o=4,b=150: a, c, e")),
-            "static note welcome[4] = {0x1901, 0x1904, 0x1908, 0x000F};")
+        source, header = rtttl2bin.generate_tune_sources(
+            [rtttl2bin.parse_tune("welcome: d=16,o=7,b=150: a, c, e")])
+        self.assertTrue("const uint8_t tune_welcome[7] = {0x40, 0x06, 0xd3, 0x14, 0x44, 0x84, 0xf0};" in source)
+        self.assertTrue("extern const uint8_t tune_welcome[7];" in header)
 
 if __name__ == '__main__':
     unittest.main()
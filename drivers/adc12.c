@@ -45,6 +45,7 @@
 // driver
 #include "adc12.h"
 #include "timer.h"
+#include "energy.h"
 
 
 // *************************************************************************************************
@@ -60,18 +61,21 @@
 uint16_t adc12_result;
 uint8_t  adc12_data_ready;
 
+// Set while a protothread conversion owns the ADC
+static uint8_t adc12_busy;
+
 
 // *************************************************************************************************
 // Extern section
 
 
 // *************************************************************************************************
-// @fn          adc12_single_conversion
-// @brief       Init ADC12. Do single conversion. Turn off ADC12.
-// @param       none
+// @fn          adc12_power_up, adc12_start, adc12_power_down
+// @brief       Init ADC12, start a single conversion, turn off ADC12.
+// @param       ref, sht, channel       reference, sample time and input of the conversion
 // @return      none
 // *************************************************************************************************
-uint16_t adc12_single_conversion(uint16_t ref, uint16_t sht, uint16_t channel)
+static void adc12_power_up(uint16_t ref, uint16_t sht, uint16_t channel)
 {
      // Initialize the shared reference module
      REFCTL0 |= REFMSTR + ref + REFON;           // Enable internal reference (1.5V or 2.5V)
@@ -82,9 +86,12 @@ uint16_t adc12_single_conversion(uint16_t ref, uint16_t sht, uint16_t channel)
      ADC12MCTL0 = ADC12SREF_1 + channel;         // ADC input channel
      ADC12IE = 0x001;                            // ADC_IFG upon conv result-ADCMEMO
 
-     // Wait 2 ticks (66us) to allow internal reference to settle
-     timer0_delay(66,LPM3_bits);
+     energy_on(ENERGY_REF);
+     energy_on(ENERGY_ADC12);
+}
 
+static void adc12_start(void)
+{
      // Start ADC12
      ADC12CTL0 |= ADC12ENC;
 
@@ -93,17 +100,10 @@ uint16_t adc12_single_conversion(uint16_t ref, uint16_t sht, uint16_t channel)
 
      // Sampling and conversion start
      ADC12CTL0 |= ADC12SC;
+}
 
-     // Wait until ADC12 has finished
-     timer0_delay(170, LPM3_bits);
-
-     uint8_t loops = 0;
-
-     //We were going away and the watchdog was tripping - this should reduce the instances of that.
-     while (!adc12_data_ready && loops++ < 30) {
-	  timer0_delay(66, LPM3_bits);
-     }
-
+static void adc12_power_down(uint16_t ref, uint16_t sht)
+{
      // Shut down ADC12
      ADC12CTL0 &= ~(ADC12ENC | ADC12SC | sht);
      ADC12CTL0 &= ~ADC12ON;
@@ -113,8 +113,40 @@ uint16_t adc12_single_conversion(uint16_t ref, uint16_t sht, uint16_t channel)
 
      ADC12IE = 0;
 
-     // Return ADC result
-     return (adc12_result);
+     energy_off(ENERGY_ADC12);
+     energy_off(ENERGY_REF);
+}
+
+// *************************************************************************************************
+// @fn          adc12_conversion
+// @brief       Init ADC12. Do single conversion. Turn off ADC12.
+//              Returns to the main loop while waiting.
+// @param       pt      protothread state, see PT_SPAWN
+// @return      PT_ENDED once adc12_result holds the result
+// *************************************************************************************************
+PT_THREAD(adc12_conversion(struct pt *pt, uint16_t ref, uint16_t sht, uint16_t channel))
+{
+     PT_BEGIN(pt);
+
+     // One conversion at a time, another thread may be converting
+     while (adc12_busy)
+	  PT_SLEEP(pt, 10);
+     adc12_busy = 1;
+
+     adc12_power_up(ref, sht, channel);
+
+     // Allow internal reference to settle
+     PT_SLEEP(pt, 66);
+
+     adc12_start();
+
+     // The ISR wakes the main loop up once ADC12 has finished
+     PT_WAIT_UNTIL_TIMEOUT(pt, adc12_data_ready, 1000);
+
+     adc12_power_down(ref, sht);
+     adc12_busy = 0;
+
+     PT_END(pt);
 }
 
 
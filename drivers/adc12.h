@@ -40,11 +40,12 @@
 
 // *************************************************************************************************
 // Include section
+#include "pt.h"
 
 
 // *************************************************************************************************
 // Prototypes section
-extern uint16_t adc12_single_conversion(uint16_t ref, uint16_t sht, uint16_t channel);
+extern PT_THREAD(adc12_conversion(struct pt *pt, uint16_t ref, uint16_t sht, uint16_t channel));
 
 // *************************************************************************************************
 // Defines section
@@ -46,6 +46,7 @@
 #include "openchronos.h"
 #include "as.h"
 #include "timer.h"
+#include "energy.h"
 
 
 // *************************************************************************************************
@@ -106,6 +107,7 @@ void as_start(void)
      AS_SPI_SEL |= AS_SDO_PIN + AS_SDI_PIN + AS_SCK_PIN; // Port pins to SDO, SDI and SCK function
      AS_CSN_OUT |= AS_CSN_PIN;                    // Deselect acceleration sensor
      AS_PWR_OUT |= AS_PWR_PIN;                    // Power on active high
+     energy_on(ENERGY_AS);
 
      // Delay of >5ms required between switching on power and configuring sensor
      timer0_delay(10, LPM3_bits);
@@ -128,6 +130,7 @@ void as_stop(void)
 
      // Power-down sensor
      AS_PWR_OUT &= ~AS_PWR_PIN;                   // Power off
+     energy_off(ENERGY_AS);
      AS_INT_OUT &= ~AS_INT_PIN;                   // Pin to low to avoid floating pins
      AS_SPI_OUT &= ~(AS_SDO_PIN + AS_SDI_PIN + AS_SCK_PIN); // Pins to low to avoid floating pins
      AS_SPI_SEL &= ~(AS_SDO_PIN + AS_SDI_PIN + AS_SCK_PIN); // Port pins to I/O function
@@ -94,8 +94,6 @@
 // *************************************************************************************************
 // Global Variable section
 
-volatile uint8_t as_last_interrupt;
-
 // *************************************************************************************************
 // Extern section
 
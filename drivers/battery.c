@@ -64,6 +64,10 @@
 #include "ports.h"
 #include "adc12.h"
 
+#include "messagebus.h"
+
+PT_TASK_DEFINE(battery_task, battery_measurement);
+
 void battery_init(void)
 {
      /* Start with battery voltage estimate of full and avoid low
@@ -72,14 +76,20 @@ void battery_init(void)
 }
 
 
-void battery_measurement(void)
+PT_THREAD(battery_measurement(struct pt *pt))
 {
+     static struct pt conversion;
+     uint16_t voltage;
+
+     PT_BEGIN(pt);
+
      /* Convert external battery voltage (ADC12INCH_11=AVCC-AVSS/2)
 	voltage = adc12_single_conversion(REFVSEL_2, ADC12SHT0_10,
 	ADC12SSEL_0, ADC12SREF_1, ADC12INCH_11,
 	ADC12_BATT_CONVERSION_TIME_USEC); */
-     uint16_t voltage = adc12_single_conversion(REFVSEL_1,
-						ADC12SHT0_10, ADC12INCH_11);
+     PT_SPAWN(pt, &conversion, adc12_conversion(&conversion, REFVSEL_1,
+						 ADC12SHT0_10, ADC12INCH_11));
+     voltage = adc12_result;
 
      /* Convert ADC value to "x.xx V"
 	Ideally we have A11=0->AVCC=0V ... A11=4095(2^12-1)->AVCC=4V
@@ -105,5 +115,9 @@ void battery_measurement(void)
      /* Display blinking battery symbol if low */
      if (battery_info.voltage < BATTERY_LOW_THRESHOLD)
 	  display_symbol(0, LCD_SYMB_BATTERY, SEG_ON | BLINK_ON);
+
+     send_events(SYS_MSG_BATT);
+
+     PT_END(pt);
 }
 
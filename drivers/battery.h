@@ -61,9 +61,15 @@
 #define __BATTERY_H__
 
 #include "openchronos.h"
+#include "pt.h"
 
 void battery_init(void);
-void battery_measurement(void);
+
+/* measures the battery, then sends SYS_MSG_BATT */
+PT_THREAD(battery_measurement(struct pt *pt));
+
+/* runs battery_measurement() from the main loop */
+extern struct pt_task battery_task;
 
 /* Battery high voltage threshold */
 #define BATTERY_HIGH_THRESHOLD          (360u)
@@ -157,7 +157,6 @@ uint8_t bmp_as_write_register(uint8_t bAddress, uint8_t bData) // NON SCRIVE!!!
 // *************************************************************************************************
 void bmp_as_get_data(int16_t *axes)
 {
-     uint8_t i;
      uint16_t data[3];
      // Exit if sensor is not powered up
      if ((AS_PWR_OUT & AS_PWR_PIN) != AS_PWR_PIN) return;
@@ -171,6 +170,19 @@ void bmp_as_get_data(int16_t *axes)
      data[1] += ((uint32_t) bmp_as_read_register(BMP_ACC_Y_MSB)) << 2;
      data[2] += ((uint32_t) bmp_as_read_register(BMP_ACC_Z_MSB)) << 2;
 
+     bmp_as_calc_axes(data, axes);
+}
+
+// *************************************************************************************************
+// @fn          bmp_as_calc_axes
+// @brief       Convert the 10 bit acceleration registers to signed values.
+// @param       uint16_t *data                           X/Y/Z register values, changed
+//              int16_t *axes                            array containing the acceleration values
+// @return      none
+// *************************************************************************************************
+void bmp_as_calc_axes(uint16_t *data, int16_t *axes)
+{
+     uint8_t i;
 
      // Convert the values from 10 bit two's complement uint to 16 bit int
      for (i = 0; i < 3; i++)
@@ -105,6 +105,7 @@ extern void bmp_as_stop(void);
 extern uint8_t bmp_as_read_register(uint8_t bAddress);
 extern uint8_t bmp_as_write_register(uint8_t bAddress, uint8_t bData);
 extern void bmp_as_get_data(int16_t * axes);
+extern void bmp_as_calc_axes(uint16_t * data, int16_t * axes);
 extern void bmp_as_enable_interrupts(bmp_as_interrupts_t interrupts);
 extern void bmp_as_disable_interrupts(void);
 extern bmp_as_status_t bmp_as_process_interrupt(void);
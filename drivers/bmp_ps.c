@@ -45,6 +45,8 @@
 #include "bmp_ps.h"
 #include "ps.h"
 #include "timer.h"
+#include "governor.h"
+#include "energy.h"
 
 // *************************************************************************************************
 // Prototypes section
@@ -55,14 +57,48 @@
 // *************************************************************************************************
 // Global Variable section
 
-// Variable to hold BMP085 calibration data
+// Variable to hold BMP085 calibration data, kept across resets with the magic and check word
+// below: the sensor keeps running as long as the watch has power
+__attribute__ ((section(".noinit")))
 bmp_085_calibration_param_t bmp_cal_param;
+__attribute__ ((section(".noinit")))
+uint16_t bmp_cal_magic;
+__attribute__ ((section(".noinit")))
+uint16_t bmp_cal_check;
 // Paramater used by temperature and pressure measurement
 long bmp_param_b5;
 
+// Pressure conversion time per oversampling setting, the datasheet maximum rounded up (ms)
+static const uint8_t bmp_ps_conversion_ms[4] = { 5, 8, 14, 26 };
+
+// Oversampling setting and averaging window of bmp_ps_get_pa()
+static uint8_t bmp_ps_oss;
+static uint8_t bmp_ps_window_len = 1;
+static uint8_t bmp_ps_window_fill;
+static uint8_t bmp_ps_window_idx;
+static uint32_t bmp_ps_window[BMP_PS_WINDOW_MAX];
+
 // *************************************************************************************************
 // Extern section
 
+// *************************************************************************************************
+// @fn          bmp_ps_cal_check
+// @brief       Check word of the calibration parameters, tells a cached copy from RAM garbage
+// @param       none
+// @return      uint16_t                     Check word
+// *************************************************************************************************
+static uint16_t bmp_ps_cal_check(void)
+{
+     const uint16_t *param = (const uint16_t *) &bmp_cal_param;
+     uint16_t check = BMP_085_CAL_MAGIC;
+     uint8_t i;
+
+     for (i = 0; i < BMP_085_PROM_SIZE / 2; i++)
+	  check = ((check << 1) | (check >> 15)) ^ param[i];
+
+     return (check);
+}
+
 // *************************************************************************************************
 // @fn          bmp_ps_init
 // @brief       Init pressure sensor I/O
@@ -72,6 +108,15 @@ long bmp_param_b5;
 void bmp_ps_init(void)
 {
      ps_init();
+     bmp_ps_set_mode(BMP_085_OSS_ULTRA_LOW_POWER, 1);
+
+     // Calibration read since power up, the sensor is already running
+     if (bmp_cal_magic == BMP_085_CAL_MAGIC && bmp_cal_check == bmp_ps_cal_check())
+	  return;
+
+     // 10msec delay to guarantee stable operation, paid when a module
+     // starts the sensor instead of at boot
+     timer0_delay(10, LPM3_bits);
 
      // Read ChipID to check if communication is working
      bmp_ps_read_register(BMP_085_CHIP_ID_REG, PS_I2C_8BIT_ACCESS);
@@ -87,22 +132,26 @@ void bmp_ps_init(void)
 // *************************************************************************************************
 void bmp_ps_get_cal_param(void)
 {
-     /*parameters AC1-AC6*/
-     bmp_cal_param.ac1 = bmp_ps_read_register(BMP_085_PROM_START_ADDR + 0, PS_I2C_16BIT_ACCESS);
-     bmp_cal_param.ac2 = bmp_ps_read_register(BMP_085_PROM_START_ADDR + 2, PS_I2C_16BIT_ACCESS);
-     bmp_cal_param.ac3 = bmp_ps_read_register(BMP_085_PROM_START_ADDR + 4, PS_I2C_16BIT_ACCESS);
-     bmp_cal_param.ac4 = bmp_ps_read_register(BMP_085_PROM_START_ADDR + 6, PS_I2C_16BIT_ACCESS);
-     bmp_cal_param.ac5 = bmp_ps_read_register(BMP_085_PROM_START_ADDR + 8, PS_I2C_16BIT_ACCESS);
-     bmp_cal_param.ac6 = bmp_ps_read_register(BMP_085_PROM_START_ADDR + 10,PS_I2C_16BIT_ACCESS);
-  
-     /*parameters B1,B2*/
-     bmp_cal_param.b1 = bmp_ps_read_register(BMP_085_PROM_START_ADDR + 12, PS_I2C_16BIT_ACCESS);
-     bmp_cal_param.b2 = bmp_ps_read_register(BMP_085_PROM_START_ADDR + 14, PS_I2C_16BIT_ACCESS);
-  
-     /*parameters MB,MC,MD*/
-     bmp_cal_param.mb = bmp_ps_read_register(BMP_085_PROM_START_ADDR + 16, PS_I2C_16BIT_ACCESS);
-     bmp_cal_param.mc = bmp_ps_read_register(BMP_085_PROM_START_ADDR + 18, PS_I2C_16BIT_ACCESS);
-     bmp_cal_param.md = bmp_ps_read_register(BMP_085_PROM_START_ADDR + 20, PS_I2C_16BIT_ACCESS);
+     uint8_t prom[BMP_085_PROM_SIZE];
+     uint16_t *param = (uint16_t *) &bmp_cal_param;
+     uint8_t i;
+
+     bmp_cal_magic = 0;
+
+     // AC1-AC6, B1, B2, MB, MC, MD in one read, in the order of bmp_085_calibration_param_t
+     if (!ps_read_burst(BMP_085_I2C_ADDR << 1, BMP_085_PROM_START_ADDR, prom, BMP_085_PROM_SIZE))
+	  return;
+
+     for (i = 0; i < BMP_085_PROM_SIZE / 2; i++)
+     {
+	  param[i] = (prom[2 * i] << 8) | prom[2 * i + 1];
+	  // No word is 0 or 0xFFFF, the read failed: don't keep it
+	  if (param[i] == 0 || param[i] == 0xFFFF)
+	       return;
+     }
+
+     bmp_cal_magic = BMP_085_CAL_MAGIC;
+     bmp_cal_check = bmp_ps_cal_check();
 }
 
 // *************************************************************************************************
@@ -115,11 +164,32 @@ void bmp_ps_start(void)
 {
      PS_INT_IFG &= ~PS_INT_PIN;
      PS_INT_IE |= PS_INT_PIN;
-     // Start sampling pressure and temperature
-     bmp_ps_get_pa();
+     // Readings of an earlier start are stale, and the pressure needs a temperature
+     bmp_ps_window_fill = 0;
+     bmp_ps_window_idx = 0;
      bmp_ps_get_temp();
 }
 
+// *************************************************************************************************
+// @fn          bmp_ps_set_mode
+// @brief       Select the pressure oversampling and the number of readings averaged
+// @param       uint8_t oss                  BMP_085_OSS_ULTRA_LOW_POWER .. BMP_085_OSS_ULTRA_HIGH_RES
+//              uint8_t window               Readings averaged by bmp_ps_get_pa(), 1 .. BMP_PS_WINDOW_MAX
+// @return      none
+// *************************************************************************************************
+void bmp_ps_set_mode(uint8_t oss, uint8_t window)
+{
+     bmp_ps_oss = oss & 3;
+
+     if (window < 1)
+	  window = 1;
+     if (window > BMP_PS_WINDOW_MAX)
+	  window = BMP_PS_WINDOW_MAX;
+     bmp_ps_window_len = window;
+     bmp_ps_window_fill = 0;
+     bmp_ps_window_idx = 0;
+}
+
 // *************************************************************************************************
 // @fn          bmp_ps_stop
 // @brief       Power down pressure sensor
@@ -157,23 +227,131 @@ uint16_t bmp_ps_read_register(uint8_t address, uint8_t mode)
      return ps_read_register(BMP_085_I2C_ADDR << 1, address, mode);
 }
 
+// *************************************************************************************************
+// @fn          bmp_ps_read_adc
+// @brief       Read the ADC_OUT registers in one transaction
+// @param       uint8_t len                  2 for MSB, LSB; 3 with XLSB
+// @return      uint32_t                     Register contents, MSB first
+// *************************************************************************************************
+static uint32_t bmp_ps_read_adc(uint8_t len)
+{
+     uint8_t adc[3] = { 0, 0, 0 };
+     uint32_t value = 0;
+     uint8_t i;
+
+     ps_read_burst(BMP_085_I2C_ADDR << 1, BMP_085_ADC_OUT_MSB_REG, adc, len);
+     for (i = 0; i < len; i++)
+	  value = (value << 8) | adc[i];
+
+     return (value);
+}
+
+// *************************************************************************************************
+// @fn          bmp_ps_convert
+// @brief       Start a conversion and sleep until the sensor is done
+// @param       uint8_t command              BMP_085_T_MEASURE, BMP_085_P_MEASURE with OSS
+//              uint8_t ms                   Conversion time (ms)
+// @return      uint8_t                      1 when EOC went high, 0 when the sensor did not answer
+// *************************************************************************************************
+static uint8_t bmp_ps_convert(uint8_t command, uint8_t ms)
+{
+     uint8_t wait = BMP_085_EOC_TIMEOUT;
+
+     energy_on(ENERGY_PS);
+     if (!bmp_ps_write_register(BMP_085_CTRL_MEAS_REG, command))
+	  wait = 0;
+     else
+	  // Sleep through the conversion instead of spinning on EOC for up to 25.5ms
+	  timer0_delay(ms, LPM3_bits);
+     // A sensor that hangs or lost the command would keep EOC low for good
+     while ((PS_INT_IN & PS_INT_PIN) == 0 && wait) {
+	  timer0_delay(1, LPM3_bits);
+	  wait--;
+     }
+     energy_off(ENERGY_PS);
+
+     return ((PS_INT_IN & PS_INT_PIN) != 0);
+}
+
+// *************************************************************************************************
+// @fn          bmp_ps_average
+// @brief       Add a reading to the averaging window
+// @param       uint32_t pa                  Pressure (Pa)
+// @return      uint32_t                     Average of the readings in the window (Pa)
+// *************************************************************************************************
+static uint32_t bmp_ps_average(uint32_t pa)
+{
+     uint32_t sum = 0;
+     uint8_t i;
+
+     bmp_ps_window[bmp_ps_window_idx] = pa;
+     if (++bmp_ps_window_idx == bmp_ps_window_len)
+	  bmp_ps_window_idx = 0;
+     if (bmp_ps_window_fill < bmp_ps_window_len)
+	  bmp_ps_window_fill++;
+
+     // Until the window wraps, its start holds the readings
+     for (i = 0; i < bmp_ps_window_fill; i++)
+	  sum += bmp_ps_window[i];
+
+     return ((sum + bmp_ps_window_fill / 2) / bmp_ps_window_fill);
+}
+
+// *************************************************************************************************
+// @fn          bmp_ps_measure
+// @brief       Read out the temperature, then the pressure compensated with it.
+// @param       bmp_ps_sample_t * sample     Temperature and pressure
+// @return      uint8_t                      1 on success, 0 when a conversion did not finish
+// *************************************************************************************************
+uint8_t bmp_ps_measure(bmp_ps_sample_t * sample)
+{
+     sample->kelvin = bmp_ps_get_temp();
+     if (sample->kelvin == 0)
+	  return (0);
+     sample->pa = bmp_ps_get_pa();
+
+     return (sample->pa != 0);
+}
+
 // *************************************************************************************************
 // @fn          bmp_ps_get_pa
 // @brief       Read out pressure. Format is Pa. Range is 30000 .. 120000 Pa.
+//              Compensated with the last temperature read, see bmp_ps_measure().
 // @param       none
-// @return      uint32_t                     15-bit pressure sensor value (Pa)
+// @return      uint32_t                     Pressure (Pa), averaged over the window, 0 on failure
 // *************************************************************************************************
 uint32_t bmp_ps_get_pa(void)
 {
-     uint16_t up;			// uncompensated pressure
+     uint32_t up;			// uncompensated pressure
+     uint8_t oss = bmp_ps_oss;
+
+     // A failed reading stays out of the window
+     if (!bmp_ps_convert(BMP_085_P_MEASURE | (oss << 6), bmp_ps_conversion_ms[oss]))
+	  return (0);
+
+     // MSB, LSB and XLSB: 16 bits plus one per oversampling step
+     up = bmp_ps_read_adc(3) >> (8 - oss);
+
+     return bmp_ps_average(bmp_ps_calc_pa(up, oss));
+}
+
+// *************************************************************************************************
+// @fn          bmp_ps_calc_pa
+// @brief       Compensate a pressure reading with the calibration and the last temperature.
+// @param       uint32_t up                  Uncompensated pressure from the ADC_OUT registers
+//              uint8_t oss                  Oversampling setting it was converted with
+// @return      uint32_t                     Pressure (Pa)
+// *************************************************************************************************
+uint32_t bmp_ps_calc_pa(uint32_t up, uint8_t oss)
+{
      int32_t pressure, x1, x2, x3, b3, b6;
      uint32_t result, b4, b7;
 
      // Add Compensation and convert decimal value to Pa
 
-     bmp_ps_write_register(BMP_085_CTRL_MEAS_REG, BMP_085_P_MEASURE);
-     while ((PS_INT_IN & PS_INT_PIN) == 0);
-  
+     // Only the 32 bit arithmetic below needs the speed
+     governor_boost();
+
      b6 = bmp_param_b5 - 4000;
      //*****calculate B3************
      x1 = (b6 * b6) >> 12;	 	 
@@ -183,18 +361,15 @@ uint32_t bmp_ps_get_pa(void)
 
      x3 = x1 + x2;
 
-     b3 = (((((long) bmp_cal_param.ac1) * 4 + x3)) + 2) / 4;
+     b3 = (((((long) bmp_cal_param.ac1) * 4 + x3) << oss) + 2) / 4;
 
      //*****calculate B4************
      x1 = (bmp_cal_param.ac3 * b6) / 8192;
      x2 = (bmp_cal_param.b1 * ((b6 * b6) >> 12)) / 65536;
      x3 = ((x1 + x2) + 2) / 4;
      b4 = (bmp_cal_param.ac4 * (uint32_t) (x3 + 32768)) / 32768;
-     
-     // Get MSB from ADC_OUT_MSB_REG
-     up = bmp_ps_read_register(BMP_085_ADC_OUT_MSB_REG, PS_I2C_16BIT_ACCESS);
 
-     b7 = ((uint32_t)(up - b3) * 50000);   
+     b7 = ((uint32_t)(up - b3) * (50000 >> oss));
      if (b7 < 0x80000000)
      {
 	  pressure = (b7 * 2) / b4;
@@ -210,6 +385,8 @@ uint32_t bmp_ps_get_pa(void)
      x2 = (pressure * BMP_SMD500_PARAM_MH) / 65536;
      result = pressure + (x1 + x2 + BMP_SMD500_PARAM_MI) / 16;	// pressure in Pa
 
+     governor_release();
+
      return (result);
 }
 
@@ -217,7 +394,7 @@ uint32_t bmp_ps_get_pa(void)
 // @fn          bmp_ps_get_temp
 // @brief       Read out temperature.
 // @param       none
-// @return      uint16_t                     13-bit temperature value in xx.x K format
+// @return      uint16_t                     13-bit temperature value in xx.x K format, 0 on failure
 // *************************************************************************************************
 uint16_t bmp_ps_get_temp(void)
 {
@@ -226,11 +403,12 @@ uint16_t bmp_ps_get_temp(void)
      int16_t temperature;
      uint16_t kelvin;
 
-     bmp_ps_write_register(BMP_085_CTRL_MEAS_REG, BMP_085_T_MEASURE);
-     while ((PS_INT_IN & PS_INT_PIN) == 0);
+     // The compensation of the next pressure keeps the last good temperature
+     if (!bmp_ps_convert(BMP_085_T_MEASURE, BMP_085_TEMP_CONVERSION_TIME))
+	  return (0);
 
      // Get temp bits from ADC_OUT registers
-     ut = bmp_ps_read_register(BMP_085_ADC_OUT_MSB_REG, PS_I2C_16BIT_ACCESS);
+     ut = bmp_ps_read_adc(2);
 
      // Add Compensation and convert decimal value to 0.1 C
      x1 = (((long) ut - (long) bmp_cal_param.ac6) * (long) bmp_cal_param.ac5) / 32768;
@@ -47,7 +47,9 @@ extern void bmp_ps_start(void);
 extern void bmp_ps_stop(void);
 extern uint16_t bmp_ps_read_register(uint8_t address, uint8_t mode);
 extern uint8_t bmp_ps_write_register(uint8_t address, uint8_t data);
+extern void bmp_ps_set_mode(uint8_t oss, uint8_t window);
 extern uint32_t bmp_ps_get_pa(void);
+extern uint32_t bmp_ps_calc_pa(uint32_t up, uint8_t oss);
 extern uint16_t bmp_ps_get_temp(void);
 
 // *************************************************************************************************
@@ -65,13 +67,28 @@ extern uint16_t bmp_ps_get_temp(void);
 #define BMP_085_CTRL_MEAS_REG (0xF4)
 #define BMP_085_ADC_OUT_MSB_REG	(0xF6)
 #define BMP_085_ADC_OUT_LSB_REG	(0xF7)
+#define BMP_085_ADC_OUT_XLSB_REG (0xF8)
+
+#define BMP_085_PROM_SIZE    (22)				 // AC1 .. MD, 11 words MSB first
+#define BMP_085_CAL_MAGIC    (0xb085)			 // bmp_cal_param holds a PROM read
 
 #define BMP_085_SOFT_RESET_REG (0xE0)
 
 #define BMP_085_T_MEASURE    (0x2E)				 // temperature measurent
-#define BMP_085_P_MEASURE    (0x34)				 // pressure measurement
+#define BMP_085_P_MEASURE    (0x34)				 // pressure measurement, OSS in bits 7:6
+
+// Oversampling settings (OSS) of the pressure measurement: 2^OSS samples per
+// conversion, less noise for a longer conversion and more charge
+#define BMP_085_OSS_ULTRA_LOW_POWER (0u)			 // 4.5ms
+#define BMP_085_OSS_STANDARD        (1u)			 // 7.5ms
+#define BMP_085_OSS_HIGH_RES        (2u)			 // 13.5ms
+#define BMP_085_OSS_ULTRA_HIGH_RES  (3u)			 // 25.5ms
 
-#define BMP_085_TEMP_CONVERSION_TIME (5)		 // TO be spec'd by GL or SB
+// Most pressure readings bmp_ps_get_pa() averages
+#define BMP_PS_WINDOW_MAX    (8u)
+
+#define BMP_085_TEMP_CONVERSION_TIME (5)		 // 4.5ms maximum, in ms
+#define BMP_085_EOC_TIMEOUT  (5)				 // ms waited for EOC after the conversion time
 
 #define BMP_SMD500_PARAM_MG  (3038)              //calibration parameter
 #define BMP_SMD500_PARAM_MH  (-7357)             //calibration parameter
@@ -94,6 +111,15 @@ typedef struct {
      short md;      		   
 } bmp_085_calibration_param_t;
 
+/** a temperature and the pressure compensated with it, see bmp_ps_measure()
+ */
+typedef struct {
+     uint32_t pa;        // pressure (Pa), averaged over the window of bmp_ps_set_mode()
+     uint16_t kelvin;    // temperature in xx.x K format
+} bmp_ps_sample_t;
+
+extern uint8_t bmp_ps_measure(bmp_ps_sample_t * sample);
+
 // *************************************************************************************************
 // Global Variable section
 
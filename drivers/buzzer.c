@@ -23,16 +23,15 @@
 **/
 
 #include "buzzer.h"
-#include "timer.h"
+#include "tunes.h"
+#include "governor.h"
+#include "energy.h"
 
-#define DURATION(note) (note >> 6)
-#define OCTAVE(note) ((note >> 4) & 0x0003)
-#define PITCH(note) (note & 0x000F)
-
-note welcome[4] = {0x1931, 0x1934, 0x1938, 0x000F};
+/* SMCLK runs from the 12MHz DCO while playing, see boot.c and governor.h */
+#define BUZZER_TICKS_PER_MS 12000
 
 // The following note table is calculated using "clock frequency in hz / sound frequency in hz"
-uint16_t base_notes[13] = {
+static const uint16_t base_notes[13] = {
      0,     /* 0: P  */
      27273, /* 1: A  */
      25742, /* 2: A# */
@@ -48,71 +47,115 @@ uint16_t base_notes[13] = {
      14447  /* C: G# */
 };
 
-volatile static note *notes = NULL;
+/* Sequencer state, only touched by the TA1 CCR0 interrupt once playing */
+static const uint8_t *volatile tune = NULL;
+static uint16_t whole_ms;
+static uint16_t periods_left;
+static uint8_t octave;
+static uint8_t volume;
 
 inline bool is_buzzer_playing() {
-     return notes != NULL;
+     return tune != NULL;
 }
 
 inline void buzzer_init(void) {
-     /* Reset TA1R, TA1 runs from 32768Hz ACLK */
+     /* Reset TA1R, TA1 runs from SMCLK */
      TA1CTL = TACLR | TASSEL__SMCLK | MC__STOP;
 
-     /* Enable IRQ, set output mode "toggle" */
-     TA1CCTL0 = OUTMOD_4;
-
-     /* Play "welcome" chord: A major */
-     buzzer_play(welcome);
+     /* Keep the buzzer output low */
+     TA1CCTL1 = OUTMOD_0;
 }
 
-inline static void buzzer_stop(void) {
+static void buzzer_stop(void) {
      /* Stop PWM timer */
      TA1CTL &= ~MC_3; // Clear any MC bits, effectively a MC_STOP
 
+     /* Disable PWM timer interrupt and force the output low */
+     TA1CCTL0 &= ~CCIE;
+     TA1CCTL1 = OUTMOD_0;
+
      /* Disable buzzer PWM output */
      P2OUT &= ~BIT7;
      P2SEL &= ~BIT7;
 
-     /* Clear PWM timer interrupt */
-     TA1CCTL0 &= ~CCIE;
+     tune = NULL;
+     governor_release();
+     energy_off(ENERGY_BUZZER);
 }
 
-static void buzzer_play_callback() {
-     /* 0x000F is the "stop bit" */
-     if (PITCH(*notes) != 0x000F) {
-	  if (PITCH(*notes) == 0) {
-	       /* Stop the timer! We are playing a rest */
-	       TA1CTL &= ~MC_3;
-	  } else {
-	       /* Set PWM frequency */
-	       TA1CCR0 = base_notes[PITCH(*notes)] >> OCTAVE(*notes);
-
-	       /* Start the timer */
-	       TA1CTL |= MC__UP;
-	  }
+/* Sets up TA1 for the next note or rest of the tune. Notes are a PWM with
+   the duty cycle picked by the volume, rests keep the output low and tick
+   every millisecond. Either way the length is counted in timer periods. */
+static void buzzer_next_event(void) {
+     uint8_t event, pitch;
+     uint16_t ms, period;
+
+     for (;;) {
+	  event = *tune++;
+	  pitch = event >> 4;
+
+	  if (pitch == BUZZER_OCTAVE)
+	       octave = event & 0x03;
+	  else if (pitch == BUZZER_VOLUME)
+	       volume = event & 0x03;
+	  else
+	       break;
+     }
 
-	  /* Calculate duration delay in ms */
-	  uint16_t delay = DURATION(*notes);
+     if (pitch == BUZZER_END) {
+	  buzzer_stop();
+	  return;
+     }
 
-	  /* Advance to the next note */
-	  notes++;
+     ms = whole_ms >> (event & BUZZER_LEN_MASK);
+     if (event & BUZZER_DOT)
+	  ms += ms >> 1;
 
-	  /* Delay for DURATION(*notes) milliseconds */
-	  timer0_delay_callback(delay, &buzzer_play_callback);
+     if (pitch == BUZZER_REST) {
+	  period = BUZZER_TICKS_PER_MS;
+	  TA1CCTL1 = OUTMOD_0;
      } else {
-	  /* Stop buzzer */
-	  buzzer_stop();
-	  notes = NULL;
+	  /* A full period of the toggle output this table was made for */
+	  period = (base_notes[pitch] >> octave) << 1;
+	  TA1CCR1 = (period >> 1) >> (BUZZER_MAX_VOLUME - volume);
+	  TA1CCTL1 = OUTMOD_7;
      }
+
+     /* Called right after the counter wrapped, so it is still below CCR0 */
+     TA1CCR0 = period - 1;
+
+     periods_left = ((uint32_t)ms * BUZZER_TICKS_PER_MS) / period;
+     if (periods_left == 0)
+	  periods_left = 1;
 }
 
-void buzzer_play(note *async_notes) {
-     if (notes) return; // Ignore if we are currently playing.
+void buzzer_play(const uint8_t *async_tune) {
+     if (tune) return; // Ignore if we are currently playing.
+
+     whole_ms = async_tune[0] | (async_tune[1] << 8);
+     tune = async_tune + 2;
+     octave = 0;
+     volume = BUZZER_MAX_VOLUME;
 
-     notes = async_notes;
+     /* until buzzer_stop() */
+     governor_boost();
+
+     TA1CTL = TACLR | TASSEL__SMCLK | MC__STOP;
+     buzzer_next_event();
+     if (!tune)
+	  return;
 
      /* Allow buzzer PWM output on P2.7 */
      P2SEL |= BIT7;
+     energy_on(ENERGY_BUZZER);
+
+     TA1CCTL0 = CCIE;
+     TA1CTL |= MC__UP;
+}
 
-     buzzer_play_callback();
+/* Counts the periods of the current note, the main loop is never woken up */
+__attribute__((interrupt(TIMER1_A0_VECTOR)))
+void timer1_A0_ISR(void) {
+     if (--periods_left == 0)
+	  buzzer_next_event();
 }
@@ -26,10 +26,11 @@
  * \brief Buzzer subsystem functions.
  * \details This file contains all the methods used for \
  * playing tones with buzzer.
- * The buzzer can play a number of different tones, represented as a
- * note array.
- * The buzzer output frequency can be calculated using:
- * \f[ \frac{T_{\mathrm{ACLK}}}{2*\mathrm{TA1CCR0}} \f]
+ * The buzzer plays tunes stored as byte strings, usually in flash. They are
+ * compiled from the RTTTL files in tunes/ into tunes.c at build time by
+ * contrib/rtttl2bin.py, which can also render them into a WAV file.
+ * The notes are stepped by the TA1 CCR0 interrupt, the buzzer output is a
+ * PWM on TA1 CCR1 whose duty cycle sets the volume.
  */
 #ifndef BUZZER_H_
 #define BUZZER_H_
@@ -39,21 +40,27 @@
 bool is_buzzer_playing();
 
 /*!
- * \brief Note type.
- * \details This is a type representing a note. It is composed by:
- * - The first 4 MSB represent the pitch
- * - The next 2 bits represent the octave
- * - The following 10 bits are the duration in ms of the note.
+ * \brief Tune events.
+ * \details A tune starts with the length of a whole note in ms as a little
+ * endian uint16, followed by one byte per event:
+ * - The 4 MSB are the pitch, 0 for a rest and 1 to 12 for A to G#.
+ * - The next bit makes the note dotted, one and a half times as long.
+ * - The 3 LSB give the length of the note as the whole note divided by 2^n.
  *
- * There are two "meta" notes:
- * - The note xxx0 represents no tone (a rest).
- * - The note xxxF represents the "stop note" marking the \
- *   end of a note sequence.
+ * Three pitch values are "meta" events instead:
+ * - #BUZZER_OCTAVE sets the octave (0-3) of the following notes from its 2 LSB.
+ * - #BUZZER_VOLUME sets the volume (0-3) of the following notes from its 2 LSB.
+ * - #BUZZER_END marks the end of the tune.
  *
- * \note The stop note is needed in the play loop to determine \
- * when to end the melody.
+ * A tune starts at octave 0 and at full volume.
  */
-typedef uint16_t note;
+#define BUZZER_REST		0x0
+#define BUZZER_OCTAVE		0xd
+#define BUZZER_VOLUME		0xe
+#define BUZZER_END		0xf
+#define BUZZER_DOT		0x08
+#define BUZZER_LEN_MASK		0x07
+#define BUZZER_MAX_VOLUME	3
 
 /*!
  * \brief Initialize buzzer subsystem.
@@ -61,9 +68,9 @@ typedef uint16_t note;
 void buzzer_init(void);
 
 /*!
- * \brief Play a sequence of notes using the buzzer.
- * \param notes An array of notes to play.
+ * \brief Play a tune using the buzzer.
+ * \param tune The tune to play, see #BUZZER_END for the format.
+ * \note The tune is read while playing, so it must stay valid until is_buzzer_playing() returns false.
  */
-void buzzer_play(note *notes);
-extern note welcome[4];
+void buzzer_play(const uint8_t *tune);
 #endif /*BUZZER_H_*/
@@ -0,0 +1,109 @@
+/**
+    drivers/crashlog.c: Openchronos crash and watchdog reset record
+
+    Copyright (C) 2026 openchronos-ng contributors
+
+    http://github.com/BenjaminSoelberg/openchronos-ng-elf
+
+    This file is part of openchronos-ng.
+
+    openchronos-ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    openchronos-ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <string.h>
+
+#include "crashlog.h"
+
+#ifdef CONFIG_CRASH_LOG
+
+/* 16 intervals of 16s, the timeout of the hardware watchdog */
+#define CRASHLOG_INTERVALS 16
+#define CRASHLOG_INTERVAL_SECONDS 16
+
+#define WDTIS_MASK (WDTIS0 | WDTIS1 | WDTIS2)
+
+/* top of the RAM, from the linker script */
+extern uint8_t __stack;
+
+struct crashlog crashlog;
+
+/* not cleared by the C startup code, so it survives the reset */
+__attribute__ ((section(".noinit")))
+struct crashlog crashlog_run;
+
+volatile uint8_t crashlog_intervals;
+
+/* PC and SP stored by WDT_ISR() before anything else touches the stack */
+struct {
+     uint16_t pc;
+     uint16_t sp;
+} crashlog_sample;
+
+void crashlog_init(void)
+{
+     uint16_t reset, iv;
+
+     /* the highest priority reason comes first, drop the others */
+     reset = SYSRSTIV;
+     do {
+	  iv = SYSRSTIV;
+     } while (iv);
+
+     if (crashlog_run.magic == CRASHLOG_MAGIC)
+	  crashlog = crashlog_run;
+     crashlog.magic = CRASHLOG_MAGIC;
+     crashlog.reset = reset;
+
+     memset(&crashlog_run, 0, sizeof(crashlog_run));
+     crashlog_run.magic = CRASHLOG_MAGIC;
+}
+
+/* the rest of WDT_ISR(), a regular interrupt handler without vector */
+__attribute__ ((interrupt, used))
+void crashlog_interval(void)
+{
+     uint16_t *sp = (uint16_t *) crashlog_sample.sp;
+     uint8_t i;
+
+     /* boot.c polls the buttons with 250ms intervals before main() */
+     if ((WDTCTL & WDTIS_MASK) != WDTIS__512K) {
+	  _BIC_SR_IRQ(LPM3_bits);
+	  return;
+     }
+
+     crashlog_run.pc = crashlog_sample.pc;
+     crashlog_run.sp = crashlog_sample.sp;
+     crashlog_run.uptime += CRASHLOG_INTERVAL_SECONDS;
+     for (i = 0; i < CRASHLOG_STACK_WORDS; i++)
+	  crashlog_run.stack[i] = (uint8_t *) &sp[i] < &__stack ? sp[i] : 0;
+
+     if (++crashlog_intervals == CRASHLOG_INTERVALS) {
+	  /* time out the watchdog within 64 cycles, SYSRSTIV tells it at boot */
+	  WDTCTL = WDTPW + WDTCNTCL + WDTIS__64 + WDTSSEL__SMCLK;
+	  while (1);
+     }
+}
+
+/* The interrupted PC sits on top of the saved SR. Without prologue the
+   stack is still the one of the interrupt entry, store both and continue
+   in crashlog_interval(), whose RETI returns from the interrupt. */
+__attribute__ ((interrupt(WDT_VECTOR), naked))
+void WDT_ISR(void)
+{
+     __asm__ __volatile__("mov 2(r1), &crashlog_sample\n\t"
+			  "mov r1, &crashlog_sample+2\n\t"
+			  "br #crashlog_interval");
+}
+
+#endif
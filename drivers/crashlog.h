@@ -0,0 +1,101 @@
+/**
+    drivers/crashlog.h: Openchronos crash and watchdog reset record
+
+    Copyright (C) 2026 openchronos-ng contributors
+
+    http://github.com/BenjaminSoelberg/openchronos-ng-elf
+
+    This file is part of openchronos-ng.
+
+    openchronos-ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    openchronos-ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+/*!
+  \file crashlog.h
+  \brief openchronos-ng crash and watchdog reset record
+  \details With CONFIG_CRASH_LOG the watchdog runs as a 16 second interval
+  timer instead of resetting the CPU by itself. Each interval samples the
+  interrupted PC and the top of the stack into a record in .noinit, which
+  the reset leaves alone. After 16 intervals without wdt_poll() the
+  handler times the watchdog out for real, so a hang in the main loop
+  resets the watch after 256 seconds as before, with its PC recorded.
+
+  At boot crashlog_init() moves the record of the previous run to
+  #crashlog, together with the reason of the reset taken from SYSRSTIV.
+  modules/diag.c shows and sends it, save it with e.g.
+  <i>mspdebug rf2500 "save_raw crashlog 46 crash.bin"</i> and symbolize
+  it with tools/crashlog.py.
+  \note Code running with interrupts disabled, interrupt handlers included,
+  is not sampled. For other resets than the watchdog the record holds the
+  last sample, taken up to 16 seconds before.
+*/
+
+#include "openchronos.h"
+
+#ifndef __CRASHLOG_H__
+#define __CRASHLOG_H__
+
+#ifdef CONFIG_CRASH_LOG
+
+/*! words of the stack kept from the interrupted stack pointer up */
+#define CRASHLOG_STACK_WORDS 16
+
+/*! the run as it ended, 46 bytes, little endian */
+struct crashlog {
+     /*! CRASHLOG_MAGIC when the fields below are valid */
+     uint16_t magic;
+     /*! SYSRSTIV of the reset that ended the run, e.g. 0x16 watchdog time out */
+     uint16_t reset;
+     /*! PC interrupted by the last watchdog interval */
+     uint16_t pc;
+     /*! SP at that interrupt, pointing to the saved SR and PC */
+     uint16_t sp;
+     /*! message bus callback dispatched last */
+     uint16_t callback;
+     /*! seconds since boot, counted in 16 second intervals */
+     uint32_t uptime;
+     /*! stack words from sp up, the saved SR and PC first */
+     uint16_t stack[CRASHLOG_STACK_WORDS];
+};
+
+#define CRASHLOG_MAGIC 0xc4a5
+
+/*! the previous run, valid after crashlog_init() */
+extern struct crashlog crashlog;
+
+/*! the current run, in .noinit */
+extern struct crashlog crashlog_run;
+
+/*! intervals since the last wdt_poll() */
+extern volatile uint8_t crashlog_intervals;
+
+/*!
+  \brief Takes the record of the previous run, call before wdt_setup().
+*/
+void crashlog_init(void);
+
+/*!
+  \brief Remembers the message bus callback about to be called.
+*/
+#define crashlog_callback(fn) (crashlog_run.callback = (uint16_t)(fn))
+
+#else
+
+static inline void crashlog_init(void) { }
+
+#define crashlog_callback(fn)
+
+#endif
+
+#endif /* __CRASHLOG_H__ */
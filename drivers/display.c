@@ -57,12 +57,12 @@
 // *************************************************************************************************
 
 #include "openchronos.h"
+#include "pool.h"
 #include <string.h>
 #include <stdlib.h>
 #include "display.h"
-
-/* Swap nibble */
-#define SWAP_NIBBLE(x)              ((((x) << 4) & 0xF0) | (((x) >> 4) & 0x0F))
+#include "timer.h"
+#include "pt.h"
 
 /* LCD controller memory map */
 #define LCD_MEM_1                   ((uint8_t*)0x0A20)
@@ -169,7 +169,6 @@
 
 #define LCD_SEG_MEM                 (LCD_MEM_1)
 #define LCD_BLK_MEM                 (LCD_MEM_1 + 0x20)
-#define LCD_MEM_LEN                 12
 
 /***************************************************************************
  ***************************** LOCAL STORAGE *******************************
@@ -188,71 +187,28 @@ static struct lcd_screen *display_screens;
 static uint8_t display_nrscreens;
 static uint8_t display_activescr;
 
-/* 7-segment character bit assignments */
-#define SEG_A     (BIT4)
-#define SEG_B     (BIT5)
-#define SEG_C     (BIT6)
-#define SEG_D     (BIT7)
-#define SEG_E     (BIT2)
-#define SEG_F     (BIT0)
-#define SEG_G     (BIT1)
-
-/* Table with memory bit assignment for digits "0"-"9" and chars "A"-"Z"
-   A
-   F   B
-   G
-   E   C
-   D
-*/
+/* text marquee, the frames are windows of the rendered string */
+static struct {
+     uint8_t glyphs[DISPLAY_MARQUEE_MAX_LEN]; /* segment bits of each character */
+     uint8_t first;                           /* leftmost segment */
+     uint8_t width;                           /* number of segments */
+     uint8_t frames;                          /* number of frames */
+     uint8_t frame;                           /* next frame to show */
+     uint16_t period;                         /* ms between two frames */
+} marquee;
+
+#ifdef CONFIG_LCD_FLIP
+/* screen 1 lives in the blinking memory, LCDDISP selects the shown screen */
+static uint8_t display_flipped;
+#else
+#define display_flipped 0
+#endif
+
+#define LCD_FONT_BITS(arg, chr, bits) bits,
+
+/* Table with memory bit assignment for digits "0"-"9" and chars "A"-"Z" */
 static const uint8_t lcd_font[] = {
-     SEG_A + SEG_B + SEG_C + SEG_D + SEG_E + SEG_F        , // Displays "0"
-     SEG_B + SEG_C                                , // Displays "1"
-     SEG_A + SEG_B +         SEG_D + SEG_E +         SEG_G, // Displays "2"
-     SEG_A + SEG_B + SEG_C + SEG_D +                 SEG_G, // Displays "3"
-     SEG_B + SEG_C +                 SEG_F + SEG_G, // Displays "4"
-     SEG_A +         SEG_C + SEG_D +         SEG_F + SEG_G, // Displays "5"
-     SEG_A +         SEG_C + SEG_D + SEG_E + SEG_F + SEG_G, // Displays "6"
-     SEG_A + SEG_B + SEG_C                                , // Displays "7"
-     SEG_A + SEG_B + SEG_C + SEG_D + SEG_E + SEG_F + SEG_G, // Displays "8"
-     SEG_A + SEG_B + SEG_C + SEG_D +         SEG_F + SEG_G, // Displays "9"
-     0                                                    , // Displays " " (:)
-     0                                                    , // Displays " " (;)
-     SEG_A +                                 SEG_F + SEG_G, // Displays "<" as high c
-     SEG_D +                 SEG_G, // Displays "="
-     0                                                    , // Displays " " (>)
-     SEG_A + SEG_B +                 SEG_E +         SEG_G, // Displays "?"
-     0                                                    , // Displays " " (@)
-     SEG_A + SEG_B + SEG_C +         SEG_E + SEG_F + SEG_G, // Displays "A"
-     SEG_C + SEG_D + SEG_E + SEG_F + SEG_G, // Displays "b"
-     SEG_D + SEG_E +         SEG_G, // Displays "c"
-     SEG_B + SEG_C + SEG_D + SEG_E +         SEG_G, // Displays "d"
-     SEG_A +               + SEG_D + SEG_E + SEG_F + SEG_G, // Displays "E"
-     SEG_A +                         SEG_E + SEG_F + SEG_G, // Displays "f"
-     SEG_A + SEG_B + SEG_C + SEG_D +         SEG_F + SEG_G, // Displays "g" same as 9
-     SEG_C +         SEG_E + SEG_F + SEG_G, // Displays "h"
-     SEG_E                , // Displays "i"
-     SEG_A + SEG_B + SEG_C + SEG_D                        , // Displays "J"
-     SEG_D +         SEG_F + SEG_G, // Displays "k"
-     SEG_D + SEG_E + SEG_F        , // Displays "L"
-     SEG_A + SEG_B + SEG_C +         SEG_E + SEG_F        , // Displays "M"
-     SEG_C +         SEG_E +         SEG_G, // Displays "n"
-     SEG_C + SEG_D + SEG_E +         SEG_G, // Displays "o"
-     SEG_A + SEG_B +                 SEG_E + SEG_F + SEG_G, // Displays "P"
-     SEG_A + SEG_B + SEG_C +                 SEG_F + SEG_G, // Displays "q"
-     SEG_E +         SEG_G, // Displays "r"
-     SEG_A +         SEG_C + SEG_D +         SEG_F + SEG_G, // Displays "S" same as 5
-     SEG_D + SEG_E + SEG_F + SEG_G, // Displays "t"
-     SEG_C + SEG_D + SEG_E                , // Displays "u"
-     SEG_C + SEG_D + SEG_E                , // Displays "v" same as u
-     SEG_B + SEG_C + SEG_D + SEG_E + SEG_F + SEG_G, // Displays "W"
-     SEG_B + SEG_C +       + SEG_E + SEG_F + SEG_G, // Displays "X" as H
-     SEG_B + SEG_C + SEG_D +         SEG_F + SEG_G, // Displays "Y"
-     SEG_A + SEG_B +         SEG_D + SEG_E +         SEG_G, // Displays "Z" same as 2
-     SEG_B +                 SEG_E +         SEG_G, // Displays "[" as _|`
-     SEG_A + SEG_B +                         SEG_F + SEG_G, // Displays "\" (#)
-     SEG_C +                 SEG_F + SEG_G, // Displays "]" as `|_
-     SEG_A                                                , // Displays "^"
-     SEG_D                          // Displays "_"
+     LCD_FONT(LCD_FONT_BITS, 0)
 };
 
 
@@ -377,6 +333,50 @@ static void write_lcd_mem(uint8_t *segmem, uint8_t *blkmem,
      }
 }
 
+static uint8_t font_bits(char chr)
+{
+     uint8_t bits = 0;       // Bits to write (default ' ' blank)
+
+     // Get bits from font set
+     if (chr >= LCD_FONT_START_CHAR && chr <= LCD_FONT_END_CHAR) {
+	  // Use font set
+	  bits = lcd_font[chr - LCD_FONT_START_CHAR];
+     } else if (chr == 0x2D) {
+	  // '-' not in font set
+	  bits = BIT1;
+     }
+
+     return bits;
+}
+
+/* Leaves the flipped mode: the shown screen goes back to the segment memory
+   and the other one to RAM, so that the blinking memory can blink again. */
+static void display_unflip(uint8_t shown)
+{
+     uint8_t hidden = !shown;
+     uint8_t *segmem = pool_alloc(&lcd_buffer_pool);
+     uint8_t *blkmem = pool_alloc(&lcd_buffer_pool);
+
+     /* nothing blinks while flipped */
+     memcpy(segmem, display_screens[hidden].segmem, LCD_MEM_LEN);
+     memset(blkmem, 0, LCD_MEM_LEN);
+
+     if (shown)
+	  memcpy(LCD_SEG_MEM, LCD_BLK_MEM, LCD_MEM_LEN);
+     LCDBMEMCTL &= ~LCDDISP;
+     memset(LCD_BLK_MEM, 0, LCD_MEM_LEN);
+
+     display_screens[hidden].segmem = segmem;
+     display_screens[hidden].blkmem = blkmem;
+     display_screens[shown].segmem = LCD_SEG_MEM;
+     display_screens[shown].blkmem = LCD_BLK_MEM;
+
+#ifdef CONFIG_LCD_FLIP
+     display_flipped = 0;
+#endif
+     start_blink();
+}
+
 /***************************************************************************
  **************************** EXPORTED FUNCTIONS ***************************
  **************************************************************************/
@@ -386,9 +386,13 @@ static void write_lcd_mem(uint8_t *segmem, uint8_t *blkmem,
 */
 void lcd_screens_create(uint8_t nr)
 {
+     /* the pool block is sized for the module using the most screens */
+     if (nr * sizeof(struct lcd_screen) > lcd_screen_pool.size)
+	  pool_panic(&lcd_screen_pool);
+
      /* allocate memory */
      display_nrscreens = nr;
-     display_screens = malloc(sizeof(struct lcd_screen) * nr);
+     display_screens = pool_alloc(&lcd_screen_pool);
 
      /* the first screen is the active one */
      display_activescr = 0;
@@ -397,9 +401,30 @@ void lcd_screens_create(uint8_t nr)
 
      /* allocate mem for the remaining and copy real screen over */
      uint8_t i = 1;
+
+#ifdef CONFIG_LCD_FLIP
+     /* Screen 1 can use the blinking memory if nothing is blinking. It is
+	shown by setting LCDDISP, which only works with blinking disabled. */
+     display_flipped = (nr > 1);
+     for (i = 0; i < LCD_MEM_LEN; i++) {
+	  if (LCD_BLK_MEM[i])
+	       display_flipped = 0;
+     }
+
+     i = 1;
+     if (display_flipped) {
+	  stop_blink();
+	  memcpy(LCD_BLK_MEM, LCD_SEG_MEM, LCD_MEM_LEN);
+	  /* blkmem is never written while flipped */
+	  display_screens[1].segmem = LCD_BLK_MEM;
+	  display_screens[1].blkmem = LCD_BLK_MEM;
+	  i = 2;
+     }
+#endif
+
      for (; i<nr; i++) {
-	  display_screens[i].segmem = malloc(LCD_MEM_LEN);
-	  display_screens[i].blkmem = malloc(LCD_MEM_LEN);
+	  display_screens[i].segmem = pool_alloc(&lcd_buffer_pool);
+	  display_screens[i].blkmem = pool_alloc(&lcd_buffer_pool);
 	  memcpy(display_screens[i].segmem, LCD_SEG_MEM, LCD_MEM_LEN);
 	  memcpy(display_screens[i].blkmem, LCD_BLK_MEM, LCD_MEM_LEN);
      }
@@ -416,17 +441,20 @@ void lcd_screens_destroy(void)
      /* switch to screen 0 and display any pending data */
      lcd_screen_activate(0);
 
+     if (display_flipped)
+	  display_unflip(0);
+
      /* now we can delete all the screens */
      for (; i<display_nrscreens; i++) {
 	  if (i != display_activescr) {
-	       free(display_screens[i].segmem);
-	       free(display_screens[i].blkmem);
+	       pool_free(&lcd_buffer_pool, display_screens[i].segmem);
+	       pool_free(&lcd_buffer_pool, display_screens[i].blkmem);
 	  }
 	  display_screens[i].segmem = NULL;
 	  display_screens[i].segmem = NULL;
      }
 
-     free(display_screens);
+     pool_free(&lcd_screen_pool, display_screens);
      display_screens = NULL;
 }
 
@@ -449,9 +477,23 @@ void lcd_screen_activate(uint8_t scr_nr)
      else
 	  display_activescr = scr_nr;
 
+     if (display_flipped) {
+	  /* screens 0 and 1 are switched by a single register write */
+	  if (display_activescr == 0) {
+	       LCDBMEMCTL &= ~LCDDISP;
+	       return;
+	  } else if (display_activescr == 1) {
+	       LCDBMEMCTL |= LCDDISP;
+	       return;
+	  }
+
+	  /* the other screens are in RAM, go back to copying */
+	  display_unflip(prevscr);
+     }
+
      /* allocate memory for previous screen */
-     display_screens[prevscr].segmem = malloc(LCD_MEM_LEN);
-     display_screens[prevscr].blkmem = malloc(LCD_MEM_LEN);
+     display_screens[prevscr].segmem = pool_alloc(&lcd_buffer_pool);
+     display_screens[prevscr].blkmem = pool_alloc(&lcd_buffer_pool);
 
      /* copy real screen contents to previous screen */
      memcpy(display_screens[prevscr].segmem, LCD_SEG_MEM, LCD_MEM_LEN);
@@ -462,8 +504,8 @@ void lcd_screen_activate(uint8_t scr_nr)
      memcpy(LCD_BLK_MEM, display_screens[display_activescr].blkmem, LCD_MEM_LEN);
 
      /* free memory from the activated screen */
-     free(display_screens[display_activescr].segmem);
-     free(display_screens[display_activescr].blkmem);
+     pool_free(&lcd_buffer_pool, display_screens[display_activescr].segmem);
+     pool_free(&lcd_buffer_pool, display_screens[display_activescr].blkmem);
 
      /* set activated screen as real screen output */
      display_screens[display_activescr].segmem = LCD_SEG_MEM;
@@ -539,7 +581,8 @@ char *_sprintf(const char *fmt, int16_t n) {
 	  if (fmt[i] == 'x') {
 	       do {
 		    sprintf_str[j--] = "0123456789ABCDEF"[n & 0x0F];
-		    n >>= 4;
+		    /* unsigned, addresses above 0x7fff too */
+		    n = (uint16_t)n >> 4;
 		    digits--;
 	       } while (n > 0);
 	  } else {
@@ -585,6 +628,9 @@ char *_itopct(uint32_t low,uint32_t high,uint32_t n)
 
 void display_symbol(uint8_t scr_nr, enum display_segment symbol, enum display_segstate state)
 {
+     if (display_flipped && (state & BLINK_SET))
+	  display_unflip(display_activescr);
+
      if (symbol <= LCD_SEG_L2_DP) {
 	  // Get LCD memory address for symbol from table
 	  uint8_t *segmem = (uint8_t *)segments_lcdmem[symbol];
@@ -610,6 +656,9 @@ void display_symbol(uint8_t scr_nr, enum display_segment symbol, enum display_se
 void display_bits(uint8_t scr_nr, enum display_segment segment,
                   uint8_t bits  , enum display_segstate state)
 {
+     if (display_flipped && (state & BLINK_SET))
+	  display_unflip(display_activescr);
+
      // Write to single 7-segment character
      if ((segment >= LCD_SEG_L1_3) && (segment <= LCD_SEG_L2_DP)) {
 	  // Get LCD memory address for segment from table
@@ -641,16 +690,7 @@ void display_bits(uint8_t scr_nr, enum display_segment segment,
 void display_char(uint8_t scr_nr, enum display_segment segment,
                   char chr, enum display_segstate state)
 {
-     uint8_t bits = 0;       // Bits to write (default ' ' blank)
- 
-     // Get bits from font set
-     if (chr >= LCD_FONT_START_CHAR && chr <= LCD_FONT_END_CHAR) {
-	  // Use font set
-	  bits = lcd_font[chr - LCD_FONT_START_CHAR];
-     } else if (chr == 0x2D) {
-	  // '-' not in font set
-	  bits = BIT1;
-     }
+     uint8_t bits = font_bits(chr);
  
      // When addressing LCD_SEG_L2_5, need to convert ASCII '1' and 'L' to 1 bit,
      // because LCD COM/SEG assignment is special for this incomplete character
@@ -680,6 +720,115 @@ void display_chars(uint8_t scr_nr,
      }
 }
 
+void display_pattern(uint8_t scr_nr,
+		     struct display_pattern const *pattern,
+		     enum display_segstate state)
+{
+     uint8_t *segmem = LCD_SEG_MEM;
+     uint8_t *blkmem = LCD_BLK_MEM;
+     uint8_t segment = pattern->first;
+     uint8_t i = 0;
+
+     if (display_flipped && (state & BLINK_SET))
+	  display_unflip(display_activescr);
+
+     if (display_screens) {
+	  segmem = display_screens[scr_nr].segmem;
+	  blkmem = display_screens[scr_nr].blkmem;
+     }
+
+     /* font lookup and nibble swap were done by the compiler */
+     for (; i < pattern->len; i++, segment++) {
+	  uint8_t offset = segments_lcdmem[segment] - LCD_MEM_1;
+
+	  write_lcd_mem(segmem + offset, blkmem + offset, pattern->bits[i],
+			segments_bitmask[segment], state);
+     }
+}
+
+/* draws the next frame on the shown screen, which is the blinking memory
+   while flipped to screen 1 */
+static void marquee_step(void)
+{
+     uint8_t *bits = &marquee.glyphs[marquee.frame];
+     uint8_t *segmem = LCD_SEG_MEM;
+     uint8_t segment = marquee.first;
+     uint8_t i = 0;
+
+     if (display_screens)
+	  segmem = display_screens[display_activescr].segmem;
+
+     for (; i < marquee.width; i++, segment++) {
+	  uint8_t *seg = segmem + (segments_lcdmem[segment] - LCD_MEM_1);
+
+	  *seg = (*seg & ~segments_bitmask[segment]) | bits[i];
+     }
+
+     if (++marquee.frame == marquee.frames)
+	  marquee.frame = 0;
+}
+
+/* steps from the main loop, so the frames don't race the other writes to
+   the LCD memory */
+static PT_THREAD(marquee_thread(struct pt *pt))
+{
+     PT_BEGIN(pt);
+     for (;;) {
+	  marquee_step();
+	  PT_SLEEP(pt, marquee.period);
+     }
+     PT_END(pt);
+}
+
+static PT_TASK_DEFINE(marquee_task, marquee_thread);
+
+void display_marquee_start(enum display_segment_array segments,
+			   char const *str, uint8_t hz)
+{
+     uint8_t len = 0;
+
+     display_marquee_stop();
+
+     marquee.first = LCD_SEG_ARRAY_FIRST(segments);
+     marquee.width = LCD_SEG_ARRAY_LEN(segments);
+
+     /* the half digit can't show most characters, leave it out */
+     if (marquee.first == LCD_SEG_L2_5) {
+	  marquee.first++;
+	  marquee.width--;
+     }
+
+     /* render the string once, already swapped for line 2 */
+     for (; len < DISPLAY_MARQUEE_MAX_LEN; len++) {
+	  uint8_t bits = 0;
+
+	  if (*str)
+	       bits = font_bits(*str++);
+	  else if (len >= marquee.width)
+	       break;
+
+	  if (marquee.first >= LCD_SEG_L2_5)
+	       bits = SWAP_NIBBLE(bits);
+	  marquee.glyphs[len] = bits;
+     }
+
+     marquee.frames = len - marquee.width + 1;
+     marquee.frame = 0;
+
+     if (hz < 1)
+	  hz = 1;
+     if (hz > 50)
+	  hz = 50;
+     marquee.period = 1000 / hz;
+
+     pt_start(&marquee_task);
+}
+
+void display_marquee_stop(void)
+{
+     pt_stop(&marquee_task);
+}
+
 // *************************************************************************************************
 // @fn          start_blink
 // @brief       Start blinking.
@@ -688,6 +837,9 @@ void display_chars(uint8_t scr_nr,
 // *************************************************************************************************
 void start_blink(void)
 {
+     if (display_flipped)
+	  display_unflip(display_activescr);
+
      LCDBBLKCTL |= LCDBLKMOD0;
 }
 
@@ -712,5 +864,8 @@ void stop_blink(void)
 // *************************************************************************************************
 void clear_blink_mem(void)
 {
+     if (display_flipped)
+	  display_unflip(display_activescr);
+
      LCDBMEMCTL |= LCDCLRBM;
 }
@@ -148,6 +148,87 @@ enum display_segment_array {
      LCD_SEG_L2_1_0          =   0x12, /*!< line2, segments 1-0 */
 };
 
+/* 7-segment character bit assignments
+   A
+   F   B
+   G
+   E   C
+   D
+*/
+#define SEG_A     (BIT4)
+#define SEG_B     (BIT5)
+#define SEG_C     (BIT6)
+#define SEG_D     (BIT7)
+#define SEG_E     (BIT2)
+#define SEG_F     (BIT0)
+#define SEG_G     (BIT1)
+
+/* Swap nibble */
+#define SWAP_NIBBLE(x)              ((((x) << 4) & 0xF0) | (((x) >> 4) & 0x0F))
+
+/* Font for characters '0' to '_', as X(arg, character, segment bits).
+   It builds the lcd_font table in display.c and lets #LCD_GLYPH() look up
+   characters at compile time. */
+#define LCD_FONT(X, arg)						\
+     X(arg, '0',  SEG_A + SEG_B + SEG_C + SEG_D + SEG_E + SEG_F        ) \
+     X(arg, '1',          SEG_B + SEG_C                                ) \
+     X(arg, '2',  SEG_A + SEG_B +         SEG_D + SEG_E +         SEG_G) \
+     X(arg, '3',  SEG_A + SEG_B + SEG_C + SEG_D +                 SEG_G) \
+     X(arg, '4',          SEG_B + SEG_C +                 SEG_F + SEG_G) \
+     X(arg, '5',  SEG_A +         SEG_C + SEG_D +         SEG_F + SEG_G) \
+     X(arg, '6',  SEG_A +         SEG_C + SEG_D + SEG_E + SEG_F + SEG_G) \
+     X(arg, '7',  SEG_A + SEG_B + SEG_C                                ) \
+     X(arg, '8',  SEG_A + SEG_B + SEG_C + SEG_D + SEG_E + SEG_F + SEG_G) \
+     X(arg, '9',  SEG_A + SEG_B + SEG_C + SEG_D +         SEG_F + SEG_G) \
+     X(arg, ':',  0                                                    ) \
+     X(arg, ';',  0                                                    ) \
+     X(arg, '<',  SEG_A +                                 SEG_F + SEG_G) /* high c */ \
+     X(arg, '=',                          SEG_D +                 SEG_G) \
+     X(arg, '>',  0                                                    ) \
+     X(arg, '?',  SEG_A + SEG_B +                 SEG_E +         SEG_G) \
+     X(arg, '@',  0                                                    ) \
+     X(arg, 'A',  SEG_A + SEG_B + SEG_C +         SEG_E + SEG_F + SEG_G) \
+     X(arg, 'B',                  SEG_C + SEG_D + SEG_E + SEG_F + SEG_G) /* b */ \
+     X(arg, 'C',                          SEG_D + SEG_E +         SEG_G) /* c */ \
+     X(arg, 'D',          SEG_B + SEG_C + SEG_D + SEG_E +         SEG_G) /* d */ \
+     X(arg, 'E',  SEG_A +                 SEG_D + SEG_E + SEG_F + SEG_G) \
+     X(arg, 'F',  SEG_A +                         SEG_E + SEG_F + SEG_G) /* f */ \
+     X(arg, 'G',  SEG_A + SEG_B + SEG_C + SEG_D +         SEG_F + SEG_G) /* g, same as 9 */ \
+     X(arg, 'H',                  SEG_C +         SEG_E + SEG_F + SEG_G) /* h */ \
+     X(arg, 'I',                                  SEG_E                ) /* i */ \
+     X(arg, 'J',  SEG_A + SEG_B + SEG_C + SEG_D                        ) \
+     X(arg, 'K',                          SEG_D +         SEG_F + SEG_G) /* k */ \
+     X(arg, 'L',                          SEG_D + SEG_E + SEG_F        ) \
+     X(arg, 'M',  SEG_A + SEG_B + SEG_C +         SEG_E + SEG_F        ) \
+     X(arg, 'N',                  SEG_C +         SEG_E +         SEG_G) /* n */ \
+     X(arg, 'O',                  SEG_C + SEG_D + SEG_E +         SEG_G) /* o */ \
+     X(arg, 'P',  SEG_A + SEG_B +                 SEG_E + SEG_F + SEG_G) \
+     X(arg, 'Q',  SEG_A + SEG_B + SEG_C +                 SEG_F + SEG_G) /* q */ \
+     X(arg, 'R',                                  SEG_E +         SEG_G) /* r */ \
+     X(arg, 'S',  SEG_A +         SEG_C + SEG_D +         SEG_F + SEG_G) /* same as 5 */ \
+     X(arg, 'T',                          SEG_D + SEG_E + SEG_F + SEG_G) /* t */ \
+     X(arg, 'U',                  SEG_C + SEG_D + SEG_E                ) /* u */ \
+     X(arg, 'V',                  SEG_C + SEG_D + SEG_E                ) /* v, same as u */ \
+     X(arg, 'W',          SEG_B + SEG_C + SEG_D + SEG_E + SEG_F + SEG_G) \
+     X(arg, 'X',          SEG_B + SEG_C +         SEG_E + SEG_F + SEG_G) /* as H */ \
+     X(arg, 'Y',          SEG_B + SEG_C + SEG_D +         SEG_F + SEG_G) \
+     X(arg, 'Z',  SEG_A + SEG_B +         SEG_D + SEG_E +         SEG_G) /* same as 2 */ \
+     X(arg, '[',          SEG_B +                 SEG_E +         SEG_G) /* as _|` */ \
+     X(arg, '\\', SEG_A + SEG_B +                         SEG_F + SEG_G) \
+     X(arg, ']',                  SEG_C +                 SEG_F + SEG_G) /* as `|_ */ \
+     X(arg, '^',  SEG_A                                                ) \
+     X(arg, '_',                          SEG_D                        )
+
+#define LCD_GLYPH_CASE(c, chr, bits) (c) == (chr) ? (bits) :
+/*!
+  \brief Segment bits of character <i>c</i>, as a constant expression when <i>c</i> is one
+  \details Same bits as #display_char() uses, '-' included. Characters outside of the font are blank.
+*/
+#define LCD_GLYPH(c) (LCD_FONT(LCD_GLYPH_CASE, c) (c) == '-' ? SEG_G : 0)
+
+/*! size of the segment and of the blinking memory, in bytes */
+#define LCD_MEM_LEN 12
+
 /*!
   \brief Virtual LCD screen
   \sa #lcd_screens_create()
@@ -167,6 +248,8 @@ struct lcd_screen {
 
   After creating the virtual screens using this function, the screen 0 is always selected as the active screen. This means that any writes to screen 0 will actually be imediately displayed on the real screen, while writes to other screens will be saved until lcd_screen_activate() is called.
   \note Each virtual screen takes 24bytes of memory. It is less than the code that you would actually need to write to handle the cases where these functions are meant to be used. However, RAM memory on the ez430 chronos is limited too so don't use a bazilion of screens.
+  \note The screens come from fixed pools sized by tools/make_modinit.py for the largest <i>nr</i> passed here by an enabled module. Asking for more halts the watch, see pool_alloc().
+  \note With CONFIG_LCD_FLIP, screen 1 is kept in the LCD blinking memory while nothing blinks, so switching between screens 0 and 1 only flips LCDDISP. Blinking a segment or activating another screen moves it back to RAM.
   \note Never, ever forget to destroy the created screens using lcd_screens_destroy() !
   \sa lcd_screens_destroy(), lcd_screen_activate()
 */
@@ -285,6 +368,99 @@ void display_chars(
      enum display_segstate state /*!< A bitfield with state operations to be performed on the segment */
      );
 
+/*!
+  \brief Segments of a string rendered at compile time
+  \details Holds the bits #display_chars() would compute for a constant string, already nibble swapped for line 2. Create it with #DISPLAY_PATTERN() and draw it with #display_pattern().
+*/
+struct display_pattern {
+     uint8_t first; /*!< the #display_segment of the leftmost character */
+     uint8_t len; /*!< the number of characters */
+     uint8_t bits[6]; /*!< the segment bits of each character, leftmost first */
+};
+
+/* first segment and number of segments of a #display_segment_array */
+#define LCD_SEG_ARRAY_FIRST(segments) (LCD_SEG_L2_0 - ((segments) >> 4))
+#define LCD_SEG_ARRAY_LEN(segments) ((segments) & 0x0f)
+
+/* i-th character of the string literal str, '\0' past its end */
+#define LCD_STR_CHAR(str, i)						\
+     (sizeof(str) > (i) ? (str)[sizeof(str) > (i) ? (i) : 0] : '\0')
+
+/* bits written by display_char() to the i-th segment of segments */
+#define LCD_PATTERN_BITS(segments, str, i)				\
+     ((i) >= LCD_SEG_ARRAY_LEN(segments) ? 0 :				\
+      LCD_SEG_ARRAY_FIRST(segments) + (i) == LCD_SEG_L2_5		\
+      && (LCD_STR_CHAR(str, i) == '1' || LCD_STR_CHAR(str, i) == 'L') ? BIT7 : \
+      LCD_SEG_ARRAY_FIRST(segments) + (i) >= LCD_SEG_L2_5 ?		\
+      SWAP_NIBBLE(LCD_GLYPH(LCD_STR_CHAR(str, i))) :			\
+      LCD_GLYPH(LCD_STR_CHAR(str, i)))
+
+/*!
+  \brief Initializer of a #display_pattern showing the string literal <i>str</i> at <i>segments</i>
+  \details The compiler folds the font lookups, so the pattern costs 8 bytes of flash and no code:
+  \code
+  static const struct display_pattern stop = DISPLAY_PATTERN(LCD_SEG_L1_3_0, "STOP");
+  \endcode
+  Like #display_chars(), a string shorter than <i>segments</i> leaves the remaining segments untouched.
+*/
+#define DISPLAY_PATTERN(segments, str) {				\
+	  LCD_SEG_ARRAY_FIRST(segments),				\
+	  sizeof(str) - 1 < LCD_SEG_ARRAY_LEN(segments) ?		\
+	  sizeof(str) - 1 : LCD_SEG_ARRAY_LEN(segments),		\
+	  { LCD_PATTERN_BITS(segments, str, 0),				\
+	    LCD_PATTERN_BITS(segments, str, 1),				\
+	    LCD_PATTERN_BITS(segments, str, 2),				\
+	    LCD_PATTERN_BITS(segments, str, 3),				\
+	    LCD_PATTERN_BITS(segments, str, 4),				\
+	    LCD_PATTERN_BITS(segments, str, 5) } }
+
+/*!
+  \brief Displays a pre-rendered string
+  \details Same result as #display_chars() with the string the pattern was made from, but the bits are copied straight into the segment memory.
+  \sa #DISPLAY_PATTERN(), #display_label()
+*/
+void display_pattern(
+     uint8_t scr_nr, /*!< the virtual screen number where to display */
+     struct display_pattern const *pattern, /*!< the pattern to display */
+     enum display_segstate state /*!< A bitfield with state operations to be performed on the segment */
+     );
+
+/*!
+  \brief Displays a string literal through #display_pattern()
+  \details Drop-in replacement for #display_chars() when <i>str</i> is a string literal, the pattern is rendered at compile time.
+*/
+#define display_label(scr_nr, segments, str, state) do {		\
+	  static const struct display_pattern __pattern =		\
+	       DISPLAY_PATTERN(segments, str);				\
+	  display_pattern((scr_nr), &__pattern, (state));		\
+     } while (0)
+
+/*! longest string shown by #display_marquee_start() */
+#define DISPLAY_MARQUEE_MAX_LEN 40
+
+/*!
+  \brief Scrolls a string through a segment array
+  \details The string is rendered once, then a protothread of the main loop shows the next window of it <i>hz</i> times per second until #display_marquee_stop() is called.
+  Example:
+  \code
+  // scrolls "HELLO WORLD" through the second line at 4Hz
+  display_marquee_start(LCD_SEG_L2_4_0, "HELLO WORLD", 4);
+  \endcode
+  \note The marquee draws on the shown screen and owns the segments until stopped, don't write to them meanwhile. Strings longer than #DISPLAY_MARQUEE_MAX_LEN are cut and LCD_SEG_L2_5 is skipped.
+  \sa pt_start()
+*/
+void display_marquee_start(
+     enum display_segment_array segments, /*!< A segment array */
+     char const *str, /*!< the string to scroll, it can be discarded after the call */
+     uint8_t hz /*!< frames per second, clamped to 1 .. 50 */
+     );
+
+/*!
+  \brief Stops the marquee started by #display_marquee_start()
+  \details The last frame stays on the screen.
+*/
+void display_marquee_stop(void);
+
 /*!
   \brief Displays a symbol
   \details Changes the <i>state</i> of the segment of <i>symbol</i>. If no virtual screens are created, the argument <i>scr_nr</i> is ignored, otherwise it selects which screen the operation will affect.
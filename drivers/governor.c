@@ -0,0 +1,122 @@
+/**
+    drivers/governor.c: Openchronos clock and core voltage governor
+
+    Copyright (C) 2026 openchronos-ng contributors
+
+    http://github.com/BenjaminSoelberg/openchronos-ng-elf
+
+    This file is part of openchronos-ng.
+
+    openchronos-ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    openchronos-ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "governor.h"
+
+#ifdef CONFIG_GOVERNOR
+
+#include "pmm.h"
+#include "timer.h"
+#include "utils.h"
+#include "energy.h"
+
+/* FLL multiplier for GOVERNOR_LOW_MHZ, (N + 1) x 32768Hz. The DCO stays in
+   DCORSEL_5 at 8MHz, FLLD_1 halves it for DCOCLKDIV */
+#define GOVERNOR_LOW_FLLN (GOVERNOR_LOW_MHZ * 1000000ul / 32768 - 1)
+
+/* 32 x 32 / 32768Hz, rounded up */
+#define GOVERNOR_SETTLE_MS 32
+
+enum governor_level {
+     GOVERNOR_LOW,
+     GOVERNOR_HIGH
+};
+
+static struct {
+     /* MCLK */
+     uint8_t mhz;
+     /* PMMCOREV, level 0 runs up to 8MHz */
+     uint8_t vcore;
+     /* UCSCTL2 */
+     uint16_t flln;
+     /* UCSCTL0 the last time the FLL ran at this level */
+     uint16_t dco;
+} levels[] = {
+     [GOVERNOR_LOW]  = { GOVERNOR_LOW_MHZ, 0, FLLD_1 + GOVERNOR_LOW_FLLN, 0 },
+     /* what boot.c sets up */
+     [GOVERNOR_HIGH] = { GOVERNOR_HIGH_MHZ, 3, FLLD_1 + 0x16E, 0 },
+};
+
+static enum governor_level level = GOVERNOR_HIGH;
+static uint8_t boosts;
+
+static void governor_switch(enum governor_level to)
+{
+     enum governor_level from = level;
+
+     /* the core voltage goes up before the frequency... */
+     if (levels[to].vcore > levels[from].vcore)
+	  SetVCore(levels[to].vcore);
+
+     /* jump to the taps the FLL locked on last time, the FLL is stopped
+	so it does not move the DCO while the multiplier changes */
+     _BIS_SR(SCG0);
+     levels[from].dco = UCSCTL0;
+     UCSCTL2 = levels[to].flln;
+     UCSCTL0 = levels[to].dco;
+     _BIC_SR(SCG0);
+     level = to;
+     energy_mclk(levels[to].mhz);
+
+     /* ...and down after it */
+     if (levels[to].vcore < levels[from].vcore)
+	  SetVCore(levels[to].vcore);
+}
+
+void governor_init(void)
+{
+     levels[GOVERNOR_HIGH].dco = UCSCTL0;
+
+     /* no taps for the low level yet, let the FLL find them. Worst case
+	settling is 32 x 32 / f_FLL_reference, see initialize_cpu_12mhz().
+	The FLL keeps running in LPM0, no need to spin for it */
+     UCSCTL2 = levels[GOVERNOR_LOW].flln;
+     timer0_delay(GOVERNOR_SETTLE_MS, LPM0_bits);
+     level = GOVERNOR_LOW;
+     energy_mclk(GOVERNOR_LOW_MHZ);
+
+     /* the frequency is down, now the core voltage can follow */
+     SetVCore(levels[GOVERNOR_LOW].vcore);
+}
+
+void governor_boost(void)
+{
+     uint16_t int_state;
+
+     ENTER_CRITICAL_SECTION(int_state);
+     if (boosts++ == 0 && level != GOVERNOR_HIGH)
+	  governor_switch(GOVERNOR_HIGH);
+     EXIT_CRITICAL_SECTION(int_state);
+}
+
+void governor_release(void)
+{
+     uint16_t int_state;
+
+     ENTER_CRITICAL_SECTION(int_state);
+     if (boosts && --boosts == 0)
+	  governor_switch(GOVERNOR_LOW);
+     EXIT_CRITICAL_SECTION(int_state);
+}
+
+#endif
@@ -0,0 +1,79 @@
+/**
+    drivers/governor.h: Openchronos clock and core voltage governor
+
+    Copyright (C) 2026 openchronos-ng contributors
+
+    http://github.com/BenjaminSoelberg/openchronos-ng-elf
+
+    This file is part of openchronos-ng.
+
+    openchronos-ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    openchronos-ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+/*!
+  \file governor.h
+  \brief openchronos-ng clock and core voltage governor
+  \details Boot sets MCLK and SMCLK to 12MHz at core voltage level 3. With
+  CONFIG_GOVERNOR the governor drops them to #GOVERNOR_LOW_MHZ at level 0
+  once the first clock frame is shown, which is enough for the wakeups of the
+  main loop. Code that needs the speed, or a 12MHz SMCLK like the buzzer and
+  the radio, runs between governor_boost() and governor_release().<br />
+  The voltage is raised before the frequency and lowered after it, and each
+  level restarts the DCO from the taps the FLL last locked on, so no switch
+  waits for the FLL to settle.
+  \note Without CONFIG_GOVERNOR the functions do nothing.
+*/
+
+#include "openchronos.h"
+
+#ifndef __GOVERNOR_H__
+#define __GOVERNOR_H__
+
+/*! MCLK between boosts, in MHz */
+#define GOVERNOR_LOW_MHZ 4
+
+/*! MCLK during boosts and without CONFIG_GOVERNOR, in MHz */
+#define GOVERNOR_HIGH_MHZ 12
+
+#ifdef CONFIG_GOVERNOR
+
+/*!
+  \brief Captures the DCO taps of both levels and switches to the low one.
+  \details This functions is called once after the first clock frame is
+  shown, before any boost. It sleeps 32ms in LPM0 while the FLL settles.
+  \note Modules are strictly forbidden to call this function.
+  \internal
+*/
+void governor_init(void);
+
+/*!
+  \brief Runs at 12MHz until the matching governor_release().
+  \details Calls nest, and both may be called from interrupts.
+*/
+void governor_boost(void);
+
+/*!
+  \brief Ends a governor_boost().
+*/
+void governor_release(void);
+
+#else
+
+static inline void governor_init(void) { }
+static inline void governor_boost(void) { }
+static inline void governor_release(void) { }
+
+#endif
+
+#endif /* __GOVERNOR_H__ */
@@ -0,0 +1,64 @@
+/**
+    drivers/irqtrace.c: Openchronos interrupt trace recorder
+
+    Copyright (C) 2026 openchronos-ng contributors
+
+    http://github.com/BenjaminSoelberg/openchronos-ng-elf
+
+    This file is part of openchronos-ng.
+
+    openchronos-ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    openchronos-ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "irqtrace.h"
+
+#ifdef CONFIG_IRQ_TRACE
+
+struct irqtrace irqtrace;
+
+/* TA0R of the last record, and the P2IN it saw */
+static uint16_t last;
+static uint8_t last_p2in;
+
+static void irqtrace_put(uint16_t now, uint8_t source, uint8_t data)
+{
+     struct irqtrace_record *r;
+
+     if (irqtrace.count == CONFIG_IRQ_TRACE_RECORDS) {
+	  irqtrace.dropped++;
+	  return;
+     }
+
+     r = &irqtrace.records[irqtrace.count++];
+     r->ticks = now - last;
+     r->source = source;
+     r->data = data;
+     last = now;
+}
+
+/* called from the handlers only, they don't nest */
+void irqtrace_record(enum irqtrace_source source, uint8_t data)
+{
+     uint16_t now = TA0R;
+     uint8_t p2in = P2IN;
+
+     if (p2in != last_p2in) {
+	  irqtrace_put(now, IRQTRACE_P2IN, p2in);
+	  last_p2in = p2in;
+     }
+
+     irqtrace_put(now, source, data);
+}
+
+#endif
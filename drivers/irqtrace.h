@@ -0,0 +1,93 @@
+/**
+    drivers/irqtrace.h: Openchronos interrupt trace recorder
+
+    Copyright (C) 2026 openchronos-ng contributors
+
+    http://github.com/BenjaminSoelberg/openchronos-ng-elf
+
+    This file is part of openchronos-ng.
+
+    openchronos-ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    openchronos-ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+/*!
+  \file irqtrace.h
+  \brief openchronos-ng interrupt trace recorder
+  \details With CONFIG_IRQ_TRACE the RTC, PORT2 and TIMER0 interrupt
+  handlers record what woke them up into #irqtrace, from boot until
+  #CONFIG_IRQ_TRACE_RECORDS records are taken. Each record holds the TA0
+  ticks since the previous one, the source and one byte of data:
+  <ul>
+    <li>#IRQTRACE_RTC: RTCIV / 2 in bits 7-6, RTCSEC in bits 5-0</li>
+    <li>#IRQTRACE_PORT2: P2IFG</li>
+    <li>#IRQTRACE_TIMER0_A0: nothing</li>
+    <li>#IRQTRACE_TIMER0_A1: TA0IV</li>
+    <li>#IRQTRACE_P2IN: P2IN, recorded before the interrupt it changed for</li>
+  </ul>
+  The TA0 overflow interrupt is enabled while tracing, so no two records
+  are more than 4 seconds apart. Save the structure with e.g.
+  <i>mspdebug rf2500 "save_raw irqtrace 516 trace.bin"</i> and replay it
+  on the host with tools/irqtrace.py, which also documents the text format.
+  \note Without CONFIG_IRQ_TRACE irqtrace_record() does nothing.
+*/
+
+#include "openchronos.h"
+
+#ifndef __IRQTRACE_H__
+#define __IRQTRACE_H__
+
+/*! what woke up the CPU, the values are part of the trace format */
+enum irqtrace_source {
+     IRQTRACE_WAIT = 0,		/*!< nothing, only time passed */
+     IRQTRACE_P2IN = 1,		/*!< input levels of port 2 changed */
+     IRQTRACE_RTC = 2,		/*!< RTC_A_ISR() */
+     IRQTRACE_PORT2 = 3,	/*!< PORT2_ISR(), buttons and sensors */
+     IRQTRACE_TIMER0_A0 = 4,	/*!< timer0_A0_ISR(), the 20Hz timer */
+     IRQTRACE_TIMER0_A1 = 5,	/*!< timer0_A1_ISR(), the other compares */
+};
+
+#ifdef CONFIG_IRQ_TRACE
+
+/*! one interrupt, 4 bytes */
+struct irqtrace_record {
+     /*! TA0 ticks (1/16384 s) since the previous record */
+     uint16_t ticks;
+     /*! #irqtrace_source */
+     uint8_t source;
+     uint8_t data;
+};
+
+/*! the trace as saved from RAM, little endian */
+struct irqtrace {
+     /*! records taken */
+     uint16_t count;
+     /*! interrupts that found the trace full */
+     uint16_t dropped;
+     struct irqtrace_record records[CONFIG_IRQ_TRACE_RECORDS];
+};
+
+extern struct irqtrace irqtrace;
+
+/*!
+  \brief Records an interrupt, called first thing by the handlers.
+*/
+void irqtrace_record(enum irqtrace_source source, uint8_t data);
+
+#else
+
+static inline void irqtrace_record(enum irqtrace_source source, uint8_t data) { }
+
+#endif
+
+#endif /* __IRQTRACE_H__ */
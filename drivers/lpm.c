@@ -23,6 +23,7 @@
 
 #include "lpm.h"
 #include "buzzer.h"
+#include "energy.h"
 
 void enter_lpm_gie(uint16_t LPM_bits) {
      if (is_buzzer_playing()) {
@@ -30,6 +31,8 @@ void enter_lpm_gie(uint16_t LPM_bits) {
 	  LPM_bits = LPM0_bits;
      }
 
+     energy_lpm(LPM_bits);
+
      /* Go to LPMx & wait for interrupts */
      _BIS_SR(LPM_bits | GIE);
      __no_operation();
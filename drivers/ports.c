@@ -29,12 +29,15 @@
 #include "ports.h"
 #include "timer.h"
 #include "utils.h"
+#include "irqtrace.h"
 
 #include "as.h"
 #include "ps.h"
 
 #define ALL_BUTTONS 0x1F
 
+EVQUEUE_DEFINE(ports_events, 8);
+
 /* contains buttons currently held down */
 volatile enum ports_buttons ports_down_btns;
 
@@ -148,7 +151,7 @@ void ports_buttons_clear(void)
 */
 void ports_buttons_poll(void)
 {
-     if (timer0_last_event | TIMER0_EVENT_20HZ && timer_20Hz_started)
+     if (timer_20Hz_started)
 	  callback_20Hz();
 }
 
@@ -161,6 +164,8 @@ void ports_buttons_poll(void)
 __attribute__((interrupt(PORT2_VECTOR)))
 void PORT2_ISR(void)
 {
+     irqtrace_record(IRQTRACE_PORT2, P2IFG);
+
      /* If the interrupt is a button press */
      if (P2IFG & ALL_BUTTONS) {
 	  /* turn on 20 Hz callback*/
@@ -171,13 +176,17 @@ void PORT2_ISR(void)
 	  }
      }
 
-     /* Handle accelerometer */
-     /* Check if accelerometer interrupt flag */
+     /* Handle accelerometer and pressure sensor */
+     uint8_t ev = 0;
+
      if ((P2IFG & AS_INT_PIN) == AS_INT_PIN)
-	  as_last_interrupt = 1;
+	  ev |= PORTS_EV_AS;
 
      if ((P2IFG & PS_INT_PIN) == PS_INT_PIN)
-	  ps_last_interrupt = 1;
+	  ev |= PORTS_EV_PS;
+
+     if (ev)
+	  evqueue_put(&ports_events, ev, P2IN);
 
      /* A write to the interrupt vector, automatically clears the
 	latest interrupt */
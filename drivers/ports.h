@@ -61,6 +61,7 @@
 
 #include <stdbool.h>
 #include "config.h"
+#include "evqueue.h"
 
 /* Button ports */
 #define PORTS_BTN_DOWN_PIN      (BIT0)
@@ -87,6 +88,15 @@ enum ports_buttons {
      PORTS_BTN_LUP       = BIT9,
 };
 
+/* Sensor interrupts queued in ports_events, data holds P2IN */
+enum ports_event {
+     PORTS_EV_AS         = BIT0, /* acceleration sensor CMA_INT */
+     PORTS_EV_PS         = BIT1, /* pressure sensor DRDY */
+};
+
+/* exclusive use by openchronos system */
+extern struct evqueue ports_events;
+
 /* Global keypress peek, should normally NOT use be used, unless a global hook is needed */
 uint8_t ports_button_pressed_peek(uint8_t btn, uint8_t with_longpress);
 bool is_ports_button_pressed();
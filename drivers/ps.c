@@ -44,6 +44,7 @@
 // driver
 #include "ps.h"
 #include "timer.h"
+#include "governor.h"
 
 // *************************************************************************************************
 // Prototypes section
@@ -77,9 +78,6 @@ void ps_init(void)
      PS_INT_IES &= ~PS_INT_PIN;           // Interrupt on EOC rising edge
      PS_I2C_OUT |= PS_SCL_PIN + PS_SDA_PIN; // SCL and SDA are high by default
      PS_I2C_DIR |= PS_SCL_PIN + PS_SDA_PIN; // SCL and SDA are outputs by default
-
-     // 100msec delay to guarantee stable operation
-     timer0_delay(10, LPM3_bits);
 }
 
 // *************************************************************************************************
@@ -267,52 +265,58 @@ uint8_t ps_write_register(uint8_t device, uint8_t address, uint8_t data)
 // *************************************************************************************************
 uint16_t ps_read_register(uint8_t device, uint8_t address, uint8_t mode)
 {
-     uint8_t success;
-     uint16_t data = 0;
+     uint8_t data[2] = { 0, 0 };
+
+     if (mode == PS_I2C_16BIT_ACCESS)
+     {
+	  ps_read_burst(device, address, data, 2);
+	  return ((data[0] << 8) | data[1]);      // MSB comes first
+     }
 
+     ps_read_burst(device, address, data, 1);
+     return (data[0]);
+}
+
+// *************************************************************************************************
+// @fn          ps_read_burst
+// @brief       Read consecutive registers from the pressure sensor in one transaction
+// @param       uint8_t device               Device address
+//              uint8_t address              First register address
+//              uint8_t * data               Register contents, in address order
+//              uint8_t len                  Number of registers, at least 1
+// @return      uint8_t                      1=Success, 0=Device did not acknowledge
+// *************************************************************************************************
+uint8_t ps_read_burst(uint8_t device, uint8_t address, uint8_t * data, uint8_t len)
+{
      ps_i2c_sda(PS_I2C_SEND_START);               // Generate start condition
 
      ps_i2c_write(device | PS_I2C_WRITE);         // Send 7bit device address + r/w bit '0' -> write
-     success = ps_i2c_sda(PS_I2C_CHECK_ACK);      // Check ACK from device
-     if (!success)
-	  return (0);
+     if (!ps_i2c_sda(PS_I2C_CHECK_ACK))           // Check ACK from device
+	  goto nack;
 
      ps_i2c_write(address);                       // Send 8bit register address
-     success = ps_i2c_sda(PS_I2C_CHECK_ACK);      // Check ACK from device
-     if (!success)
-	  return (0);
+     if (!ps_i2c_sda(PS_I2C_CHECK_ACK))           // Check ACK from device
+	  goto nack;
 
      ps_i2c_sda(PS_I2C_SEND_RESTART);             // Generate restart condition
 
      ps_i2c_write(device | PS_I2C_READ);          // Send 7bit device address + r/w bit '1' -> read
-     success = ps_i2c_sda(PS_I2C_CHECK_ACK);      // Check ACK from device
-     if (!success)
-	  return (0);
+     if (!ps_i2c_sda(PS_I2C_CHECK_ACK))           // Check ACK from device
+	  goto nack;
 
-     if (mode == PS_I2C_16BIT_ACCESS)
-     {
-	  data = ps_i2c_read(1) << 8;              // Read MSB 8bit data from register
-	  data |= ps_i2c_read(0);                  // Read LSB 8bit data from register
-     }
-     else
-     {
-	  data = ps_i2c_read(0);                   // Read 8bit data from register
-     }
+     // The device advances the register address after each byte,
+     // ACK keeps it sending, NACK ends the read after the last one
+     while (--len)
+	  *data++ = ps_i2c_read(1);
+     *data = ps_i2c_read(0);
 
      ps_i2c_sda(PS_I2C_SEND_STOP);                // Generate stop condition
 
-     return (data);
-}
+     return (1);
 
-// *************************************************************************************************
-// @fn          ps_i2c_delay
-// @brief       Delay between I2C signal edges.
-// @param       none
-// @return      none
-// *************************************************************************************************
-void ps_i2c_delay(void)
-{
-     asm ("	nop");
+nack:
+     ps_i2c_sda(PS_I2C_SEND_STOP);                // Release the bus
+     return (0);
 }
 
 // *************************************************************************************************
@@ -406,6 +410,9 @@ int16_t conv_pa_to_meter(uint32_t p_meas, uint16_t t_meas)
      volatile float fl_p_meas = (float)p_meas / 100;     // Convert from Pa to hPa
      volatile float fl_t_meas = (float)t_meas / 10;      // Convert from 10 K to 1 K
 
+     // Software floating point, worth the 12MHz
+     governor_boost();
+
      for (i = 0; i <= 16; i++)
      {
 	  if (p[i] < fl_p_meas)
@@ -441,6 +448,8 @@ int16_t conv_pa_to_meter(uint32_t p_meas, uint16_t t_meas)
      fl_h = Invt00 * t0 * hnoll;
      h = (uint16_t) fl_h;
 
+     governor_release();
+
      return (h);
 }
 
@@ -43,17 +43,15 @@
 // Prototypes section
 extern void ps_init(void);
 extern uint8_t ps_i2c_sda(uint8_t ack);
-extern void ps_i2c_delay(void);
 extern void ps_i2c_write(uint8_t data);
 extern uint8_t ps_i2c_read(uint8_t ack);
 extern uint8_t ps_write_register(uint8_t device, uint8_t address, uint8_t data);
 extern uint16_t ps_read_register(uint8_t device, uint8_t address, uint8_t mode);
+extern uint8_t ps_read_burst(uint8_t device, uint8_t address, uint8_t * data, uint8_t len);
 extern void init_pressure_table(void);
 extern void update_pressure_table(int16_t href, uint32_t p_meas, uint16_t t_meas);
 extern int16_t conv_pa_to_meter(uint32_t p_meas, uint16_t t_meas);
 
-volatile uint8_t ps_last_interrupt;
-
 // *************************************************************************************************
 // Defines section
 
@@ -84,6 +82,13 @@ volatile uint8_t ps_last_interrupt;
 #define PS_I2C_SEND_STOP     (2u)
 #define PS_I2C_CHECK_ACK     (3u)
 
+// Delay between I2C signal edges, in MCLK cycles. The shortest SCL low phase, in ps_i2c_read(),
+// is the delay plus the instruction raising SCL and must last the 1.3us tLOW of 400kHz fast mode.
+// Sized for GOVERNOR_HIGH_MHZ: a transfer may run inside any boost, the buzzer and the radio
+// hold one for seconds. At GOVERNOR_LOW_MHZ the bus only runs slower.
+#define PS_I2C_DELAY_CYCLES  (12u)
+#define ps_i2c_delay()       __delay_cycles(PS_I2C_DELAY_CYCLES)
+
 #define PS_I2C_8BIT_ACCESS   (0u)
 #define PS_I2C_16BIT_ACCESS  (1u)
 
@@ -39,7 +39,10 @@
 #include "openchronos.h"
 
 // driver
+#include "radio.h"
 #include "rf1a.h"
+#include "governor.h"
+#include "energy.h"
 
 // *************************************************************************************************
 // Extern section
@@ -47,6 +50,71 @@
 // SimpliciTI CC430 radio ISR - located in SimpliciTi library
 extern void MRFI_RadioIsr(void);
 
+// *************************************************************************************************
+// Defines section
+
+// MARCSTATE values polled while a raw packet is being sent
+#define MARC_STATE_IDLE              (0x01)
+#define MARC_STATE_TXFIFO_UNDERFLOW  (0x16)
+
+// MARCSTATE polls before radio_raw_send() gives up, each one waits at least 1us at the 12MHz the
+// radio holds. A full FIFO takes about 2ms on air, calibration included
+#define RADIO_RAW_SEND_POLLS         (10000u)
+
+// Carrier of the raw packet mode for the CONFIG_ISM band, FREQ = f * 2^16 / 26MHz
+#if CONFIG_ISM == 1
+#define RADIO_RAW_FREQ               (0x22B13Bul)  // US, 902.0 MHz
+#elif CONFIG_ISM == 2
+#define RADIO_RAW_FREQ               (0x216276ul)  // EU, 868.0 MHz
+#elif CONFIG_ISM == 3
+#define RADIO_RAW_FREQ               (0x10B071ul)  // LF, 433.92 MHz
+#else
+#error "CONFIG_ISM must be 1 (US), 2 (EU) or 3 (LF)"
+#endif
+
+// *************************************************************************************************
+// Global Variable section
+
+// Raw packet mode: carrier of the CONFIG_ISM band, 250 kBaud GFSK, variable packet length, CRC
+// appended by the radio.
+// Register values exported from SmartRF Studio for the 26 MHz crystal of the Chronos.
+static const uint8_t radio_raw_settings[][2] = {
+     {IOCFG0,   0x06},                         // GDO0 asserts on sync word, deasserts at end of packet
+     {FIFOTHR,  0x07},
+     {PKTLEN,   RADIO_RAW_MAX_PAYLOAD},
+     {PKTCTRL1, 0x04},                         // Append RSSI/LQI status bytes on the receiving side
+     {PKTCTRL0, 0x05},                         // Variable packet length, CRC enabled
+     {ADDR,     0x00},
+     {CHANNR,   0x00},
+     {FSCTRL1,  0x0C},
+     {FSCTRL0,  0x00},
+     {FREQ2,    (RADIO_RAW_FREQ >> 16) & 0xFF},
+     {FREQ1,    (RADIO_RAW_FREQ >> 8) & 0xFF},
+     {FREQ0,    RADIO_RAW_FREQ & 0xFF},
+     {MDMCFG4,  0x2D},
+     {MDMCFG3,  0x3B},
+     {MDMCFG2,  0x13},
+     {MDMCFG1,  0x22},
+     {MDMCFG0,  0xF8},
+     {DEVIATN,  0x62},
+     {MCSM1,    0x30},                         // Return to IDLE once a packet has been sent
+     {MCSM0,    0x18},                         // Calibrate when going from IDLE to TX
+     {FOCCFG,   0x1D},
+     {BSCFG,    0x1C},
+     {AGCCTRL2, 0xC7},
+     {AGCCTRL1, 0x00},
+     {AGCCTRL0, 0xB0},
+     {FREND1,   0xB6},
+     {FREND0,   0x10},
+     {FSCAL3,   0xEA},
+     {FSCAL2,   0x2A},
+     {FSCAL1,   0x00},
+     {FSCAL0,   0x1F},
+     {TEST2,    0x88},
+     {TEST1,    0x31},
+     {TEST0,    0x09},
+};
+
 // *************************************************************************************************
 // @fn          radio_reset
 // @brief       Reset radio core.
@@ -118,6 +186,10 @@ void radio_sxoff(void)
 // *************************************************************************************************
 void open_radio(void)
 {
+     // The radio core interface runs at 12MHz until close_radio()
+     governor_boost();
+     energy_on(ENERGY_RADIO);
+
      // Reset radio core
      radio_reset();
 
@@ -129,6 +201,64 @@ void open_radio(void)
 
 
 
+// *************************************************************************************************
+// @fn          radio_raw_open
+// @brief       Prepare radio for sending raw packets, bypassing the SimpliciTI stack.
+// @param       none
+// @return      none
+// *************************************************************************************************
+void radio_raw_open(void)
+{
+     uint8_t i;
+
+     // The radio core interface runs at 12MHz until close_radio()
+     governor_boost();
+     energy_on(ENERGY_RADIO);
+
+     radio_reset();
+
+     for (i = 0; i < sizeof(radio_raw_settings) / sizeof(radio_raw_settings[0]); i++)
+	  WriteSingleReg(radio_raw_settings[i][0], radio_raw_settings[i][1]);
+
+     WritePATable(0x50);                       // 0 dBm
+     Strobe(RF_SFTX);
+}
+
+
+// *************************************************************************************************
+// @fn          radio_raw_send
+// @brief       Send one raw packet. The whole frame goes into the TX FIFO with a single burst
+//              write and the function returns once the radio is back to IDLE.
+// @param       uint8_t *packet         packet[0] is the payload length (max. RADIO_RAW_MAX_PAYLOAD),
+//                                      followed by the payload itself
+// @return      uint8_t                 1 if the packet went out, 0 if the radio did not return to
+//                                      IDLE in time. The TX FIFO is flushed either way
+// *************************************************************************************************
+uint8_t radio_raw_send(uint8_t *packet)
+{
+     uint16_t polls = RADIO_RAW_SEND_POLLS;
+     uint8_t state;
+
+     WriteBurstReg(RF_TXFIFOWR, packet, packet[0] + 1);
+     Strobe(RF_STX);
+
+     do {
+	  __delay_cycles(12);
+	  state = ReadSingleReg(MARCSTATE | RF_STATREGRD) & 0x1F;
+     } while ((state != MARC_STATE_IDLE) && (state != MARC_STATE_TXFIFO_UNDERFLOW) && (--polls > 0));
+
+     if (state == MARC_STATE_IDLE)
+	  return 1;
+
+     // Stuck or underflowed: back to IDLE, where the FIFO can be flushed
+     Strobe(RF_SIDLE);
+     Strobe(RF_SFTX);
+     return 0;
+}
+
+
+
+
 // *************************************************************************************************
 // @fn          close_radio
 // @brief       Shutdown radio for RF communication.
@@ -146,6 +276,9 @@ void close_radio(void)
 
      // Put radio to sleep
      radio_powerdown();
+
+     energy_off(ENERGY_RADIO);
+     governor_release();
 }
 
 
@@ -36,12 +36,18 @@
 #ifndef RADIO_H_
 #define RADIO_H_
 
+/* Largest payload accepted by radio_raw_send(). Together with the length byte
+   and the two status bytes appended on reception it fills the 64 byte FIFO. */
+#define RADIO_RAW_MAX_PAYLOAD 61
+
 extern void radio_reset(void);
 extern void radio_powerdown(void);
 extern void radio_sxoff(void);
 extern void radio_idle(void);
 extern void open_radio(void);
 extern void close_radio(void);
+extern void radio_raw_open(void);
+extern uint8_t radio_raw_send(uint8_t *packet);
 extern void pmm_set_high_current_mode(void);
 extern void pmm_set_low_current_mode(void);
 
@@ -26,23 +26,60 @@
 
 #ifdef CONFIG_RTC_DST
 
-/* "private" defines */
-#define N_SUN_OF_MON(n,mon,year) (((n)*7)-rtc_dst_day_of_week((year),(mon),((n)*7)))
-#define LAST_SUN_OF_MON(mon,days,year) ((days)-rtc_dst_day_of_week((year),(mon),(days)))
-#define DSTNUM(x,y,z) (((uint16_t)(x)*1000)+(uint16_t)(y*10)+(uint16_t)(z))
-
 #include "rtca.h"
 
 #include "rtc_dst.h"
 
-/* "private" functions */
-uint8_t rtc_dst_isDateInDST(uint8_t month, uint8_t day, uint8_t hour);
+#define RULE_MONTH(r) ((r) >> 12)
+#define RULE_WEEK(r)  (((r) >> 9) & 0x07)
+#define RULE_WDAY(r)  (((r) >> 6) & 0x07)
+#define RULE_HOUR(r)  ((r) & 0x3f)
+
+const struct rtc_dst_rule rtc_dst_rules[RTC_DST_ZONES] = RTC_DST_RULES;
 
-struct rtc_dst_date_struct rtc_dst_dates[2];
 uint8_t rtc_dst_state;
+uint8_t rtc_dst_zone = CONFIG_RTC_DST_ZONE;
+uint32_t rtc_dst_next = UINT32_MAX;
+
+/* Local time of the start and end of DST in two consecutive years, as
+   rtca_time.epoch values. Changes start from standard time (even entries)
+   and end from DST (odd entries). */
+static uint32_t transitions[4];
+
+
+/* rtca_time.epoch of a rule date in the given year */
+static uint32_t rtc_dst_rule_time(uint16_t rule, uint16_t year)
+{
+     uint8_t mon = RULE_MONTH(rule);
+     uint16_t day;
+
+     if (RULE_WEEK(rule) == 5) {
+	  /* step back from the last day of the month */
+	  day = rtca_days_since_epoch(year, mon, rtca_get_max_days(mon, year));
+	  day -= (day + 4 - RULE_WDAY(rule) + 7) % 7;
+     } else {
+	  /* 1970-01-01 was a thursday */
+	  day = rtca_days_since_epoch(year, mon, 1);
+	  day += (RULE_WDAY(rule) + 7 - (day + 4) % 7) % 7 + (RULE_WEEK(rule) - 1) * 7;
+     }
+
+     return day * 86400ul + RULE_HOUR(rule) * 3600ul;
+}
+
+/* Picks the first change after now that leaves the current state, 0 if it
+   is not in transitions[] */
+static uint32_t rtc_dst_pick_next(uint32_t now)
+{
+     uint32_t next = 0;
+     uint8_t i;
 
-uint8_t rtc_dst_day_of_week(uint16_t year, uint8_t month, uint8_t day);
+     for (i = rtc_dst_state; i < 4; i += 2) {
+	  if (transitions[i] > now && (!next || transitions[i] < next))
+	       next = transitions[i];
+     }
 
+     return next;
+}
 
 /****************************************************************************/
 /* DST initialize function. This is called by the module config setup       */
@@ -50,171 +87,79 @@ uint8_t rtc_dst_day_of_week(uint16_t year, uint8_t month, uint8_t day);
 void rtc_dst_init(void)
 {
      /* Calculate when to switch dates */
-     rtc_dst_calculate_dates(rtca_time.year, rtca_time.mon, rtca_time.day, rtca_time.hour);
+     rtc_dst_calculate_dates();
+}
+
+void rtc_dst_set_zone(uint8_t zone)
+{
+     rtc_dst_zone = (zone > RTC_DST_ZONES ? DST_NONE : zone);
+     rtc_dst_calculate_dates();
 }
 
 /******************************************************************************/
 /* This function is called on hour changes by the rtca interrupt handler.     */
-/* It implements the time changes on the appropriate days.                    */
+/* It implements the time changes at the precomputed transition time.        */
 /******************************************************************************/
 void rtc_dst_hourly_update(void)
 {
-     if (rtca_time.hour == 2) {
-	  /* time changes always occur at 2AM */
-	  if (rtc_dst_state == RTC_DST_STATE_ST) {
-	       if (rtca_time.mon == rtc_dst_dates[0].month && rtca_time.day == rtc_dst_dates[0].day) {
-		    /* spring forward */
-		    rtc_dst_state = RTC_DST_STATE_DST;
-		    rtca_time.hour++;
-		    rtca_set_time();
-	       }
-	  } else {
-	       /* rtc_dst_state == RTC_DST_STATE_DST */
-	       if (rtca_time.mon == rtc_dst_dates[1].month && rtca_time.day == rtc_dst_dates[1].day) {
-		    /* fall back */
-		    rtc_dst_state = RTC_DST_STATE_ST;
-		    rtca_time.hour--;
-		    rtca_set_time();
-	       }
-	  }
+     if (rtca_time.epoch < rtc_dst_next)
+	  return;
+
+     if (rtc_dst_state == RTC_DST_STATE_ST) {
+	  /* spring forward */
+	  rtc_dst_state = RTC_DST_STATE_DST;
+	  rtca_time.hour++;
+     } else {
+	  /* fall back */
+	  rtc_dst_state = RTC_DST_STATE_ST;
+	  rtca_time.hour--;
+     }
+     rtca_set_time();
+
+     /* the following change is usually already known, recompute once a year */
+     rtc_dst_next = rtc_dst_pick_next(rtca_time.epoch);
+     if (!rtc_dst_next) {
+	  uint8_t state = rtc_dst_state;
+	  rtc_dst_calculate_dates();
+	  rtc_dst_state = state;
+	  rtc_dst_next = rtc_dst_pick_next(rtca_time.epoch);
      }
 }
 
 /********************************************************************************/
-/* This function calculates the new date for DST switching. It should be called */
-/* once a year, or whenever the date/time is changed                            */
-/* @param uint8_t month The current month.                                      */
-/* @param uint8_t day   The current day.                                        */
-/* @param uint8_t hour  The current hour (to get the DST right if time is changed on day of DST switch). */
+/* This function calculates the DST changes of the current and the next year    */
+/* and whether the current time is in DST. It is called whenever the date/time  */
+/* is changed, and when the precomputed changes run out.                        */
 /********************************************************************************/
-
-void rtc_dst_calculate_dates(uint16_t year, uint8_t month, uint8_t day, uint8_t hour)
+void rtc_dst_calculate_dates(void)
 {
+     const struct rtc_dst_rule *rule;
+     uint32_t now = rtca_time.epoch;
+     uint8_t i;
+
+     if (rtc_dst_zone == DST_NONE) {
+	  rtc_dst_state = RTC_DST_STATE_ST;
+	  rtc_dst_next = UINT32_MAX;
+	  return;
+     }
 
-#if (CONFIG_RTC_DST_ZONE == DST_US)
-     // DST in US/Canada: 2nd Sun in Mar to 1st Sun in Nov.
-     rtc_dst_dates[0].month = 3;
-     rtc_dst_dates[0].day = N_SUN_OF_MON(2, 3, year);
-     rtc_dst_dates[1].month = 11;
-     rtc_dst_dates[1].day = N_SUN_OF_MON(1, 11, year);
-#endif
-#if (CONFIG_RTC_DST_ZONE == DST_MEX)
-     // DST in Mexico: first Sun in Apr to last Sun in Oct.
-     rtc_dst_dates[0].month = 4;
-     rtc_dst_dates[0].day = N_SUN_OF_MON(1, 4, year);
-     rtc_dst_dates[1].month = 10;
-     rtc_dst_dates[1].day = LAST_SUN_OF_MON(10, 31, year);
-#endif
-#if (CONFIG_RTC_DST_ZONE == DST_BRZ)
-     // DST in Brazil: third Sun in Oct to third Sun in Feb.
-     rtc_dst_dates[0].month = 10;
-     rtc_dst_dates[0].day = N_SUN_OF_MON(3, 10, year);
-     rtc_dst_dates[1].month = 2;
-     rtc_dst_dates[1].day = N_SUN_OF_MON(3, 2, year);
-#endif
-#if (CONFIG_RTC_DST_ZONE == DST_EU)
-     // DST in EU/UK: last Sun in Mar to last Sun in Oct.
-     rtc_dst_dates[0].month = 3;
-     rtc_dst_dates[0].day = LAST_SUN_OF_MON(3, 31, year);
-     rtc_dst_dates[1].month = 10;
-     rtc_dst_dates[1].day = LAST_SUN_OF_MON(10, 31, year);
-#endif
-#if (CONFIG_RTC_DST_ZONE == DST_AUS)
-     // DST in Australia: first Sun in Oct to first Sun in Apr.
-     rtc_dst_dates[0].month = 10;
-     rtc_dst_dates[0].day = N_SUN_OF_MON(1, 10, year);
-     rtc_dst_dates[1].month = 4;
-     rtc_dst_dates[1].day = N_SUN_OF_MON(1, 4, year);
-#endif
-#if (CONFIG_RTC_DST_ZONE == DST_NZ)
-     // DST in New Zealand: last Sun in Sep to first Sun in Apr.
-     rtc_dst_dates[0].month = 9;
-     rtc_dst_dates[0].day = LAST_SUN_OF_MON(9, 30, year);
-     rtc_dst_dates[1].month = 4;
-     rtc_dst_dates[1].day = N_SUN_OF_MON(1, 4, year);
-#endif
+     rule = &rtc_dst_rules[rtc_dst_zone - 1];
+     for (i = 0; i < 2; i++) {
+	  transitions[2 * i] = rtc_dst_rule_time(rule->start, rtca_time.year + i);
+	  transitions[2 * i + 1] = rtc_dst_rule_time(rule->end, rtca_time.year + i);
+     }
 
      // This test may be wrong if you set your watch
      // on the time-change day.
-     rtc_dst_state = (rtc_dst_isDateInDST(month, day, hour)) ? RTC_DST_STATE_DST : RTC_DST_STATE_ST;
-}
-
-/* Figure out if the specified hour on the specified day is within the DST range */
-uint8_t rtc_dst_isDateInDST(uint8_t month, uint8_t day, uint8_t hour)
-{
-     /* clip hour to a single digit since we only care which side of 2AM it is */
-     /* and we're going to do comparisons via a MMDDH integer in 16 bits */
-     if (hour > 9) hour = 9;
-
-     if (rtc_dst_dates[0].month < rtc_dst_dates[1].month) {
+     if (transitions[0] < transitions[1]) {
 	  /* Northern hemisphere */
-	  return
-	       ((DSTNUM(month, day, hour) >= DSTNUM(rtc_dst_dates[0].month, rtc_dst_dates[0].day, 2)) &&
-		(DSTNUM(month, day, hour) < DSTNUM(rtc_dst_dates[1].month, rtc_dst_dates[1].day, 2)));
+	  rtc_dst_state = (now >= transitions[0] && now < transitions[1]);
      } else {
 	  /* Southern hemisphere */
-	  return (!(
-		       ((DSTNUM(month, day, hour) >= DSTNUM(rtc_dst_dates[1].month, rtc_dst_dates[1].day,2)) &&
-			(DSTNUM(month, day, hour) < DSTNUM(rtc_dst_dates[0].month, rtc_dst_dates[0].day,2)))));
+	  rtc_dst_state = !(now >= transitions[1] && now < transitions[0]);
      }
-}
-
-uint8_t rtc_dst_day_of_week(uint16_t year, uint8_t month, uint8_t day)
-{
-     /* Calculate days since 2000-01-01 */
-     uint32_t tmp = (year % 200) * 365;
-     tmp += (((year % 200) + 3) / 4); // leap days
-
-     switch (month) { // using lots of drop-through!
-     case 12:
-	  tmp += 30; /* for nov */
-
-     case 11:
-	  tmp += 31; /* for oct */
-
-     case 10:
-	  tmp += 30; /* for sep */
-
-     case 9:
-	  tmp += 31; /* for aug */
-
-     case 8:
-	  tmp += 31; /* for jul */
 
-     case 7:
-	  tmp += 30; /* for jun */
-
-     case 6:
-	  tmp += 31; /* for may */
-
-     case 5:
-	  tmp += 30; /* for apr */
-
-     case 4:
-	  tmp += 31; /* for mar */
-
-     case 3:
-	  tmp += 28; /* for feb */
-
-	  if ((year % 4) == 0) {
-	       tmp++;
-	  }
-
-     case 2:
-	  tmp += 31; /* for jan */
-
-     case 1:
-     default:
-	  /* do nothing */
-	  break;
-     }
-
-     tmp += day;
-     tmp--; /* because day-of-month is 1-based (2000-01-01 is the ZERO day). */
-
-     /* day zero (2000-01-01) was a Saturday. */
-     return (uint8_t)((tmp + 6) % 7);
+     rtc_dst_next = rtc_dst_pick_next(now);
 }
 
 #endif /* CONFIG_RTC_DST */
-
@@ -25,26 +25,35 @@
 #ifndef RTC_DST_H_
 #define RTC_DST_H_
 
+#include "rtc_dst_rules.h"
+
 #define RTC_DST_STATE_ST 0
 #define RTC_DST_STATE_DST 1
 
-#define DST_US 1
-#define DST_MEX 2
-#define DST_BRZ 3
-#define DST_EU 4
-#define DST_AUS 5
-#define DST_NZ 6
+/* DST disabled, zones are numbered from 1 in drivers/rtc_dst.rules */
+#define DST_NONE 0
+
+/* packs one end of a DST period: day wday (0 sunday) of week (1-4, 5 being
+   the last) of month, at hour of the local time before the change */
+#define RTC_DST_DATE(month, week, wday, hour) \
+     (((month) << 12) | ((week) << 9) | ((wday) << 6) | (hour))
 
-struct rtc_dst_date_struct {
-     uint8_t month;
-     uint8_t day;
+struct rtc_dst_rule {
+     char name[5];
+     uint16_t start;
+     uint16_t end;
 };
 
-extern struct rtc_dst_date_struct dst_dates[];
+extern const struct rtc_dst_rule rtc_dst_rules[];
 extern uint8_t rtc_dst_state;
+extern uint8_t rtc_dst_zone;
+
+/* rtca_time.epoch of the next change, rtc_dst_hourly_update() acts when it is reached */
+extern uint32_t rtc_dst_next;
 
 void rtc_dst_init(void);
-void rtc_dst_calculate_dates(uint16_t year, uint8_t month, uint8_t day, uint8_t hour);
+void rtc_dst_set_zone(uint8_t zone);
+void rtc_dst_calculate_dates(void);
 void rtc_dst_hourly_update(void);
 
 #endif
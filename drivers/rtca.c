@@ -24,6 +24,8 @@
 
 #include "rtca.h"
 #include "rtca_now.h"
+#include "utils.h"
+#include "irqtrace.h"
 
 #ifdef CONFIG_RTC_DST
 #include "rtc_dst.h"
@@ -34,9 +36,19 @@
    Exception 2: a year that is divisible by 400 is a leap year. */
 #define IS_LEAP_YEAR(Y) (((Y)%4 == 0) && (((Y)%100 != 0) || ((Y)%400 == 0)))
 
-/* compute number of leap years since BASE_YEAR */
-#define BASE_YEAR 1984 /* not a leap year, so no need to add 1 */
-#define LEAPS_SINCE_YEAR(Y) (((Y) - BASE_YEAR) + ((Y) - BASE_YEAR) / 4);
+/* seven events, a main loop stalled for longer with second events on merges
+   the rest into the next event instead of losing them */
+EVQUEUE_DEFINE(rtca_events, 8);
+
+/* event bits that found the queue full, sent with the next event */
+static uint16_t rtca_unqueued;
+
+volatile uint8_t rtca_sets;
+
+/* days before the first of each month in a common year */
+static const uint16_t days_before_month[13] = {
+     0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365
+};
 
 #ifdef CONFIG_MOD_CLOCK_AMPM
 uint8_t display_am_pm = 1;
@@ -44,6 +56,60 @@ uint8_t display_am_pm = 1;
 uint8_t display_am_pm = 0;
 #endif
 
+/* day of the year, 0 being january 1st */
+static uint16_t rtca_yday(uint16_t year, uint8_t mon, uint8_t day)
+{
+     uint16_t yday = days_before_month[mon - 1] + day - 1;
+
+     if (mon > 2 && IS_LEAP_YEAR(year))
+	  yday++;
+
+     return yday;
+}
+
+uint16_t rtca_days_since_epoch(uint16_t year, uint8_t mon, uint8_t day)
+{
+     return (year - 1970) * 365u
+	  + (year - 1969) / 4 - (year - 1901) / 100 + (year - 1601) / 400
+	  + rtca_yday(year, mon, day);
+}
+
+/* epoch at the start of the current minute, lets minute events keep the
+   epoch while second events are disabled */
+static uint32_t minute_epoch;
+
+/* Full recompute of the values the ISR keeps up to date, only needed when
+   the time or date is set */
+static void rtca_update_epoch(void)
+{
+     rtca_time.yday = rtca_yday(rtca_time.year, rtca_time.mon, rtca_time.day);
+     minute_epoch =
+	  rtca_days_since_epoch(rtca_time.year, rtca_time.mon, rtca_time.day) * 86400ul
+	  + rtca_time.hour * 3600ul + rtca_time.min * 60u;
+     rtca_time.epoch = minute_epoch + rtca_time.sec;
+}
+
+/* The RTC events are bits, so a full queue merges them into the next event
+   rather than dropping them: an RTCA_EV_ALARM is late at worst, by up to the
+   next minute event. Called with interrupts disabled. */
+static void rtca_queue(uint16_t ev)
+{
+     ev |= rtca_unqueued;
+     rtca_unqueued = evqueue_put(&rtca_events, ev, rtca_time.sec) ? 0 : ev;
+}
+
+/* Setting the time also happens from the main loop, keep the ISR the only
+   producer of rtca_events while queueing */
+static void rtca_post_alarm(void)
+{
+     uint16_t int_state;
+
+     ENTER_CRITICAL_SECTION(int_state);
+     rtca_sets++;
+     rtca_queue(RTCA_EV_ALARM);
+     EXIT_CRITICAL_SECTION(int_state);
+}
+
 void rtca_init(void)
 {
      rtca_time.year = COMPILE_YEAR;
@@ -53,6 +119,7 @@ void rtca_init(void)
      rtca_time.hour = COMPILE_HOUR;
      rtca_time.min = COMPILE_MIN;
      rtca_time.sec = 59; // So we can see the watch is working after reset
+     rtca_update_epoch();
 
 #ifdef CONFIG_RTC_IRQ
      /* Enable calendar mode (date/time registers are automatically reset)
@@ -86,31 +153,13 @@ void rtca_init(void)
 /* returns number of days for a given month */
 uint8_t rtca_get_max_days(uint8_t month, uint16_t year)
 {
-     switch (month) {
-     case 1:
-     case 3:
-     case 5:
-     case 7:
-     case 8:
-     case 10:
-     case 12:
-	  return 31;
-
-     case 4:
-     case 6:
-     case 9:
-     case 11:
-	  return 30;
-
-     case 2:
-	  if (IS_LEAP_YEAR(year))
-	       return 29;
-	  else
-	       return 28;
-
-     default:
+     if (month < 1 || month > 12)
 	  return 0;
-     }
+
+     if (month == 2 && IS_LEAP_YEAR(year))
+	  return 29;
+
+     return days_before_month[month] - days_before_month[month - 1];
 }
 
 void rtca_set_time()
@@ -123,8 +172,21 @@ void rtca_set_time()
      RTCMIN = rtca_time.min;
      RTCHOUR = rtca_time.hour;
 
+     rtca_update_epoch();
+
      /* Resume RTC time keeping */
      rtca_start();
+
+     /* Let alarm users reschedule, the next match may have moved */
+     rtca_post_alarm();
+}
+
+void rtca_set_second_events(uint8_t on)
+{
+     if (on)
+	  RTCCTL01 |= RTCRDYIE;
+     else
+	  RTCCTL01 &= ~RTCRDYIE;
 }
 
 void rtca_get_alarm(uint8_t *hour, uint8_t *min)
@@ -156,60 +218,34 @@ void rtca_enable_alarm()
      RTCCTL01 |= RTCAIE;
 }
 
+void rtca_set_alarm_at(uint8_t dow, uint8_t hour, uint8_t min)
+{
+     /* Disable alarm interrupt while setting alarm */
+     RTCCTL01 &= ~RTCAIE;
+     /* Match day of week, hour and min, not the day of month */
+     RTCADAY  = 0;
+     RTCADOW  = RTCAE | dow;
+     RTCAHOUR = RTCAE | hour;
+     RTCAMIN  = RTCAE | min;
+     /* Enable alarm interrupt */
+     RTCCTL01 |= RTCAIE;
+}
+
 void rtca_disable_alarm()
 {
      /* Disable alarm interrupt */
      RTCCTL01 &= ~RTCAIE;
-     /* Clear Alarm Enable for both hour and min */
+     /* Clear Alarm Enable for dow, hour and min */
+     RTCADOW  &= ~RTCAE;
      RTCAHOUR &= ~RTCAE;
      RTCAMIN  &= ~RTCAE;
 }
 
 void rtca_update_dow(struct DATETIME *datetime)
 {
-     uint8_t dow;
-
-     dow = LEAPS_SINCE_YEAR(datetime->year);
-
-     if ((29 == rtca_get_max_days(2, datetime->year)) && (datetime->mon < 3))
-	  dow--; /* if this is a leap year but before February 29 */
-
-     /* add day of current month */
-     dow += datetime->day;
-
-     /* add this month's dow value */
-     switch (datetime->mon) {
-     case 5:
-	  dow += 1;
-	  break;
-
-     case 8:
-	  dow += 2;
-	  break;
-
-     case 2:
-     case 3:
-     case 11:
-	  dow += 3;
-	  break;
-
-     case 6:
-	  dow += 4;
-	  break;
-
-     case 9:
-     case 12:
-	  dow += 5;
-	  break;
-
-     case 4:
-     case 7:
-	  dow += 6;
-	  break;
-     }
-
-     dow = dow % 7;
-     datetime->dow = dow;
+     /* 1970-01-01 was a thursday */
+     datetime->dow = (rtca_days_since_epoch(datetime->year, datetime->mon,
+					    datetime->day) + 4) % 7;
 }
 
 void rtca_set_date()
@@ -226,12 +262,17 @@ void rtca_set_date()
      RTCYEARL = rtca_time.year & 0xff;
      RTCYEARH = rtca_time.year >> 8;
 
+     rtca_update_epoch();
+
      /* Resume RTC time keeping */
      rtca_start();
 
+     /* Let alarm users reschedule, the next match may have moved */
+     rtca_post_alarm();
+
 #ifdef CONFIG_RTC_DST
      /* calculate new DST switch dates */
-     rtc_dst_calculate_dates(rtca_time.year, rtca_time.mon, rtca_time.day, rtca_time.hour);
+     rtc_dst_calculate_dates();
 #endif
 }
 __attribute__((interrupt(RTC_A_VECTOR)))
@@ -243,13 +284,15 @@ void RTC_A_ISR(void)
      /* copy register values */
      rtca_time.sec = RTCSEC;
 
-     /* count system time */
-     rtca_time.sys++;
+     irqtrace_record(IRQTRACE_RTC, (iv / 2) << 6 | rtca_time.sec);
 
      enum rtca_tevent ev = 0;
 
      /* second event (from the read ready interrupt flag) */
      if (iv == RTCIV_RTCRDYIFG) {    /* Did second changed */
+	  /* count system time */
+	  rtca_time.sys++;
+	  rtca_time.epoch++;
 	  ev = RTCA_EV_SECOND;
 	  goto finish;
      }
@@ -264,22 +307,24 @@ void RTC_A_ISR(void)
 	  ev = RTCA_EV_MINUTE;
 	  rtca_time.min = RTCMIN;
 
+	  /* catch up with the seconds not counted while second events are off */
+	  minute_epoch += 60;
+	  rtca_time.sys += minute_epoch - rtca_time.epoch;
+	  rtca_time.epoch = minute_epoch;
+
 	  if (rtca_time.min != 0)     /* Hour changed */
 	       goto finish;
 
 	  ev |= RTCA_EV_HOUR;
 	  rtca_time.hour = RTCHOUR;
 
-#ifdef CONFIG_RTC_DST
-	  rtc_dst_hourly_update();
-#endif
-
 	  if (rtca_time.hour != 0)    /* Day changed */
 	       goto finish;
 
 	  ev |= RTCA_EV_DAY;
 	  rtca_time.day = RTCDAY;
 	  rtca_time.dow = RTCDOW;
+	  rtca_time.yday++;
 
 	  if (rtca_time.day != 1)     /* Month changed */
 	       goto finish;
@@ -292,16 +337,20 @@ void RTC_A_ISR(void)
 
 	  ev |= RTCA_EV_YEAR;
 	  rtca_time.year = RTCYEARL | (RTCYEARH << 8);
-#ifdef CONFIG_RTC_DST
-	  /* calculate new DST switch dates */
-	  rtc_dst_calculate_dates(rtca_time.year, rtca_time.mon, rtca_time.day, rtca_time.hour);
-#endif
+	  rtca_time.yday = 0;
      }
 
 finish:
-     /* append events, since ISR could be triggered
-	multipe times until rtca_last_event gets parsed */
-     rtca_last_event |= ev;
+#ifdef CONFIG_RTC_DST
+     /* after the date is up to date, a change may set the time */
+     if (ev & RTCA_EV_HOUR)
+	  rtc_dst_hourly_update();
+#endif
+
+     /* queue events, the ISR can be triggered multiple
+	times before the main loop gets to them */
+     if (ev)
+	  rtca_queue(ev);
 
      /* exit from LPM3, give execution back to mainloop */
      _BIC_SR_IRQ(LPM3_bits);
@@ -26,6 +26,7 @@
 #define __RTCA_H__
 
 #include "openchronos.h"
+#include "evqueue.h"
 
 enum rtca_tevent {
      RTCA_EV_NONE    = 0,
@@ -45,6 +46,8 @@ static char const * const rtca_dow_str[] = {
 
 struct DATETIME {
      uint32_t sys;   /* system time: number of seconds since power on */
+     uint32_t epoch; /* seconds since 1970-01-01 00:00 of the RTC time, kept by the ISR */
+     uint16_t yday;  /* day of the year, 0 being january 1st, kept by the ISR */
      uint16_t year;  /* cache of RTC year register */
      uint8_t mon;    /* cache of RTC month register */
      uint8_t day;    /* cache of RTC day register */
@@ -62,23 +65,42 @@ uint8_t display_am_pm;
 #define rtca_stop()  (RTCCTL01 |=  RTCHOLD)
 #define rtca_start() (RTCCTL01 &= ~RTCHOLD)
 
+/* 1/128s elapsed in the current second, straight from the RT1PS prescaler */
+#define rtca_subsec() (RTCPS1 & 0x7f)
+
 /* the ev variable holds the time event, see enum rtca_tevent for more info.
    please add -fshort-enums to CFLAGS to store rtca_tevent as only a byte */
 void rtca_init(void);
 
 uint8_t rtca_get_max_days(uint8_t month, uint16_t year);
 
+/* days from 1970-01-01 up to the given date, valid until 2149 */
+uint16_t rtca_days_since_epoch(uint16_t year, uint8_t mon, uint8_t day);
+
 void rtca_update_dow(struct DATETIME *datetime);
 void rtca_set_time();
 void rtca_set_date();
 
+/* second events wake the CPU up every second, the time is kept by minute
+   events while they are off */
+void rtca_set_second_events(uint8_t on);
+
 void rtca_get_alarm(uint8_t *hour, uint8_t *min);
 void rtca_set_alarm(uint8_t hour, uint8_t min);
 
 void rtca_enable_alarm();
 void rtca_disable_alarm();
 
-/* exclusive use by openchronos system */
-volatile enum rtca_tevent rtca_last_event;
+/* programs and enables the alarm for the next dow/hour/min match. Changing
+   the time or date posts a RTCA_EV_ALARM, so alarm users can reschedule */
+void rtca_set_alarm_at(uint8_t dow, uint8_t hour, uint8_t min);
+
+/* counts the changes of time or date, a RTCA_EV_ALARM that comes with a new
+   count was posted by a change and not by an alarm match */
+extern volatile uint8_t rtca_sets;
+
+/* exclusive use by openchronos system: the RTC events, ev holds enum
+   rtca_tevent bits and data the seconds of the event */
+extern struct evqueue rtca_events;
 
 #endif /* __RTCA_H__ */
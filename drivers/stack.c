@@ -0,0 +1,69 @@
+/**
+   drivers/stack.c: Stack usage monitor
+
+   Copyright (C) 2026 openchronos-ng contributors
+
+   http://github.com/BenjaminSoelberg/openchronos-ng-elf
+
+   This file is part of openchronos-ng.
+
+   openchronos-ng is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   openchronos-ng is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+#include "stack.h"
+
+#define STACK_PAINT 0xA5
+
+/* bytes below the stack pointer left alone by stack_paint(), they hold
+   the return address and saved registers of the call itself */
+#define STACK_PAINT_GUARD 16
+
+/* From the linker script: end of the static data and top of the RAM */
+extern uint8_t end;
+extern uint8_t __stack;
+
+uint16_t stack_peak;
+
+/* deepest written address found so far, nothing below it was touched */
+static uint8_t *stack_low = &__stack;
+
+/* Runs from boot.c before .data and .bss are initialized, so it must not
+   use any variable. */
+void stack_paint(void)
+{
+     uint8_t *p = &end;
+     uint8_t *sp = (uint8_t *) __get_SP_register() - STACK_PAINT_GUARD;
+
+     while (p < sp)
+	  *p++ = STACK_PAINT;
+}
+
+uint16_t stack_scan(void)
+{
+     uint8_t *p = &end;
+
+     /* everything above stack_low is known to be used already, an interrupt
+	nesting on top of us may still move it down while we look */
+     while (p < stack_low && *p == STACK_PAINT)
+	  p++;
+
+     stack_low = p;
+     stack_peak = &__stack - p;
+
+     return stack_peak;
+}
+
+uint16_t stack_size(void)
+{
+     return &__stack - &end;
+}
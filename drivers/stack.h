@@ -0,0 +1,44 @@
+/**
+   drivers/stack.h: Stack usage monitor
+
+   Copyright (C) 2026 openchronos-ng contributors
+
+   http://github.com/BenjaminSoelberg/openchronos-ng-elf
+
+   This file is part of openchronos-ng.
+
+   openchronos-ng is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   openchronos-ng is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "openchronos.h"
+
+#ifndef __STACK_H__
+#define __STACK_H__
+
+/* Deepest stack use seen by stack_scan(), in bytes */
+extern uint16_t stack_peak;
+
+/* Fills the unused RAM between the end of .bss and the stack pointer with a
+   known pattern. Call once at boot, before main(). */
+void stack_paint(void);
+
+/* Finds the deepest stack address that was written since stack_paint(),
+   updates and returns stack_peak. Every call walks up from the end of .bss
+   over all the bytes still painted, so it takes longer the more RAM is free. */
+uint16_t stack_scan(void);
+
+/* RAM available to the stack, in bytes */
+uint16_t stack_size(void);
+
+#endif /* __STACK_H__ */
@@ -68,24 +68,44 @@
 static uint8_t adcresult[TEMPORAL_FILTER_WINDOW];
 static uint8_t adcresult_idx = 0;
 
+/* the first measurement fills the window */
+static uint8_t primed;
+
+static PT_THREAD(temperature_boot(struct pt *pt))
+{
+     static struct pt measurement, conversion;
+
+     PT_BEGIN(pt);
+     PT_SPAWN(pt, &measurement, temperature_measurement(&measurement, &conversion));
+     PT_END(pt);
+}
+
+static PT_TASK_DEFINE(temperature_task, temperature_boot);
+
 void temperature_init(void)
 {
-     temperature.value = adc12_single_conversion(REFVSEL_0,
-						 ADC12SHT0_8, ADC12INCH_10);
      temperature.offset = CONFIG_TEMPERATURE_OFFSET;
 
-     adcresult[0] = temperature.value;
-     adcresult[1] = temperature.value;
-     adcresult[2] = temperature.value;
-     adcresult[3] = temperature.value;
+     /* The first conversion takes 236ms, the main loop runs it in the
+	background. The temperature module may measure on its own
+	meanwhile, adc12_conversion() runs one after the other. */
+     pt_start(&temperature_task);
 }
 
 
-void temperature_measurement(void)
+PT_THREAD(temperature_measurement(struct pt *pt, struct pt *conversion))
 {
+     PT_BEGIN(pt);
+
      /* Convert internal temperature diode voltage */
-     adcresult[adcresult_idx++] = adc12_single_conversion(REFVSEL_0,
-							  ADC12SHT0_8, ADC12INCH_10);
+     PT_SPAWN(pt, conversion, adc12_conversion(conversion, REFVSEL_0,
+					       ADC12SHT0_8, ADC12INCH_10));
+     if (!primed) {
+	  temperature.value = adc12_result;
+	  adcresult[1] = adcresult[2] = adcresult[3] = adc12_result;
+	  primed = 1;
+     }
+     adcresult[adcresult_idx++] = adc12_result;
      if (adcresult_idx == TEMPORAL_FILTER_WINDOW)
 	  adcresult_idx = 0;
 
@@ -93,6 +113,8 @@ void temperature_measurement(void)
      temperature.value = (temperature.value & 0xff00)
 	  | (((uint16_t)adcresult[0] + (uint16_t)adcresult[1]
 	      + (uint16_t)adcresult[2] + (uint16_t)adcresult[3]) >> 2);
+
+     PT_END(pt);
 }
 
 
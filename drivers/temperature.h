@@ -26,9 +26,12 @@
 #define __TEMPERATURE_H__
 
 #include "openchronos.h"
+#include "pt.h"
 
 void temperature_init(void);
-void temperature_measurement(void);
+/* conversion is the state of the ADC12 child thread, each caller that may
+   run at the same time as another needs its own */
+PT_THREAD(temperature_measurement(struct pt *pt, struct pt *conversion));
 void temperature_get_C(int16_t *temp);
 void temperature_get_F(int16_t *temp);
 
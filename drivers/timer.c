@@ -58,22 +58,19 @@
 #include "wdt.h"
 #include "utils.h"
 #include "lpm.h"
+#include "irqtrace.h"
 
 /* HARDWARE TIMER ASSIGNMENT:
    TA0CCR0: 20Hz timer used by the button driver
    TA0CCR1: Unused
    TA0CCR2: delay timer with callback
    TA0CCR3: programmable timer via messagebus
-   TA0CCR4: timer0_delay, will enter LPMx to save power
+   TA0CCR4: timer0_delay, will enter LPMx to save power, and the
+	    protothread wakeups when no delay is running
    OVERFLOW: 0.244Hz timer ~ 4.1S via messagebus
 */
 
-/* source is ACLK=32768Hz (nominal) with /2 divider */
-#define TIMER0_FREQ 16384
-
-/* converts microseconds to clock ticks */
-#define TIMER0_TICKS_FROM_MS(T) ((((uint32_t)TIMER0_FREQ) * (uint32_t)T) \
-				 / ((uint32_t)1000))
+EVQUEUE_DEFINE(timer0_events, 8);
 
 static volatile uint8_t delay_finished;
 
@@ -85,8 +82,8 @@ static void (*delay_callback)(void) = NULL;
 void init_timer0_20hz();
 
 void timer0_init(void) {
-#ifdef CONFIG_TIMER_4S_IRQ
-     /* Enable overflow interrupts */
+#if defined(CONFIG_TIMER_4S_IRQ) || defined(CONFIG_IRQ_TRACE)
+     /* Enable overflow interrupts, they also bound the gaps of the trace */
      TA0CTL |= TAIE;
 #endif
 
@@ -146,8 +143,8 @@ void timer0_delay(uint16_t duration, uint16_t LPM_bits) {
      /* Set next CCR match */
      TA0CCR4 = TA0R + TIMER0_TICKS_FROM_MS(duration);
 
-     /* enable interrupt */
-     TA0CCTL4 |= CCIE;
+     /* enable interrupt, dropping a pending protothread wakeup */
+     TA0CCTL4 = CCIE;
 
      /* Wait for interrupt */
      while (1) {
@@ -167,6 +164,20 @@ void timer0_delay(uint16_t duration, uint16_t LPM_bits) {
      TA0CCTL4 &= ~CCIE;
 }
 
+void timer0_wakeup_at(uint16_t at) {
+     TA0CCR4 = at;
+     TA0CCTL4 = CCIE;
+
+     /* the compare only matches the exact value, raise the
+	interrupt by hand if at has already passed */
+     if ((int16_t)(TA0R - at) >= 0)
+	  TA0CCTL4 |= CCIFG;
+}
+
+void timer0_wakeup_cancel(void) {
+     TA0CCTL4 &= ~CCIE;
+}
+
 void timer0_delay_callback_destroy(void) {
      /* abort a delay without calling callback */
      /* disable interrupt */
@@ -224,14 +235,16 @@ void timer0_destroy_prog_timer() {
 /* interrupt vector for CCR0 */
 __attribute__((interrupt(TIMER0_A0_VECTOR)))
 void timer0_A0_ISR(void) {
+     irqtrace_record(IRQTRACE_TIMER0_A0, 0);
+
      /* setup timer for next time */
      TA0CCR0 = TA0R + timer0_20hz_ticks;
 
      /* increase 20hz counter */
      timer0_20hz_counter++;
 
-     /* store 20hz timer event */
-     timer0_last_event |= TIMER0_EVENT_20HZ;
+     /* queue 20hz timer event */
+     evqueue_put(&timer0_events, TIMER0_EVENT_20HZ, timer0_20hz_counter);
 
      /* exit from LPM3, give execution back to mainloop */
      _BIC_SR_IRQ(LPM3_bits);
@@ -243,13 +256,15 @@ void timer0_A1_ISR(void) {
      /* reading TA0IV automatically resets the interrupt flag */
      uint8_t flag = (uint8_t) TA0IV; // ISR reason. Only look at the lower 8 bits
 
+     irqtrace_record(IRQTRACE_TIMER0_A1, flag);
+
      /* programable timer */
      if (flag == TA0IV_TA0CCR3) {
 	  /* setup timer for next time */
 	  TA0CCR3 = TA0R + timer0_prog_ticks;
 
-	  /* store event */
-	  timer0_last_event |= TIMER0_EVENT_PROG;
+	  /* queue event */
+	  evqueue_put(&timer0_events, TIMER0_EVENT_PROG, timer0_20hz_counter);
 
 	  goto exit_lpm3;
      }
@@ -281,8 +296,8 @@ void timer0_A1_ISR(void) {
 #ifdef CONFIG_TIMER_4S_IRQ
      /* 0.24Hz timer, ticked by overflow interrupts */
      if (flag == TA0IV_TA0IFG) {
-	  /* store event */
-	  timer0_last_event |= TIMER0_EVENT_4S;
+	  /* queue event */
+	  evqueue_put(&timer0_events, TIMER0_EVENT_4S, timer0_20hz_counter);
 
 	  goto exit_lpm3;
      }
@@ -30,10 +30,18 @@
 */
 
 #include "openchronos.h"
+#include "evqueue.h"
 
 #ifndef __TIMER_H__
 #define __TIMER_H__
 
+/*! TA0R frequency, ACLK=32768Hz (nominal) with /2 divider */
+#define TIMER0_FREQ 16384
+
+/*! converts milliseconds to TA0R ticks */
+#define TIMER0_TICKS_FROM_MS(T) ((((uint32_t)TIMER0_FREQ) * (uint32_t)T) \
+				 / ((uint32_t)1000))
+
 void start_timer0_20hz();
 void stop_timer0_20hz();
 
@@ -97,6 +105,19 @@ void timer0_delay_callback(
 */
 void timer0_delay_callback_destroy(void);
 
+/*!
+  \brief wake the main loop up when TA0R reaches \b at
+  \details Used by the protothreads, see pt.h. Shares its compare register with timer0_delay(), which cancels it.
+  \internal
+*/
+void timer0_wakeup_at(uint16_t at);
+
+/*!
+  \brief cancel the wakeup of timer0_wakeup_at()
+  \internal
+*/
+void timer0_wakeup_cancel(void);
+
 /*!
   \brief Bitfield of events produced by this driver
 */
@@ -110,11 +131,11 @@ enum timer0_event {
 };
 
 /*!
-  \brief Bitfield holding the last generated (timer) event.
-  \details Timer0 interrupt routines update this variable with the last happening events. Inside the mainloop, the system then clears this variable after reading it. Read events are broadcasted in #sys_message.
-  \note This function is to be used exclusively by the system. No module is allowed to read or write to this variable.
+  \brief Queue of the generated (timer) events.
+  \details Timer0 interrupt routines queue an event with a #timer0_event bit in <i>ev</i> and #timer0_20hz_counter in <i>data</i>. Inside the mainloop, the system takes them out of the queue and broadcasts them in #sys_message.
+  \note This queue is to be used exclusively by the system. No module is allowed to read or write to it.
   \internal
 */
-volatile enum timer0_event timer0_last_event;
+extern struct evqueue timer0_events;
 
 #endif /* __TIMER_H__ */
@@ -66,6 +66,8 @@
 #include "vti_as.h"
 #include "as.h"
 #include "timer.h"
+#include "pt.h"
+#include "energy.h"
 
 #ifndef CONFIG_MOD_ACCELEROMETER
 void as_disconnect(void)
@@ -164,14 +166,15 @@ void as_init(void)
 }
 
 
-/******************************************************************************/
-/* @fn          change_mode */
-/* @brief       This is only called for a "warm" (as_start was already called) mode change */
-/* @param       mode can be [FALL_MODE, MEASUREMENT_MODE,ACTIVITY_MODE] */
-/* @return      none */
-/******************************************************************************/
+/* mode to configure, and whether the sensor is powering up first */
+static uint8_t as_mode;
+static uint8_t as_cold;
 
-void change_mode(uint8_t mode)
+/* set until the mode of as_mode is written to the sensor */
+static uint8_t as_mode_pending;
+
+/* Writes the parameters of mode, returns the matching ADDR_CTRL value */
+static uint8_t as_mode_config(uint8_t mode)
 {
      uint8_t bConfig = 0x00;
 
@@ -253,21 +256,72 @@ void change_mode(uint8_t mode)
 
      }
 
+     return bConfig;
+}
+
+/* The power up and mode change sequence, run from the main loop so the
+   settling delays don't block it */
+static PT_THREAD(as_setup(struct pt *pt))
+{
+     PT_BEGIN(pt);
+
+     if (as_cold) {
+	  /* Delay of >5ms required between switching on power and configuring sensor */
+	  PT_SLEEP(pt, 10);
+
+	  /* Initialize interrupt pin for data read out from acceleration sensor */
+	  AS_INT_IFG &= ~AS_INT_PIN; /* Reset flag */
+	  AS_INT_IE |= AS_INT_PIN; /* Enable interrupt */
+
+	  /* Reset sensor */
+	  as_write_register(0x04, 0x02);
+	  as_write_register(0x04, 0x0A);
+	  as_write_register(0x04, 0x04);
+
+	  /* Wait 5 ms before starting sensor output */
+	  PT_SLEEP(pt, 5);
+     }
+
      /* Wait 2 ms before entering modality to settle down */
-     timer0_delay(2, LPM3_bits);
+     PT_SLEEP(pt, 2);
 
-     /* write the configuration */
-     as_write_register(ADDR_CTRL, bConfig);
+     /* write the configuration of the latest mode asked for */
+     as_write_register(ADDR_CTRL, as_mode_config(as_mode));
+     as_mode_pending = 0;
 
      /* Wait 2 ms before entering modality to settle down */
-     timer0_delay(2, LPM3_bits);
+     PT_SLEEP(pt, 2);
 
+     PT_END(pt);
 }
+
+static PT_TASK_DEFINE(as_setup_task, as_setup);
+
+/******************************************************************************/
+/* @fn          change_mode */
+/* @brief       This is only called for a "warm" (as_start was already called) mode change */
+/* @param       mode can be [FALL_MODE, MEASUREMENT_MODE,ACTIVITY_MODE] */
+/* @return      none, the mode is set from the main loop a few ms later */
+/******************************************************************************/
+void change_mode(uint8_t mode)
+{
+     as_mode = mode;
+
+     /* a pending setup picks the new mode up */
+     if (as_mode_pending)
+	  return;
+
+     pt_stop(&as_setup_task);
+     as_cold = 0;
+     as_mode_pending = 1;
+     pt_start(&as_setup_task);
+}
+
 /******************************************************************************/
 /* @fn          as_start */
 /* @brief       Power-up and initialize acceleration sensor in measurment mode */
 /* @param       mode can be [FALL_MODE, MEASUREMENT_MODE,ACTIVITY_MODE] */
-/* @return      none */
+/* @return      none, the sensor is set up from the main loop */
 /******************************************************************************/
 void as_start(uint8_t mode)
 {
@@ -293,25 +347,14 @@ void as_start(uint8_t mode)
      AS_PWR_OUT |= AS_PWR_PIN; /* Power on active high */
 #endif
 
-     /* Delay of >5ms required between switching on power and configuring sensor */
-     timer0_delay(10, LPM3_bits);
-
-     /* Initialize interrupt pin for data read out from acceleration sensor */
-     AS_INT_IFG &= ~AS_INT_PIN; /* Reset flag */
-     AS_INT_IE |= AS_INT_PIN; /* Enable interrupt */
-
-
-     /* Reset sensor */
-     as_write_register(0x04, 0x02);
-     as_write_register(0x04, 0x0A);
-     as_write_register(0x04, 0x04);
-
-     /* Wait 5 ms before starting sensor output */
-     timer0_delay(5, LPM3_bits);
-
-     /* then select modality */
-     change_mode(mode);
+     /* power up, then select modality */
+     pt_stop(&as_setup_task);
+     as_mode = mode;
+     as_cold = 1;
+     as_mode_pending = 1;
+     pt_start(&as_setup_task);
 
+     energy_on(ENERGY_AS);
 }
 
 /******************************************************************************/
@@ -322,6 +365,10 @@ void as_start(uint8_t mode)
 /******************************************************************************/
 void as_stop(void)
 {
+     /* Abort a setup in progress */
+     pt_stop(&as_setup_task);
+     as_mode_pending = 0;
+
      /* Disable interrupt */
      AS_INT_IE &= ~AS_INT_PIN; /* Disable interrupt */
 
@@ -341,6 +388,8 @@ void as_stop(void)
      as_write_register(0x04, 0x0A);
      as_write_register(0x04, 0x04);
 #endif
+
+     energy_off(ENERGY_AS);
 }
 
 /******************************************************************************/
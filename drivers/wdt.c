@@ -21,10 +21,16 @@
    along with this program.  If not, see <http://www.gnu.org/licenses/>.
 **/
 #include "wdt.h"
+#include "crashlog.h"
 
 inline void wdt_setup() {
-#ifdef USE_WATCHDOG
-     WDTCTL = WDTPW + WDTIS__512K + WDTSSEL__ACLK;
+#if defined(CONFIG_CRASH_LOG)
+     /* 16s intervals, drivers/crashlog.c resets after 16 of them */
+     WDTCTL = WDTPW + WDTTMSEL + WDTCNTCL + WDTIS__512K + WDTSSEL__ACLK;
+     SFRIE1 |= WDTIE;
+#elif defined(USE_WATCHDOG)
+     /* 256s, the CPU may only wake up for minute events */
+     WDTCTL = WDTPW + WDTIS__8192K + WDTSSEL__ACLK;
 #else
      wdt_stop();
 #endif
@@ -37,7 +43,10 @@ inline void wdt_stop() {
 
 /* service watchdog on wakeup */
 inline void wdt_poll() {
-#ifdef USE_WATCHDOG
+#if defined(CONFIG_CRASH_LOG)
+     /* the interval keeps running, it samples the PC */
+     crashlog_intervals = 0;
+#elif defined(USE_WATCHDOG)
      WDTCTL = (WDTCTL & 0xff) | WDTPW | WDTCNTCL;
 #endif
 }
@@ -0,0 +1,75 @@
+/**
+    energy.h: openchronos-ng energy model hooks
+
+    Copyright (C) 2026 openchronos-ng contributors
+
+    http://github.com/BenjaminSoelberg/openchronos-ng-elf
+
+    This file is part of openchronos-ng.
+
+    openchronos-ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    openchronos-ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+/*!
+    \file energy.h
+    \brief Hooks for the energy model of tools/energy.py
+    \details Drivers mark where they switch a power hungry peripheral on and
+    off, the low power mode the main loop sleeps in and the MCLK frequency
+    the governor switches to. The firmware
+    compiles the hooks to nothing, the host simulation of tools/energy.py
+    defines ENERGY_TRACE and integrates the time spent in each state.
+*/
+
+#ifndef __ENERGY_H__
+#define __ENERGY_H__
+
+#include <stdint.h>
+
+/*!
+    \brief The peripherals with an on-time in the energy model.
+*/
+enum energy_sink {
+    ENERGY_ADC12,		/*!< ADC12_A converter, drivers/adc12 */
+    ENERGY_REF,			/*!< shared reference, drivers/adc12 */
+    ENERGY_BUZZER,		/*!< PWM driven buzzer, drivers/buzzer */
+    ENERGY_AS,			/*!< acceleration sensor, drivers/as and vti_as */
+    ENERGY_PS,			/*!< pressure sensor conversions, drivers/bmp_ps */
+    ENERGY_RADIO,		/*!< radio core, drivers/radio */
+    ENERGY_SINKS
+};
+
+#ifdef ENERGY_TRACE
+
+/*! the peripheral starts drawing current, nothing if it already does */
+void energy_on(enum energy_sink sink);
+
+/*! the peripheral stops drawing current */
+void energy_off(enum energy_sink sink);
+
+/*! the CPU goes to sleep in the given low power mode */
+void energy_lpm(uint16_t lpm_bits);
+
+/*! MCLK runs at mhz from now on, at the core voltage the governor pairs with it */
+void energy_mclk(uint8_t mhz);
+
+#else
+
+#define energy_on(sink)
+#define energy_off(sink)
+#define energy_lpm(lpm_bits)
+#define energy_mclk(mhz)
+
+#endif
+
+#endif				/* __ENERGY_H__ */
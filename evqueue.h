@@ -0,0 +1,135 @@
+/**
+    evqueue.h: openchronos-ng interrupt to main loop event queues
+
+    Copyright (C) 2026 openchronos-ng contributors
+
+    http://github.com/BenjaminSoelberg/openchronos-ng-elf
+
+    This file is part of openchronos-ng.
+
+    openchronos-ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    openchronos-ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+/*!
+    \file evqueue.h
+    \brief Interrupt to main loop event queues
+    \details Every interrupt source owns one queue: its ISR is the only
+    writer of <i>head</i> and the main loop the only writer of <i>tail</i>,
+    so neither side needs to disable interrupts. An event that finds the
+    queue full is counted in <i>dropped</i> and lost, evqueue_put() tells
+    the producer so that it can merge the event into its next one.
+    A driver that also queues events from the main loop must do so with
+    interrupts disabled, to remain the single producer.
+*/
+
+#ifndef __EVQUEUE_H__
+#define __EVQUEUE_H__
+
+#include <msp430.h>
+
+#include <stdint.h>
+
+/*!
+    \brief An event as queued by an interrupt handler.
+*/
+struct sys_event {
+    /*! #evqueue_seq when the event was queued, orders the events of all queues */
+    uint16_t seq;
+    /*! event bits of the source, see the driver of the queue */
+    uint16_t ev;
+    /*! payload, see the driver of the queue */
+    uint16_t data;
+};
+
+/*!
+    \brief A single producer, single consumer ring of events.
+    \details Holds up to <i>mask</i> events. Use #EVQUEUE_DEFINE to create one.
+*/
+struct evqueue {
+    /*! storage for mask + 1 events */
+    struct sys_event *buf;
+    /*! number of slots minus one, the number of slots is a power of two */
+    uint8_t mask;
+    /*! next slot to write, only written by the producer */
+    volatile uint8_t head;
+    /*! next slot to read, only written by the consumer */
+    volatile uint8_t tail;
+    /*! events lost because the queue was full, saturates at 255 */
+    volatile uint8_t dropped;
+};
+
+/*!
+    \brief Number of the next event queued, counted across all queues.
+    \details A wrapping count and not a timer stamp, so that the order
+    holds however long the main loop sleeps. Producers never interrupt
+    each other, see the file description.
+*/
+extern uint16_t evqueue_seq;
+
+/*!
+    \brief Defines a queue of <i>nr</i> slots, <i>nr</i> being a power of two.
+*/
+#define EVQUEUE_DEFINE(var, nr)					\
+    static struct sys_event var##_buf[(nr)];			\
+    struct evqueue var = { var##_buf, (nr) - 1, 0, 0, 0 }
+
+/* keeps the compiler from moving buffer accesses across index updates */
+#define evqueue_barrier() __asm__ __volatile__("" ::: "memory")
+
+/*!
+    \brief Queues an event, called by the producer only.
+    \return 1 if it was queued, 0 if the queue was full
+*/
+static inline uint8_t evqueue_put(struct evqueue *q, uint16_t ev, uint16_t data)
+{
+    uint8_t head = q->head;
+    uint8_t next = (head + 1) & q->mask;
+
+    if (next == q->tail) {
+	if (q->dropped != 0xff)
+	    q->dropped++;
+	return 0;
+    }
+
+    q->buf[head].seq = evqueue_seq++;
+    q->buf[head].ev = ev;
+    q->buf[head].data = data;
+    evqueue_barrier();
+    q->head = next;
+
+    return 1;
+}
+
+/*!
+    \brief Returns the oldest event without removing it, NULL if the queue is empty.
+*/
+static inline struct sys_event *evqueue_peek(struct evqueue *q)
+{
+    if (q->head == q->tail)
+	return NULL;
+
+    evqueue_barrier();
+    return &q->buf[q->tail];
+}
+
+/*!
+    \brief Removes the event returned by evqueue_peek().
+*/
+static inline void evqueue_pop(struct evqueue *q)
+{
+    evqueue_barrier();
+    q->tail = (q->tail + 1) & q->mask;
+}
+
+#endif				/* __EVQUEUE_H__ */
@@ -37,14 +37,11 @@
 #define MENUMODE_IDLE_MAX_COUNT 10
 #define MENU_EDITMODE_IDLE_MAX_COUNT 10
 
-/* The head of the linked list holding menu items */
-static struct menu *menu_head;
-
 /* Menu mode stuff */
 static struct {
     uint8_t enabled:1;		/* is menu mode enabled? */
-    struct menu *item;		/* the currently active menu item */
-    struct menu *start_item;	/* the original menu item */
+    uint8_t item;		/* index of the currently active menu item */
+    uint8_t start_item;		/* index of the original menu item */
     uint8_t idle_count;		/* number of idle polls counts */
 } menumode;
 
@@ -112,11 +109,18 @@ static void editmode_handler(void)
 /******************** Menu mode ********************/
 /***************************************************/
 
+/* handlers of the currently active menu item */
+static struct menu_handlers const *menu_fn(void)
+{
+    struct menu const *item = menu_table[menumode.item];
+
+    return item->override ? item->override : &item->fn;
+}
+
 static void menumode_select(void)
 {
     /* exit menu mode */
     menumode.enabled = 0;
-    menumode.start_item = NULL;
     menumode.idle_count = 0;
 
     /* clear both lines but keep symbols! */
@@ -131,8 +135,8 @@ static void menumode_select(void)
     display_chars(0, LCD_SEG_L2_4_0, NULL, BLINK_OFF);
 
     /* activate item */
-    if (menumode.item->activate_fn)
-	menumode.item->activate_fn();
+    if (menu_fn()->activate_fn)
+	menu_fn()->activate_fn();
 }
 
 void menumode_cancel(void)
@@ -148,14 +152,14 @@ static void menumode_start(void)
     menumode.idle_count = 0;
 
     /* deactivate current menu item */
-    if (menumode.item->deactivate_fn)
-	menumode.item->deactivate_fn();
+    if (menu_fn()->deactivate_fn)
+	menu_fn()->deactivate_fn();
 
     /* enable edit mode */
     menumode.enabled = 1;
 
     /* show MENU in the first line */
-    display_chars(0, LCD_SEG_L1_3_0, "MENU", SEG_SET);
+    display_label(0, LCD_SEG_L1_3_0, "MENU", SEG_SET);
 
     /* turn on up/down symbols */
     display_symbol(0, LCD_SYMB_ARROW_UP, SEG_ON);
@@ -163,23 +167,25 @@ static void menumode_start(void)
 
     /* show up blinking name of current selected item */
     display_chars(0, LCD_SEG_L2_4_0, NULL, BLINK_ON);
-    display_chars(0, LCD_SEG_L2_4_0, menumode.item->name, SEG_SET);
+    display_pattern(0, &menu_table[menumode.item]->name, SEG_SET);
 }
 
 static void menumode_next(void)
 {
     menumode.idle_count = 0;
-    menumode.item = menumode.item->next;
+    if (++menumode.item == menu_table_len)
+	menumode.item = 0;
     display_clear(0, 2);
-    display_chars(0, LCD_SEG_L2_4_0, menumode.item->name, SEG_SET);
+    display_pattern(0, &menu_table[menumode.item]->name, SEG_SET);
 }
 
 static void menumode_prev(void)
 {
     menumode.idle_count = 0;
-    menumode.item = menumode.item->prev;
+    if (menumode.item-- == 0)
+	menumode.item = menu_table_len - 1;
     display_clear(0, 2);
-    display_chars(0, LCD_SEG_L2_4_0, menumode.item->name, SEG_SET);
+    display_pattern(0, &menu_table[menumode.item]->name, SEG_SET);
 }
 
 static void menumode_handler(void)
@@ -198,35 +204,35 @@ static void menumode_handler(void)
 static void menuitem_handler(void)
 {
     if (ports_button_pressed(PORTS_BTN_LSTAR, 1)) {
-	if (menumode.item->lstar_btn_fn)
-	    menumode.item->lstar_btn_fn();
+	if (menu_fn()->lstar_btn_fn)
+	    menu_fn()->lstar_btn_fn();
 
     } else
 	if (ports_button_pressed
-	    (PORTS_BTN_STAR, !!(menumode.item->lstar_btn_fn))) {
+	    (PORTS_BTN_STAR, !!(menu_fn()->lstar_btn_fn))) {
 	menumode_start();
 
     } else if (ports_button_pressed(PORTS_BTN_LNUM, 1)) {
-	if (menumode.item->lnum_btn_fn)
-	    menumode.item->lnum_btn_fn();
+	if (menu_fn()->lnum_btn_fn)
+	    menu_fn()->lnum_btn_fn();
 
     } else
 	if (ports_button_pressed
-	    (PORTS_BTN_NUM, !!(menumode.item->lnum_btn_fn))) {
-	if (menumode.item->num_btn_fn)
-	    menumode.item->num_btn_fn();
+	    (PORTS_BTN_NUM, !!(menu_fn()->lnum_btn_fn))) {
+	if (menu_fn()->num_btn_fn)
+	    menu_fn()->num_btn_fn();
 
     } else if (ports_button_pressed(PORTS_BTN_UP | PORTS_BTN_DOWN, 0)) {
-	if (menumode.item->updown_btn_fn)
-	    menumode.item->updown_btn_fn();
+	if (menu_fn()->updown_btn_fn)
+	    menu_fn()->updown_btn_fn();
 
     } else if (ports_button_pressed(PORTS_BTN_UP, 0)) {
-	if (menumode.item->up_btn_fn)
-	    menumode.item->up_btn_fn();
+	if (menu_fn()->up_btn_fn)
+	    menu_fn()->up_btn_fn();
 
     } else if (ports_button_pressed(PORTS_BTN_DOWN, 0)) {
-	if (menumode.item->down_btn_fn)
-	    menumode.item->down_btn_fn();
+	if (menu_fn()->down_btn_fn)
+	    menu_fn()->down_btn_fn();
     }
 }
 
@@ -243,9 +249,16 @@ void menu_timeout_poll(void)
     }
 }
 
+uint8_t menu_timeout_pending(void)
+{
+    return menumode.enabled || menu_editmode.enabled;
+}
+
 void menu_check_buttons(void)
 {
-    if (menu_editmode.enabled) {
+    if (!menu_table_len) {
+	/* no module has a menu entry */
+    } else if (menu_editmode.enabled) {
 	editmode_handler();
     } else if (menumode.enabled) {
 	menumode_handler();
@@ -256,49 +269,12 @@ void menu_check_buttons(void)
     ports_buttons_clear();
 }
 
-struct menu *menu_add_entry(char const *name,
-			    void (*up_btn_fn) (void),
-			    void (*down_btn_fn) (void),
-			    void (*num_btn_fn) (void),
-			    void (*lstar_btn_fn) (void),
-			    void (*lnum_btn_fn) (void),
-			    void (*updown_btn_fn) (void),
-			    void (*activate_fn) (void),
-			    void (*deactivate_fn) (void))
+void menu_init(void)
 {
-    struct menu **menu_hd = &menu_head;
-    struct menu *menu_p;
-
-    if (!*menu_hd) {
-	/* Head is empty, create new menu item linked to itself */
-	menu_p = (struct menu *) malloc(sizeof(struct menu));
-	menu_p->next = menu_p;
-	menu_p->prev = menu_p;
-	*menu_hd = menu_p;
-
-	/* There wasnt any menu active, so we activate this one */
-	menumode.item = menu_p;
-	activate_fn();
-    } else {
-	/* insert new item before head */
-	menu_p = (struct menu *) malloc(sizeof(struct menu));
-	menu_p->next = (*menu_hd);
-	menu_p->prev = (*menu_hd)->prev;
-	(*menu_hd)->prev = menu_p;
-	menu_p->prev->next = menu_p;
-    }
+    menumode.item = 0;
 
-    menu_p->name = name;
-    menu_p->up_btn_fn = up_btn_fn;
-    menu_p->down_btn_fn = down_btn_fn;
-    menu_p->num_btn_fn = num_btn_fn;
-    menu_p->lstar_btn_fn = lstar_btn_fn;
-    menu_p->lnum_btn_fn = lnum_btn_fn;
-    menu_p->updown_btn_fn = updown_btn_fn;
-    menu_p->activate_fn = activate_fn;
-    menu_p->deactivate_fn = deactivate_fn;
-
-    return menu_p;
+    if (menu_table_len && menu_fn()->activate_fn)
+	menu_fn()->activate_fn();
 }
 
 void menu_editmode_start(void (*complete_fn) (void),
@@ -36,22 +36,7 @@
 
 #include <stdint.h>
 
-/*!
-    \brief Adds an entry to the main menu.
-    \details This function is to be used by modules, so that they can be visible in the main menu. A good place to call this function is from the corresponding module's _init function.
-    \note This function is NULL safe. You can set all of its parameters to NULL (except name) if you don't need their functionality.
-    \note The <i>name</i> string cannot be longer than 5 characters due to the LCD screen size.
-*/
-struct menu *menu_add_entry(char const *name,	/*!< item name to be displayed in the menu */
-			    void (*up_btn_fn) (void),	/*!< callback for up button presses. */
-			    void (*down_btn_fn) (void),	/*!< callback for down button presses. */
-			    void (*num_btn_fn) (void),	/*!< callback for num button presses. */
-			    void (*lstar_btn_fn) (void),	/*!< callback for long star button presses. */
-			    void (*lnum_btn_fn) (void),	/*!< callback for long num button presses. */
-			    void (*updown_btn_fn) (void),	/*!< callback for up&down button presses. */
-			    void (*activate_fn) (void),	/*!< callback for when the user switches into this entry in the menu. */
-			    void (*deactivate_fn) (void)	/*!< callback for when the user switches out from this entry in the menu. */
-    );
+#include "drivers/display.h"
 
 /*!
     \brief A item structure for menu_editmode_start.
@@ -64,7 +49,7 @@ struct menu_editmode_item {
 
 /*!
     \brief Enters edit mode.
-    \details The edit mode is a mechanism that allows the user to change values being displayed in the screen. For example, if a clock alarm is being displayed, then edit mode can be used to increase/decrease the values of hours and minutes. A good place to call this function is from the module's lstar_btn_fn function (see menu_add_entry()).<br />
+    \details The edit mode is a mechanism that allows the user to change values being displayed in the screen. For example, if a clock alarm is being displayed, then edit mode can be used to increase/decrease the values of hours and minutes. A good place to call this function is from the module's lstar_btn_fn function (see #menu_handlers).<br />
     See modules/alarm.c for an example how to use this.
 */
 void menu_editmode_start(
@@ -75,32 +60,78 @@ void menu_editmode_start(
 			    /*! A vector of #menu_editmode_item, it must be NULL terminated! */
 			    struct menu_editmode_item *items);
 
-/* Menu definitions and declarations */
-struct menu {
-    /* menu item name */
-    char const *name;
-    /* Pointer to up button handler */
+/*!
+    \brief Button and (de)activation handlers of a menu entry.
+    \note All of them can be NULL if you don't need their functionality.
+*/
+struct menu_handlers {
+    /*! callback for up button presses. */
     void (*up_btn_fn) (void);
-    /* Pointer to down button handler */
+    /*! callback for down button presses. */
     void (*down_btn_fn) (void);
-    /* Pointer to function button (NUM) */
+    /*! callback for num button presses. */
     void (*num_btn_fn) (void);
-    /* Pointer to settings button (long STAR) */
+    /*! callback for long star button presses. */
     void (*lstar_btn_fn) (void);
-    /* Pointer to function button (long NUM) */
+    /*! callback for long num button presses. */
     void (*lnum_btn_fn) (void);
-    /* Pointer to simultaneous up&down press */
+    /*! callback for up&down button presses. */
     void (*updown_btn_fn) (void);
-    /* Pointer to activate function */
+    /*! callback for when the user switches into this entry in the menu. */
     void (*activate_fn) (void);
-    /* Pointer to deactivate function */
+    /*! callback for when the user switches out from this entry in the menu. */
     void (*deactivate_fn) (void);
-    /* pointer to next menu item */
-    struct menu *next;
-    struct menu *prev;
 };
 
+/*!
+    \brief An entry of the main menu.
+    \details Modules that want to be visible in the main menu define one, named mod_<i>module</i>_menu, as a const so it stays in flash:<br />
+    <code>
+    const struct menu mod_battery_menu = {<br />
+    &nbsp;&nbsp;.name = MENU_NAME("BATT"),<br />
+    &nbsp;&nbsp;.fn = {<br />
+    &nbsp;&nbsp;&nbsp;&nbsp;.activate_fn = &battery_activate,<br />
+    &nbsp;&nbsp;&nbsp;&nbsp;.deactivate_fn = &battery_deactivate,<br />
+    &nbsp;&nbsp;},<br />
+    };<br />
+    </code>
+    tools/make_modinit.py collects the entries of the enabled modules into #menu_table, in the order given by their menu_order.
+    \note The <i>name</i> string cannot be longer than 5 characters due to the LCD screen size.
+*/
+struct menu {
+    /*! item name to be displayed in the menu, see #MENU_NAME() */
+    struct display_pattern name;
+    /*! the handlers of the entry */
+    struct menu_handlers fn;
+    /*! if not NULL, used instead of <i>fn</i>. Lets a module change its handlers at runtime by keeping them in RAM. */
+    struct menu_handlers *override;
+};
+
+/*!
+    \brief Renders a menu entry name at compile time, see #DISPLAY_PATTERN().
+*/
+#define MENU_NAME(str) DISPLAY_PATTERN(LCD_SEG_L2_4_0, str)
+
+/*!
+    \brief The main menu, generated in modinit.c.
+*/
+extern const struct menu *const menu_table[];
+/*!
+    \brief Number of entries in #menu_table.
+*/
+extern const uint8_t menu_table_len;
+
+/*!
+    \brief Activates the first entry of the menu, call once after mod_init().
+*/
+void menu_init(void);
+
 void menu_check_buttons(void);
 void menu_timeout_poll(void);
 
+/*!
+    \brief Returns non zero while menu_timeout_poll() needs to be called every second.
+*/
+uint8_t menu_timeout_pending(void);
+
 #endif				/* __MENU_H__ */
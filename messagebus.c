@@ -23,27 +23,194 @@
 **/
 
 #include "messagebus.h"
+#include "pool.h"
+
+#include "drivers/rtca.h"
+#include "drivers/timer.h"
+#include "drivers/crashlog.h"
+
+#define BUDGET_TICKS(us) ((uint16_t)((uint32_t)(us) * TIMER0_FREQ / 1000000ul))
 
 /* the message bus */
 static struct sys_messagebus *messagebus;
 
+/* A dispatch in progress. Callbacks may unregister, register and move
+   nodes, so the node to visit next is kept here, where unlinking it
+   advances it, and not read from a node that may be freed meanwhile.
+   Dispatches nest when a callback sends events. */
+struct dispatch {
+    struct sys_messagebus *next;
+    struct dispatch *outer;
+};
+
+static struct dispatch *dispatches;
+static uint8_t fresh_nodes;
+
+const struct sys_event *sys_messagebus_event;
+
+struct sys_messagebus_stats sys_messagebus_stats[SYS_PRIO_CLASSES];
+
+static const uint16_t default_budget[SYS_PRIO_CLASSES] = {
+    BUDGET_TICKS(SYS_BUDGET_INPUT_US),
+    BUDGET_TICKS(SYS_BUDGET_DISPLAY_US),
+    BUDGET_TICKS(SYS_BUDGET_BACKGROUND_US),
+};
+
+/* inserts the node after the last one of its class */
+static void link_node(struct sys_messagebus *node)
+{
+    struct sys_messagebus **p = &messagebus;
+
+    while (*p && (*p)->prio <= node->prio)
+	p = &(*p)->next;
+
+    node->next = *p;
+    *p = node;
+
+    /* the message being dispatched was meant for the nodes before */
+    node->fresh = dispatches != NULL;
+    fresh_nodes |= node->fresh;
+}
+
+/* the node leaves the list, no dispatch may visit it */
+static void unlink_node(struct sys_messagebus *node)
+{
+    struct dispatch *d;
+
+    for (d = dispatches; d; d = d->outer)
+	if (d->next == node)
+	    d->next = node->next;
+}
+
+static void dispatch_begin(struct dispatch *d)
+{
+    d->next = messagebus;
+    d->outer = dispatches;
+    dispatches = d;
+}
+
+/* the next node the dispatch calls, NULL at the end of the list */
+static struct sys_messagebus *dispatch_next(struct dispatch *d)
+{
+    struct sys_messagebus *node;
+
+    do {
+	node = d->next;
+	if (node)
+	    d->next = node->next;
+    } while (node && node->fresh);
+
+    return node;
+}
+
+static void dispatch_end(struct dispatch *d)
+{
+    struct sys_messagebus *p;
+
+    dispatches = d->outer;
+    if (dispatches || !fresh_nodes)
+	return;
+
+    for (p = messagebus; p; p = p->next)
+	p->fresh = 0;
+    fresh_nodes = 0;
+}
+
+/* calls the node, measuring the time it takes */
+static void call_node(struct sys_messagebus *node, enum sys_message msg)
+{
+    /* the callback may unregister and free its node */
+    struct sys_messagebus_stats *stats = &sys_messagebus_stats[node->prio];
+    uint16_t budget = node->budget;
+    uint16_t start = TA0R, elapsed;
+
+    crashlog_callback(node->fn);
+    node->fn(msg);
+
+    elapsed = TA0R - start;
+    if (elapsed > stats->worst)
+	stats->worst = elapsed;
+    if (elapsed > budget && stats->overruns != 0xffff)
+	stats->overruns++;
+}
+
 /***************************************************************************
  ************************* THE SYSTEM MESSAGE BUS **************************
  **************************************************************************/
 void sys_messagebus_register(void (*callback) (enum sys_message),
 			     enum sys_message listens)
 {
-    struct sys_messagebus **p = &messagebus;
+    sys_messagebus_register_every(callback, listens, 1, 0);
+}
+
+void sys_messagebus_register_every(void (*callback) (enum sys_message),
+				   enum sys_message listens,
+				   uint8_t divider, uint8_t phase)
+{
+    struct sys_messagebus *node;
+    int16_t now = -1;
+
+    /* 0 would divide by zero below, take it as every message */
+    if (divider == 0)
+	divider = 1;
 
+    /* whole minutes do not need the RTC to wake up every second */
+    if (listens == SYS_MSG_RTC_SECOND && divider >= 60
+	&& divider % 60 == 0 && phase % 60 == 0) {
+	listens = SYS_MSG_RTC_MINUTE;
+	divider /= 60;
+	phase /= 60;
+    }
+
+    /* the last message of this type was for the current second/minute */
+    if (listens == SYS_MSG_RTC_SECOND)
+	now = rtca_time.sec;
+    else if (listens == SYS_MSG_RTC_MINUTE)
+	now = rtca_time.min;
+
+    node = pool_alloc(&messagebus_pool);
+    node->fn = callback;
+    node->listens = listens;
+    node->divider = divider;
+    node->prio = SYS_PRIO_DISPLAY;
+    node->pending = SYS_MSG_NONE;
+    node->budget = default_budget[SYS_PRIO_DISPLAY];
+
+    if (now < 0) {
+	node->countdown = divider;
+    } else {
+	now = (phase - now - 1) % divider;
+	node->countdown = (now < 0 ? now + divider : now) + 1;
+    }
+
+    link_node(node);
+}
+
+void sys_messagebus_set_priority(void (*callback) (enum sys_message),
+				 enum sys_priority prio, uint16_t budget_us)
+{
+    struct sys_messagebus **p = &messagebus, *moved = NULL, *node;
+
+    /* take the nodes out of the list, then link them back in their class */
     while (*p) {
-	/* Set p to address of next pointer */
-	p = &(*p)->next;
+	if ((*p)->fn == callback) {
+	    node = *p;
+	    unlink_node(node);
+	    *p = node->next;
+	    node->next = moved;
+	    moved = node;
+	} else {
+	    p = &(*p)->next;
+	}
     }
 
-    *p = malloc(sizeof(struct sys_messagebus));
-    (*p)->next = NULL;
-    (*p)->fn = callback;
-    (*p)->listens = listens;
+    while (moved) {
+	node = moved;
+	moved = node->next;
+	node->prio = prio;
+	node->budget = budget_us ? BUDGET_TICKS(budget_us) : default_budget[prio];
+	link_node(node);
+    }
 }
 
 void sys_messagebus_unregister_all(void (*callback) (enum sys_message))
@@ -58,11 +225,12 @@ void sys_messagebus_unregister(void (*callback) (enum sys_message),
 
     while (p) {
 	if (p->fn == callback && (listens == 0 || p->listens == listens)) {
+	    unlink_node(p);
 	    if (!pp) {		// If 1. element
 		// Remove first element by pointing to the next
 		messagebus = p->next;
 		// Free element
-		free(p);
+		pool_free(&messagebus_pool, p);
 		// Set current pointer to point to new first element
 		p = messagebus;
 		// Keep pp the same (NULL)
@@ -70,7 +238,7 @@ void sys_messagebus_unregister(void (*callback) (enum sys_message),
 		// Remove element by pointing previous to the next
 		pp->next = p->next;
 		// Free element
-		free(p);
+		pool_free(&messagebus_pool, p);
 		// Set current pointer to point to next element
 		p = pp->next;
 		// Keep pp the same
@@ -84,18 +252,60 @@ void sys_messagebus_unregister(void (*callback) (enum sys_message),
     }
 }
 
-void send_events(enum sys_message msg)
+enum sys_message sys_messagebus_listens(void)
 {
     struct sys_messagebus *p = messagebus;
+    enum sys_message listens = SYS_MSG_NONE;
 
     while (p) {
-	/* notify listener if he registered for any of these messages */
+	listens |= p->listens;
+	p = p->next;
+    }
+
+    return listens;
+}
+
+void send_events(enum sys_message msg)
+{
+    struct dispatch d;
+    struct sys_messagebus *p;
+
+    dispatch_begin(&d);
+    while ((p = dispatch_next(&d))) {
+	/* notify listener if he registered for any of these messages
+	   and this is his turn */
 	enum sys_message filtered_msg = msg & p->listens;
-	if (filtered_msg) {
-	    p->fn(filtered_msg);
+	if (filtered_msg && --p->countdown == 0) {
+	    p->countdown = p->divider;
+	    if (p->prio == SYS_PRIO_BACKGROUND)
+		p->pending |= filtered_msg;
+	    else
+		call_node(p, filtered_msg);
 	}
+    }
+    dispatch_end(&d);
+}
 
-	/* move to next */
-	p = p->next;
+void sys_messagebus_background(void)
+{
+    struct dispatch d;
+    struct sys_messagebus *p;
+    enum sys_message msg;
+
+    dispatch_begin(&d);
+    while ((p = dispatch_next(&d))) {
+	if (p->pending) {
+	    msg = p->pending;
+	    p->pending = SYS_MSG_NONE;
+	    call_node(p, msg);
+	}
     }
+    dispatch_end(&d);
+}
+
+void send_event(const struct sys_event *ev, enum sys_message msg)
+{
+    sys_messagebus_event = ev;
+    send_events(msg);
+    sys_messagebus_event = NULL;
 }
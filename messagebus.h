@@ -36,6 +36,8 @@
 
 #include <stdint.h>
 
+#include "evqueue.h"
+
 /*!
     \brief List of possible message types for the message bus.
     \sa sys_messagebus_register()
@@ -64,17 +66,63 @@ enum sys_message {
 };
 
 /*!
-    \brief Linked list of nodes listening to the message bus.
+    \brief Priority classes of the message bus nodes.
+    \details Messages are delivered to the classes in this order. #SYS_PRIO_BACKGROUND nodes are called later, after the menu has handled the buttons.
+    \sa sys_messagebus_set_priority()
+*/
+enum sys_priority {
+    SYS_PRIO_INPUT = 0,		/*!< reacts to the user, e.g. stopping an alarm. */
+    SYS_PRIO_DISPLAY,		/*!< updates the screen, the default class. */
+    SYS_PRIO_BACKGROUND,	/*!< slow work: sensor reads, crypto, radio. */
+    SYS_PRIO_CLASSES
+};
+
+/*! \name Default time budget of a callback per class, in microseconds */
+/*@{*/
+#define SYS_BUDGET_INPUT_US 2000
+#define SYS_BUDGET_DISPLAY_US 10000
+#define SYS_BUDGET_BACKGROUND_US 50000
+/*@}*/
+
+/*!
+    \brief Linked list of nodes listening to the message bus, sorted by priority class.
 */
 struct sys_messagebus {
     /*! callback for receiving messages from the system bus */
     void (*fn) (enum sys_message);
     /*! bitfield of message types that the node wishes to receive */
     enum sys_message listens;
+    /*! receive one in every \b divider messages, 1 for all of them */
+    uint8_t divider;
+    /*! messages left until the next delivery */
+    uint8_t countdown;
+    /*! priority class, see #sys_priority */
+    uint8_t prio;
+    /*! linked by a callback, the dispatch in progress skips it */
+    uint8_t fresh;
+    /*! messages waiting for a #SYS_PRIO_BACKGROUND node */
+    enum sys_message pending;
+    /*! time the callback may take, in TA0R ticks */
+    uint16_t budget;
     /*! pointer to the next node in the list */
     struct sys_messagebus *next;
 };
 
+/*!
+    \brief Callback timings of a priority class.
+*/
+struct sys_messagebus_stats {
+    /*! longest callback, in TA0R ticks (1/16384 s) */
+    uint16_t worst;
+    /*! callbacks that took longer than their budget, saturates */
+    uint16_t overruns;
+};
+
+/*!
+    \brief Callback timings per #sys_priority class, since boot.
+*/
+extern struct sys_messagebus_stats sys_messagebus_stats[SYS_PRIO_CLASSES];
+
 /*!
     \brief Registers a node in the message bus.
     \details Registers (add) a node to the message bus. A node can filter what message(s) are to be received by setting the bitfield \b listens.
@@ -86,6 +134,36 @@ void sys_messagebus_register(
 				/*! only receive messages of this type */
 				enum sys_message listens);
 
+/*!
+    \brief Registers a node that receives one in every \b divider messages.
+    \details Skipped messages only cost a decrement, the callback is not called. For #SYS_MSG_RTC_SECOND and #SYS_MSG_RTC_MINUTE, deliveries are aligned so that the second (minute) of the delivered messages modulo \b divider is \b phase, e.g. a divider of 30 and a phase of 0 delivers at :00 and :30. Other messages are delivered every \b divider messages counted from now, \b phase is ignored.<br />
+    A #SYS_MSG_RTC_SECOND node whose divider and phase are multiples of 60 is served by minute messages, so the RTC can stop waking the CPU every second. Its callback then receives #SYS_MSG_RTC_MINUTE.<br />
+    Listen to a single message type, since every message type counts towards the divider.
+    \sa sys_messagebus_register
+*/
+void sys_messagebus_register_every(
+				/*! callback to receive messages from the message bus */
+				void (*callback) (enum sys_message),
+				/*! only receive messages of this type */
+				enum sys_message listens,
+				/*! receive one in every divider messages, 0 is taken as 1 */
+				uint8_t divider,
+				/*! second or minute to align the deliveries to, below divider */
+				uint8_t phase);
+
+/*!
+    \brief Moves the nodes of a callback to a priority class.
+    \details Applies to the nodes already registered with \b callback, call it after registering. Nodes are #SYS_PRIO_DISPLAY with its default budget until then.<br />
+    #SYS_PRIO_BACKGROUND callbacks receive the messages that arrived since their last call at once, and #sys_messagebus_event is NULL for them.
+*/
+void sys_messagebus_set_priority(
+				    /*! the same callback used on sys_messagebus_register() */
+				    void (*callback) (enum sys_message),
+				    /*! the class */
+				    enum sys_priority prio,
+				    /*! how long the callback may take in microseconds, 0 for the default of the class */
+				    uint16_t budget_us);
+
 /*!
     \brief Unregisters a node from the message bus.
     \sa sys_messagebus_register
@@ -105,10 +183,35 @@ void sys_messagebus_unregister(
 				  /*! the same message used on sys_messagebus_register() */
 				  enum sys_message listens);
 
+/*!
+    \brief Returns all the message types listened to on the message bus.
+    \details Lets drivers stop generating messages nobody listens to.
+*/
+enum sys_message sys_messagebus_listens(void);
+
 /*!
     \brief Send a message to all listening nodes on the message bus.
+    \details #SYS_PRIO_BACKGROUND nodes only get it on the next sys_messagebus_background().
     \sa sys_messagebus_register, sys_messagebus_unregister
 */
 void send_events(enum sys_message msg);
 
+/*!
+    \brief Calls the #SYS_PRIO_BACKGROUND nodes that have messages waiting.
+    \note For the main loop only, after the buttons are handled.
+*/
+void sys_messagebus_background(void);
+
+/*!
+    \brief Send a message produced by a queued interrupt event.
+    \details Like send_events(), with #sys_messagebus_event pointing to \b ev during the callbacks.
+*/
+void send_event(const struct sys_event *ev, enum sys_message msg);
+
+/*!
+    \brief The interrupt event behind the message being sent, NULL for other messages.
+    \details Lets a callback read the payload and the TA0R timestamp of the event, see evqueue.h.
+*/
+extern const struct sys_event *sys_messagebus_event;
+
 #endif				/* __MESSAGEBUS_H__ */
@@ -24,6 +24,7 @@
 
 #include "messagebus.h"
 #include "menu.h"
+#include "tunes.h"
 
 /* drivers */
 #include "drivers/rtca.h"
@@ -54,7 +55,6 @@ const uint16_t mgrav_per_bit[7] = { 18, 36, 71, 143, 286, 571, 1142 };
 
 // *** Tunes for accelerometer synestesia
 
-static note smb[] = { 0x2588, 0x000F };
 
 // *************************************************************************************************
 // Global Variable section
@@ -150,28 +150,28 @@ void update_menu()
      case VIEW_SET_MODE:
 
 	  if (as_config.mode == FALL_MODE)
-	       display_chars(0, LCD_SEG_L1_3_0, "FALL", SEG_SET);
+	       display_label(0, LCD_SEG_L1_3_0, "FALL", SEG_SET);
 	  else if (as_config.mode == MEASUREMENT_MODE)
-	       display_chars(0, LCD_SEG_L1_3_0, "MEAS", SEG_SET);
+	       display_label(0, LCD_SEG_L1_3_0, "MEAS", SEG_SET);
 	  else if (as_config.mode == ACTIVITY_MODE)
-	       display_chars(0, LCD_SEG_L1_3_0, "ACTI", SEG_SET);
+	       display_label(0, LCD_SEG_L1_3_0, "ACTI", SEG_SET);
 
-	  display_chars(0, LCD_SEG_L2_4_0, "MODE", SEG_SET);
+	  display_label(0, LCD_SEG_L2_4_0, "MODE", SEG_SET);
 	  break;
 
      case VIEW_SET_PARAMS:
 
-	  display_chars(0, LCD_SEG_L2_4_0, "SETS", SEG_SET);
+	  display_label(0, LCD_SEG_L2_4_0, "SETS", SEG_SET);
 	  break;
 
      case VIEW_STATUS:
 
-	  display_chars(0, LCD_SEG_L2_4_0, "STAT", SEG_SET);
+	  display_label(0, LCD_SEG_L2_4_0, "STAT", SEG_SET);
 	  break;
 
      case VIEW_AXIS:
 
-	  display_chars(0, LCD_SEG_L2_4_0, "DATA", SEG_SET);
+	  display_label(0, LCD_SEG_L2_4_0, "DATA", SEG_SET);
 	  break;
 
      default:
@@ -217,7 +217,7 @@ static void up_btn()
 
      case VIEW_AXIS:
 
-	  display_chars(0, LCD_SEG_L1_3_0, "TODO", SEG_SET);
+	  display_label(0, LCD_SEG_L1_3_0, "TODO", SEG_SET);
 	  break;
 
      default:
@@ -320,7 +320,7 @@ static void as_event(enum sys_message msg)
 	  as_status.all_flags = as_get_status();
 	  //TODO For debugging only
 	  _printf(0, LCD_SEG_L1_1_0, "%1u", as_status.all_flags);
-	  buzzer_play(smb);
+	  buzzer_play(tune_smb);
 	  //if we were in free fall or motion detection mode check for the event
 	  if (as_status.int_status.falldet || as_status.int_status.motiondet) {
 
@@ -404,8 +404,8 @@ static void acc_activated()
 	  // After this call interrupts will be generated
      }
 
-     display_chars(0, LCD_SEG_L1_3_0, "ACTI", SEG_SET);
-     display_chars(0, LCD_SEG_L2_4_0, "MODE", SEG_SET);
+     display_label(0, LCD_SEG_L1_3_0, "ACTI", SEG_SET);
+     display_label(0, LCD_SEG_L2_4_0, "MODE", SEG_SET);
 
 
 
@@ -458,9 +458,20 @@ static void acc_deactivated()
 
 
 
+const struct menu mod_accelerometer_b_menu = {
+     .name = MENU_NAME("ACC"),
+     .fn = {
+	  .up_btn_fn = &up_btn,
+	  .down_btn_fn = &down_btn,
+	  .num_btn_fn = &num_pressed,
+	  .lstar_btn_fn = &star_long_pressed,
+	  .activate_fn = &acc_activated,
+	  .deactivate_fn = &acc_deactivated,
+     },
+};
+
 void mod_accelerometer_b_init()
 {
-
      //if this is called only one time after reboot there are some important things to initialise
      //Initialise sAccel struct?
      sAccel.data = 0;
@@ -469,12 +480,4 @@ void mod_accelerometer_b_init()
      sAccel.timeout = ACCEL_MEASUREMENT_TIMEOUT;
      /* Clear mode */
      sAccel.mode = ACCEL_MODE_OFF;
-
-     menu_add_entry("ACC",
-		    &up_btn,
-		    &down_btn,
-		    &num_pressed,
-		    &star_long_pressed,
-		    NULL, NULL, &acc_activated, &acc_deactivated);
-
 }
@@ -34,6 +34,7 @@
 #include "drivers/as.h"
 #include "drivers/bmp_as.h"
 #include "drivers/timer.h"
+#include "drivers/governor.h"
 
 #include <math.h>
 
@@ -49,6 +50,7 @@ static void print_acc(void)
      uint8_t dec;
      int8_t tmp;
 
+     governor_boost();
      for (j = 0, vals[3] = 0; j < 3; j++) {
 	  vals[j] = axes[j] * scale_factor;
 	  vals[3] += vals[j] * vals[j];
@@ -56,27 +58,28 @@ static void print_acc(void)
      vals[3] = sqrtf(vals[3]);	// Modulus of acceleration vector.
      vals[4] = atan2f(vals[0], vals[2]) * 5729; // Pitch angle. Convert from rad to deg and multiply by 100.
      vals[5] = atan2f(vals[1], vals[2]) * 5729; // Roll angle.
+     governor_release();
 
 
      display_symbol(0, LCD_SEG_L2_DP, SEG_SET);
      switch (i) {
      case 0:
-	  display_chars(0, LCD_SEG_L1_3_0, "  X ", SEG_SET);
+	  display_label(0, LCD_SEG_L1_3_0, "  X ", SEG_SET);
 	  break;
      case 1:
-	  display_chars(0, LCD_SEG_L1_3_0, "  Y ", SEG_SET);
+	  display_label(0, LCD_SEG_L1_3_0, "  Y ", SEG_SET);
 	  break;
      case 2:
-	  display_chars(0, LCD_SEG_L1_3_0, "  Z ", SEG_SET);
+	  display_label(0, LCD_SEG_L1_3_0, "  Z ", SEG_SET);
 	  break;
      case 3:
-	  display_chars(0, LCD_SEG_L1_3_0, "ABSO", SEG_SET);
+	  display_label(0, LCD_SEG_L1_3_0, "ABSO", SEG_SET);
 	  break;
      case 4:
-       	  display_chars(0, LCD_SEG_L1_3_0, "PITC", SEG_SET);
+       	  display_label(0, LCD_SEG_L1_3_0, "PITC", SEG_SET);
 	  break;
      case 5:
-       	  display_chars(0, LCD_SEG_L1_3_0, "ROLL", SEG_SET);
+       	  display_label(0, LCD_SEG_L1_3_0, "ROLL", SEG_SET);
 	  break;
      }
 
@@ -153,30 +156,35 @@ static void num_pressed(void)
      switch (scale) {
      case 0:
 	  bmp_as_start(BMP_GRANGE_2G, BMP_BWD_62HZ, BMP_SLEEP_1000MS, 1);
-	  display_chars(0, LCD_SEG_L1_3_0, " 2 G", SEG_SET | BLINK_SET);
+	  display_label(0, LCD_SEG_L1_3_0, " 2 G", SEG_SET | BLINK_SET);
 	  break;
      case 1:
 	  bmp_as_start(BMP_GRANGE_4G, BMP_BWD_62HZ, BMP_SLEEP_1000MS, 1);
-	  display_chars(0, LCD_SEG_L1_3_0, " 4 G", SEG_SET | BLINK_SET);
+	  display_label(0, LCD_SEG_L1_3_0, " 4 G", SEG_SET | BLINK_SET);
 	  break;
      case 2:
 	  bmp_as_start(BMP_GRANGE_8G, BMP_BWD_62HZ, BMP_SLEEP_1000MS, 1);
-	  display_chars(0, LCD_SEG_L1_3_0, " 8 G", SEG_SET | BLINK_SET);
+	  display_label(0, LCD_SEG_L1_3_0, " 8 G", SEG_SET | BLINK_SET);
 	  break;
      case 3:
 	  bmp_as_start(BMP_GRANGE_16G, BMP_BWD_62HZ, BMP_SLEEP_1000MS, 1);
-	  display_chars(0, LCD_SEG_L1_3_0, "16 G", SEG_SET | BLINK_SET);
+	  display_label(0, LCD_SEG_L1_3_0, "16 G", SEG_SET | BLINK_SET);
 	  break;
      }
 
      timer0_delay(1000, LPM3_bits);
-     display_chars(0, LCD_SEG_L1_3_0, "8888", SEG_OFF | BLINK_OFF);
+     display_label(0, LCD_SEG_L1_3_0, "8888", SEG_OFF | BLINK_OFF);
      axes[0] = axes[1] = axes[2] = 0;
      print_acc();
 }
 
-void mod_accelerometer_w_init(void)
-{
-     menu_add_entry("ACCEL", &up_btn, &down_btn, &num_pressed, NULL, NULL,
-		    NULL, &acc_activate, &acc_deactivate);
-}
+const struct menu mod_accelerometer_w_menu = {
+     .name = MENU_NAME("ACCEL"),
+     .fn = {
+	  .up_btn_fn = &up_btn,
+	  .down_btn_fn = &down_btn,
+	  .num_btn_fn = &num_pressed,
+	  .activate_fn = &acc_activate,
+	  .deactivate_fn = &acc_deactivate,
+     },
+};
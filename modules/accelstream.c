@@ -0,0 +1,226 @@
+/**
+   modules/accelstream.c: accelerometer RF streaming module for openchronos-ng
+
+   Copyright (C) 2026 openchronos-ng contributors
+
+   http://github.com/HashakGik/openchronos-ng-elf
+
+   This file is part of openchronos-ng.
+
+   openchronos-ng is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   openchronos-ng is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <string.h>
+
+#include "messagebus.h"
+#include "menu.h"
+
+#include "drivers/display.h"
+#include "drivers/as.h"
+#include "drivers/bmp_as.h"
+#include "drivers/radio.h"
+
+/* Streams the 10 bit BMA250 samples as raw radio packets instead of answering one
+   BM_SPL_GetData poll per sample. Each packet carries a keyframe followed by the
+   per-axis differences between consecutive samples, all packed into a bitstream:
+
+   byte 0      sequence number
+   byte 1      number of samples (keyframe included)
+   byte 2      g range index in the high nibble, delta width in bits (0-11) in the low nibble
+   byte 3..    keyframe X, Y, Z as 10 bit two's complement, then (count - 1) * 3 deltas
+	       of 'width' bits each, two's complement, MSB first
+
+   contrib/accelstream.py decodes this format. */
+
+#define STREAM_MAX_SAMPLES 24
+#define STREAM_HEADER_LEN 3
+#define STREAM_KEYFRAME_BITS 30
+
+static int16_t samples[STREAM_MAX_SAMPLES][3];
+static uint8_t nsamples;
+static uint8_t width;
+static uint8_t seq;
+static uint8_t range;
+static uint16_t packets_sent;
+
+/* packet[0] is the length byte expected by radio_raw_send() */
+static uint8_t packet[RADIO_RAW_MAX_PAYLOAD + 1];
+static uint8_t *bit_ptr;
+static uint8_t bit_pos;
+
+static const uint8_t grange[4] = { BMP_GRANGE_2G, BMP_GRANGE_4G,
+     BMP_GRANGE_8G, BMP_GRANGE_16G };
+
+static uint8_t packed_len(uint8_t count, uint8_t w)
+{
+     return STREAM_HEADER_LEN +
+	  (STREAM_KEYFRAME_BITS + 3 * w * (count - 1) + 7) / 8;
+}
+
+/* Number of bits needed to store d as two's complement, 0 if d is 0. */
+static uint8_t delta_width(int16_t d)
+{
+     uint8_t w;
+
+     if (d == 0)
+	  return 0;
+
+     if (d < 0)
+	  d = ~d;
+
+     for (w = 1; d; w++)
+	  d >>= 1;
+
+     return w;
+}
+
+static void put_bits(uint16_t v, uint8_t n)
+{
+     while (n--) {
+	  if (v & (1u << n))
+	       *bit_ptr |= 0x80 >> bit_pos;
+	  if (++bit_pos == 8) {
+	       bit_pos = 0;
+	       bit_ptr++;
+	  }
+     }
+}
+
+static void stream_flush(void)
+{
+     uint8_t s, i;
+
+     if (nsamples == 0)
+	  return;
+
+     memset(packet, 0, sizeof(packet));
+     packet[0] = packed_len(nsamples, width);
+     packet[1] = seq++;
+     packet[2] = nsamples;
+     packet[3] = (range << 4) | width;
+
+     bit_ptr = &packet[1 + STREAM_HEADER_LEN];
+     bit_pos = 0;
+
+     for (i = 0; i < 3; i++)
+	  put_bits(samples[0][i], 10);
+
+     for (s = 1; s < nsamples; s++)
+	  for (i = 0; i < 3; i++)
+	       put_bits(samples[s][i] - samples[s - 1][i], width);
+
+     if (radio_raw_send(packet))
+	  packets_sent++;
+
+     nsamples = 0;
+     width = 0;
+
+     _printf(0, LCD_SEG_L1_3_0, "%4u", packets_sent % 10000);
+}
+
+static void stream_push(int16_t *axes)
+{
+     uint8_t w = width;
+     uint8_t i, d;
+
+     if (nsamples > 0) {
+	  for (i = 0; i < 3; i++) {
+	       d = delta_width(axes[i] - samples[nsamples - 1][i]);
+	       if (d > w)
+		    w = d;
+	  }
+
+	  /* Send what we have if this sample does not fit anymore */
+	  if (nsamples == STREAM_MAX_SAMPLES
+	      || packed_len(nsamples + 1, w) > RADIO_RAW_MAX_PAYLOAD) {
+	       stream_flush();
+	       w = 0;
+	  }
+     }
+
+     memcpy(samples[nsamples++], axes, sizeof(samples[0]));
+     width = w;
+}
+
+static void stream_event(enum sys_message msg)
+{
+     int16_t axes[3];
+
+     bmp_as_get_data(axes);
+     stream_push(axes);
+}
+
+static void stream_start(void)
+{
+     bmp_as_interrupts_t ints;
+
+     nsamples = 0;
+     width = 0;
+
+     /* 62.5Hz bandwidth gives a new sample every 8ms */
+     bmp_as_start(grange[range], BMP_BWD_62HZ, BMP_SLEEP_NO, 0);
+
+     ints = bmp_as_init_interrupts();
+     ints.new_interrupt = 1;
+     bmp_as_enable_interrupts(ints);
+}
+
+static void stream_stop(void)
+{
+     bmp_as_disable_interrupts();
+     bmp_as_stop();
+     stream_flush();
+}
+
+static void num_pressed(void)
+{
+     stream_stop();
+     range = (range + 1) % 4;
+     _printf(0, LCD_SEG_L2_1_0, "%2u", 2 << range);
+     stream_start();
+}
+
+static void accelstream_activate(void)
+{
+     seq = 0;
+     packets_sent = 0;
+
+     display_label(0, LCD_SEG_L2_4_2, "STR", SEG_SET);
+     _printf(0, LCD_SEG_L2_1_0, "%2u", 2 << range);
+     display_label(0, LCD_SEG_L1_3_0, "   0", SEG_SET);
+
+     radio_raw_open();
+     as_init();
+     stream_start();
+
+     sys_messagebus_register(&stream_event, SYS_MSG_AS_INT);
+}
+
+static void accelstream_deactivate(void)
+{
+     sys_messagebus_unregister_all(&stream_event);
+     stream_stop();
+     close_radio();
+
+     display_clear(0, 0);
+}
+
+const struct menu mod_accelstream_menu = {
+     .name = MENU_NAME("ASTRM"),
+     .fn = {
+	  .num_btn_fn = &num_pressed,
+	  .activate_fn = &accelstream_activate,
+	  .deactivate_fn = &accelstream_deactivate,
+     },
+};
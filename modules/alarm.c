@@ -24,26 +24,143 @@
 
 #include "messagebus.h"
 #include "menu.h"
+#include "tunes.h"
 
 /* drivers */
 #include "drivers/display.h"
 #include "drivers/rtca.h"
 #include "drivers/buzzer.h"
 #include "drivers/ports.h"
+#include "drivers/infomem.h"
+
+#ifndef CONFIG_MOD_ALARM_COUNT
+#define CONFIG_MOD_ALARM_COUNT 4
+#endif
+
+#ifndef CONFIG_MOD_ALARM_SNOOZE
+#define CONFIG_MOD_ALARM_SNOOZE 5
+#endif
+
+/* Alarms are scheduled in minutes since sunday 00:00. Only the nearest
+   upcoming alarm, snooze or chime is programmed into the RTC_A alarm
+   registers, so the CPU is woken up exactly when something rings.
+   contrib/alarmsim.py models this scheduler. */
+#define ALARM_DAY	(24 * 60u)
+#define ALARM_WEEK	(7 * ALARM_DAY)
+#define ALARM_NONE	0xffff
+
+/* bit n of days rings on day of week n, 0 being sunday */
+#define ALARM_DAILY	0x7f
+#define ALARM_WEEKDAYS	0x3e
+#define ALARM_WEEKEND	0x41
+/* turn the alarm off once it has rung */
+#define ALARM_ONCE	0x80
+
+#define ALARM_INFOMEM_ID 'A'
+
+struct alarm {
+     uint8_t hour;
+     uint8_t min;
+     uint8_t days;
+     uint8_t on;
+};
+
+/* Stored as a whole in infomem, keep it a multiple of words */
+static struct {
+     struct alarm alarms[CONFIG_MOD_ALARM_COUNT];
+     uint8_t chime;
+     uint8_t reserved;
+} alarm_cfg;
+
+static uint16_t snooze = ALARM_NONE;
+static uint8_t sel;
+/* rtca_sets when the alarms were last checked */
+static uint8_t sets_seen;
+
+static const uint8_t days_presets[] = {
+     ALARM_ONCE | ALARM_DAILY, ALARM_DAILY, ALARM_WEEKDAYS, ALARM_WEEKEND,
+     BIT0, BIT1, BIT2, BIT3, BIT4, BIT5, BIT6
+};
 
-static union {
-     struct {
-	  /* one shot alarm */
-	  uint8_t alarm:1;
-	  /* hourly chime */
-	  uint8_t chime:1;
-     };
-     uint8_t state:2;
-} alarm_state;
+static const struct display_pattern days_names[] = {
+     DISPLAY_PATTERN(LCD_SEG_L2_4_0, "ONCE "),
+     DISPLAY_PATTERN(LCD_SEG_L2_4_0, "DAILY"),
+     DISPLAY_PATTERN(LCD_SEG_L2_4_0, "WKDAY"),
+     DISPLAY_PATTERN(LCD_SEG_L2_4_0, "WKEND"),
+     DISPLAY_PATTERN(LCD_SEG_L2_4_0, "SUN  "),
+     DISPLAY_PATTERN(LCD_SEG_L2_4_0, "MON  "),
+     DISPLAY_PATTERN(LCD_SEG_L2_4_0, "TUE  "),
+     DISPLAY_PATTERN(LCD_SEG_L2_4_0, "WED  "),
+     DISPLAY_PATTERN(LCD_SEG_L2_4_0, "THU  "),
+     DISPLAY_PATTERN(LCD_SEG_L2_4_0, "FRI  "),
+     DISPLAY_PATTERN(LCD_SEG_L2_4_0, "SAT  "),
+};
+
+static uint8_t tmp_hh, tmp_mm, tmp_days;
+
+static uint16_t now_minutes(void)
+{
+     return rtca_time.dow * ALARM_DAY + rtca_time.hour * 60u + rtca_time.min;
+}
+
+/* Minutes from now until t, a full week if t is now */
+static uint16_t minutes_until(uint16_t t, uint16_t now)
+{
+     return (t > now ? t : t + ALARM_WEEK) - now;
+}
+
+static void alarm_schedule(void)
+{
+     uint16_t now = now_minutes();
+     uint16_t next = ALARM_NONE;
+     uint16_t t;
+     uint8_t i, d;
 
-static uint8_t tmp_hh, tmp_mm;
-static note chime_notes[2] = { 0x1931, 0x000F };
-static note alarm_notes[4] = { 0x3234, 0x1900, 0x3234, 0x000F };
+     for (i = 0; i < CONFIG_MOD_ALARM_COUNT; i++) {
+	  struct alarm *a = &alarm_cfg.alarms[i];
+
+	  if (!a->on)
+	       continue;
+
+	  for (d = 0; d < 7; d++) {
+	       if (!(a->days & (1 << d)))
+		    continue;
+
+	       t = minutes_until(d * ALARM_DAY + a->hour * 60u + a->min, now);
+	       if (t < next)
+		    next = t;
+	  }
+     }
+
+     if (snooze != ALARM_NONE) {
+	  t = minutes_until(snooze, now);
+	  if (t < next)
+	       next = t;
+     }
+
+     if (alarm_cfg.chime) {
+	  t = 60 - rtca_time.min;
+	  if (t < next)
+	       next = t;
+     }
+
+     if (next == ALARM_NONE) {
+	  rtca_disable_alarm();
+	  return;
+     }
+
+     t = (now + next) % ALARM_WEEK;
+     rtca_set_alarm_at(t / ALARM_DAY, (t / 60) % 24, t % 60);
+}
+
+static void alarm_save(void)
+{
+#ifdef CONFIG_INFOMEM
+     infomem_app_replace(ALARM_INFOMEM_ID, (uint16_t *)&alarm_cfg,
+			 sizeof(alarm_cfg) / 2);
+#endif
+     alarm_schedule();
+}
 
 static void print_mm(void)
 {
@@ -73,38 +190,104 @@ static void print_hh(void)
      }
 }
 
+static void print_days(void)
+{
+     uint8_t i;
+
+     for (i = 0; i < sizeof(days_presets); i++) {
+	  if (days_presets[i] == tmp_days) {
+	       display_pattern(0, &days_names[i], SEG_SET);
+	       return;
+	  }
+     }
+     display_label(0, LCD_SEG_L2_4_0, "-----", SEG_SET);
+}
+
 static void refresh_screen()
 {
-     rtca_get_alarm(&tmp_hh, &tmp_mm);
+     struct alarm *a = &alarm_cfg.alarms[sel];
+
+     tmp_hh = a->hour;
+     tmp_mm = a->min;
      print_hh();
      print_mm();
+     _printf(0, LCD_SEG_L2_4_0, "AL %2u", sel + 1);
+
+     display_symbol(0, LCD_ICON_ALARM, a->on ? SEG_ON : SEG_OFF);
+     display_symbol(0, LCD_ICON_BEEPER2, alarm_cfg.chime ? SEG_ON : SEG_OFF);
+     display_symbol(0, LCD_ICON_BEEPER3, alarm_cfg.chime ? SEG_ON : SEG_OFF);
 }
 
 static uint8_t alarm_sec_elapsed = 0;
-static void alarm_event(enum sys_message msg)
+static void ring_event(enum sys_message msg)
 {
      if (msg & SYS_MSG_BUTTON || alarm_sec_elapsed >= 30) {
+	  /* any button but NUM snoozes */
+	  if (msg & SYS_MSG_BUTTON
+	      && !ports_button_pressed_peek(PORTS_BTN_NUM, 0)) {
+	       snooze = (now_minutes() + CONFIG_MOD_ALARM_SNOOZE) % ALARM_WEEK;
+	       alarm_schedule();
+	  }
 	  alarm_sec_elapsed = 0;
 	  ports_buttons_clear();
-	  sys_messagebus_unregister(&alarm_event,
+	  sys_messagebus_unregister(&ring_event,
 				    SYS_MSG_BUTTON | SYS_MSG_RTC_SECOND);
 	  return;
      }
 
-     if (msg & SYS_MSG_RTC_ALARM) {
-	  sys_messagebus_register(&alarm_event,
-				  SYS_MSG_BUTTON | SYS_MSG_RTC_SECOND);
-     }
-
      alarm_sec_elapsed++;
-     buzzer_play(alarm_notes);
+     buzzer_play(tune_alarm);
 }
 
-static void hour_event(enum sys_message msg)
+/* The RTC alarm fired or the clock was changed, see what is due now */
+static void alarm_event(enum sys_message msg)
 {
-     if (msg & SYS_MSG_RTC_HOUR) {
-	  buzzer_play(chime_notes);
+     uint16_t now = now_minutes();
+     uint8_t ring = 0, changed = 0;
+     uint8_t i;
+
+     /* A clock change moved the time onto a new minute rather than
+	reaching it: nothing rings, and a snooze is meant for the old time */
+     if (rtca_sets != sets_seen) {
+	  sets_seen = rtca_sets;
+	  snooze = ALARM_NONE;
+	  alarm_schedule();
+	  return;
+     }
+
+     for (i = 0; i < CONFIG_MOD_ALARM_COUNT; i++) {
+	  struct alarm *a = &alarm_cfg.alarms[i];
+
+	  if (!a->on || !(a->days & (1 << rtca_time.dow))
+	      || a->hour != rtca_time.hour || a->min != rtca_time.min)
+	       continue;
+
+	  ring = 1;
+	  if (a->days & ALARM_ONCE) {
+	       a->on = 0;
+	       changed = 1;
+	  }
+     }
+
+     if (snooze == now) {
+	  snooze = ALARM_NONE;
+	  ring = 1;
+     }
+
+     if (ring) {
+	  alarm_sec_elapsed = 0;
+	  sys_messagebus_register(&ring_event,
+				  SYS_MSG_BUTTON | SYS_MSG_RTC_SECOND);
+	  sys_messagebus_set_priority(&ring_event, SYS_PRIO_INPUT, 0);
+	  buzzer_play(tune_alarm);
+     } else if (alarm_cfg.chime && rtca_time.min == 0) {
+	  buzzer_play(tune_chime);
      }
+
+     if (changed)
+	  alarm_save();
+     else
+	  alarm_schedule();
 }
 
 /*************************** edit mode callbacks **************************/
@@ -143,17 +326,54 @@ static void edit_mm_set(int8_t step)
      print_mm();
 }
 
+/* Days */
+static void edit_days_sel(void)
+{
+     print_days();
+     display_chars(0, LCD_SEG_L2_4_0, NULL, BLINK_ON);
+}
+
+static void edit_days_dsel(void)
+{
+     display_chars(0, LCD_SEG_L2_4_0, NULL, BLINK_OFF);
+}
+
+static void edit_days_set(int8_t step)
+{
+     uint8_t i = 0;
+
+     while (i < sizeof(days_presets) - 1 && days_presets[i] != tmp_days)
+	  i++;
+
+     helpers_loop(&i, 0, sizeof(days_presets) - 1, step);
+     tmp_days = days_presets[i];
+     print_days();
+}
+
 /* Save */
 static void edit_save(void)
 {
      /* Here we return from the edit mode, fill in the new values! */
-     rtca_set_alarm(tmp_hh, tmp_mm);
+     struct alarm *a = &alarm_cfg.alarms[sel];
+
+     a->hour = tmp_hh;
+     a->min = tmp_mm;
+     a->days = tmp_days;
+     a->on = 1;
+     alarm_save();
+     refresh_screen();
+}
+
+static void edit_cancel(void)
+{
+     refresh_screen();
 }
 
 /* edit mode item table */
 static struct menu_editmode_item edit_items[] = {
      {&edit_hh_sel, &edit_hh_dsel, &edit_hh_set},
      {&edit_mm_sel, &edit_mm_dsel, &edit_mm_set},
+     {&edit_days_sel, &edit_days_dsel, &edit_days_set},
      {NULL},
 };
 
@@ -170,57 +390,82 @@ static void alarm_deactivated()
 {
      /* clean up screen */
      display_clear(0, 1);
+     display_clear(0, 2);
+}
+
+
+/* UP and DOWN select the alarm */
+static void up_pressed()
+{
+     helpers_loop(&sel, 0, CONFIG_MOD_ALARM_COUNT - 1, 1);
+     refresh_screen();
+}
+
+static void down_pressed()
+{
+     helpers_loop(&sel, 0, CONFIG_MOD_ALARM_COUNT - 1, -1);
+     refresh_screen();
 }
 
 
 /* NUM (#) button pressed callback */
 static void num_pressed()
 {
-     /* this cycles between all alarm/chime combinations and overflow */
-     alarm_state.state++;
-
-     rtca_disable_alarm();
-     /* Prevents double registration */
-     sys_messagebus_unregister(&alarm_event, SYS_MSG_RTC_ALARM);
-     /* Register RTC alarm event only if needed, saving CPU cycles.. */
-     if (alarm_state.alarm) {
-	  display_symbol(0, LCD_ICON_ALARM, SEG_ON);
-	  sys_messagebus_register(&alarm_event, SYS_MSG_RTC_ALARM);
-	  rtca_enable_alarm();
-     } else {
-	  display_symbol(0, LCD_ICON_ALARM, SEG_OFF);
-     }
+     struct alarm *a = &alarm_cfg.alarms[sel];
 
-     /* Prevents double registration */
-     sys_messagebus_unregister(&hour_event, SYS_MSG_RTC_HOUR);
-     /* Register RTC hour event only if needed, saving CPU cycles.. */
-     if (alarm_state.chime) {
-	  display_symbol(0, LCD_ICON_BEEPER2, SEG_ON);
-	  display_symbol(0, LCD_ICON_BEEPER3, SEG_ON);
-	  sys_messagebus_register(&hour_event, SYS_MSG_RTC_HOUR);
-     } else {
-	  display_symbol(0, LCD_ICON_BEEPER2, SEG_OFF);
-	  display_symbol(0, LCD_ICON_BEEPER3, SEG_OFF);
-     }
+     /* an alarm that was never set rings once */
+     if (!a->days)
+	  a->days = ALARM_ONCE | ALARM_DAILY;
+
+     a->on = !a->on;
+     alarm_save();
+     refresh_screen();
+}
+
+
+/* NUM (#) button long press toggles the hourly chime */
+static void num_long_pressed()
+{
+     alarm_cfg.chime = !alarm_cfg.chime;
+     alarm_save();
+     refresh_screen();
 }
 
 
 /* Star button long press callback. */
 static void star_long_pressed()
 {
-     /* Save the current time in edit_buffer */
-     rtca_get_alarm(&tmp_hh, &tmp_mm);
+     struct alarm *a = &alarm_cfg.alarms[sel];
+
+     tmp_hh = a->hour;
+     tmp_mm = a->min;
+     tmp_days = a->days ? a->days : ALARM_ONCE | ALARM_DAILY;
 
-     menu_editmode_start(&edit_save, NULL, edit_items);
+     menu_editmode_start(&edit_save, &edit_cancel, edit_items);
 }
 
 
-void mod_alarm_init()
+void mod_alarm_init(void)
 {
-     menu_add_entry("ALARM",
-		    NULL,
-		    NULL,
-		    &num_pressed,
-		    &star_long_pressed,
-		    NULL, NULL, &alarm_activated, &alarm_deactivated);
+#ifdef CONFIG_INFOMEM
+     infomem_app_read(ALARM_INFOMEM_ID, (uint16_t *)&alarm_cfg,
+		      sizeof(alarm_cfg) / 2, 0);
+#endif
+     sets_seen = rtca_sets;
+     sys_messagebus_register(&alarm_event, SYS_MSG_RTC_ALARM);
+     alarm_schedule();
 }
+
+
+const struct menu mod_alarm_menu = {
+     .name = MENU_NAME("ALARM"),
+     .fn = {
+	  .up_btn_fn = &up_pressed,
+	  .down_btn_fn = &down_pressed,
+	  .num_btn_fn = &num_pressed,
+	  .lnum_btn_fn = &num_long_pressed,
+	  .lstar_btn_fn = &star_long_pressed,
+	  .activate_fn = &alarm_activated,
+	  .deactivate_fn = &alarm_deactivated,
+     },
+};
@@ -34,35 +34,39 @@
 #include "openchronos.h"
 #include "config.h"
 
-static uint8_t altitude_counter;
-
 static void update_altitude(enum sys_message msg)
 {
-     if (altitude_counter == 0) {
-	  int16_t alti =
-	       conv_pa_to_meter(bmp_ps_get_pa(), bmp_ps_get_temp());
-	  if (alti < 0) {
-	       display_symbol(0, LCD_SYMB_ARROW_DOWN, SEG_SET);
-	       alti = -alti;
-	  } else
-	       display_symbol(0, LCD_SYMB_ARROW_DOWN, SEG_OFF);
-
-	  if (alti == 0)
-	       display_chars(0, LCD_SEG_L1_3_0, "   0", SEG_SET);
-	  else
-	       _printf(0, LCD_SEG_L1_3_0, "%4u", alti);
+     bmp_ps_sample_t sample;
+     int16_t alti;
+
+     if (!bmp_ps_measure(&sample)) {
+	  display_label(0, LCD_SEG_L1_3_0, "----", SEG_SET);
+	  return;
      }
-     altitude_counter = (altitude_counter + 1) % CONFIG_MOD_ALTIMETER_REFRESH;	// #include "config.h"
+     alti = conv_pa_to_meter(sample.pa, sample.kelvin);
+     if (alti < 0) {
+	  display_symbol(0, LCD_SYMB_ARROW_DOWN, SEG_SET);
+	  alti = -alti;
+     } else
+	  display_symbol(0, LCD_SYMB_ARROW_DOWN, SEG_OFF);
+
+     if (alti == 0)
+	  display_label(0, LCD_SEG_L1_3_0, "   0", SEG_SET);
+     else
+	  _printf(0, LCD_SEG_L1_3_0, "%4u", alti);
 }
 
 static void alti_init(void)
 {
      bmp_ps_init();
+     bmp_ps_set_mode(CONFIG_MOD_ALTIMETER_OSS, CONFIG_MOD_ALTIMETER_WINDOW);
      init_pressure_table();
      bmp_ps_start();
 
-     altitude_counter = 0;
-     sys_messagebus_register(&update_altitude, SYS_MSG_RTC_SECOND);	// The SYS_MSG_PS_INT is generated only after start_altitude_measurement() and the measurement is currently done synchronously via spinlocking, so it's not useful.
+     update_altitude(SYS_MSG_NONE);
+     sys_messagebus_register_every(&update_altitude, SYS_MSG_RTC_SECOND,
+				   CONFIG_MOD_ALTIMETER_REFRESH, 0);	// The measurement sleeps through the conversion and waits for EOC itself, giving up after BMP_085_EOC_TIMEOUT, so SYS_MSG_PS_INT is not needed.
+     sys_messagebus_set_priority(&update_altitude, SYS_PRIO_BACKGROUND, 0);
      display_symbol(0, LCD_UNIT_L1_M, SEG_SET);
 }
 
@@ -73,8 +77,10 @@ static void alti_deac(void)
      display_symbol(0, LCD_UNIT_L1_M, SEG_OFF);
 }
 
-void mod_altimeter_init(void)
-{
-     menu_add_entry("ALTIT", NULL, NULL, NULL, NULL, NULL, NULL, &alti_init,
-		    &alti_deac);
-}
+const struct menu mod_altimeter_menu = {
+     .name = MENU_NAME("ALTIT"),
+     .fn = {
+	  .activate_fn = &alti_init,
+	  .deactivate_fn = &alti_deac,
+     },
+};
@@ -50,7 +50,8 @@ static void battery_event(enum sys_message event)
 
 static void battery_activate(void)
 {
-     battery_measurement();
+     /* the display is refreshed once the measurement is done */
+     pt_start(&battery_task);
 
      sys_messagebus_register(&battery_event, SYS_MSG_BATT);
 
@@ -83,12 +84,10 @@ static void battery_deactivate(void)
      display_symbol(0, LCD_SYMB_BATTERY, SEG_OFF);
 }
 
-void mod_battery_init(void)
-{
-     menu_add_entry("BATT",
-		    NULL,
-		    NULL,
-		    NULL,
-		    NULL,
-		    NULL, NULL, &battery_activate, &battery_deactivate);
-}
+const struct menu mod_battery_menu = {
+     .name = MENU_NAME("BATT"),
+     .fn = {
+	  .activate_fn = &battery_activate,
+	  .deactivate_fn = &battery_deactivate,
+     },
+};
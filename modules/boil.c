@@ -34,6 +34,7 @@
 #include "drivers/display.h"
 #include "drivers/bmp_ps.h"
 #include "drivers/ps.h"
+#include "drivers/governor.h"
 
 #include <math.h>
 
@@ -54,19 +55,37 @@ static float b[SUB_NUM] =
 static float c[SUB_NUM] =
 { 234.26800, 238.87000, 226.18400, 220.79000, 215.30700, 219.48200, 227.00000,
   237.23000 };
-static char substances[SUB_NUM][6] =
-{ "WATER", "METHA", "ETHAN", "BENZE", "XYLEN", "TOLUE", "CLFOR",
-  "ACETO" };
+static const struct display_pattern substances[SUB_NUM] = {
+     DISPLAY_PATTERN(LCD_SEG_L2_4_0, "WATER"),
+     DISPLAY_PATTERN(LCD_SEG_L2_4_0, "METHA"),
+     DISPLAY_PATTERN(LCD_SEG_L2_4_0, "ETHAN"),
+     DISPLAY_PATTERN(LCD_SEG_L2_4_0, "BENZE"),
+     DISPLAY_PATTERN(LCD_SEG_L2_4_0, "XYLEN"),
+     DISPLAY_PATTERN(LCD_SEG_L2_4_0, "TOLUE"),
+     DISPLAY_PATTERN(LCD_SEG_L2_4_0, "CLFOR"),
+     DISPLAY_PATTERN(LCD_SEG_L2_4_0, "ACETO")
+};
 
 static uint8_t i;
 static uint8_t unit;
-static uint8_t boil_counter;
 
 static void print_boil(void)
 {
-     float t = b[i] / (a[i] - log10f(PA_TO_MMHG(bmp_ps_get_pa()))) - c[i];
+     bmp_ps_sample_t sample;
+     uint32_t pa;
+     float t;
 
-     display_chars(0, LCD_SEG_L2_4_0, substances[i], SEG_SET);
+     if (!bmp_ps_measure(&sample)) {
+	  display_label(0, LCD_SEG_L1_3_1, "---", SEG_SET);
+	  return;
+     }
+     pa = sample.pa;
+
+     governor_boost();
+     t = b[i] / (a[i] - log10f(PA_TO_MMHG(pa))) - c[i];
+     governor_release();
+
+     display_pattern(0, &substances[i], SEG_SET);
      display_symbol(0, LCD_UNIT_L1_DEGREE, SEG_SET);
      switch (unit) {
      case 0:			// Celsius
@@ -94,17 +113,14 @@ static void print_boil(void)
 
      
      if ((uint16_t) t == 0)
-	  display_chars(0, LCD_SEG_L1_3_1, "  0", SEG_SET);
+	  display_label(0, LCD_SEG_L1_3_1, "  0", SEG_SET);
      else
 	  _printf(0, LCD_SEG_L1_3_1, "%3u", (uint16_t) t);
 }
 
 static void boil_interrupt(enum sys_message msg)
 {
-     if (boil_counter == 0)
-	  print_boil();
-
-     boil_counter = (boil_counter + 1) % CONFIG_MOD_BOIL_REFRESH;
+     print_boil();
 }
 
 static void up_btn(void)
@@ -127,12 +143,16 @@ static void num_pressed(void)
 
 static void boil_activate(void)
 {
-     i = unit = boil_counter = 0;
+     i = unit = 0;
      bmp_ps_init();
      init_pressure_table();
      bmp_ps_start();
 
-     sys_messagebus_register(&boil_interrupt, SYS_MSG_RTC_SECOND);
+     print_boil();
+     sys_messagebus_register_every(&boil_interrupt, SYS_MSG_RTC_SECOND,
+				   CONFIG_MOD_BOIL_REFRESH, 0);
+     /* the pressure read waits for the sensor */
+     sys_messagebus_set_priority(&boil_interrupt, SYS_PRIO_BACKGROUND, 0);
 }
 
 static void boil_deactivate(void)
@@ -143,8 +163,13 @@ static void boil_deactivate(void)
      display_clear(0, 0);
 }
 
-void mod_boil_init(void)
-{
-     menu_add_entry("BOIL", &up_btn, &down_btn, &num_pressed, NULL, NULL,
-		    NULL, &boil_activate, &boil_deactivate);
-}
+const struct menu mod_boil_menu = {
+     .name = MENU_NAME("BOIL"),
+     .fn = {
+	  .up_btn_fn = &up_btn,
+	  .down_btn_fn = &down_btn,
+	  .num_btn_fn = &num_pressed,
+	  .activate_fn = &boil_activate,
+	  .deactivate_fn = &boil_deactivate,
+     },
+};
@@ -27,7 +27,8 @@
 /* drivers */
 #include "drivers/display.h"
 
-static note n[2] = { 0x3200, 0x000F };
+/* a 200ms whole note, set by update() */
+static uint8_t n[5] = { 200, 0, BUZZER_OCTAVE << 4, 0x10, BUZZER_END << 4 };
 
 int8_t oct = 0;
 int8_t key = 1;
@@ -35,7 +36,7 @@ int8_t key = 1;
 static void activate()
 {
      /* update screen */
-     display_chars(0, LCD_SEG_L2_4_1, "BUZZ", SEG_ON);
+     display_label(0, LCD_SEG_L2_4_1, "BUZZ", SEG_ON);
 }
 
 static void deactivate()
@@ -49,7 +50,8 @@ static void update()
      _printf(0, LCD_SEG_L1_3_2, "%02u", oct);
      _printf(0, LCD_SEG_L1_1_0, "%02u", key);
 
-     n[0] = 0x3200 + (oct << 4) + key;
+     n[2] = (BUZZER_OCTAVE << 4) | oct;
+     n[3] = key << 4;
      buzzer_play(n);
 
 }
@@ -82,9 +84,12 @@ static void down()
      update();
 }
 
-void mod_buzztest_init(void)
-{
-     menu_add_entry("BUZZ",
-		    &up,
-		    &down, NULL, NULL, NULL, NULL, &activate, &deactivate);
-}
+const struct menu mod_buzztest_menu = {
+     .name = MENU_NAME("BUZZ"),
+     .fn = {
+	  .up_btn_fn = &up,
+	  .down_btn_fn = &down,
+	  .activate_fn = &activate,
+	  .deactivate_fn = &deactivate,
+     },
+};
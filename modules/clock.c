@@ -30,6 +30,9 @@
 /* drivers */
 #include "drivers/rtca.h"
 #include "drivers/display.h"
+#ifdef CONFIG_RTC_DST
+#include "drivers/rtc_dst.h"
+#endif
 
 #ifdef CONFIG_MOD_CLOCK_MONTH_FIRST
 #define MONTH_SEGMENT   (LCD_SEG_L2_4_3)
@@ -43,6 +46,9 @@
 
 static struct DATETIME *datetime = &rtca_time;
 
+/* copy of the time being edited, in effect while datetime points to it */
+static struct DATETIME edit_datetime;
+
 static uint8_t display_seconds = 0;
 
 static void clock_event(enum sys_message msg)
@@ -118,10 +124,16 @@ static void auto_adjust_dd()
 
 static void register_events()
 {
-     sys_messagebus_register(&clock_event,
-			     SYS_MSG_RTC_YEAR | SYS_MSG_RTC_MONTH |
-			     SYS_MSG_RTC_DAY | SYS_MSG_RTC_HOUR |
-			     SYS_MSG_RTC_MINUTE | SYS_MSG_RTC_SECOND);
+     enum sys_message msg = SYS_MSG_RTC_YEAR | SYS_MSG_RTC_MONTH |
+	  SYS_MSG_RTC_DAY | SYS_MSG_RTC_HOUR | SYS_MSG_RTC_MINUTE;
+
+     /* seconds wake the CPU up, only listen when they are shown */
+#ifndef CONFIG_MOD_CLOCK_BLINKCOL
+     if (display_seconds)
+#endif
+	  msg |= SYS_MSG_RTC_SECOND;
+
+     sys_messagebus_register(&clock_event, msg);
 }
 
 static void unregister_events()
@@ -261,6 +273,37 @@ static void edit_12_24_set(int8_t step)
      update_screen();
 }
 
+#ifdef CONFIG_RTC_DST
+/* DST zone, the new zone takes effect on save */
+static uint8_t edit_dst_zone;
+
+static void edit_dst_display(void)
+{
+     /* names may be shorter than the four segments */
+     display_clear(2, 1);
+     display_chars(2, LCD_SEG_L1_3_0, edit_dst_zone == DST_NONE ? " OFF" :
+		   rtc_dst_rules[edit_dst_zone - 1].name, SEG_SET);
+}
+
+static void edit_dst_sel(void)
+{
+     lcd_screen_activate(2);
+     edit_dst_display();
+     display_chars(2, LCD_SEG_L1_3_0, NULL, BLINK_ON);
+}
+
+static void edit_dst_dsel(void)
+{
+     display_chars(2, LCD_SEG_L1_3_0, NULL, BLINK_OFF);
+}
+
+static void edit_dst_set(int8_t step)
+{
+     helpers_loop(&edit_dst_zone, DST_NONE, RTC_DST_ZONES, step);
+     edit_dst_display();
+}
+#endif
+
 static void edit_end()
 {				/* turn off only SOME blinking segments */
      display_chars(0, LCD_SEG_L1_3_0, NULL, BLINK_OFF);
@@ -283,7 +326,6 @@ static void edit_cancel()
 {
      rtca_stop();		// Countered in edit_end
 
-     free(datetime);
      datetime = &rtca_time;	// Restore current time
      edit_end();
 }
@@ -297,10 +339,12 @@ static void edit_save()
      uint32_t sys_clocks = rtca_time.sys;
      memcpy(&rtca_time, datetime, sizeof(struct DATETIME));
      rtca_time.sys = sys_clocks;
-     free(datetime);
      datetime = &rtca_time;
 
      datetime->sec = 0;
+#ifdef CONFIG_RTC_DST
+     rtc_dst_set_zone(edit_dst_zone);
+#endif
      rtca_set_time();
      rtca_set_date();
      edit_end();
@@ -314,6 +358,9 @@ static struct menu_editmode_item edit_items[] = {
      {&edit_mo_sel, &edit_mo_dsel, &edit_mo_set},
      {&edit_dd_sel, &edit_dd_dsel, &edit_dd_set},
      {&edit_12_24_sel, &edit_12_24_dsel, &edit_12_24_set},
+#ifdef CONFIG_RTC_DST
+     {&edit_dst_sel, &edit_dst_dsel, &edit_dst_set},
+#endif
      {NULL},
 };
 
@@ -323,10 +370,11 @@ static void edit_activate()
 
      unregister_events();
 
-     struct DATETIME *edit_rtca =
-	  (struct DATETIME *) malloc(sizeof(struct DATETIME));
-     memcpy(edit_rtca, datetime, sizeof(struct DATETIME));
-     datetime = edit_rtca;
+     memcpy(&edit_datetime, datetime, sizeof(struct DATETIME));
+     datetime = &edit_datetime;
+#ifdef CONFIG_RTC_DST
+     edit_dst_zone = rtc_dst_zone;
+#endif
 
      rtca_start();
 
@@ -388,17 +436,21 @@ static void star_long_pressed()
 static void up_down_pressed()
 {
      display_seconds ^= 1;
+     unregister_events();
+     register_events();
      display_clear(0, 2);
 
      update_screen();
 }
 
-void mod_clock_init()
-{
-     menu_add_entry("CLOCK",
-		    &up_down_pressed,
-		    &up_down_pressed,
-		    &num_pressed,
-		    &star_long_pressed,
-		    NULL, NULL, &clock_activated, &clock_deactivated);
-}
+const struct menu mod_clock_menu = {
+     .name = MENU_NAME("CLOCK"),
+     .fn = {
+	  .up_btn_fn = &up_down_pressed,
+	  .down_btn_fn = &up_down_pressed,
+	  .num_btn_fn = &num_pressed,
+	  .lstar_btn_fn = &star_long_pressed,
+	  .activate_fn = &clock_activated,
+	  .deactivate_fn = &clock_deactivated,
+     },
+};
@@ -34,7 +34,6 @@
 #include "drivers/display.h"
 #include "drivers/temperature.h"
 
-static uint8_t i;
 static uint8_t unit;
 
 static void display_chirp(void)
@@ -71,16 +70,12 @@ static void display_chirp(void)
      if (freq > 0)
 	  _printf(0, LCD_SEG_L1_3_0, "%4u", freq);
      else
-	  display_chars(0, LCD_SEG_L1_3_0, "   0", SEG_SET);
+	  display_label(0, LCD_SEG_L1_3_0, "   0", SEG_SET);
 }
 
 static void chirp_interrupt(enum sys_message msg)
 {
-     if (i == 0) {
-	  display_chirp();
-     }
-
-     i = (i + 1) % CONFIG_MOD_CRICKETS_REFRESH;
+     display_chirp();
 }
 
 static void change_unit(void)
@@ -91,8 +86,10 @@ static void change_unit(void)
 
 static void crickets_activate(void)
 {
-     i = unit = 0;
-     sys_messagebus_register(&chirp_interrupt, SYS_MSG_RTC_SECOND);
+     unit = 0;
+     display_chirp();
+     sys_messagebus_register_every(&chirp_interrupt, SYS_MSG_RTC_SECOND,
+				   CONFIG_MOD_CRICKETS_REFRESH, 0);
 }
 
 static void crickets_deactivate(void)
@@ -102,8 +99,11 @@ static void crickets_deactivate(void)
 }
 
 
-void mod_crickets_init(void)
-{
-     menu_add_entry("CRICK", NULL, NULL, &change_unit, NULL, NULL, NULL,
-		    &crickets_activate, &crickets_deactivate);
-}
+const struct menu mod_crickets_menu = {
+     .name = MENU_NAME("CRICK"),
+     .fn = {
+	  .num_btn_fn = &change_unit,
+	  .activate_fn = &crickets_activate,
+	  .deactivate_fn = &crickets_deactivate,
+     },
+};
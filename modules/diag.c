@@ -0,0 +1,257 @@
+/**
+   modules/diag.c: diagnostics module for openchronos-ng
+
+   Copyright (C) 2026 openchronos-ng contributors
+
+   http://github.com/HashakGik/openchronos-ng-elf
+
+   This file is part of openchronos-ng.
+
+   openchronos-ng is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   openchronos-ng is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <string.h>
+
+#include "messagebus.h"
+#include "menu.h"
+#include "pool.h"
+
+#include "drivers/display.h"
+#include "drivers/radio.h"
+#include "drivers/stack.h"
+#include "drivers/crashlog.h"
+
+/* Views, cycled with UP and DOWN:
+   STACK  peak stack use in bytes
+   <pool> peak:size of the pool, in blocks
+   WAKE   main loop wakeups during the last minute
+   <prio> worst:overruns of the message bus callbacks of a priority
+	  class, in milliseconds, both shown up to 99
+   BTN    longest main loop pass that handled a button, in milliseconds
+   RST<r> with CONFIG_CRASH_LOG, SYSRSTIV of the last reset in hex and the
+	  PC the watchdog saw last (see drivers/crashlog.h)
+   BOOT   with CONFIG_BOOT_PROFILE, milliseconds from the start of main()
+	  to the first clock frame
+
+   NUM sends everything as one raw radio packet (see radio_raw_send()) on
+   the CONFIG_ISM band, little endian:
+
+   byte 0-1    'D', format version
+   byte 2-3    stack size
+   byte 4-5    stack peak
+   byte 6-9    wakeups since boot
+   byte 10-11  wakeups during the last minute
+   byte 12     number of pools, followed for each pool by
+	       5 bytes name (space padded), used, peak and size in blocks
+   then        number of priority classes, followed for each class by
+	       the worst callback in TA0R ticks and the overruns, 2 bytes each
+   then        longest button pass, 2 bytes, in TA0R ticks
+   then        SYSRSTIV of the last reset (1 byte, 0 without CONFIG_CRASH_LOG),
+	       last PC, last message bus callback, 2 bytes each, and
+	       the uptime of the run in seconds, 4 bytes
+
+   contrib/ChronosTool.py diag decodes it. */
+
+#define DIAG_VERSION 3
+#define DIAG_NAME_LEN 5
+
+static struct pool *const pools[] = {
+     &messagebus_pool, &lcd_screen_pool, &lcd_buffer_pool
+};
+
+#define DIAG_NR_POOLS (sizeof(pools) / sizeof(pools[0]))
+#define DIAG_VIEW_WAKE (DIAG_NR_POOLS + 1)
+#define DIAG_VIEW_BTN (DIAG_VIEW_WAKE + SYS_PRIO_CLASSES + 1)
+#ifdef CONFIG_CRASH_LOG
+#define DIAG_VIEW_RESET (DIAG_VIEW_BTN + 1)
+#else
+#define DIAG_VIEW_RESET DIAG_VIEW_BTN
+#endif
+#ifdef CONFIG_BOOT_PROFILE
+#define DIAG_VIEW_BOOT (DIAG_VIEW_RESET + 1)
+#else
+#define DIAG_VIEW_BOOT DIAG_VIEW_RESET
+#endif
+#define DIAG_VIEW_LAST DIAG_VIEW_BOOT
+
+static char const *const prio_names[SYS_PRIO_CLASSES] = {
+     "INPUT", "DISPL", "BACKG"
+};
+
+/* TA0R ticks to milliseconds */
+static uint16_t ticks_ms(uint16_t ticks)
+{
+     return ((uint32_t)ticks * 1000) >> 14;
+}
+
+static uint16_t upto99(uint16_t v)
+{
+     return v > 99 ? 99 : v;
+}
+
+static uint8_t view;
+
+static void diag_show(void)
+{
+     display_clear(0, 0);
+
+     if (view == 0) {
+	  _printf(0, LCD_SEG_L1_3_0, "%4u", stack_peak);
+	  display_label(0, LCD_SEG_L2_4_0, "STACK", SEG_SET);
+     } else if (view <= DIAG_NR_POOLS) {
+	  struct pool *pool = pools[view - 1];
+
+	  _printf(0, LCD_SEG_L1_3_2, "%2u", pool->peak);
+	  _printf(0, LCD_SEG_L1_1_0, "%02u", pool->nr);
+	  display_symbol(0, LCD_SEG_L1_COL, SEG_ON);
+	  display_chars(0, LCD_SEG_L2_4_0, pool->name, SEG_SET);
+     } else if (view == DIAG_VIEW_WAKE) {
+	  _printf(0, LCD_SEG_L1_3_0, "%4u", runloop_wakeups_minute);
+	  display_label(0, LCD_SEG_L2_4_0, "WAKE", SEG_SET);
+     } else if (view < DIAG_VIEW_BTN) {
+	  struct sys_messagebus_stats *stats =
+	       &sys_messagebus_stats[view - DIAG_VIEW_WAKE - 1];
+
+	  _printf(0, LCD_SEG_L1_3_2, "%2u", upto99(ticks_ms(stats->worst)));
+	  _printf(0, LCD_SEG_L1_1_0, "%02u", upto99(stats->overruns));
+	  display_symbol(0, LCD_SEG_L1_COL, SEG_ON);
+	  display_chars(0, LCD_SEG_L2_4_0, prio_names[view - DIAG_VIEW_WAKE - 1], SEG_SET);
+     } else if (view == DIAG_VIEW_BTN) {
+	  _printf(0, LCD_SEG_L1_3_0, "%4u", ticks_ms(runloop_button_latency));
+	  display_label(0, LCD_SEG_L2_4_0, "BTN", SEG_SET);
+     }
+#ifdef CONFIG_CRASH_LOG
+     else if (view == DIAG_VIEW_RESET) {
+	  _printf(0, LCD_SEG_L1_3_0, "%04x", crashlog.pc);
+	  _printf(0, LCD_SEG_L2_4_0, "RST%02x", crashlog.reset);
+     }
+#endif
+#ifdef CONFIG_BOOT_PROFILE
+     else if (view == DIAG_VIEW_BOOT) {
+	  _printf(0, LCD_SEG_L1_3_0, "%4u",
+		  ticks_ms(boot_profile[BOOT_STAGE_FRAME]));
+	  display_label(0, LCD_SEG_L2_4_0, "BOOT", SEG_SET);
+     }
+#endif
+}
+
+static void diag_event(enum sys_message msg)
+{
+     /* stack_peak and the wakeup rate were just updated by the main loop */
+     diag_show();
+}
+
+static void up_pressed(void)
+{
+     helpers_loop(&view, 0, DIAG_VIEW_LAST, 1);
+     diag_show();
+}
+
+static void down_pressed(void)
+{
+     helpers_loop(&view, 0, DIAG_VIEW_LAST, -1);
+     diag_show();
+}
+
+static void put16(uint8_t *p, uint16_t v)
+{
+     p[0] = v & 0xff;
+     p[1] = v >> 8;
+}
+
+static void num_pressed(void)
+{
+     uint8_t packet[RADIO_RAW_MAX_PAYLOAD + 1];
+     uint8_t *p = &packet[1];
+     uint8_t i, n, sent;
+
+     *p++ = 'D';
+     *p++ = DIAG_VERSION;
+     put16(p, stack_size());
+     put16(p + 2, stack_peak);
+     put16(p + 4, runloop_wakeups & 0xffff);
+     put16(p + 6, runloop_wakeups >> 16);
+     put16(p + 8, runloop_wakeups_minute);
+     p += 10;
+
+     *p++ = DIAG_NR_POOLS;
+     for (i = 0; i < DIAG_NR_POOLS; i++) {
+	  for (n = 0; n < DIAG_NAME_LEN && pools[i]->name[n]; n++)
+	       p[n] = pools[i]->name[n];
+	  for (; n < DIAG_NAME_LEN; n++)
+	       p[n] = ' ';
+	  p += DIAG_NAME_LEN;
+	  *p++ = pools[i]->used;
+	  *p++ = pools[i]->peak;
+	  *p++ = pools[i]->nr;
+     }
+
+     *p++ = SYS_PRIO_CLASSES;
+     for (i = 0; i < SYS_PRIO_CLASSES; i++) {
+	  put16(p, sys_messagebus_stats[i].worst);
+	  put16(p + 2, sys_messagebus_stats[i].overruns);
+	  p += 4;
+     }
+     put16(p, runloop_button_latency);
+     p += 2;
+
+#ifdef CONFIG_CRASH_LOG
+     *p++ = crashlog.reset;
+     put16(p, crashlog.pc);
+     put16(p + 2, crashlog.callback);
+     put16(p + 4, crashlog.uptime & 0xffff);
+     put16(p + 6, crashlog.uptime >> 16);
+#else
+     *p++ = 0;
+     memset(p, 0, 8);
+#endif
+     p += 8;
+
+     packet[0] = p - &packet[1];
+
+     radio_raw_open();
+     sent = radio_raw_send(packet);
+     close_radio();
+
+     if (sent)
+	  display_label(0, LCD_SEG_L2_4_0, " SENT", SEG_SET);
+     else
+	  display_label(0, LCD_SEG_L2_4_0, " FAIL", SEG_SET);
+}
+
+static void diag_activate(void)
+{
+     view = 0;
+     diag_show();
+
+     sys_messagebus_register(&diag_event, SYS_MSG_RTC_MINUTE);
+}
+
+static void diag_deactivate(void)
+{
+     sys_messagebus_unregister_all(&diag_event);
+
+     display_clear(0, 0);
+}
+
+const struct menu mod_diag_menu = {
+     .name = MENU_NAME("DIAG"),
+     .fn = {
+	  .up_btn_fn = &up_pressed,
+	  .down_btn_fn = &down_pressed,
+	  .num_btn_fn = &num_pressed,
+	  .activate_fn = &diag_activate,
+	  .deactivate_fn = &diag_deactivate,
+     },
+};
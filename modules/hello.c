@@ -21,46 +21,27 @@
    along with this program.  If not, see <http://www.gnu.org/licenses/>.
 **/
 
-/* This module shows a scrolling hello world.
-   The display_scroll function will probably be included in the display driver.
- */
+/* This module shows a scrolling hello world. */
 
-#include "messagebus.h"
 #include "menu.h"
 #include "drivers/display.h"
 
-uint8_t str_counter;
-char *hello = "HELLO WORLD ITS GOOD TO SEE YOU ALL";
-
-void display_scroll(uint8_t scr_nr, enum display_segment_array segments, char const *str, uint8_t len, enum display_segstate state, uint8_t *i)
-{
-     uint8_t segnum = segments & 0x0f;
-     uint8_t lastchar = (segnum < len)? (len - segnum + 1): segnum;
-
-     display_chars(scr_nr, segments, str + *i, state);
-     *i = (*i + 1) % lastchar;
-}
-
-
-
-static void hello_interrupt(enum sys_message msg)
-{
-     display_scroll(0, LCD_SEG_L2_4_0, hello, 35, SEG_SET, &str_counter);
-}
-
 static void hello_activate(void)
 {
-     str_counter = 0;
-     sys_messagebus_register(&hello_interrupt, SYS_MSG_RTC_SECOND);
+     display_marquee_start(LCD_SEG_L2_4_0,
+			   "HELLO WORLD ITS GOOD TO SEE YOU ALL", 4);
 }
 
 static void hello_deactivate(void)
 {
-     sys_messagebus_unregister_all(&hello_interrupt);
+     display_marquee_stop();
+     display_clear(0, 2);
 }
 
-void mod_hello_init(void)
-{
-     menu_add_entry("HELLO", NULL, NULL, NULL, NULL, NULL, NULL,
-		    &hello_activate, &hello_deactivate);
-}
+const struct menu mod_hello_menu = {
+     .name = MENU_NAME("HELLO"),
+     .fn = {
+	  .activate_fn = &hello_activate,
+	  .deactivate_fn = &hello_deactivate,
+     },
+};
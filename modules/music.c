@@ -23,24 +23,21 @@
 
 #include "messagebus.h"
 #include "menu.h"
+#include "tunes.h"
 
 /* drivers */
 #include "drivers/display.h"
 #include "drivers/buzzer.h"
 
-/* tunes generated using contrib/rtttl2bin.py */
-/* nokia tune */
-static note nokia[] =  {0x25a8, 0x25a6, 0x4b1a, 0x4b1c, 0x25a5, 0x2593, 0x4b16, 0x4b18, 0x2593, 0x2591, 0x4b15, 0x4b18, 0x6411, 0x000F};
-
 static void num_press()
 {
-     buzzer_play(nokia);
+     buzzer_play(tune_nokia);
 }
 
 
 static void music_activate()
 {
-     display_chars(0, LCD_SEG_L2_4_0, "MUSIC", SEG_ON);
+     display_label(0, LCD_SEG_L2_4_0, "MUSIC", SEG_ON);
 }
 
 static void music_deactivate()
@@ -48,11 +45,11 @@ static void music_deactivate()
      display_clear(0, 2);
 }
 
-void mod_music_init(void)
-{
-     menu_add_entry("MUSIC",
-		    NULL,
-		    NULL,
-		    &num_press,
-		    NULL, NULL, NULL, &music_activate, &music_deactivate);
-}
+const struct menu mod_music_menu = {
+     .name = MENU_NAME("MUSIC"),
+     .fn = {
+	  .num_btn_fn = &num_press,
+	  .activate_fn = &music_activate,
+	  .deactivate_fn = &music_deactivate,
+     },
+};
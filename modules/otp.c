@@ -27,11 +27,13 @@
 #include "otp.h"
 #include "messagebus.h"
 #include "menu.h"
+#include "tunes.h"
 
 /* drivers */
 #include "drivers/rtca.h"
 #include "drivers/display.h"
 #include "drivers/buzzer.h"
+#include "drivers/governor.h"
 
 #if defined(CONFIG_RTC_DST)
 #include "drivers/rtc_dst.h"
@@ -40,49 +42,11 @@
 /* hmac routines*/
 #include "hashutils.h"
 
-/* 7-segment character bit assignments */
-/* Replicated from drivers/display.c (shouldn't this be in display.h ?) */
-#define SEG_A     (BIT4)
-#define SEG_B     (BIT5)
-#define SEG_C     (BIT6)
-#define SEG_D     (BIT7)
-#define SEG_E     (BIT2)
-#define SEG_F     (BIT0)
-#define SEG_G     (BIT1)
-
-static int days[12] =
-{ 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
-
 #if defined(CONFIG_MOD_OTP_SOUND_CUE)
 int8_t otp_sound_cue = 0;
 int8_t otp_first_code = 1;
 #endif
 
-uint32_t simple_mktime(int year, int month, int day, int hour, int minute,
-		       int second)
-{
-     //only works for year 2000 - 2032
-     uint32_t result;
-
-     year += month / 12;
-     month %= 12;
-     result = (year - 1970) * 365 + days[month];
-     if (month <= 1)
-	  year--;
-
-     result += (year - 1968) / 4;
-     result += day - 1;
-     result = ((result * 24 + hour) * 60 + minute) * 60 + second;
-
-#if defined(CONFIG_RTC_DST)
-     if (rtc_dst_state == RTC_DST_STATE_DST) {
-	  result = result - 3600;
-     }
-#endif
-
-     return result;
-}
-
 const keystore_t otp_keys[] = CONFIG_MOD_OTP_KEYS;
 #define NUM_ELEMS(x) (sizeof(x)/sizeof(x[0]))
 #define NUM_KEYS NUM_ELEMS(otp_keys)
@@ -131,8 +95,10 @@ static uint32_t calculate_otp(uint32_t time, const uint8_t * otp_key,
      otp_data[7] = (time) & 0xff;
 
 
+     governor_boost();
      hmac_sha1(otp_key, otp_key_len, otp_data, sizeof(otp_data),
 	       otp_result, sizeof(otp_result));
+     governor_release();
 
      int off = otp_result[SHA1_DIGEST_LENGTH - 1] & 0x0f;
 
@@ -161,10 +127,12 @@ static void clock_event(enum sys_message msg)
      display_bits(0, LCD_SEG_L2_4, indicator[2 * segment + 1], BLINK_SET);
      display_char(0, LCD_SEG_L1_3, otp_identifier, SEG_SET);
 
-     // Calculate timestamp
-     uint32_t time =
-	  simple_mktime(rtca_time.year, rtca_time.mon - 1, rtca_time.day,
-			rtca_time.hour, rtca_time.min, rtca_time.sec);
+     // Timestamp kept by the RTC driver, in local time
+     uint32_t time = rtca_time.epoch;
+#if defined(CONFIG_RTC_DST)
+     if (rtc_dst_state == RTC_DST_STATE_DST)
+	  time -= 3600;
+#endif
      time = (time - CONFIG_MOD_OTP_OFFSET * 3600) / 30;
 
      // Check if new code must be calculated
@@ -181,9 +149,8 @@ static void clock_event(enum sys_message msg)
 	  v = (otp_value % 1000);
 	  _printf(0, LCD_SEG_L2_2_0, "%03u", v);
 #if defined(CONFIG_MOD_OTP_SOUND_CUE)
-	  extern note welcome[4];
 	  if (!otp_first_code && otp_sound_cue)
-	       buzzer_play(welcome);
+	       buzzer_play(tune_welcome);
 	  otp_first_code = 0;
 #endif
      }
@@ -204,6 +171,8 @@ static void otp_request_update(bool activated)
 static void otp_activated()
 {
      sys_messagebus_register(&clock_event, SYS_MSG_RTC_SECOND);
+     /* the HMAC takes a while every 30 seconds */
+     sys_messagebus_set_priority(&clock_event, SYS_PRIO_BACKGROUND, 0);
      display_char(0, LCD_SEG_L1_3, '8', BLINK_ON);
 #if defined(CONFIG_MOD_OTP_SOUND_CUE)
      display_bits(0, LCD_SEG_L2_3, SEG_G, otp_sound_cue ? SEG_ON : SEG_OFF);
@@ -246,18 +215,15 @@ static void otp_toggle_beep()
 }
 #endif
 
-void mod_otp_init()
-{
-     menu_add_entry("OTP", &otp_gen_next,	/* up         */
-		    &otp_gen_prev,	/* down       */
+const struct menu mod_otp_menu = {
+     .name = MENU_NAME("OTP"),
+     .fn = {
+	  .up_btn_fn = &otp_gen_next,
+	  .down_btn_fn = &otp_gen_prev,
 #if defined(CONFIG_MOD_OTP_SOUND_CUE)
-		    &otp_toggle_beep,	/* num        */
-#else
-		    NULL,	/* num        */
+	  .num_btn_fn = &otp_toggle_beep,
 #endif
-		    NULL,	/* long star  */
-		    NULL,	/* long num   */
-		    NULL,	/* up-down    */
-		    &otp_activated,	/* activate   */
-		    &otp_deactivated);	/* deactivate */
-}
+	  .activate_fn = &otp_activated,
+	  .deactivate_fn = &otp_deactivated,
+     },
+};
@@ -50,7 +50,7 @@ static void button_event(enum sys_message event)
 static void reset_activate()
 {
      /* update screen */
-     display_chars(0, LCD_SEG_L2_4_0, "RESET", SEG_ON);
+     display_label(0, LCD_SEG_L2_4_0, "RESET", SEG_ON);
 }
 
 static void reset_deactivate()
@@ -59,15 +59,19 @@ static void reset_deactivate()
      display_clear(0, 2);
 }
 
+const struct menu mod_reset_menu = {
+     .name = MENU_NAME("RESET"),
+     .fn = {
+	  .num_btn_fn = &num_press,
+	  .activate_fn = &reset_activate,
+	  .deactivate_fn = &reset_deactivate,
+     },
+};
+
 void mod_reset_init(void)
 {
 #ifdef CONFIG_MOD_RESET_EASY_RESET
      sys_messagebus_register(&button_event, SYS_MSG_BUTTON);
+     sys_messagebus_set_priority(&button_event, SYS_PRIO_INPUT, 0);
 #endif
-
-     menu_add_entry("RESET",
-		    NULL,
-		    NULL,
-		    &num_press,
-		    NULL, NULL, NULL, &reset_activate, &reset_deactivate);
 }
@@ -37,6 +37,7 @@
 #include "drivers/display.h"
 #include "drivers/bmp_ps.h"
 #include "drivers/ps.h"
+#include "drivers/governor.h"
 
 #include <math.h>
 
@@ -44,17 +45,27 @@
 #define MS_TO_MPH(x) (x * 2.237)
 #define MS_TO_FTS(x) (x * 3.281)
 
-static uint8_t i;
 static uint8_t unit;
 
 static void print_sound(void)
 {
     float rho;
     float s;
-    uint32_t pa = bmp_ps_get_pa();
+    bmp_ps_sample_t sample;
+    uint32_t pa;
+    uint16_t temp;
 
-    rho = pa / (bmp_ps_get_temp() / 10.0 * 287.058);
+    if (!bmp_ps_measure(&sample)) {
+	display_label(0, LCD_SEG_L1_3_0, "----", SEG_SET);
+	return;
+    }
+    pa = sample.pa;
+    temp = sample.kelvin;
+
+    governor_boost();
+    rho = pa / (temp / 10.0 * 287.058);
     s = sqrtf(1.4 * pa / rho);
+    governor_release();
 
     switch (unit) {
     case 0:			// m/s
@@ -100,10 +111,7 @@ static void print_sound(void)
 
 static void sound_interrupt(enum sys_message msg)
 {
-    if (i == 0)
-	print_sound();
-
-    i = (i + 1) % CONFIG_MOD_SOUNDSPEED_REFRESH;
+    print_sound();
 }
 
 static void num_pressed(void)
@@ -114,12 +122,14 @@ static void num_pressed(void)
 
 static void sound_activate(void)
 {
-    i = unit = 0;
+    unit = 0;
     bmp_ps_init();
     init_pressure_table();
     bmp_ps_start();
 
-    sys_messagebus_register(&sound_interrupt, SYS_MSG_RTC_SECOND);
+    print_sound();
+    sys_messagebus_register_every(&sound_interrupt, SYS_MSG_RTC_SECOND,
+				  CONFIG_MOD_SOUNDSPEED_REFRESH, 0);
 
 }
 
@@ -132,8 +142,11 @@ static void sound_deactivate(void)
 }
 
 
-void mod_soundspeed_init(void)
-{
-    menu_add_entry("SSOUN", NULL, NULL, &num_pressed, NULL, NULL, NULL,
-		   &sound_activate, &sound_deactivate);
-}
+const struct menu mod_soundspeed_menu = {
+    .name = MENU_NAME("SSOUN"),
+    .fn = {
+	.num_btn_fn = &num_pressed,
+	.activate_fn = &sound_activate,
+	.deactivate_fn = &sound_deactivate,
+    },
+};
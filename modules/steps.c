@@ -23,6 +23,7 @@
 
 #include "messagebus.h"
 #include "menu.h"
+#include "pt.h"
 
 #include "drivers/display.h"
 #include "drivers/as.h"
@@ -43,25 +44,39 @@ static void update_steps(enum sys_message msg)
   _printf(0, LCD_SEG_L2_5_0, "%6u", steps);
 }
 
-static void steps_activate(void)
+static PT_THREAD(steps_start(struct pt *pt))
 {
-  steps = 0;
-  as_init();
+  bmp_as_interrupts_t ints;
+
+  PT_BEGIN(pt);
   bmp_as_start(BMP_GRANGE_8G, BMP_BWD_31HZ, BMP_SLEEP_10MS, 1); // Filter data at 31.25Hz and set the range to 8g.
-  timer0_delay(1000, LPM3_bits);
+  PT_SLEEP(pt, 1000);
 
-  bmp_as_interrupts_t ints = bmp_as_init_interrupts();
+  ints = bmp_as_init_interrupts();
   ints.slope_interrupt.x = 1;
   ints.slope_interrupt.y = 1;
   ints.slope_interrupt.z = 1;
   bmp_as_enable_interrupts(ints); // Enable slope interrupt on all three axes.
 
   sys_messagebus_register(&update_steps, SYS_MSG_AS_INT);
-  display_chars(0, LCD_SEG_L2_5_0, "     0", SEG_SET);
+  PT_END(pt);
+}
+
+static PT_TASK_DEFINE(steps_task, steps_start);
+
+static void steps_activate(void)
+{
+  steps = 0;
+  as_init();
+  display_label(0, LCD_SEG_L2_5_0, "     0", SEG_SET);
+
+  /* the sensor settles for a second, the menu keeps running meanwhile */
+  pt_start(&steps_task);
 }
 
 static void steps_deactivate(void)
 {
+  pt_stop(&steps_task);
   display_clear(0, 0);
   sys_messagebus_unregister_all(&update_steps);
 
@@ -72,11 +87,14 @@ static void steps_deactivate(void)
 static void long_num_pressed(void)
 {
   steps = 0;
-  display_chars(0, LCD_SEG_L2_5_0, "     0", SEG_SET);
+  display_label(0, LCD_SEG_L2_5_0, "     0", SEG_SET);
 }
 
-void mod_steps_init(void)
-{
-  menu_add_entry("STEPS", NULL, NULL, NULL, NULL, &long_num_pressed,
-		 NULL, &steps_activate, &steps_deactivate);
-}
+const struct menu mod_steps_menu = {
+  .name = MENU_NAME("STEPS"),
+  .fn = {
+    .lnum_btn_fn = &long_num_pressed,
+    .activate_fn = &steps_activate,
+    .deactivate_fn = &steps_deactivate,
+  },
+};
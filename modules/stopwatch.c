@@ -86,7 +86,8 @@ struct swatch_conf sSwatch_conf;
 static uint8_t icon_stopwatch_on_cents;
 static uint8_t icon_stopwatch_off_cents;
 
-static struct menu *menu_entry;	// Kind of a hack in order to change the button allocation at runtime
+/* RAM copy of the menu handlers, so that long NUM can be enabled at runtime */
+static struct menu_handlers stopwatch_handlers;
 
 /*
  * Helper Functions
@@ -116,14 +117,14 @@ static void drawStopWatchScreen(void)
 	  sSwatch_time[SW_DISPLAYNG] = sSwatch_time[sSwatch_conf.lap_act];
 	  if (SW_COUNTING == sSwatch_conf.lap_act) {
 	       if (sSwatch_conf.state == SWATCH_MODE_OFF) {
-		    display_chars(0, LCD_SEG_L1_3_0, "STOP", SEG_SET);
+		    display_label(0, LCD_SEG_L1_3_0, "STOP", SEG_SET);
 	       } else {
-		    display_chars(0, LCD_SEG_L1_3_2, "LP", SEG_SET);
+		    display_label(0, LCD_SEG_L1_3_2, "LP", SEG_SET);
 		    _printf(0, LCD_SEG_L1_1_0, "%2u", sSwatch_conf.laps);
 	       }
 
 	  } else {
-	       display_chars(0, LCD_SEG_L1_3_2, "LP", SEG_SET);
+	       display_label(0, LCD_SEG_L1_3_2, "LP", SEG_SET);
 	       _printf(0, LCD_SEG_L1_1_0, "%2u", sSwatch_conf.lap_act + 1);
 	  }
 	  if (sSwatch_time[SW_DISPLAYNG].minutes < 20
@@ -240,7 +241,7 @@ static void up_press()
 static void num_long_pressed()
 {
      clear_stopwatch();
-     menu_entry->lnum_btn_fn = NULL;
+     stopwatch_handlers.lnum_btn_fn = NULL;
      drawStopWatchScreen();
 }
 
@@ -249,32 +250,36 @@ static void num_press()
      if (sSwatch_conf.state == SWATCH_MODE_OFF) {
 	  sSwatch_conf.state = SWATCH_MODE_ON;
 	  sSwatch_conf.lap_act = SW_COUNTING;
-	  menu_entry->lnum_btn_fn = NULL;
+	  stopwatch_handlers.lnum_btn_fn = NULL;
 	  icon_stopwatch_on_cents = sSwatch_time[SW_COUNTING].cents;
 	  icon_stopwatch_off_cents = (icon_stopwatch_on_cents + 50) % 100;
 	  sys_messagebus_register(&stopwatch_event, SYS_MSG_TIMER_20HZ);
 	  start_timer0_20hz();
      } else {
 	  sSwatch_conf.state = SWATCH_MODE_OFF;
-	  menu_entry->lnum_btn_fn = &num_long_pressed;
+	  stopwatch_handlers.lnum_btn_fn = &num_long_pressed;
 	  stop_timer0_20hz();
 	  sys_messagebus_unregister_all(&stopwatch_event);
      }
      drawStopWatchScreen();
 }
 
+const struct menu mod_stopwatch_menu = {
+     .name = MENU_NAME("STOP"),
+     .fn = {
+	  .up_btn_fn = &up_press,
+	  .down_btn_fn = &down_press,
+	  .num_btn_fn = &num_press,
+	  .activate_fn = &stopwatch_activated,
+	  .deactivate_fn = &stopwatch_deactivated,
+     },
+     .override = &stopwatch_handlers,
+};
+
 void mod_stopwatch_init(void)
 {
      sSwatch_conf.state = SWATCH_MODE_OFF;
      clear_stopwatch();
 
-     menu_entry = menu_add_entry("STOP",
-				 &up_press,
-				 &down_press,
-				 &num_press,
-				 NULL,
-				 NULL,
-				 NULL,
-				 &stopwatch_activated,
-				 &stopwatch_deactivated);
+     stopwatch_handlers = mod_stopwatch_menu.fn;
 }
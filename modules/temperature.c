@@ -25,6 +25,7 @@
 
 #include "messagebus.h"
 #include "menu.h"
+#include "pt.h"
 
 /* drivers */
 #include "drivers/display.h"
@@ -40,6 +41,9 @@ uint8_t use_temperature_metric = 0;
 
 static uint8_t sec;
 
+/* the measurement may finish after the module was left */
+static uint8_t active;
+
 static void display_temperature(void)
 {
      int16_t temp;
@@ -52,11 +56,23 @@ static void display_temperature(void)
      display_char(0, LCD_SEG_L1_0, (temp % 10) + 48, SEG_SET);
 }
 
+static PT_THREAD(measure_temperature(struct pt *pt))
+{
+     static struct pt measurement, conversion;
+
+     PT_BEGIN(pt);
+     PT_SPAWN(pt, &measurement, temperature_measurement(&measurement, &conversion));
+     if (active)
+	  display_temperature();
+     PT_END(pt);
+}
+
+static PT_TASK_DEFINE(measure_task, measure_temperature);
+
 static void event_1_sec_callback(enum sys_message msg)
 {
      if (++sec >= TEMP_UPDATE_INTERVAL_IN_SEC) {
-	  temperature_measurement();
-	  display_temperature();
+	  pt_start(&measure_task);
 	  sec = 0;
      }
 }
@@ -65,7 +81,7 @@ static void event_1_sec_callback(enum sys_message msg)
 
 static void display_temp_text_on_line_2()
 {
-     display_chars(0, LCD_SEG_L2_4_1, "TEMP", SEG_SET);
+     display_label(0, LCD_SEG_L2_4_1, "TEMP", SEG_SET);
 }
 
 // Offset
@@ -98,9 +114,9 @@ static void edit_offset_set(int8_t step)
 static void update_c_or_f_display()
 {
      if (use_temperature_metric) {
-	  display_chars(0, LCD_SEG_L2_5_0, " USE\\C", SEG_SET);
+	  display_label(0, LCD_SEG_L2_5_0, " USE\\C", SEG_SET);
      } else {
-	  display_chars(0, LCD_SEG_L2_5_0, " USE\\F", SEG_SET);
+	  display_label(0, LCD_SEG_L2_5_0, " USE\\F", SEG_SET);
      }
 }
 
@@ -140,13 +156,15 @@ static void temperature_activate(void)
      display_symbol(0, LCD_SEG_L1_DP0, SEG_ON);
 
      /* display -- symbol while a measure is not performed */
-     display_chars(0, LCD_SEG_L1_2_0, "---", SEG_ON);
+     display_label(0, LCD_SEG_L1_2_0, "---", SEG_ON);
      display_temp_text_on_line_2();
+     active = 1;
      sys_messagebus_register(&event_1_sec_callback, SYS_MSG_RTC_SECOND);
 }
 
 static void temperature_deactivate(void)
 {
+     active = 0;
      sys_messagebus_unregister_all(&event_1_sec_callback);
 
      /* cleanup screen */
@@ -160,13 +178,11 @@ static void temperature_edit(void)
      menu_editmode_start(&display_temp_text_on_line_2, NULL, edit_items);
 }
 
-void mod_temperature_init(void)
-{
-     menu_add_entry("TEMP",
-		    NULL,
-		    NULL,
-		    NULL,
-		    &temperature_edit,
-		    NULL,
-		    NULL, &temperature_activate, &temperature_deactivate);
-}
+const struct menu mod_temperature_menu = {
+     .name = MENU_NAME("TEMP"),
+     .fn = {
+	  .lstar_btn_fn = &temperature_edit,
+	  .activate_fn = &temperature_activate,
+	  .deactivate_fn = &temperature_deactivate,
+     },
+};
@@ -333,14 +333,20 @@ void deactivate(void)
      display_clear(0, 0);
 }
 
+const struct menu mod_tide_menu = {
+     .name = MENU_NAME("TIDE"),
+     .fn = {
+	  .up_btn_fn = &buttonUp,
+	  .down_btn_fn = &buttonDown,
+	  .lstar_btn_fn = &longStarButton,
+	  .activate_fn = &activate,
+	  .deactivate_fn = &deactivate,
+     },
+};
+
 void mod_tide_init(void)
 {
      sys_messagebus_register(&minuteTick, SYS_MSG_RTC_MINUTE);
-     menu_add_entry("TIDE",
-		    &buttonUp,
-		    &buttonDown,
-		    NULL,
-		    &longStarButton, NULL, NULL, &activate, &deactivate);
      tide = timeFromMinutes(90);	/* fullTideTime); */
      minuteTick();		/* initla display setup */
 }
@@ -68,6 +68,8 @@
 #include "messagebus.h"
 #include "menu.h"
 #include "modinit.h"
+#include "pt.h"
+#include "tunes.h"
 
 /* Driver */
 #include "drivers/display.h"
@@ -79,13 +81,17 @@
 #include "drivers/ports.h"
 #include "drivers/timer.h"
 #include "drivers/pmm.h"
+#include "drivers/governor.h"
 #include "drivers/rf1a.h"
 #include "drivers/rtca.h"
 #include "drivers/temperature.h"
 #include "drivers/battery.h"
 #include "drivers/utils.h"
 #include "drivers/wdt.h"
+#include "drivers/crashlog.h"
 #include "drivers/lpm.h"
+#include "drivers/stack.h"
+#include "drivers/infomem.h"
 
 #if defined (WHITE_PCB) && defined (BLACK_PCB)
 #error "You can't use both Black and White modules!"
@@ -96,51 +102,86 @@
 #ifdef BLACK_PCB
 #include "drivers/vti_as.h"
 #endif
-void handle_events(void)
-{
-    enum sys_message msg = SYS_MSG_NONE;
+/* main loop wakeups since boot and during the last full minute */
+uint32_t runloop_wakeups;
+uint16_t runloop_wakeups_minute;
+uint16_t runloop_button_latency;
 
-    /* drivers/rtca */
-    if (rtca_last_event) {
-	msg |= rtca_last_event;
-	rtca_last_event = RTCA_EV_NONE;
-    }
+#ifdef CONFIG_BOOT_PROFILE
+uint16_t boot_profile[BOOT_STAGES];
+#endif
 
-    /* drivers/timer */
-    if (timer0_last_event) {
-	msg |= timer0_last_event << 7;
-	timer0_last_event = TIMER0_EVENT_NONE;
-    }
+uint16_t evqueue_seq;
 
-    /* drivers/accelerometer */
-    if (as_last_interrupt) {
-	msg |= SYS_MSG_AS_INT;
-	as_last_interrupt = 0;
-    }
+/* the interrupt event queues, and where their event bits go in sys_message */
+static const struct {
+    struct evqueue *queue;
+    uint8_t shift;
+} event_sources[] = {
+    { &rtca_events, 0 },		/* drivers/rtca */
+    { &timer0_events, 7 },		/* drivers/timer */
+    { &ports_events, 10 },		/* drivers/accelerometer and pressure */
+};
 
-    /* drivers/pressure */
-    if (ps_last_interrupt) {
-	msg |= SYS_MSG_PS_INT;
-	ps_last_interrupt = 0;
-    }
+#define EVENT_SOURCES (sizeof(event_sources) / sizeof(event_sources[0]))
 
+static void handle_message(const struct sys_event *ev, enum sys_message msg)
+{
     /* menu system */
     if (msg & SYS_MSG_RTC_SECOND) {
 	menu_timeout_poll();
     }
 #ifdef CONFIG_BATTERY_MONITOR
-    /* drivers/battery */
+    /* drivers/battery, sends SYS_MSG_BATT when done */
     if (msg & SYS_MSG_RTC_MINUTE) {
-	msg |= SYS_MSG_BATT;
-	battery_measurement();
+	pt_start(&battery_task);
     }
 #endif
+#ifdef CONFIG_MOD_DIAG
+    if (msg & SYS_MSG_RTC_MINUTE) {
+	static uint32_t last_wakeups;
 
-    if (is_ports_button_pressed()) {
-	msg |= SYS_MSG_BUTTON;
+	stack_scan();
+	runloop_wakeups_minute = runloop_wakeups - last_wakeups;
+	last_wakeups = runloop_wakeups;
+    }
+#endif
+
+    send_event(ev, msg);
+}
+
+void handle_events(void)
+{
+    struct sys_event ev;
+    uint8_t i, oldest;
+    uint16_t seq;
+
+    /* deliver the queued events one at a time, oldest first, so
+       listeners see them in the order they happened */
+    while (1) {
+	oldest = EVENT_SOURCES;
+	seq = 0;
+	for (i = 0; i < EVENT_SOURCES; i++) {
+	    struct sys_event *e = evqueue_peek(event_sources[i].queue);
+	    /* the queued events span a few numbers, the difference survives the wrap */
+	    if (e && (oldest == EVENT_SOURCES || (int16_t)(e->seq - seq) < 0)) {
+		seq = e->seq;
+		oldest = i;
+	    }
+	}
+	if (oldest == EVENT_SOURCES)
+	    break;
+
+	/* free the slot before the listeners run, they may take long */
+	ev = *evqueue_peek(event_sources[oldest].queue);
+	evqueue_pop(event_sources[oldest].queue);
+
+	handle_message(&ev, (enum sys_message)ev.ev << event_sources[oldest].shift);
     }
 
-    send_events(msg);
+    if (is_ports_button_pressed()) {
+	send_events(SYS_MSG_BUTTON);
+    }
 }
 
 /***************************************************************************
@@ -149,9 +190,17 @@ void handle_events(void)
 
 void init_application(void)
 {
+    // ---------------------------------------------------------------------
+    // Configure Timer0 for use by the clock and delay functions, first so
+    // that the boot profile counts from here
+    timer0_init();
+
     // ---------------------------------------------------------------------
     // Enable watchdog
 
+    /* Keep what the watchdog saw of the previous run */
+    crashlog_init();
+
     // Watchdog triggers after 16 seconds when not cleared
     wdt_setup();
 
@@ -165,8 +214,8 @@ void init_application(void)
     // Allow reconfiguration during runtime:
     PMAPCTL = PMAPRECFG;
 
-    // P2.7 = TA1CCR0A output (buzzer output)
-    P2MAP7 = PM_TA1CCR0A;
+    // P2.7 = TA1CCR1A output (buzzer PWM output)
+    P2MAP7 = PM_TA1CCR1A;
     P2OUT &= ~BIT7;
     P2DIR |= BIT7;
 
@@ -184,6 +233,7 @@ void init_application(void)
 
     // Init the hardwre real time clock (RTC_A)
     rtca_init();
+    boot_stage_done(BOOT_STAGE_RTC);
 
     // ---------------------------------------------------------------------
     // Configure ports
@@ -192,6 +242,7 @@ void init_application(void)
     // Reset radio core
     radio_reset();
     radio_powerdown();
+    boot_stage_done(BOOT_STAGE_RADIO);
 
 #if defined(CONFIG_MOD_ACCELEROMETER_B) || defined(CONFIG_MOD_ACCELEROMETER_W)
     // ---------------------------------------------------------------------
@@ -204,10 +255,7 @@ void init_application(void)
     // ---------------------------------------------------------------------
     // Init buttons
     init_buttons();
-
-    // ---------------------------------------------------------------------
-    // Configure Timer0 for use by the clock and delay functions
-    timer0_init();
+    boot_stage_done(BOOT_STAGE_INPUTS);
 
     /* Init buzzer */
     buzzer_init();
@@ -219,7 +267,7 @@ void init_application(void)
     /* drivers/battery */
     battery_init();
 
-    /* drivers/temperature */
+    /* drivers/temperature, measures in the background */
     temperature_init();
 
 #ifdef CONFIG_INFOMEM
@@ -227,6 +275,17 @@ void init_application(void)
 	infomem_init(INFOMEM_C, INFOMEM_C + 2 * INFOMEM_SEGMENT_SIZE);
     }
 #endif
+    boot_stage_done(BOOT_STAGE_DRIVERS);
+}
+
+/* What the first clock frame does not wait for */
+static void init_deferred(void)
+{
+    /* Drop to the low clock, before the welcome tune boosts it */
+    governor_init();
+
+    /* Play "welcome" chord: A major */
+    buzzer_play(tune_welcome);
 }
 
 #ifdef CONFIG_RUNLOOP_INDICATOR
@@ -254,12 +313,30 @@ int main(void)
 
     /* Init modules */
     mod_init();
+    boot_stage_done(BOOT_STAGE_MODULES);
+
+    /* activate the first menu entry */
+    menu_init();
+    boot_stage_done(BOOT_STAGE_FRAME);
+
+    init_deferred();
+    boot_stage_done(BOOT_STAGE_DEFERRED);
 
     /* main loop */
     while (1) {
+#ifdef CONFIG_MOD_DIAG
+	uint16_t woken;
+	uint8_t pressed;
+#endif
+
 	/* Go to LPM3, wait for interrupts */
 	enter_lpm_gie(LPM3_bits);
 
+#ifdef CONFIG_MOD_DIAG
+	runloop_wakeups++;
+	woken = TA0R;
+#endif
+
 #ifdef CONFIG_RUNLOOP_INDICATOR
 	debug_runloop_indicator();
 #endif
@@ -274,7 +351,26 @@ int main(void)
 	handle_events();
 
 	/* check for button presses and drive the menu */
+#ifdef CONFIG_MOD_DIAG
+	pressed = is_ports_button_pressed();
+#endif
 	menu_check_buttons();
+
+#ifdef CONFIG_MOD_DIAG
+	/* the menu handled a new press, the screen is up to date */
+	if (pressed && (uint16_t)(TA0R - woken) > runloop_button_latency)
+	    runloop_button_latency = TA0R - woken;
+#endif
+
+	/* the slow listeners run once the buttons are handled */
+	sys_messagebus_background();
+
+	/* continue the protothreads that are done waiting */
+	pt_run();
+
+	/* wake up every second only while something counts seconds */
+	rtca_set_second_events((sys_messagebus_listens() & SYS_MSG_RTC_SECOND)
+			       || menu_timeout_pending());
     }
 }
 
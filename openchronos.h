@@ -35,7 +35,7 @@
     If you are a module developer please take a look to the following topics, we choose them for you because they are the most important when starting a new module.
     <ol>
         <li>First have a look to <a href="http://sourceforge.net/p/openchronos-ng/wiki/Module%20build%20system/">our wiki</a> to understand how to create a module (including its sources) and make it appear in the openchronos menu config. It is really simple and should not take much of your time.</li>
-        <li>Then have a look to menu_add_entry(), this is what you should call during module initialization to make it appear in the system menu. It is also in this function where you specify the module functions that are to be called when the user presses the ez430 chronos buttons.</li>
+        <li>Then have a look to struct menu, this is what your module should define as mod_<i>name</i>_menu to make it appear in the system menu. It is also there that you specify the module functions that are to be called when the user presses the ez430 chronos buttons.</li>
         <li>Your module is now receiving input but what about output? Have a look to drivers/display.h, you can display strings using #display_chars() and turn ON/OFF symbols using #display_symbol(). </li>
         <li>Finally, if your module needs to execute some code periodically, then have a look to sys_messagebus_register() and #sys_message, on how to make your module listen for system events, like 1Hz events from the hardware timer.</li>
     </ol>
@@ -73,4 +73,46 @@ void helpers_loop(uint8_t * value,	/*!< value a pointer to the variable to be in
 		  int8_t step	/*!< 1 for incrementing value, -1 for a decrement */
     );
 
+/*!
+    \brief Number of times the main loop woke up since boot.
+*/
+extern uint32_t runloop_wakeups;
+/*!
+    \brief Main loop wakeups during the last full minute.
+    \note Both counters are only kept when the diagnostics module is enabled.
+*/
+extern uint16_t runloop_wakeups_minute;
+/*!
+    \brief Longest main loop pass from wakeup until the menu handled a held button, in TA0R ticks (1/16384 s).
+    \note Only kept when the diagnostics module is enabled.
+*/
+extern uint16_t runloop_button_latency;
+
+/*!
+    \brief The boot stages of main(), in order.
+*/
+enum boot_stage {
+    BOOT_STAGE_RTC,		/*!< rtca_init() */
+    BOOT_STAGE_RADIO,		/*!< radio core reset and powered down */
+    BOOT_STAGE_INPUTS,		/*!< acceleration sensor pins and buttons */
+    BOOT_STAGE_DRIVERS,		/*!< buzzer, pressure sensor, battery, temperature, infomem */
+    BOOT_STAGE_MODULES,		/*!< mod_init() */
+    BOOT_STAGE_FRAME,		/*!< menu_init(), the first clock frame is on the LCD */
+    BOOT_STAGE_DEFERRED,	/*!< governor and welcome tune, after the first frame */
+    BOOT_STAGES
+};
+
+#ifdef CONFIG_BOOT_PROFILE
+/*!
+    \brief TA0R ticks (1/16384 s) from the start of Timer0 to the end of each #boot_stage.
+    \details Timer0 starts first thing in main(). Save it with e.g.
+    <i>mspdebug rf2500 "save_raw boot_profile 14 boot.bin"</i> and report it
+    with tools/bootprof.py.
+*/
+extern uint16_t boot_profile[BOOT_STAGES];
+#define boot_stage_done(stage) (boot_profile[(stage)] = TA0R)
+#else
+#define boot_stage_done(stage)
+#endif
+
 #endif				/* __EZCHRONOS_H__ */
@@ -0,0 +1,71 @@
+/**
+    pool.c: openchronos-ng fixed-block memory pools
+
+    Copyright (C) 2026 openchronos-ng contributors
+
+    http://github.com/BenjaminSoelberg/openchronos-ng-elf
+
+    This file is part of openchronos-ng.
+
+    openchronos-ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    openchronos-ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include <msp430.h>
+#include <stdlib.h>
+
+#include "pool.h"
+
+#include "drivers/display.h"
+
+/* The pools are only used from the main loop, never from interrupts,
+   so there is no locking here. */
+
+void pool_panic(struct pool *pool)
+{
+    display_clear(0, 0);
+    display_label(0, LCD_SEG_L1_3_0, "FULL", SEG_SET);
+    display_chars(0, LCD_SEG_L2_4_0, pool->name, SEG_SET);
+
+    /* Stop here: the watchdog reboots us if enabled */
+    while (1);
+}
+
+void *pool_alloc(struct pool *pool)
+{
+    void *blk = pool->free;
+
+    if (blk) {
+	/* Reuse the most recently freed block */
+	pool->free = *(void **) blk;
+    } else if (pool->fresh < pool->nr) {
+	blk = pool->mem + pool->fresh++ * pool->size;
+    } else {
+	pool_panic(pool);
+    }
+
+    if (++pool->used > pool->peak)
+	pool->peak = pool->used;
+
+    return blk;
+}
+
+void pool_free(struct pool *pool, void *blk)
+{
+    if (!blk)
+	return;
+
+    *(void **) blk = pool->free;
+    pool->free = blk;
+    pool->used--;
+}
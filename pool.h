@@ -0,0 +1,100 @@
+/**
+    pool.h: openchronos-ng fixed-block memory pools
+
+    Copyright (C) 2026 openchronos-ng contributors
+
+    http://github.com/BenjaminSoelberg/openchronos-ng-elf
+
+    This file is part of openchronos-ng.
+
+    openchronos-ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    openchronos-ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+/*!
+    \file pool.h
+    \brief Fixed-block memory pools
+    \details Replaces malloc() for the few objects the firmware creates at
+    runtime. Every pool holds blocks of a single size in statically allocated
+    storage, so allocating and freeing are O(1) and RAM can't fragment.
+    The pools are defined in modinit.c, sized by tools/make_modinit.py for
+    the modules enabled in the configuration.
+*/
+
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <stdint.h>
+
+/*!
+    \brief A pool of equally sized memory blocks.
+    \details Blocks that were never handed out are taken in order from
+    <i>mem</i>, freed blocks are kept in a singly linked list threaded
+    through the blocks themselves. Use #POOL_DEFINE to create one.
+*/
+struct pool {
+    /*! storage for all blocks */
+    uint8_t *mem;
+    /*! size of a block in bytes, rounded up to a pointer */
+    uint16_t size;
+    /*! number of blocks in the pool */
+    uint8_t nr;
+    /*! blocks from this index on were never allocated */
+    uint8_t fresh;
+    /*! blocks currently allocated */
+    uint8_t used;
+    /*! high-water mark of <i>used</i> */
+    uint8_t peak;
+    /*! list of freed blocks */
+    void *free;
+    /*! up to 5 characters, shown on the LCD when the pool is exhausted */
+    char const *name;
+};
+
+/*! number of pointers needed to hold a block of <i>size</i> bytes */
+#define POOL_WORDS(size) (((size) + sizeof(void *) - 1) / sizeof(void *))
+
+/*!
+    \brief Defines a pool of <i>nr</i> blocks of <i>size</i> bytes.
+*/
+#define POOL_DEFINE(var, name, size, nr)				\
+    static void *var##_mem[POOL_WORDS(size) * (nr)];			\
+    struct pool var = { (uint8_t *) var##_mem,				\
+	POOL_WORDS(size) * sizeof(void *), (nr), 0, 0, 0, NULL, (name) }
+
+/*!
+    \brief Takes a block from the pool.
+    \details Never returns NULL: an exhausted pool is a build configuration
+    error and ends in pool_panic().
+*/
+void *pool_alloc(struct pool *pool);
+
+/*!
+    \brief Returns a block obtained with pool_alloc() to the pool.
+    \note Passing NULL is allowed and does nothing.
+*/
+void pool_free(struct pool *pool, void *blk);
+
+/*!
+    \brief Reports an exhausted pool and halts.
+    \details Shows FULL and the name of the pool on the LCD, then spins
+    until the watchdog (if enabled) reboots the watch.
+*/
+void pool_panic(struct pool *pool);
+
+/* Pools generated in modinit.c */
+extern struct pool messagebus_pool;	/*!< struct sys_messagebus nodes */
+extern struct pool lcd_screen_pool;	/*!< the struct lcd_screen array */
+extern struct pool lcd_buffer_pool;	/*!< segment and blink memory copies */
+
+#endif				/* __POOL_H__ */
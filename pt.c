@@ -0,0 +1,111 @@
+/**
+    pt.c: openchronos-ng protothreads
+
+    Copyright (C) 2026 openchronos-ng contributors
+
+    http://github.com/BenjaminSoelberg/openchronos-ng-elf
+
+    This file is part of openchronos-ng.
+
+    openchronos-ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    openchronos-ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include "pt.h"
+
+/* the running tasks */
+static struct pt_task *tasks;
+
+/* earliest wakeup asked for during this pt_run() */
+static uint16_t wake_at;
+static uint8_t wake_pending;
+
+/* a task was started during pt_run() */
+static uint8_t started;
+
+uint8_t pt_expired(uint16_t at)
+{
+    if ((int16_t)(TA0R - at) >= 0)
+	return 1;
+
+    if (!wake_pending || (int16_t)(at - wake_at) < 0) {
+	wake_at = at;
+	wake_pending = 1;
+    }
+    return 0;
+}
+
+void pt_start(struct pt_task *task)
+{
+    if (pt_running(task))
+	return;
+
+    PT_INIT(&task->pt);
+    task->next = tasks;
+    tasks = task;
+    started = 1;
+}
+
+void pt_stop(struct pt_task *task)
+{
+    struct pt_task **p = &tasks;
+
+    while (*p) {
+	if (*p == task) {
+	    *p = task->next;
+	    task->next = NULL;
+	    return;
+	}
+	p = &(*p)->next;
+    }
+}
+
+uint8_t pt_running(struct pt_task *task)
+{
+    struct pt_task *p = tasks;
+
+    while (p) {
+	if (p == task)
+	    return 1;
+	p = p->next;
+    }
+    return 0;
+}
+
+void pt_run(void)
+{
+    struct pt_task *p, *next;
+    char state;
+
+    wake_pending = 0;
+
+    do {
+	started = 0;
+	for (p = tasks; p; p = next) {
+	    /* the thread may stop itself or start others */
+	    next = p->next;
+	    state = p->fn(&p->pt);
+	    if (state >= PT_EXITED)
+		pt_stop(p);
+	    else if (state == PT_YIELDED)
+		pt_expired(TA0R + 1);
+	}
+    } while (started);
+
+    /* timer0_delay() shares the compare register, it only runs before
+       this point of the main loop, so arm it on every pass */
+    if (wake_pending)
+	timer0_wakeup_at(wake_at);
+    else
+	timer0_wakeup_cancel();
+}
@@ -0,0 +1,165 @@
+/**
+    pt.h: openchronos-ng protothreads
+
+    Copyright (C) 2026 openchronos-ng contributors
+
+    http://github.com/BenjaminSoelberg/openchronos-ng-elf
+
+    This file is part of openchronos-ng.
+
+    openchronos-ng is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    openchronos-ng is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+/*!
+    \file pt.h
+    \brief Protothreads, stackless coroutines run by the main loop
+    \details A protothread is a function that returns to the main loop
+    wherever it has to wait, and continues from there the next time it is
+    called, in the style of Adam Dunkels' protothreads. This replaces
+    timer0_delay(), which sleeps in a private low power loop while buttons
+    and messages wait.<br />
+    The position is saved as a line number in a switch, so the local
+    variables of the thread are lost while it waits: keep state in static
+    variables, and don't use switch statements across a wait.<br />
+    A #pt_task runs a protothread from the main loop until it ends, see
+    pt_start().
+*/
+
+#ifndef __PT_H__
+#define __PT_H__
+
+#include <stdint.h>
+
+#include "drivers/timer.h"
+
+/*!
+    \brief The state of a protothread.
+*/
+struct pt {
+    /*! line to continue from, 0 at the start */
+    uint16_t lc;
+    /*! TA0R at the end of a #PT_SLEEP */
+    uint16_t wake;
+};
+
+/*! \name Protothread return values */
+/*@{*/
+#define PT_WAITING 0
+#define PT_YIELDED 1
+#define PT_EXITED  2
+#define PT_ENDED   3
+/*@}*/
+
+/*! declares a protothread, e.g. PT_THREAD(blink(struct pt *pt)) */
+#define PT_THREAD(name_args) char name_args
+
+/*! restarts the protothread from the beginning */
+#define PT_INIT(pt) ((pt)->lc = 0)
+
+/*! starts the body of a protothread */
+#define PT_BEGIN(pt) { char pt_yield_flag = 1; (void)pt_yield_flag; \
+	switch ((pt)->lc) { case 0:
+
+/*! ends the body of a protothread */
+#define PT_END(pt) } PT_INIT(pt); return PT_ENDED; }
+
+/*! returns to the main loop until cond is true */
+#define PT_WAIT_UNTIL(pt, cond)				\
+    do {						\
+	(pt)->lc = __LINE__; case __LINE__:		\
+	if (!(cond))					\
+	    return PT_WAITING;				\
+    } while (0)
+
+/*! returns to the main loop while cond is true */
+#define PT_WAIT_WHILE(pt, cond) PT_WAIT_UNTIL((pt), !(cond))
+
+/*! returns to the main loop once */
+#define PT_YIELD(pt)					\
+    do {						\
+	pt_yield_flag = 0;				\
+	(pt)->lc = __LINE__; case __LINE__:		\
+	if (pt_yield_flag == 0)				\
+	    return PT_YIELDED;				\
+    } while (0)
+
+/*! runs the child protothread until it ends */
+#define PT_SPAWN(pt, child, thread)			\
+    do {						\
+	PT_INIT(child);					\
+	PT_WAIT_UNTIL((pt), (thread) >= PT_EXITED);	\
+    } while (0)
+
+/*! ends the protothread here */
+#define PT_EXIT(pt) do { PT_INIT(pt); return PT_EXITED; } while (0)
+
+/*! returns to the main loop until cond is true, or for at most ms (1 - 1000) milliseconds */
+#define PT_WAIT_UNTIL_TIMEOUT(pt, cond, ms)				\
+    do {								\
+	(pt)->wake = TA0R + TIMER0_TICKS_FROM_MS(ms);			\
+	PT_WAIT_UNTIL((pt), (cond) || pt_expired((pt)->wake));		\
+    } while (0)
+
+/*! returns to the main loop for ms (1 - 1000) milliseconds */
+#define PT_SLEEP(pt, ms) PT_WAIT_UNTIL_TIMEOUT((pt), 0, (ms))
+
+/*!
+    \brief Returns true once TA0R has passed <i>at</i>.
+    \details Otherwise makes sure the main loop wakes up at <i>at</i>. Only
+    for protothreads run by a #pt_task, through #PT_SLEEP.
+*/
+uint8_t pt_expired(uint16_t at);
+
+/*!
+    \brief A protothread run by the main loop.
+    \details Use #PT_TASK_DEFINE to create one.
+*/
+struct pt_task {
+    struct pt pt;
+    PT_THREAD((*fn)(struct pt *pt));
+    struct pt_task *next;
+};
+
+/*!
+    \brief Defines a task running the protothread <i>fn</i>.
+*/
+#define PT_TASK_DEFINE(var, fn) struct pt_task var = { { 0, 0 }, (fn), NULL }
+
+/*!
+    \brief Starts a task.
+    \details The protothread is called from the main loop, after the
+    messages are sent, until it exits or ends. Starting a running task
+    does nothing.
+*/
+void pt_start(struct pt_task *task);
+
+/*!
+    \brief Stops a task wherever it is waiting.
+    \details Nothing cleans up after the protothread, drivers must offer
+    their own way to stop what the thread started.
+*/
+void pt_stop(struct pt_task *task);
+
+/*!
+    \brief Returns true while the task runs.
+*/
+uint8_t pt_running(struct pt_task *task);
+
+/*!
+    \brief Calls the protothreads of the running tasks once.
+    \note For the main loop only.
+*/
+void pt_run(void);
+
+#endif				/* __PT_H__ */
@@ -0,0 +1,96 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+"""
+Reports the boot stages timed by a firmware built with CONFIG_BOOT_PROFILE,
+see enum boot_stage in openchronos.h.
+
+Save boot_profile from RAM right after a boot and report it:
+
+    mspdebug rf2500 "save_raw boot_profile 14 boot.bin"
+    bootprof.py -b tools/bootprof.json boot.bin
+
+Each stage is listed with the time it ended and took, counted from the
+start of Timer0 in main(). The time to the first clock frame is the
+benchmark: with -b it is compared against a previous report and the exit
+status is 1 when it grew by more than the tolerance.
+"""
+
+import os
+import sys
+import json
+import struct
+
+# enum boot_stage
+STAGES = ["rtc", "radio", "inputs", "drivers", "modules", "frame", "deferred"]
+
+# Timer0 runs from ACLK / 2
+TICKS_PER_MS = 16.384
+
+
+def read_binary(data):
+    """milliseconds at the end of each stage, from a boot_profile saved from RAM"""
+    ticks = struct.unpack_from("<%dH" % len(STAGES), data)
+    if not ticks[-1] or list(ticks) != sorted(ticks):
+        raise ValueError("not a boot profile: %s" % " ".join("%d" % t for t in ticks))
+    return [t / TICKS_PER_MS for t in ticks]
+
+
+def stages(times):
+    """(stage, ended at, took) in milliseconds"""
+    return [(name, at, at - (times[i - 1] if i else 0.0))
+            for i, (name, at) in enumerate(zip(STAGES, times))]
+
+
+def report(times, previous=None, tolerance=1.0, out=sys.stdout):
+    """prints the stages, False if the first frame is later than in previous"""
+    ok = True
+    out.write("%-10s %9s %9s\n" % ("stage", "at ms", "took ms"))
+    for name, at, took in stages(times):
+        line = "%-10s %9.1f %9.1f" % (name, at, took)
+        if previous is not None and name in previous:
+            delta = at - previous[name]
+            line += " %+9.1f" % delta
+            if name == "frame" and delta > tolerance:
+                line += "  SLOWER"
+                ok = False
+        out.write(line + "\n")
+    if not ok:
+        out.write("ERROR: the first clock frame shows up later than in the baseline\n")
+    return ok
+
+
+if __name__ == "__main__":
+    from optparse import OptionParser
+    parser = OptionParser(usage="%prog [options] boot.bin")
+    parser.add_option("-b", "--baseline", dest="baseline",
+                      help="times of a previous boot to compare with")
+    parser.add_option("-u", "--update", dest="update", action="store_true",
+                      help="write the times to the baseline instead of comparing")
+    parser.add_option("-t", "--tolerance", dest="tolerance", type="float", default=1.0,
+                      help="milliseconds the first frame may be late, default 1")
+    (options, args) = parser.parse_args()
+    if len(args) != 1:
+        parser.error("one saved boot profile expected")
+
+    f = open(args[0], "rb")
+    data = f.read()
+    f.close()
+    try:
+        times = read_binary(data)
+    except (ValueError, struct.error) as e:
+        sys.stderr.write("ERROR: %s\n" % e)
+        sys.exit(2)
+
+    previous = None
+    if options.baseline and not options.update and os.path.isfile(options.baseline):
+        previous = json.load(open(options.baseline))
+
+    ok = report(times, previous, options.tolerance)
+
+    if options.baseline and options.update:
+        f = open(options.baseline, "w")
+        json.dump(dict((name, round(at, 1)) for name, at, _ in stages(times)), f, indent=1, sort_keys=True)
+        f.close()
+
+    if not ok:
+        sys.exit(1)
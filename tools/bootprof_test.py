@@ -0,0 +1,64 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+
+import os
+import struct
+import unittest
+import bootprof
+
+try:
+    from StringIO import StringIO
+except ImportError:
+    from io import StringIO
+
+# Timer0 ticks at the end of each stage, 1/16384 s
+TICKS = [164, 328, 360, 492, 1638, 2048, 2600]
+
+
+def profile(ticks):
+    return struct.pack("<%dH" % len(ticks), *ticks)
+
+
+class BootProfileTests(unittest.TestCase):
+    def test_read(self):
+        """The saved ticks become milliseconds, one per stage"""
+        times = bootprof.read_binary(profile(TICKS))
+        self.assertEqual(len(times), len(bootprof.STAGES))
+        self.assertAlmostEqual(times[bootprof.STAGES.index("frame")], 125.0)
+
+    def test_not_a_profile(self):
+        """A firmware without CONFIG_BOOT_PROFILE leaves zeros or garbage"""
+        self.assertRaises(ValueError, bootprof.read_binary, profile([0] * 7))
+        self.assertRaises(ValueError, bootprof.read_binary, profile([5, 4, 6, 7, 8, 9, 10]))
+        self.assertRaises(struct.error, bootprof.read_binary, profile([1, 2]))
+
+    def test_stages(self):
+        """Each stage took the time since the previous one ended"""
+        rows = bootprof.stages(bootprof.read_binary(profile(TICKS)))
+        self.assertEqual([r[0] for r in rows], bootprof.STAGES)
+        self.assertAlmostEqual(rows[0][2], 10.0, 1)
+        self.assertAlmostEqual(rows[4][2], (1638 - 492) / 16.384)
+
+    def test_baseline(self):
+        """Only a later first frame fails, the deferred stage may grow"""
+        out = open(os.devnull, "w")
+        times = bootprof.read_binary(profile(TICKS))
+        previous = dict((name, at) for name, at, _ in bootprof.stages(times))
+        self.assertTrue(bootprof.report(times, previous, out=out))
+        later = bootprof.read_binary(profile(TICKS[:5] + [2048 + 33, 2600]))
+        self.assertFalse(bootprof.report(later, previous, out=out))
+        self.assertTrue(bootprof.report(later, previous, 3.0, out))
+        self.assertTrue(bootprof.report(bootprof.read_binary(profile(TICKS[:6] + [9000])), previous, out=out))
+        out.close()
+
+    def test_report(self):
+        """One line per stage, after the header"""
+        out = StringIO()
+        bootprof.report(bootprof.read_binary(profile(TICKS)), out=out)
+        lines = out.getvalue().splitlines()
+        self.assertEqual(len(lines), len(bootprof.STAGES) + 1)
+        self.assertEqual(lines[6].split(), ["frame", "125.0", "25.0"])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -46,12 +46,31 @@ DATA["USE_LCD_CHARGE_PUMP"] = {
     "help": "Use the internal charge pump to make the display contrast constant through the whole battery lifetime. As a downside this increases current usage and reduces battery lifetime.",
 }
 
+DATA["CONFIG_LCD_FLIP"] = {
+    "name": "Flip LCD screens in hardware",
+    "default": False,
+    "help": "Modules with several screens keep their second screen in the LCD blinking memory and switch to it with a single register write instead of copying both memories. Falls back to copying as soon as something blinks.",
+}
+
 DATA["USE_WATCHDOG"] = {
     "name": "Use Watchdog",
     "default": True,
     "help": "Protects the clock against deadlocks by rebooting it.",
 }
 
+DATA["CONFIG_CRASH_LOG"] = {
+    "name": "Record crashes and watchdog resets",
+    "default": False,
+    'depends': [ 'USE_WATCHDOG' ],
+    "help": "Runs the watchdog as a 16s interval timer that samples the PC and stack and resets after 256s without wakeup. The reason of the last reset, its PC, stack, last message bus callback and uptime are kept across the reset and shown by the DIAG module, tools/crashlog.py symbolizes them.",
+}
+
+DATA["CONFIG_BOOT_PROFILE"] = {
+    "name": "Time the boot stages",
+    "default": False,
+    "help": "Keeps the Timer0 ticks at the end of each boot stage in RAM, to be saved with mspdebug and reported by tools/bootprof.py. The DIAG module shows the time to the first clock frame.",
+}
+
 DATA["CONFIG_RUNLOOP_INDICATOR"] = {
     "name": "Show runloop indicator",
     "default": False,
@@ -83,7 +102,7 @@ DATA["CONFIG_RTC_DST_ZONE"] = {
     "type": "text",
     "default": 1,
     'depends': [ 'CONFIG_RTC_DST' ],
-    "help": "DST Zone: 1=DST_US, 2=DST_MEX, 3=DST_BRZ, 4=DST_EU, 5=DST_AUS, 6=DST_NZ."
+    "help": "Default DST zone, can be changed in the clock settings. 0=none, 1=DST_US, 2=DST_MEX, 3=DST_BRZ, 4=DST_EU, 5=DST_AUS, 6=DST_NZ, 7=DST_UK, 8=DST_EET. See drivers/rtc_dst.rules to add zones."
 }
 
 # TIMER0 DRIVER ##############################################################
@@ -99,6 +118,41 @@ DATA["CONFIG_TIMER_4S_IRQ"] = {
     "help": "Enables 0.244Hz interrupts on the hardware timer.",
 }
 
+# GOVERNOR DRIVER ############################################################
+
+DATA["TEXT_GOVERNOR"] = {
+    "name": "Clock governor",
+    "type": "info",
+}
+
+DATA["CONFIG_GOVERNOR"] = {
+    "name": "Run at 4MHz between heavy tasks",
+    "default": False,
+    "help": "Lowers MCLK to 4MHz and the core voltage to level 0 after boot. OTP codes, pressure compensation, accelerometer math, the buzzer and the radio still run at 12MHz. tools/energy.py -g compares a day with and without it.",
+}
+
+# INTERRUPT TRACE ############################################################
+
+DATA["TEXT_IRQ_TRACE"] = {
+    "name": "Interrupt trace",
+    "type": "info",
+}
+
+DATA["CONFIG_IRQ_TRACE"] = {
+    "name": "Record the interrupts after boot",
+    "default": False,
+    "help": "Records the RTC, button, sensor and timer interrupts into RAM, to be saved with mspdebug and replayed with tools/irqtrace.py. Enables the 0.244Hz timer interrupt.",
+}
+
+DATA["CONFIG_IRQ_TRACE_RECORDS"] = {
+    "name": "Interrupts to record",
+    "type": "text",
+    "default": "128",
+    "ifndef": True,
+    'depends': [ 'CONFIG_IRQ_TRACE' ],
+    "help": "Size of the trace, 4 bytes of RAM each.",
+}
+
 # PORTS DRIVER ###############################################################
 
 DATA["TEXT_PORTS"] = {
@@ -171,6 +225,19 @@ DATA["CONFIG_TEMPERATURE_METRIC"] = {
     "help": "Show in degrees C if enabled, F otherwise.",
 }
 
+# INFOMEM DRIVER #############################################################
+
+DATA["TEXT_INFOMEM"] = {
+    "name": "Information memory driver",
+    "type": "info",
+}
+
+DATA["CONFIG_INFOMEM"] = {
+    "name": "Keep settings in the information memory",
+    "default": True,
+    "help": "Lets modules store settings in the information memory flash, so they survive a reset. Used by the alarm module.",
+}
+
 # RADIO DRIVER ##################################################
 DATA["TEXT_RADIO"] = {
     "name": "Radio driver",
@@ -181,7 +248,7 @@ DATA["CONFIG_ISM"] = {
     "name": "ISM band for radio operation",
     "type": "text",
     "default": 1,
-    "help": "Band: 1=US (902MHz), 2=EU (868MHz), 3=LF (433MHz legacy)."
+    "help": "Band: 1=US (902MHz), 2=EU (868MHz), 3=LF (433MHz legacy). Also the carrier of the raw radio packets."
 }
 
 # AUTOMATICALLY GENERATED MODULE LIST ########################################
@@ -0,0 +1,153 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+"""
+Symbolizes the crash record of a watch built with CONFIG_CRASH_LOG, see
+drivers/crashlog.h.
+
+Save the record of the previous run from RAM and decode it against the
+firmware that ran:
+
+    mspdebug rf2500 "save_raw crashlog 46 crash.bin"
+    crashlog.py -e build/openchronos.elf crash.bin
+
+The report names the reset reason, the function the last watchdog
+interval interrupted, the message bus callback dispatched last and the
+stack words that look like return addresses, the callers of that function
+from the innermost on. Without mspdebug, the addresses printed by
+'ChronosTool.py diag' are symbolized with -a.
+"""
+
+import sys
+import struct
+import elf
+
+# struct crashlog
+FORMAT = "<HHHHHI16H"
+MAGIC = 0xc4a5
+
+# SYSRSTIV of the CC430F6137
+RESETS = {
+    0x00: "no reset pending",
+    0x02: "brownout, power on",
+    0x04: "RST/NMI pin",
+    0x06: "software brownout",
+    0x08: "wakeup from LPMx.5",
+    0x0a: "security violation",
+    0x0c: "SVS low side",
+    0x0e: "SVS high side",
+    0x10: "SVM low side overvoltage",
+    0x12: "SVM high side overvoltage",
+    0x14: "software power on reset",
+    0x16: "watchdog time out, the main loop hung",
+    0x18: "watchdog password violation",
+    0x1a: "flash password violation",
+    0x1e: "instruction fetch from peripheral area",
+    0x20: "PMM password violation",
+}
+
+
+def read(data):
+    """the fields of a struct crashlog saved from RAM"""
+    fields = struct.unpack_from(FORMAT, data)
+    if fields[0] != MAGIC:
+        raise ValueError("not a crash record, magic 0x%04x" % fields[0])
+    return {"reset": fields[1], "pc": fields[2], "sp": fields[3],
+            "callback": fields[4], "uptime": fields[5], "stack": list(fields[6:])}
+
+
+class Symbols:
+    """function names of the addresses in an ELF file"""
+    def __init__(self, obj):
+        if not [s for s in obj.sections if s.sh_type == elf.ELFSection.SHT_SYMTAB]:
+            raise ValueError("no symbol table, the ELF was stripped")
+        self.code = [(s.sh_addr, s.sh_addr + s.sh_size) for s in obj.sections
+                     if s.sh_flags & elf.ELFSection.SHF_EXECINSTR]
+        self.functions = sorted((s.st_value, s.st_size, s.name) for s in obj.getSymbols()
+                                if s.getType() == elf.ELFSymbol.STT_FUNC and s.name)
+
+    def is_code(self, address):
+        for start, end in self.code:
+            if start <= address < end:
+                return True
+        return False
+
+    def lookup(self, address):
+        """name+offset of the function holding address, None outside of them"""
+        best = None
+        for start, size, name in self.functions:
+            if start > address:
+                break
+            if address < start + max(size, 1):
+                best = (name, address - start)
+        if best is None:
+            return None
+        if best[1]:
+            return "%s+0x%x" % best
+        return best[0]
+
+    def describe(self, address):
+        return "0x%04x %s" % (address, self.lookup(address) or "?")
+
+
+def calls(record, symbols):
+    """(stack address, return address, caller) of the code addresses on the stack"""
+    res = []
+    # the first two words are the SR and PC pushed by the interrupt
+    for i, word in enumerate(record["stack"][2:]):
+        # a call at the end of a function returns to the next one
+        if word & 1 or not symbols.is_code(word - 2):
+            continue
+        caller = symbols.lookup(word - 2)
+        if caller:
+            res.append((record["sp"] + 2 * (i + 2), word, caller))
+    return res
+
+
+def report(record, symbols, out=sys.stdout):
+    out.write("reset    0x%02x %s\n" % (record["reset"], RESETS.get(record["reset"], "unknown")))
+    out.write("uptime   %d s\n" % record["uptime"])
+    if not record["sp"]:
+        out.write("no watchdog interval was taken before the reset\n")
+        return
+    out.write("pc       %s\n" % symbols.describe(record["pc"]))
+    out.write("callback %s\n" % symbols.describe(record["callback"]))
+    out.write("sp       0x%04x\n" % record["sp"])
+    for sp, word, caller in calls(record, symbols):
+        out.write("  0x%04x 0x%04x called from %s\n" % (sp, word, caller))
+
+
+if __name__ == "__main__":
+    from optparse import OptionParser
+    parser = OptionParser(usage="%prog -e openchronos.elf [crash.bin]")
+    parser.add_option("-e", "--elf", dest="elf",
+                      help="firmware that crashed, with its symbols")
+    parser.add_option("-a", "--address", dest="addresses", action="append", default=[],
+                      help="only symbolize this address, may be repeated")
+    (options, args) = parser.parse_args()
+    if not options.elf:
+        parser.error("the ELF file is needed")
+    if len(args) != 1 and not options.addresses:
+        parser.error("a saved crash record or addresses expected")
+
+    obj = elf.ELFObject()
+    f = open(options.elf, "rb")
+    obj.fromFile(f)
+    f.close()
+    try:
+        symbols = Symbols(obj)
+    except ValueError as e:
+        sys.stderr.write("ERROR: %s: %s\n" % (options.elf, e))
+        sys.exit(1)
+
+    for address in options.addresses:
+        print(symbols.describe(int(address, 16)))
+
+    if args:
+        f = open(args[0], "rb")
+        data = f.read()
+        f.close()
+        try:
+            report(read(data), symbols)
+        except (ValueError, struct.error) as e:
+            sys.stderr.write("ERROR: %s\n" % e)
+            sys.exit(1)
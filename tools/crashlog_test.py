@@ -0,0 +1,117 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+
+import os
+import struct
+import tempfile
+import unittest
+import elf
+import crashlog
+
+try:
+    from StringIO import StringIO
+except ImportError:
+    from io import StringIO
+
+# functions of the test ELF: name, address, size
+FUNCTIONS = [("main", 0x8000, 0x40), ("menu_check_buttons", 0x8040, 0x20), ("clock_event", 0x8060, 0x30)]
+
+
+def write_elf(filename):
+    """write a minimal ELF32 executable with a .text section and a symbol table of FUNCTIONS"""
+    text = "\0" * 0x100
+    strtab = "\0" + "".join(name + "\0" for name, _, _ in FUNCTIONS)
+    symtab = struct.pack("<IIIBBH", 0, 0, 0, 0, 0, 0)
+    nameoff = 1
+    for name, address, size in FUNCTIONS:
+        symtab += struct.pack("<IIIBBH", nameoff, address, size, 0x12, 0, 1)
+        nameoff += len(name) + 1
+    # a variable must not be taken for a function
+    symtab += struct.pack("<IIIBBH", 1, 0x8080, 2, 0x11, 0, 1)
+    shstrtab = "\0.text\0.symtab\0.strtab\0.shstrtab\0"
+    body = text + symtab + strtab + shstrtab
+    offset = 52
+    headers = [struct.pack("<IIIIIIIIII", *[0] * 10),
+               struct.pack("<IIIIIIIIII", 1, 1, 0x6, 0x8000, offset, len(text), 0, 0, 2, 0),
+               struct.pack("<IIIIIIIIII", 7, 2, 0, 0, offset + len(text), len(symtab), 3, 1, 4, 16),
+               struct.pack("<IIIIIIIIII", 15, 3, 0, 0, offset + len(text) + len(symtab), len(strtab), 0, 0, 1, 0),
+               struct.pack("<IIIIIIIIII", 23, 3, 0, 0, offset + len(body) - len(shstrtab), len(shstrtab), 0, 0, 1, 0)]
+    ehdr = struct.pack("<16sHHIIIIIHHHHHH", "\x7fELF\x01\x01\x01" + "\0" * 9, 2, 105, 1, 0x8000,
+                       0, offset + len(body), 0, 52, 32, 0, 40, len(headers), len(headers) - 1)
+    fp = open(filename, "wb")
+    fp.write(ehdr + body + "".join(headers))
+    fp.close()
+
+
+def record(**fields):
+    """a struct crashlog as saved from RAM"""
+    values = dict(reset=0x16, pc=0x8066, sp=0x2bd0, callback=0x8060, uptime=3600, stack=[0] * 16)
+    values.update(fields)
+    return struct.pack(crashlog.FORMAT, crashlog.MAGIC, values["reset"], values["pc"], values["sp"],
+                       values["callback"], values["uptime"], *values["stack"])
+
+
+class CrashLogTests(unittest.TestCase):
+    def setUp(self):
+        fd, self.filename = tempfile.mkstemp(".elf")
+        os.close(fd)
+        write_elf(self.filename)
+        obj = elf.ELFObject()
+        fp = open(self.filename, "rb")
+        obj.fromFile(fp)
+        fp.close()
+        self.symbols = crashlog.Symbols(obj)
+
+    def tearDown(self):
+        os.remove(self.filename)
+
+    def test_symbols(self):
+        """The ELF symbol table names the function holding an address"""
+        self.assertEqual(self.symbols.lookup(0x8000), "main")
+        self.assertEqual(self.symbols.lookup(0x8052), "menu_check_buttons+0x12")
+        self.assertEqual(self.symbols.lookup(0x8090), None)
+        self.assertEqual(self.symbols.lookup(0x7ffe), None)
+        self.assertEqual(self.symbols.describe(0x8066), "0x8066 clock_event+0x6")
+
+    def test_stripped(self):
+        """A stripped ELF is refused rather than symbolizing nothing"""
+        obj = elf.ELFObject()
+        fp = open(self.filename, "rb")
+        obj.fromFile(fp)
+        fp.close()
+        obj.sections = [s for s in obj.sections if s.sh_type != elf.ELFSection.SHT_SYMTAB]
+        self.assertRaises(ValueError, crashlog.Symbols, obj)
+
+    def test_record(self):
+        """A saved record reads back, anything else is refused"""
+        fields = crashlog.read(record())
+        self.assertEqual(fields["reset"], 0x16)
+        self.assertEqual(fields["uptime"], 3600)
+        self.assertEqual(len(fields["stack"]), 16)
+        self.assertEqual(struct.calcsize(crashlog.FORMAT), 46)
+        self.assertRaises(ValueError, crashlog.read, "\xff" * 46)
+
+    def test_calls(self):
+        """Return addresses on the stack name the callers, data and the interrupt frame don't"""
+        stack = [0x8066, 0x8066, 0x0003, 0x8056, 0x2bf0, 0x8021, 0x8012, 0x9000] + [0] * 8
+        fields = crashlog.read(record(stack=stack))
+        self.assertEqual(crashlog.calls(fields, self.symbols),
+                         [(0x2bd6, 0x8056, "menu_check_buttons+0x14"), (0x2bdc, 0x8012, "main+0x10")])
+        out = StringIO()
+        crashlog.report(fields, self.symbols, out)
+        lines = out.getvalue().splitlines()
+        self.assertEqual(lines[0], "reset    0x16 watchdog time out, the main loop hung")
+        self.assertEqual(lines[2], "pc       0x8066 clock_event+0x6")
+        self.assertEqual(lines[3], "callback 0x8060 clock_event")
+        self.assertEqual(len(lines), 7)
+
+    def test_reset_before_first_interval(self):
+        """Without a watchdog interval only the reason and uptime are known"""
+        out = StringIO()
+        crashlog.report(crashlog.read(record(reset=0x02, sp=0, pc=0, uptime=0)), self.symbols, out)
+        self.assertEqual(out.getvalue().splitlines()[0], "reset    0x02 brownout, power on")
+        self.assertEqual(len(out.getvalue().splitlines()), 3)
+
+
+if __name__ == '__main__':
+    unittest.main()
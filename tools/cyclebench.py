@@ -0,0 +1,257 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+"""
+Cycle counts of firmware kernels on the MSP430 instruction set simulator.
+
+Host timings say little about a 16-bit CPU without a hardware multiplier,
+so the kernels below are built with msp430-elf-gcc and the flags of
+Common.mk, linked against the real drivers and run on the 'sim' driver of
+mspdebug. A tracer device counts the MCLK cycles; the benchmark program
+calls bench_mark() between the kernels and stops there on a breakpoint, the
+difference of two counts minus the cost of an empty pair is the cycle count
+of one call.
+
+The counts are compared against a baseline file, tools/cyclebench.json by
+default, the exit status is 1 when a kernel got slower than the tolerance
+allows or when there is no baseline to compare with. -u writes it; the
+baseline is only meaningful when measured, so write it with -u on a machine
+with the toolchain and mspdebug instead of filling it in by hand.
+"""
+
+import os
+import re
+import sys
+import json
+import shutil
+import subprocess
+import tempfile
+
+ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
+
+# linked as they are, besides the sources the benchmark program includes to
+# reach static functions (modules/hashutils.c, drivers/rtc_dst.c)
+SOURCES = ["drivers/display.c", "drivers/ps.c", "drivers/bmp_ps.c",
+           "drivers/bmp_as.c", "drivers/rtca.c"]
+
+# (name, call), in the order they run; the call is a C statement
+KERNELS = [
+    ("sha1_transform", "sha1_transform(&sha1_info);"),
+    ("hmac_sha1", "hmac_sha1(key, sizeof(key), challenge, sizeof(challenge), digest, sizeof(digest));"),
+    ("_sprintf", "sink = _sprintf(\"%04u\", 2026);"),
+    ("conv_pa_to_meter", "altitude = conv_pa_to_meter(95000, 2932);"),
+    ("bmp_ps_calc_pa", "pa = bmp_ps_calc_pa(23843, 0);"),
+    ("rtca_days_since_epoch", "days = rtca_days_since_epoch(2026, 10, 19);"),
+    ("rtc_dst_rule_time", "epoch = rtc_dst_rule_time(rtc_dst_rules[0].start, 2026);"),
+    ("bmp_as_calc_axes", "bmp_as_calc_axes(raw, axes);"),
+]
+
+MAIN = """\
+/* benchmark program generated by tools/cyclebench.py */
+#include "modules/hashutils.c"
+
+/* the DST rules are benchmarked whatever config.h says */
+#define CONFIG_RTC_DST
+#ifndef CONFIG_RTC_DST_ZONE
+#define CONFIG_RTC_DST_ZONE 0
+#endif
+
+#include "openchronos.h"
+#include "drivers/display.h"
+#include "drivers/ps.h"
+#include "drivers/bmp_ps.h"
+#include "drivers/bmp_as.h"
+#include "drivers/rtca.h"
+
+#include "drivers/rtc_dst.c"
+
+extern bmp_085_calibration_param_t bmp_cal_param;
+extern long bmp_param_b5;
+
+#ifdef CONFIG_GOVERNOR
+/* cycles don't depend on the clock, leave the PMM alone */
+void governor_boost(void) {}
+void governor_release(void) {}
+#endif
+
+static SHA1_INFO sha1_info;
+static const uint8_t key[10] = "0123456789";
+static const uint8_t challenge[8] = {0, 0, 0, 0, 3, 0x6b, 0x2e, 0x40};
+static uint8_t digest[20];
+static int16_t axes[3];
+static uint16_t raw[3];
+
+volatile char *sink;
+volatile int16_t altitude;
+volatile uint32_t pa;
+volatile uint16_t days;
+volatile uint32_t epoch;
+
+/* the breakpoint between two kernels */
+__attribute__((noinline)) void bench_mark(void)
+{
+	__asm__ volatile ("");
+}
+
+int main(void)
+{
+	WDTCTL = WDTPW + WDTHOLD;
+
+	sha1_init(&sha1_info);
+	init_pressure_table();
+	/* BMP085 datasheet example, 15.0 degrees C */
+	bmp_cal_param.ac1 = 408;
+	bmp_cal_param.ac2 = -72;
+	bmp_cal_param.ac3 = -14383;
+	bmp_cal_param.ac4 = 32741;
+	bmp_cal_param.ac5 = 32757;
+	bmp_cal_param.ac6 = 23153;
+	bmp_cal_param.b1 = 6190;
+	bmp_cal_param.b2 = 4;
+	bmp_cal_param.mb = -32768;
+	bmp_cal_param.mc = -8711;
+	bmp_cal_param.md = 2868;
+	bmp_param_b5 = 2399;
+
+	/* an empty pair, the cost of the breakpoint call itself */
+	bench_mark();
+	bench_mark();
+%(calls)s
+	while (1);
+}
+"""
+
+# the MCLK counter of 'simio info' on a tracer device
+_mclk_re = re.compile(r"^\s*MCLK:\s*(\d+)", re.M)
+_assign_re = re.compile(r"^\s*([A-Za-z_][A-Za-z0-9_]*)\s*(\+?=)\s*(.*?)\s*$")
+_var_re = re.compile(r"\$\(([A-Za-z_][A-Za-z0-9_]*)\)")
+
+
+def parse_make_vars(lines, env=None):
+    """the '=' and '+=' assignments of a makefile, references expanded"""
+    values = dict(env or {})
+    for line in lines:
+        line = line.split("#", 1)[0]
+        m = _assign_re.match(line)
+        if not m:
+            continue
+        name, op, value = m.groups()
+        value = _var_re.sub(lambda v: values.get(v.group(1), ""), value)
+        if op == "+=" and values.get(name):
+            value = values[name] + " " + value
+        values[name] = value.strip()
+    return values
+
+
+def build_flags(msp430_ti, debug=False):
+    """compiler flags of the firmware build, taken from Common.mk"""
+    f = open(os.path.join(ROOT, "Common.mk"))
+    values = parse_make_vars(f, {"MSP430_TI": msp430_ti})
+    f.close()
+    flags = values["CFLAGS"].split() + values["CFLAGS_DBG" if debug else "CFLAGS_REL"].split()
+    # the breakpoint needs the symbols, so no -Wl,-s from LDFLAGS_REL
+    return flags + ["-Wl,--gc-sections"] + values["INCLUDES"].split()
+
+
+def benchmark_source(kernels=KERNELS):
+    return MAIN % {"calls": "".join("\t%s\n\tbench_mark();\n" % call for name, call in kernels)}
+
+
+def mspdebug_commands(elf, marks):
+    """stops at each bench_mark() and prints the cycle counter"""
+    return ["prog %s" % elf, "simio add tracer t", "setbreak bench_mark"] + \
+        ["run", "simio info t"] * marks
+
+
+def parse_counts(output):
+    """the MCLK counts printed by mspdebug, in order"""
+    return [int(c) for c in _mclk_re.findall(output)]
+
+
+def cycles_per_call(counts, kernels=KERNELS):
+    """counts at each bench_mark(), the empty pair first"""
+    if len(counts) != len(kernels) + 2:
+        raise ValueError("%d breakpoints hit instead of %d" % (len(counts), len(kernels) + 2))
+    overhead = counts[1] - counts[0]
+    return dict((name, counts[i + 2] - counts[i + 1] - overhead)
+                for i, (name, call) in enumerate(kernels))
+
+
+def run(cc, mspdebug, msp430_ti, debug=False):
+    """builds and runs the benchmark, returns the cycles per kernel"""
+    build = tempfile.mkdtemp(prefix="cyclebench")
+    try:
+        f = open(os.path.join(build, "bench.c"), "w")
+        f.write(benchmark_source())
+        f.close()
+        elf = os.path.join(build, "bench.elf")
+        # -Wl,-Map and -fstack-usage leave their files in the build directory
+        subprocess.check_call([cc] + build_flags(msp430_ti, debug) +
+                              ["-I" + build, "-I" + ROOT, "-I" + os.path.join(ROOT, "drivers"),
+                               "-o", elf, os.path.join(build, "bench.c")] +
+                              [os.path.join(ROOT, s) for s in SOURCES] + ["-lm"], cwd=build)
+        out = subprocess.check_output([mspdebug, "-q", "sim"] +
+                                      mspdebug_commands(elf, len(KERNELS) + 2), cwd=build)
+        return cycles_per_call(parse_counts(out.decode()))
+    finally:
+        shutil.rmtree(build, ignore_errors=True)
+
+
+def report(cycles, previous=None, tolerance=0.0, out=sys.stdout):
+    """prints the cycles per call, False if a kernel got slower than tolerance percent"""
+    ok = True
+    out.write("%-24s %10s\n" % ("", "cycles"))
+    for name, call in KERNELS:
+        if name not in cycles:
+            continue
+        line = "%-24s %10d" % (name, cycles[name])
+        if previous and name in previous["cycles"]:
+            before = previous["cycles"][name]
+            line += " %+9d" % (cycles[name] - before)
+            if cycles[name] > before * (1 + tolerance / 100.0):
+                line += "  SLOWER"
+                ok = False
+        out.write(line + "\n")
+    if not ok:
+        out.write("ERROR: kernels got slower than the baseline\n")
+    return ok
+
+
+if __name__ == "__main__":
+    from optparse import OptionParser
+    parser = OptionParser(usage="%prog [options]")
+    parser.add_option("--cc", dest="cc", default="msp430-elf-gcc",
+                      help="MSP430 compiler [default: %default]")
+    parser.add_option("--mspdebug", dest="mspdebug", default="mspdebug",
+                      help="mspdebug with the sim driver [default: %default]")
+    parser.add_option("--ti", dest="ti", default=os.environ.get("MSP430_TI", ""),
+                      help="MSP430_TI of Common.mk, the toolchain root [default: %default]")
+    parser.add_option("-d", "--debug", dest="debug", action="store_true",
+                      help="build with CFLAGS_DBG instead of CFLAGS_REL")
+    parser.add_option("-b", "--baseline", dest="baseline",
+                      default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "cyclebench.json"),
+                      help="cycle counts to compare with [default: %default]")
+    parser.add_option("-u", "--update", dest="update", action="store_true",
+                      help="write the counts to the baseline instead of comparing")
+    parser.add_option("-t", "--tolerance", dest="tolerance", type="float", default=0.0,
+                      help="allowed growth of a kernel in percent [default: %default]")
+    (options, args) = parser.parse_args()
+
+    # a missing baseline would let any count pass
+    previous = None
+    if not options.update:
+        if not os.path.isfile(options.baseline):
+            sys.stderr.write("ERROR: no baseline %s, write one with -u\n" % options.baseline)
+            sys.exit(1)
+        previous = json.load(open(options.baseline))
+
+    cycles = run(options.cc, options.mspdebug, options.ti, options.debug)
+
+    ok = report(cycles, previous, options.tolerance)
+
+    if options.update:
+        f = open(options.baseline, "w")
+        json.dump({"cycles": cycles}, f, indent=1, sort_keys=True)
+        f.close()
+
+    if not ok:
+        sys.exit(1)
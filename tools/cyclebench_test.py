@@ -0,0 +1,81 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+
+import os
+import subprocess
+import sys
+import unittest
+import cyclebench
+
+# 'simio info' of a tracer device, as printed by mspdebug
+TRACER_INFO = """\
+Instruction count: %d
+MCLK:              %d
+SMCLK:             %d
+ACLK:              0
+IRQ requested:     none
+"""
+
+
+class CycleBenchTests(unittest.TestCase):
+    def test_make_vars(self):
+        """Assignments are appended to and expanded in order"""
+        values = cyclebench.parse_make_vars([
+            "CC_CMACH    = -mmcu=cc430f6137\n",
+            "# a comment\n",
+            "CFLAGS      += $(CC_CMACH) -Wall\n",
+            "CFLAGS      += -Os # trailing comment\n",
+            "INCLUDES    += -I$(MSP430_TI)/include\n",
+        ], {"MSP430_TI": "/ti"})
+        self.assertEqual(values["CFLAGS"], "-mmcu=cc430f6137 -Wall -Os")
+        self.assertEqual(values["INCLUDES"], "-I/ti/include")
+
+    def test_common_mk_flags(self):
+        """The release flags of the firmware, symbols kept for the breakpoint"""
+        flags = cyclebench.build_flags("/ti")
+        self.assertIn("-mmcu=cc430f6137", flags)
+        self.assertIn("-mhwmult=none", flags)
+        self.assertIn("-Os", flags)
+        self.assertIn("-I/ti/include", flags)
+        self.assertNotIn("-Wl,-s", flags)
+        self.assertIn("-O1", cyclebench.build_flags("/ti", debug=True))
+
+    def test_cycles_per_call(self):
+        """The empty pair is taken off each kernel"""
+        kernels = [("a", ""), ("b", "")]
+        counts = [100, 110, 1110, 1130]
+        out = "".join(TRACER_INFO % (c / 2, c, c) for c in counts)
+        self.assertEqual(cyclebench.parse_counts(out), counts)
+        self.assertEqual(cyclebench.cycles_per_call(counts, kernels), {"a": 990, "b": 10})
+        self.assertRaises(ValueError, cyclebench.cycles_per_call, counts[:3], kernels)
+
+    def test_one_breakpoint_per_kernel(self):
+        """The program calls bench_mark() after each kernel"""
+        source = cyclebench.benchmark_source()
+        self.assertEqual(source.count("bench_mark();"), len(cyclebench.KERNELS) + 2)
+        commands = cyclebench.mspdebug_commands("bench.elf", len(cyclebench.KERNELS) + 2)
+        self.assertEqual(commands.count("run"), len(cyclebench.KERNELS) + 2)
+
+    def test_baseline(self):
+        """Any kernel slower than the baseline fails"""
+        out = open(os.devnull, "w")
+        previous = {"cycles": {"hmac_sha1": 100000, "_sprintf": 500}}
+        self.assertTrue(cyclebench.report({"hmac_sha1": 99000, "_sprintf": 500}, previous, out=out))
+        self.assertFalse(cyclebench.report({"hmac_sha1": 99000, "_sprintf": 501}, previous, out=out))
+        self.assertTrue(cyclebench.report({"hmac_sha1": 100900}, previous, 1.0, out))
+        # kernels new to the baseline are only reported
+        self.assertTrue(cyclebench.report({"sha1_transform": 20000}, previous, out=out))
+        out.close()
+
+    def test_missing_baseline(self):
+        """Without a baseline the run fails before building, unless it writes one"""
+        script = os.path.join(os.path.dirname(os.path.abspath(__file__)), "cyclebench.py")
+        proc = subprocess.Popen([sys.executable, script, "-b", os.path.join(cyclebench.ROOT, "missing.json"),
+                                 "--cc", "false"], stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        out, err = proc.communicate()
+        self.assertEqual(proc.returncode, 1)
+        self.assertIn("no baseline", err.decode())
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,187 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+"""
+Compiles drivers/rtc_dst.rules into drivers/rtc_dst_rules.h, the table of
+daylight saving time zones used by drivers/rtc_dst.c.
+
+With -t it instead writes the changes tzdata has for the zones naming a
+tzdata zone, the reference tools/rtc_dst_test.py checks the firmware
+against. Reading tzdata needs the zoneinfo module of python 3.9 or later,
+the reference is committed so that the test runs without it.
+"""
+
+import calendar
+import datetime
+import re
+import sys
+
+RULE_DATE = re.compile(r"^M(\d+)\.(\d)\.(\d)(?:/(\d+))?$")
+
+
+class Date:
+    """one end of a DST period: day 'wday' of week 'week' of 'month' at 'hour'"""
+    def __init__(self, month, week, wday, hour):
+        self.month = month
+        self.week = week
+        self.wday = wday
+        self.hour = hour
+
+
+class Zone:
+    def __init__(self, name, start, end, tzname=None, years=None):
+        self.name = name
+        self.start = start
+        self.end = end
+        self.tzname = tzname
+        self.years = years
+
+
+def parse_date(text):
+    m = RULE_DATE.match(text)
+    if not m:
+        raise ValueError("bad rule date %r, expected Mm.w.d/h" % text)
+    month, week, wday = [int(v) for v in m.groups()[:3]]
+    hour = 2 if m.group(4) is None else int(m.group(4))
+    if not 1 <= month <= 12 or not 1 <= week <= 5 or not 0 <= wday <= 6:
+        raise ValueError("rule date %r out of range" % text)
+    return Date(month, week, wday, hour)
+
+
+def parse_zone(line):
+    fields = line.split()
+    if len(fields) not in (2, 4) or len(fields[0]) > 4:
+        raise ValueError("expected 'name rule [tzdata zone] [years]': %r" % line)
+    dates = fields[1].split(",")
+    if len(dates) != 2:
+        raise ValueError("expected start and end in %r" % fields[1])
+    start, end = [parse_date(d) for d in dates]
+    # the change is done by moving the hour register, so it must stay in the same day
+    if start.hour > 22:
+        raise ValueError("DST must start before 23:00: %r" % line)
+    if end.hour < 1 or end.hour > 23:
+        raise ValueError("DST must end between 01:00 and 23:00: %r" % line)
+    zone = Zone(fields[0], start, end)
+    if len(fields) == 4:
+        first, last = fields[3].split("-")
+        zone.tzname = fields[2]
+        zone.years = (int(first), int(last))
+    return zone
+
+
+def parse_rules(text):
+    """returns the zones in text, the format of drivers/rtc_dst.rules"""
+    zones = []
+    for line in text.splitlines():
+        line = line.split("#")[0].strip()
+        if line:
+            zones.append(parse_zone(line))
+    if len(zones) > 15:
+        raise ValueError("at most 15 zones fit in the zone number")
+    return zones
+
+
+def read_rules(filename):
+    with open(filename) as f:
+        return parse_rules(f.read())
+
+
+def local_epoch(time):
+    """seconds since 1970 of a naive local time, like rtca_time.epoch"""
+    return calendar.timegm(time.timetuple())
+
+
+def tzdata_transitions(tz, year):
+    """local time before the start and the end of DST in year, according to tzdata"""
+    res = {}
+    hour = datetime.timedelta(hours=1)
+    t = datetime.datetime(year, 1, 1, tzinfo=datetime.timezone.utc)
+    day = datetime.timedelta(days=1)
+    while t.year == year:
+        before = t.astimezone(tz).utcoffset()
+        if (t + day).astimezone(tz).utcoffset() != before:
+            # DST changes happen on full hours
+            while (t + hour).astimezone(tz).utcoffset() == before:
+                t += hour
+            t += hour
+            after = t.astimezone(tz).utcoffset()
+            res["start" if after > before else "end"] = local_epoch(t.replace(tzinfo=None) + before)
+        t += day
+    return res.get("start"), res.get("end")
+
+
+def tzdata_reference(zones):
+    """[(zone name, year, start, end)] from tzdata, for the years the rules claim"""
+    import zoneinfo
+    res = []
+    for zone in zones:
+        if not zone.tzname:
+            continue
+        tz = zoneinfo.ZoneInfo(zone.tzname)
+        for year in range(zone.years[0], zone.years[1] + 1):
+            start, end = tzdata_transitions(tz, year)
+            res.append((zone.name, year, start, end))
+    return res
+
+
+def generate_reference(reference):
+    out = ["# This file is autogenerated by tools/dstrules.py -t, do not edit!",
+           "# zone, year, then the local times before the start and the end of DST"]
+    for name, year, start, end in reference:
+        out.append("%s %u %u %u" % (name, year, start, end))
+    return "\n".join(out) + "\n"
+
+
+def read_reference(filename):
+    """the [(zone name, year, start, end)] written by -t"""
+    res = []
+    with open(filename) as f:
+        for line in f:
+            fields = line.split("#")[0].split()
+            if fields:
+                res.append((fields[0],) + tuple(int(v) for v in fields[1:]))
+    return res
+
+
+def c_date(d):
+    return "RTC_DST_DATE(%2u, %u, %u, %2u)" % (d.month, d.week, d.wday, d.hour)
+
+
+def generate_header(zones):
+    out = ["/* This file is autogenerated by tools/dstrules.py, do not edit! */",
+           "",
+           "#ifndef RTC_DST_RULES_H_",
+           "#define RTC_DST_RULES_H_",
+           ""]
+    for i, zone in enumerate(zones):
+        out.append("#define DST_%s %u" % (zone.name.upper(), i + 1))
+    out += ["",
+            "#define RTC_DST_ZONES %u" % len(zones),
+            "",
+            "#define RTC_DST_RULES { \\"]
+    for zone in zones:
+        out.append("\t{ \"%s\", %s, %s }, \\" % (zone.name, c_date(zone.start), c_date(zone.end)))
+    out += ["}", "", "#endif", ""]
+    return "\n".join(out)
+
+
+if __name__ == '__main__':
+    from optparse import OptionParser
+    parser = OptionParser(usage="%prog [options] <rules file>")
+    parser.add_option("-o", "--output", dest="output", default="drivers/rtc_dst_rules.h",
+                      help="header to write, default %default")
+    parser.add_option("-t", "--tzdata", dest="tzdata",
+                      help="write the tzdata reference of the zones to this file instead")
+    (options, args) = parser.parse_args()
+    if len(args) != 1:
+        parser.error("no rules file given")
+
+    try:
+        zones = read_rules(args[0])
+    except ValueError as e:
+        sys.exit("%s: %s" % (args[0], e))
+    if options.tzdata:
+        with open(options.tzdata, "w") as f:
+            f.write(generate_reference(tzdata_reference(zones)))
+        sys.exit(0)
+    with open(options.output, "w") as f:
+        f.write(generate_header(zones))
@@ -157,6 +157,37 @@ class ELFProgramHeader:
             self.p_filesz, self.p_memsz, self.p_flags,
             self.p_align)
 
+class ELFSymbol:
+    """read and store a symbol table entry"""
+    Elf32_Sym = "<IIIBBH"               #entry format
+
+    #symbol types, low nibble of st_info
+    STT_NOTYPE      = 0
+    STT_OBJECT      = 1
+    STT_FUNC        = 2
+    STT_SECTION     = 3
+    STT_FILE        = 4
+
+    def __init__(self):
+        """create a new empty symbol"""
+        (self.st_name, self.st_value, self.st_size, self.st_info,
+         self.st_other, self.st_shndx) = [0]*6
+        self.name = None
+
+    def fromString(self, s):
+        """get symbol from string"""
+        (self.st_name, self.st_value, self.st_size, self.st_info,
+         self.st_other, self.st_shndx) = struct.unpack(self.Elf32_Sym, s)
+
+    def getType(self):
+        return self.st_info & 0xf
+
+    def __str__(self):
+        """pretty print for debug..."""
+        return "%s(%r, st_value=0x%04x, st_size=%s, st_info=%s, st_shndx=%s)" % (
+            self.__class__.__name__, self.name,
+            self.st_value, self.st_size, self.st_info, self.st_shndx)
+
 class ELFObject:
     """Object to read and handle an LEF object file"""
     #header information
@@ -294,6 +325,21 @@ class ELFObject:
                 res.append(section)
         return res
 
+    def getSymbols(self):
+        """get the entries of the symbol tables, with their names"""
+        res = []
+        size = struct.calcsize(ELFSymbol.Elf32_Sym)
+        for section in self.sections:
+            if section.sh_type != ELFSection.SHT_SYMTAB:
+                continue
+            strtab = self.sections[section.sh_link].data
+            for offset in range(0, len(section.data) - size + 1, size):
+                symbol = ELFSymbol()
+                symbol.fromString(section.data[offset:offset + size])
+                symbol.name = strtab[symbol.st_name:].split('\0')[0]
+                res.append(symbol)
+        return res
+
     def __str__(self):
         """pretty print for debug..."""
         return "%s(self.e_type=%r, self.e_machine=%r, self.e_version=%r, sections=%r)" % (
@@ -0,0 +1,694 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+"""
+Predicts the charge the firmware draws from the battery over a day, per
+module, to compare firmware configurations before flashing them.
+
+The message bus, RTC, protothread, battery, ADC12, buzzer and low power
+mode code of the firmware is built for the host with tools/hostcc.py and
+run through a simulated day. The drivers report when they switch
+peripherals on and off, which low power mode the main loop sleeps in and,
+with CONFIG_GOVERNOR, the MCLK of drivers/governor, through the hooks of
+energy.h. Cycles and sleep are charged at the current of the level they
+ran at. Modules are stand-ins described in
+tools/energy.cfg: their cost per call, registered on the real message bus.
+The time in each state is then multiplied by the currents of energy.cfg.
+
+With -p the day is run once per pressure sensor mode of [ps modes], the
+modules switching on the sensor with the conversion time of that mode, and
+the cost of each mode is tabulated. With -g it is run with MCLK fixed at
+12MHz and core voltage level 3, as boot.c leaves them, and with
+CONFIG_GOVERNOR, and the two are compared per owner.
+"""
+
+from __future__ import print_function
+
+import copy
+import json
+import os
+import sys
+
+try:
+    import configparser
+except ImportError:
+    import ConfigParser as configparser
+
+import hostcc
+
+sys.path.insert(0, os.path.join(hostcc.ROOT, "contrib"))
+import rtttl2bin
+
+# enum energy_sink
+SINKS = ["adc12", "ref", "buzzer", "as", "ps", "radio"]
+
+MESSAGES = {
+    "second": "SYS_MSG_RTC_SECOND",
+    "minute": "SYS_MSG_RTC_MINUTE",
+    "hour": "SYS_MSG_RTC_HOUR",
+    "day": "SYS_MSG_RTC_DAY",
+    "batt": "SYS_MSG_BATT",
+    "button": "SYS_MSG_BUTTON",
+}
+
+# the configuration of config.h the host build follows
+HOST_CONFIG = ["CONFIG_RTC_IRQ", "CONFIG_BATTERY_MONITOR", "CONFIG_BATTERY_DISABLE_FILTER",
+               "CONFIG_GOVERNOR"]
+
+SOURCES = ["messagebus.c", "pt.c", "drivers/rtca.c", "drivers/adc12.c",
+           "drivers/battery.c", "drivers/buzzer.c", "drivers/lpm.c", "drivers/governor.c"]
+
+SECONDS = 24 * 3600
+
+# The main loop of openchronos.c over a day, without the menu. The RTC
+# ticks every second, the protothread wakeups and the ADC12 interrupt
+# happen in between, the buzzer interrupt runs while the CPU sleeps.
+# Prints "owner name calls cycles cycles_low active_s lpm0_s asleep_low_s
+# sink_s..." then "day seconds wakeups", the _low counters at
+# GOVERNOR_LOW_MHZ.
+MAIN = """\
+#include <stdio.h>
+#include <stdlib.h>
+#include "messagebus.h"
+#include "pool.h"
+#include "pt.h"
+#include "energy.h"
+#include "drivers/rtca.h"
+#include "drivers/adc12.h"
+#include "drivers/battery.h"
+#include "drivers/buzzer.h"
+#include "drivers/display.h"
+#include "drivers/lpm.h"
+#include "drivers/governor.h"
+#include "tunes.h"
+
+""" + hostcc.RTC_TICK.replace("%", "%%") + """
+
+#define SECONDS %(seconds)d
+#define WAKEUP_CYCLES %(wakeup_cycles)d
+#define BATTERY_CYCLES %(battery_cycles)d
+#define BUZZER_ISR_CYCLES %(buzzer_isr_cycles)d
+#define ADC_CONVERSION_S (%(adc_conversion_ms)f / 1000)
+#define SMCLK_HZ (GOVERNOR_HIGH_MHZ * 1e6)
+
+void ADC12ISR(void);
+void timer1_A0_ISR(void);
+
+struct pool messagebus_pool;
+
+void *pool_alloc(struct pool *pool)
+{
+	return malloc(sizeof(struct sys_messagebus));
+}
+
+void pool_free(struct pool *pool, void *blk)
+{
+	free(blk);
+}
+
+void display_symbol(uint8_t scr_nr, enum display_segment symbol, enum display_segstate state)
+{
+}
+
+void timer0_delay(uint16_t duration, uint16_t LPM_bits)
+{
+}
+
+void SetVCore(unsigned char level)
+{
+}
+
+static uint16_t wake_at;
+static uint8_t armed;
+
+void timer0_wakeup_at(uint16_t at)
+{
+	wake_at = at;
+	armed = 1;
+}
+
+void timer0_wakeup_cancel(void)
+{
+	armed = 0;
+}
+
+struct owner {
+	const char *name;
+	unsigned long calls;
+	double cycles;
+	double cycles_low;
+	double active;
+	double lpm0;
+	double asleep_low;
+	double sink[ENERGY_SINKS];
+};
+
+enum { SYSTEM, BATTERY };
+
+static struct owner owners[] = {
+%(owners)s
+};
+
+struct module {
+	int owner;
+	enum sys_message listens;
+	uint8_t divider;
+	unsigned long from;
+	unsigned long until;
+	double cycles;
+	uint8_t boost;
+	int sink;
+	double on;
+};
+
+static const struct module modules[] = {
+%(modules)s
+};
+
+#define MODULES (sizeof(modules) / sizeof(modules[0]))
+
+struct event {
+	unsigned long at;
+	int owner;
+	const uint8_t *tune;
+};
+
+static const struct event events[] = {
+%(events)s
+};
+
+#define EVENTS (sizeof(events) / sizeof(events[0]))
+
+static const unsigned long buttons = %(buttons)d;
+
+static double now;
+static int owner = SYSTEM;
+static uint16_t lpm = LPM3_bits;
+static uint8_t mclk_mhz = GOVERNOR_HIGH_MHZ;
+static int lpm0_owner = SYSTEM;
+static double since[ENERGY_SINKS];
+static int sink_owner[ENERGY_SINKS];
+static uint8_t sink_on[ENERGY_SINKS];
+static unsigned long wakeups;
+static uint8_t button_pending;
+
+void energy_on(enum energy_sink sink)
+{
+	if (sink_on[sink])
+		return;
+	sink_on[sink] = 1;
+	sink_owner[sink] = owner;
+	since[sink] = now;
+}
+
+void energy_off(enum energy_sink sink)
+{
+	if (!sink_on[sink])
+		return;
+	sink_on[sink] = 0;
+	owners[sink_owner[sink]].sink[sink] += now - since[sink];
+}
+
+void energy_lpm(uint16_t lpm_bits)
+{
+	lpm = lpm_bits;
+	lpm0_owner = sink_on[ENERGY_BUZZER] ? sink_owner[ENERGY_BUZZER] : owner;
+}
+
+void energy_mclk(uint8_t mhz)
+{
+	mclk_mhz = mhz;
+}
+
+/* cycles run by n at the current MCLK, they take no simulated time */
+static void run_cycles(int n, double cycles)
+{
+	owners[n].cycles += cycles;
+	owners[n].active += cycles / (mclk_mhz * 1e6);
+	if (mclk_mhz == GOVERNOR_LOW_MHZ) {
+		owners[n].cycles_low += cycles;
+		owners[SYSTEM].asleep_low -= cycles / (mclk_mhz * 1e6);
+	}
+}
+
+static void run_module(int n)
+{
+	int previous = owner;
+
+	owner = modules[n].owner;
+	owners[owner].calls++;
+	if (modules[n].boost)
+		governor_boost();
+	run_cycles(owner, modules[n].cycles);
+	if (modules[n].boost)
+		governor_release();
+	if (modules[n].sink >= 0)
+		owners[owner].sink[modules[n].sink] += modules[n].on;
+	owner = previous;
+}
+
+%(callbacks)s
+
+/* moves the time forward, the CPU sleeping in the last mode entered */
+static void account(double t)
+{
+	if (lpm == LPM0_bits)
+		owners[lpm0_owner].lpm0 += t - now;
+	if (mclk_mhz == GOVERNOR_LOW_MHZ)
+		owners[SYSTEM].asleep_low += t - now;
+	now = t;
+	TA0R = (uint16_t)(unsigned long long)(now * TIMER0_FREQ + 1e-6);
+}
+
+/* the time the TA1 interrupt of the buzzer is due */
+static double ta1_due;
+
+static void sleep_until(double until)
+{
+	while (is_buzzer_playing() && ta1_due <= until) {
+		account(ta1_due);
+		owner = sink_owner[ENERGY_BUZZER];
+		run_cycles(owner, BUZZER_ISR_CYCLES);
+		timer1_A0_ISR();
+		owner = SYSTEM;
+		ta1_due += (TA1CCR0 + 1) / SMCLK_HZ;
+	}
+	account(until);
+}
+
+static void main_loop_pass(void)
+{
+	struct sys_event *ev;
+	enum sys_message msg;
+
+	wakeups++;
+	run_cycles(SYSTEM, WAKEUP_CYCLES);
+
+	while ((ev = evqueue_peek(&rtca_events))) {
+		msg = ev->ev;
+		evqueue_pop(&rtca_events);
+#ifdef CONFIG_BATTERY_MONITOR
+		if (msg & SYS_MSG_RTC_MINUTE) {
+			pt_start(&battery_task);
+			owners[BATTERY].calls++;
+			run_cycles(BATTERY, BATTERY_CYCLES);
+		}
+#endif
+		send_events(msg);
+	}
+
+	if (button_pending) {
+		button_pending = 0;
+		send_events(SYS_MSG_BUTTON);
+	}
+
+	sys_messagebus_background();
+
+	/* drivers/battery runs the only protothread */
+	owner = BATTERY;
+	pt_run();
+	owner = SYSTEM;
+
+	rtca_set_second_events(sys_messagebus_listens() & SYS_MSG_RTC_SECOND);
+	enter_lpm_gie(LPM3_bits);
+}
+
+/* runs the main loop for the wakeups due before the second ends */
+static void run_second(unsigned long sec)
+{
+	static uint8_t converting;
+	static double converted;
+	double next;
+
+	while (1) {
+		next = sec;
+		if (armed && now + (uint16_t)(wake_at - TA0R) / (double)TIMER0_FREQ < next)
+			next = now + (uint16_t)(wake_at - TA0R) / (double)TIMER0_FREQ;
+		if (converting && converted < next)
+			next = converted;
+		if (next >= sec)
+			break;
+
+		sleep_until(next);
+		if (converting && converted <= now) {
+			/* a fresh 3V cell */
+			converting = 0;
+			ADC12CTL0 &= ~ADC12SC;
+			ADC12MEM0 = 3075;
+			ADC12IV = 6;
+			ADC12ISR();
+		} else {
+			armed = 0;
+		}
+		main_loop_pass();
+
+		if (!converting && (ADC12CTL0 & ADC12SC)) {
+			converting = 1;
+			converted = now + ADC_CONVERSION_S;
+		}
+	}
+	sleep_until(sec);
+}
+
+int main(void)
+{
+	unsigned long sec, woken, i;
+	int s;
+
+	rtca_init();
+	rtca_time.year = 2026;
+	rtca_time.mon = 3;
+	rtca_time.day = 2;
+	rtca_time.hour = 0;
+	rtca_time.min = 0;
+	rtca_time.sec = 0;
+	rtca_set_time();
+	rtca_set_date();
+	battery_init();
+	/* openchronos.c once the first clock frame is shown */
+	governor_init();
+
+	for (i = 0; i < MODULES; i++)
+		if (modules[i].from == 0)
+			sys_messagebus_register_every(callbacks[i], modules[i].listens, modules[i].divider, 0);
+	main_loop_pass();
+
+	for (sec = 1; sec <= SECONDS; sec++) {
+		run_second(sec);
+
+		/* (de)activated by the user just before the second */
+		woken = 0;
+		for (i = 0; i < MODULES; i++) {
+			if (modules[i].from == sec) {
+				sys_messagebus_register_every(callbacks[i], modules[i].listens, modules[i].divider, 0);
+				woken = 1;
+			}
+			if (modules[i].until == sec) {
+				sys_messagebus_unregister_all(callbacks[i]);
+				woken = 1;
+			}
+		}
+		if (woken)
+			main_loop_pass();
+
+		woken = rtc_wakeups;
+		rtc_tick();
+
+		for (i = 0; i < EVENTS; i++) {
+			if (events[i].at != sec)
+				continue;
+			owner = events[i].owner;
+			buzzer_play(events[i].tune);
+			owner = SYSTEM;
+			ta1_due = now + (TA1CCR0 + 1) / SMCLK_HZ;
+			woken = 0;
+		}
+
+		if (buttons && sec %% (SECONDS / buttons) == 0) {
+			button_pending = 1;
+			woken = 0;
+		}
+
+		if (woken != rtc_wakeups)
+			main_loop_pass();
+	}
+
+	for (s = 0; s < ENERGY_SINKS; s++)
+		energy_off(s);
+
+	for (i = 0; i < sizeof(owners) / sizeof(owners[0]); i++) {
+		printf("owner %%s %%lu %%.0f %%.0f %%.9f %%.6f %%.6f", owners[i].name, owners[i].calls,
+		       owners[i].cycles, owners[i].cycles_low, owners[i].active, owners[i].lpm0,
+		       owners[i].asleep_low);
+		for (s = 0; s < ENERGY_SINKS; s++)
+			printf(" %%.6f", owners[i].sink[s]);
+		printf("\\n");
+	}
+	printf("day %%.0f %%lu\\n", now, wakeups);
+
+	return 0;
+}
+"""
+
+
+def read_config_h(filename):
+    """the CONFIG_ names defined by config.h"""
+    defined = set()
+    for line in open(filename):
+        fields = line.split()
+        if len(fields) >= 2 and fields[0] == "#define":
+            defined.add(fields[1])
+    return defined
+
+
+def hhmm(text):
+    hour, minute = [int(v) for v in text.split(":")]
+    return hour * 3600 + minute * 60
+
+
+class Model:
+    """energy.cfg, the sections whose 'config' config.h lacks left out"""
+    def __init__(self, filename, defined=None):
+        cfg = configparser.RawConfigParser()
+        cfg.read(filename)
+
+        def enabled(section):
+            return defined is None or not cfg.has_option(section, "config") \
+                or cfg.get(section, "config") in defined
+
+        self.currents = dict((k, float(v)) for k, v in cfg.items("currents"))
+        self.always_on = [(k, float(v)) for k, v in cfg.items("always_on")]
+        self.firmware = dict((k, float(v)) for k, v in cfg.items("firmware"))
+        self.modules = []
+        self.events = []
+        self.ps_modes = []
+        self.buttons = 0
+        if cfg.has_section("ps modes"):
+            self.ps_modes = [(k, float(v)) for k, v in cfg.items("ps modes")]
+        if cfg.has_section("buttons"):
+            self.buttons = cfg.getint("buttons", "per_day")
+        for section in cfg.sections():
+            if not enabled(section):
+                continue
+            if section.startswith("module "):
+                get = lambda key, default=None: cfg.get(section, key) \
+                    if cfg.has_option(section, key) else default
+                self.modules.append({
+                    "name": section[7:].strip(),
+                    "listens": [MESSAGES[m.strip()] for m in get("listens").split(",")],
+                    "divider": int(get("divider", 1)),
+                    "from": hhmm(get("from", "0:00")),
+                    "until": hhmm(get("until", "24:00")),
+                    "cycles": float(get("cycles", 0)),
+                    "boost": get("boost", "no") == "yes",
+                    "sink": get("sink"),
+                    "on_ms": float(get("on_ms", 0)),
+                })
+            elif section.startswith("event "):
+                self.events.append({
+                    "at": hhmm(cfg.get(section, "at")),
+                    "tune": cfg.get(section, "tune"),
+                    "owner": cfg.get(section, "owner"),
+                })
+        self.host_config = [c for c in HOST_CONFIG if defined is None or c in defined]
+
+
+def tunes():
+    """{rtttl file name: parsed tune} of tunes/"""
+    d = os.path.join(hostcc.ROOT, "tunes")
+    tunes = {}
+    for f in sorted(os.listdir(d)):
+        if f.endswith(".rtttl"):
+            with open(os.path.join(d, f)) as rtttl:
+                tunes[f[:-6]] = rtttl2bin.parse_tune(rtttl.read())
+    return tunes
+
+
+def simulate(model, seconds=SECONDS):
+    """runs the host build, returns ({owner: counters}, seconds, wakeups)"""
+    owners = ["system", "battery"]
+
+    def owner(name):
+        if name not in owners:
+            owners.append(name)
+        return owners.index(name)
+
+    all_tunes = tunes()
+    modules = []
+    callbacks = []
+    for i, m in enumerate(model.modules):
+        sink = SINKS.index(m["sink"]) if m["sink"] else -1
+        modules.append("\t{ %d, %s, %d, %d, %d, %f, %d, %d, %f }," % (
+            owner(m["name"]), " | ".join(m["listens"]), m["divider"], m["from"], m["until"],
+            m["cycles"], m["boost"], sink, m["on_ms"] / 1000))
+        callbacks.append("static void module%d(enum sys_message msg) { run_module(%d); }" % (i, i))
+    callbacks.append("static void (*const callbacks[])(enum sys_message) = { %s };" %
+                     ", ".join("module%d" % i for i in range(len(model.modules))))
+    events = ["\t{ %d, %d, %s }," % (e["at"], owner(e["owner"]), rtttl2bin.tune_name(all_tunes[e["tune"]]))
+              for e in model.events]
+
+    source, header = rtttl2bin.generate_tune_sources(all_tunes.values())
+    fw = model.firmware
+    main = MAIN % {
+        "seconds": seconds,
+        "wakeup_cycles": fw["wakeup_cycles"],
+        "battery_cycles": fw["battery_cycles"],
+        "buzzer_isr_cycles": fw["buzzer_isr_cycles"],
+        "adc_conversion_ms": fw["adc_conversion_ms"],
+        "owners": "\n".join('\t{ "%s" },' % o for o in owners),
+        "modules": "\n".join(modules),
+        "events": "\n".join(events),
+        "callbacks": "\n".join(callbacks),
+        "buttons": model.buttons,
+    }
+    build = hostcc.HostBuild(main, SOURCES, model.host_config + ["ENERGY_TRACE"],
+                             {"tunes.c": source, "tunes.h": header})
+    try:
+        lines = build.run()
+    finally:
+        build.close()
+
+    result = {}
+    for line in lines[:-1]:
+        fields = line.split()
+        result[fields[1]] = {
+            "calls": int(fields[2]),
+            "cycles": float(fields[3]),
+            "cycles_low": float(fields[4]),
+            "active": float(fields[5]),
+            "lpm0": float(fields[6]),
+            "asleep_low": float(fields[7]),
+            "sinks": dict(zip(SINKS, [float(v) for v in fields[8:]])),
+        }
+    day, seconds, wakeups = lines[-1].split()
+    return result, float(seconds), int(wakeups)
+
+
+def charges(model, result, seconds):
+    """[(name, uAh)] per owner then per always on load"""
+    cur = model.currents
+    # without CONFIG_GOVERNOR nothing runs at the low level
+    active_low = cur.get("active_per_mhz_low", cur["active_per_mhz"])
+    lpm3_low = cur.get("lpm3_low", cur["lpm3"])
+    active_s = sum(r["active"] for r in result.values())
+    rows = []
+    for name in result:
+        r = result[name]
+        uas = (r["cycles"] - r["cycles_low"]) / 1e6 * cur["active_per_mhz"]
+        uas += r["cycles_low"] / 1e6 * active_low
+        uas += r["lpm0"] * (cur["lpm0"] - cur["lpm3"])
+        uas += sum(r["sinks"][s] * cur[s] for s in SINKS)
+        if name == "system":
+            uas += (seconds - active_s - r["asleep_low"]) * cur["lpm3"]
+            uas += r["asleep_low"] * lpm3_low
+        rows.append((name, uas / 3600))
+    rows.sort(key=lambda row: row[0] != "system")
+    rows += [(name, ua * seconds / 3600) for name, ua in model.always_on]
+    return rows
+
+
+def ps_modes(model):
+    """[(mode, on_ms, uAh/day of the ps modules, uAh/day)] with each of [ps modes]"""
+    res = []
+    for mode, on_ms in model.ps_modes:
+        m = copy.copy(model)
+        m.modules = [dict(mod, on_ms=on_ms) if mod["sink"] == "ps" else mod for mod in model.modules]
+        names = [mod["name"] for mod in m.modules if mod["sink"] == "ps"]
+        result, seconds, wakeups = simulate(m)
+        rows = charges(m, result, seconds)
+        scale = SECONDS / seconds
+        res.append((mode, on_ms, sum(uah for name, uah in rows if name in names) * scale,
+                    sum(uah for name, uah in rows) * scale))
+    return res
+
+
+def governor(model):
+    """[(name, uAh/day at a fixed 12MHz, uAh/day with CONFIG_GOVERNOR)]"""
+    days = []
+    for on in (False, True):
+        m = copy.copy(model)
+        m.host_config = [c for c in model.host_config if c != "CONFIG_GOVERNOR"]
+        if on:
+            m.host_config.append("CONFIG_GOVERNOR")
+        result, seconds, wakeups = simulate(m)
+        scale = SECONDS / seconds
+        days.append([(name, uah * scale) for name, uah in charges(m, result, seconds)])
+    # both days have the same owners, in the same order
+    return [(name, fixed, governed) for (name, fixed), (n, governed) in zip(*days)]
+
+
+def report_governor(rows, out=sys.stdout):
+    out.write("%-16s %10s %10s %10s\n" % ("uAh/day", "12MHz", "governor", "saving"))
+    for name, fixed, governed in rows + [("total", sum(r[1] for r in rows), sum(r[2] for r in rows))]:
+        out.write("%-16s %10.2f %10.2f %9.1f%%\n" %
+                  (name, fixed, governed, 100 * (fixed - governed) / fixed if fixed else 0))
+
+
+def report_ps_modes(modes, capacity_mah, out=sys.stdout):
+    out.write("%-16s %6s %10s %10s %6s\n" % ("ps mode", "ms", "ps uAh", "uAh/day", "days"))
+    for mode, on_ms, ps_uah, total in modes:
+        out.write("%-16s %6.1f %10.2f %10.2f %6.0f\n" %
+                  (mode, on_ms, ps_uah, total, capacity_mah * 1000 / total))
+
+
+def report(rows, seconds, wakeups, capacity_mah, previous=None, tolerance=1.0, out=sys.stdout):
+    """prints the charge per day, False if it grew over tolerance percent of previous"""
+    scale = SECONDS / seconds
+    total = sum(uah for name, uah in rows) * scale
+    out.write("%-16s %10s\n" % ("", "uAh/day"))
+    for name, uah in rows:
+        delta = ""
+        if previous and name in previous["rows"]:
+            delta = " %+9.2f" % (uah * scale - previous["rows"][name])
+        out.write("%-16s %10.2f%s\n" % (name, uah * scale, delta))
+    out.write("%-16s %10.2f\n" % ("total", total))
+    out.write("%d wakeups, %.0f days on a %.0fmAh cell\n" %
+              (wakeups * scale, capacity_mah * 1000 / total, capacity_mah))
+    if previous and total > previous["total"] * (1 + tolerance / 100):
+        out.write("ERROR: the day costs %.2fuAh more than the baseline\n" % (total - previous["total"]))
+        return False
+    return True
+
+
+if __name__ == "__main__":
+    from optparse import OptionParser
+    parser = OptionParser(usage="%prog [options]")
+    parser.add_option("-f", "--model", dest="model",
+                      default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "energy.cfg"),
+                      help="currents, costs and day to simulate [default: %default]")
+    parser.add_option("-c", "--config", dest="config",
+                      help="config.h to follow, all of energy.cfg by default")
+    parser.add_option("-b", "--baseline", dest="baseline",
+                      help="report of a previous run to compare with")
+    parser.add_option("-u", "--update", dest="update", action="store_true",
+                      help="write the report to the baseline instead of comparing")
+    parser.add_option("-t", "--tolerance", dest="tolerance", type="float", default=1.0,
+                      help="allowed growth of the day over the baseline in percent [default: %default]")
+    parser.add_option("-p", "--ps-modes", dest="ps_modes", action="store_true",
+                      help="tabulate the day for each pressure sensor mode of [ps modes]")
+    parser.add_option("-g", "--governor", dest="governor", action="store_true",
+                      help="compare the day at a fixed 12MHz with the day under CONFIG_GOVERNOR")
+    (options, args) = parser.parse_args()
+
+    model = Model(options.model, options.config and read_config_h(options.config))
+    if options.ps_modes:
+        report_ps_modes(ps_modes(model), model.firmware["capacity_mah"])
+        sys.exit(0)
+    if options.governor:
+        report_governor(governor(model))
+        sys.exit(0)
+    result, seconds, wakeups = simulate(model)
+    rows = charges(model, result, seconds)
+
+    previous = None
+    if options.baseline and not options.update and os.path.isfile(options.baseline):
+        previous = json.load(open(options.baseline))
+
+    ok = report(rows, seconds, wakeups, model.firmware["capacity_mah"], previous, options.tolerance)
+
+    if options.baseline and options.update:
+        f = open(options.baseline, "w")
+        json.dump({"rows": dict(rows), "total": sum(uah for name, uah in rows)}, f, indent=1, sort_keys=True)
+        f.close()
+
+    if not ok:
+        sys.exit(1)
@@ -0,0 +1,197 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+
+import os
+import shutil
+import tempfile
+import unittest
+import energy
+import rtttl2bin
+
+CURRENTS = """\
+[currents]
+active_per_mhz = 300
+active_per_mhz_low = 200
+lpm3 = 2
+lpm3_low = 1.5
+lpm0 = 100
+adc12 = 150
+ref = 100
+buzzer = 1000
+as = 50
+ps = 500
+radio = 15000
+
+[always_on]
+lcd = 3
+
+[firmware]
+wakeup_cycles = 1000
+battery_cycles = 2000
+buzzer_isr_cycles = 40
+adc_conversion_ms = 0.2
+capacity_mah = 220
+"""
+
+# TIMER0_TICKS_FROM_MS(66), the reference settling sleep of adc12_conversion()
+REF_SETTLE = 1081 / 16384.0
+
+
+class EnergyTests(unittest.TestCase):
+    def setUp(self):
+        self.dir = tempfile.mkdtemp(prefix="energy")
+
+    def tearDown(self):
+        shutil.rmtree(self.dir, ignore_errors=True)
+
+    def model(self, day, config=None):
+        filename = os.path.join(self.dir, "energy.cfg")
+        f = open(filename, "w")
+        f.write(CURRENTS + day)
+        f.close()
+        return energy.Model(filename, config)
+
+    def test_idle_day(self):
+        """Without listeners the CPU only wakes up for the minute events"""
+        model = self.model("", set(["CONFIG_RTC_IRQ"]))
+        result, seconds, wakeups = energy.simulate(model)
+        self.assertEqual(seconds, 86400)
+        self.assertEqual(wakeups, 1 + 1440)
+        rows = dict(energy.charges(model, result, seconds))
+        active_s = wakeups * 1000 / 12e6
+        self.assertAlmostEqual(rows["system"], (wakeups * 1000 / 1e6 * 300 + (86400 - active_s) * 2) / 3600)
+        self.assertAlmostEqual(rows["lcd"], 72)
+        self.assertEqual(rows["battery"], 0)
+
+    def test_battery_monitor(self):
+        """drivers/battery converts once a minute, the reference settles first"""
+        model = self.model("", set(["CONFIG_RTC_IRQ", "CONFIG_BATTERY_MONITOR"]))
+        result, seconds, wakeups = energy.simulate(model)
+        battery = result["battery"]
+        self.assertEqual(battery["calls"], 1440)
+        # the day ends right after the last one started
+        self.assertAlmostEqual(battery["sinks"]["ref"], 1439 * (REF_SETTLE + 0.0002), 3)
+        self.assertAlmostEqual(battery["sinks"]["adc12"], battery["sinks"]["ref"])
+        # the minute, the end of the settling and the ADC12 interrupt
+        self.assertEqual(wakeups, 1 + 1440 + 2 * 1439)
+
+    def test_modules(self):
+        """Module nodes are called by the message bus from 'from' to 'until'"""
+        model = self.model("""\
+[module baro]
+config = CONFIG_MOD_BARO
+listens = second
+divider = 2
+from = 10:00
+until = 10:10
+cycles = 12000
+sink = ps
+on_ms = 10
+
+[module gone]
+config = CONFIG_MOD_GONE
+listens = minute
+cycles = 1
+""", set(["CONFIG_RTC_IRQ", "CONFIG_MOD_BARO"]))
+        result, seconds, wakeups = energy.simulate(model)
+        self.assertNotIn("gone", result)
+        self.assertEqual(result["baro"]["calls"], 300)
+        self.assertEqual(result["baro"]["cycles"], 300 * 12000)
+        self.assertAlmostEqual(result["baro"]["sinks"]["ps"], 3)
+        # second events only while the module listens, and the two
+        # (de)activations
+        self.assertEqual(wakeups, 1 + 1440 + 600 - 10 + 2)
+
+    def test_ps_modes(self):
+        """Each pressure sensor mode costs its conversion time in the modules using it"""
+        model = self.model("""\
+[module baro]
+listens = minute
+cycles = 12000
+sink = ps
+on_ms = 10
+
+[ps modes]
+fast = 10
+fine = 31
+""", set(["CONFIG_RTC_IRQ"]))
+        modes = energy.ps_modes(model)
+        self.assertEqual([m[:2] for m in modes], [("fast", 10), ("fine", 31)])
+        # 500uA for 21ms more, once a minute, the day ends before the last call
+        self.assertAlmostEqual(modes[1][2] - modes[0][2], 1439 * 0.021 * 500 / 3600)
+        self.assertAlmostEqual(modes[1][3] - modes[0][3], modes[1][2] - modes[0][2])
+        self.assertEqual(model.modules[0]["on_ms"], 10)
+
+    def test_tune(self):
+        """A tune keeps the CPU in LPM0 while the buzzer plays, charged to its owner"""
+        model = self.model("""\
+[event alarm]
+at = 07:00
+tune = alarm
+owner = alarm
+""")
+        result, seconds, wakeups = energy.simulate(model)
+        events = rtttl2bin.tune_events(rtttl2bin.encode_tune(energy.tunes()["alarm"]))
+        playing = sum(period * periods for period, duty, periods in events) / 12e6
+        self.assertAlmostEqual(result["alarm"]["sinks"]["buzzer"], playing, 6)
+        self.assertEqual(result["alarm"]["cycles"], 40 * sum(periods for period, duty, periods in events))
+        # until the next wakeup, the minute after
+        self.assertAlmostEqual(result["alarm"]["lpm0"], 60)
+
+    def test_governor(self):
+        """With CONFIG_GOVERNOR the wakeups run and sleep at the low level, boosts at 12MHz"""
+        model = self.model("""\
+[module otp]
+listens = minute
+cycles = 12000
+boost = yes
+""", set(["CONFIG_RTC_IRQ", "CONFIG_GOVERNOR"]))
+        result, seconds, wakeups = energy.simulate(model)
+        system = result["system"]
+        self.assertEqual(system["cycles_low"], system["cycles"])
+        self.assertAlmostEqual(system["active"], wakeups * 1000 / 4e6)
+        self.assertEqual(result["otp"]["cycles_low"], 0)
+        self.assertAlmostEqual(result["otp"]["active"], 1439 * 12000 / 12e6)
+        # the boosts return to the low level, asleep all day but the active time
+        self.assertAlmostEqual(system["asleep_low"], seconds - system["active"], 6)
+        rows = dict(energy.charges(model, result, seconds))
+        self.assertAlmostEqual(rows["system"], (wakeups * 1000 / 1e6 * 200 + system["asleep_low"] * 1.5
+                                                + (seconds - system["asleep_low"] - system["active"]
+                                                   - result["otp"]["active"]) * 2) / 3600)
+        self.assertAlmostEqual(rows["otp"], 1439 * 12000 / 1e6 * 300 / 3600)
+
+    def test_governor_comparison(self):
+        """-g runs the day at a fixed 12MHz and under CONFIG_GOVERNOR, owner by owner"""
+        model = self.model("""\
+[module clock]
+listens = minute
+cycles = 6000
+
+[module otp]
+listens = minute
+cycles = 12000
+boost = yes
+""", set(["CONFIG_RTC_IRQ"]))
+        rows = energy.governor(model)
+        self.assertEqual(sorted(r[0] for r in rows), ["battery", "clock", "lcd", "otp", "system"])
+        rows = dict((name, (fixed, governed)) for name, fixed, governed in rows)
+        # light work runs at the low level, boosted work at 12MHz either way
+        self.assertAlmostEqual(rows["clock"][0], 1439 * 6000 / 1e6 * 300 / 3600)
+        self.assertAlmostEqual(rows["clock"][1], 1439 * 6000 / 1e6 * 200 / 3600)
+        self.assertAlmostEqual(rows["otp"][0], rows["otp"][1])
+        self.assertLess(rows["system"][1], rows["system"][0])
+        self.assertEqual(rows["lcd"], (72.0, 72.0))
+        # the model given is left as it was
+        self.assertEqual(model.host_config, ["CONFIG_RTC_IRQ"])
+
+    def test_baseline(self):
+        """A day costing more than the tolerance over the baseline fails"""
+        rows = [("system", 50.0), ("lcd", 60.0)]
+        out = open(os.devnull, "w")
+        self.assertTrue(energy.report(rows, 86400, 1441, 220, {"rows": {}, "total": 109.5}, 1.0, out))
+        self.assertFalse(energy.report(rows, 86400, 1441, 220, {"rows": {}, "total": 100.0}, 1.0, out))
+        out.close()
+
+
+if __name__ == '__main__':
+    unittest.main()
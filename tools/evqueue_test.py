@@ -0,0 +1,72 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+
+import unittest
+import hostcc
+
+# Host test program for evqueue.h, "put ev" queues an event, "pop" prints
+# "seq ev data" of the oldest event or "empty", "full" when a put failed.
+# The sequence starts at 65530 to cross the wrap. The last line is "dropped n".
+MAIN = """\
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "evqueue.h"
+
+EVQUEUE_DEFINE(q, 4);
+uint16_t evqueue_seq = 65530;
+
+int main(int argc, char **argv)
+{
+	struct sys_event *ev;
+	int n;
+
+	for (n = 1; n < argc; n++) {
+		if (strncmp(argv[n], "put", 3) == 0) {
+			if (!evqueue_put(&q, atoi(argv[n] + 3), n * 10))
+				printf("full\\n");
+		} else if ((ev = evqueue_peek(&q))) {
+			printf("%u %u %u\\n", ev->seq, ev->ev, ev->data);
+			evqueue_pop(&q);
+		} else {
+			printf("empty\\n");
+		}
+	}
+	printf("dropped %u\\n", q.dropped);
+
+	return 0;
+}
+"""
+
+
+@unittest.skipIf(hostcc.compiler() is None, "no host C compiler")
+class EvqueueTests(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.build = hostcc.HostBuild(MAIN, [])
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.build.close()
+
+    def test_order(self):
+        """Events come out in the order they were queued, numbered, with their payload"""
+        lines = self.build.run("put1", "put2", "pop", "put3", "pop", "pop", "pop")
+        self.assertEqual(lines, ["65530 1 10", "65531 2 20", "65532 3 40", "empty", "dropped 0"])
+
+    def test_wrap(self):
+        """The ring keeps working past the end of its storage"""
+        steps = []
+        for i in range(10):
+            steps += ["put%u" % i, "pop"]
+        lines = self.build.run(*steps)
+        self.assertEqual(lines[:-1], ["%u %u %u" % ((65530 + i) % 65536, i, 20 * i + 10) for i in range(10)])
+
+    def test_overflow(self):
+        """A full queue keeps its events, tells the producer and counts the new ones as dropped"""
+        lines = self.build.run(*(["put%u" % i for i in range(6)] + ["pop"] * 4))
+        self.assertEqual(lines, ["full"] * 3 + ["65530 0 10", "65531 1 20", "65532 2 30", "empty", "dropped 3"])
+
+
+if __name__ == '__main__':
+    unittest.main()
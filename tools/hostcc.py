@@ -0,0 +1,258 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+"""
+Builds firmware sources for the host, so their logic can be unit tested
+against a reference without a watch.
+
+The MSP430 registers become plain variables declared by a stub msp430.h and
+defined in a generated registers.c. Interrupt handlers turn into ordinary
+functions that the test program calls after setting up the registers, the
+interrupt vector register (RTCIV, ...) included.
+"""
+
+import os
+import shutil
+import subprocess
+import tempfile
+
+try:
+    from shutil import which
+except ImportError:
+    from distutils.spawn import find_executable as which
+
+# (type, name) of the registers the host tested drivers touch
+REGISTERS = [
+    ("uint16_t", "RTCCTL01"), ("uint16_t", "RTCIV"),
+    ("uint8_t", "RTCSEC"), ("uint8_t", "RTCMIN"), ("uint8_t", "RTCHOUR"),
+    ("uint8_t", "RTCDAY"), ("uint8_t", "RTCDOW"), ("uint8_t", "RTCMON"),
+    ("uint8_t", "RTCYEARL"), ("uint8_t", "RTCYEARH"),
+    ("uint8_t", "RTCAMIN"), ("uint8_t", "RTCAHOUR"), ("uint8_t", "RTCADOW"), ("uint8_t", "RTCADAY"),
+    ("uint8_t", "RTCPS0"), ("uint8_t", "RTCPS1"),
+    ("uint16_t", "TA0R"),
+    ("uint16_t", "REFCTL0"), ("uint16_t", "ADC12CTL0"), ("uint16_t", "ADC12CTL1"),
+    ("uint8_t", "ADC12MCTL0"), ("uint16_t", "ADC12IE"), ("uint16_t", "ADC12IV"), ("uint16_t", "ADC12MEM0"),
+    ("uint16_t", "TA1CTL"), ("uint16_t", "TA1CCTL0"), ("uint16_t", "TA1CCTL1"),
+    ("uint16_t", "TA1CCR0"), ("uint16_t", "TA1CCR1"),
+    ("uint8_t", "P2OUT"), ("uint8_t", "P2SEL"),
+    ("uint8_t", "P2IN"), ("uint8_t", "P2DIR"), ("uint8_t", "P2REN"), ("uint8_t", "P2IE"),
+    ("uint8_t", "P2IES"), ("uint8_t", "P2IFG"), ("uint16_t", "P2IV"),
+    ("uint8_t", "PJIN"), ("uint8_t", "PJOUT"), ("uint8_t", "PJDIR"), ("uint8_t", "PJREN"),
+    ("uint16_t", "TA0CTL"), ("uint16_t", "TA0IV"),
+    ("uint16_t", "TA0CCTL0"), ("uint16_t", "TA0CCTL1"), ("uint16_t", "TA0CCTL2"),
+    ("uint16_t", "TA0CCTL3"), ("uint16_t", "TA0CCTL4"),
+    ("uint16_t", "TA0CCR0"), ("uint16_t", "TA0CCR1"), ("uint16_t", "TA0CCR2"),
+    ("uint16_t", "TA0CCR3"), ("uint16_t", "TA0CCR4"),
+    ("uint16_t", "UCSCTL0"), ("uint16_t", "UCSCTL2"),
+]
+
+STUB_MSP430_H = """\
+/* host stub generated by tools/hostcc.py */
+#include <stdint.h>
+
+%(registers)s
+
+/* the low power bits interrupt handlers cleared, to leave the sleep */
+extern volatile uint16_t host_lpm_exit;
+
+#define interrupt(vector) used
+#define _BIC_SR_IRQ(bits) (host_lpm_exit |= (bits))
+#define _BIS_SR(bits)
+#define _BIC_SR(bits)
+#define __no_operation()
+#define __get_SR_register() 0
+#define __disable_interrupt()
+#define __enable_interrupt()
+#define __set_interrupt_state(x)
+
+/* defined by the test programs of bit-banging drivers, which delay after each edge */
+void __delay_cycles(unsigned long cycles);
+
+#define LPM0_bits 0x0010
+#define LPM3_bits 0x00d0
+
+#define BIT0 0x0001
+#define BIT1 0x0002
+#define BIT2 0x0004
+#define BIT3 0x0008
+#define BIT4 0x0010
+#define BIT5 0x0020
+#define BIT6 0x0040
+#define BIT7 0x0080
+#define BIT8 0x0100
+#define BIT9 0x0200
+#define BITA 0x0400
+#define BITB 0x0800
+#define BITC 0x1000
+#define BITD 0x2000
+#define BITE 0x4000
+#define BITF 0x8000
+
+#define RTC_A_VECTOR 41
+#define RTCMODE 0x2000
+#define RTCHOLD 0x4000
+#define RTCTEVIE 0x0040
+#define RTCAIE 0x0020
+#define RTCRDYIE 0x0010
+#define RTCAE 0x80
+#define RTCIV_RTCRDYIFG 0x0002
+#define RTCIV_RTCTEVIFG 0x0004
+#define RTCIV_RTCAIFG 0x0006
+
+#define ADC12_VECTOR 46
+#define __even_in_range(x, y) (x)
+#define REFMSTR 0x0080
+#define REFVSEL_1 0x0010
+#define REFON 0x0001
+#define ADC12SHT0_10 0x0a00
+#define ADC12ON 0x0010
+#define ADC12ENC 0x0002
+#define ADC12SC 0x0001
+#define ADC12SHP 0x0200
+#define ADC12SREF_1 0x0010
+#define ADC12INCH_11 0x000b
+
+#define PORT2_VECTOR 42
+#define TIMER0_A0_VECTOR 53
+#define TIMER0_A1_VECTOR 52
+#define TASSEL__ACLK 0x0100
+#define ID__2 0x0040
+#define MC__CONTINUOUS 0x0020
+#define TAIE 0x0002
+#define CCIFG 0x0001
+#define TA0IV_TA0CCR1 0x0002
+#define TA0IV_TA0CCR2 0x0004
+#define TA0IV_TA0CCR3 0x0006
+#define TA0IV_TA0CCR4 0x0008
+#define TA0IV_TA0IFG 0x000e
+
+#define TIMER1_A0_VECTOR 49
+#define TACLR 0x0004
+#define TASSEL__SMCLK 0x0200
+#define MC_3 0x0030
+#define MC__STOP 0x0000
+#define MC__UP 0x0010
+#define CCIE 0x0010
+#define OUTMOD_0 0x0000
+#define OUTMOD_7 0x00e0
+
+#define SCG0 0x0040
+#define FLLD_1 0x1000
+"""
+
+RTCA_NOW_H = """\
+#define COMPILE_YEAR 2000
+#define COMPILE_MON 1
+#define COMPILE_DAY 1
+#define COMPILE_DOW 6
+#define COMPILE_HOUR 0
+#define COMPILE_MIN 0
+"""
+
+# Emulates one second of the RTC_A calendar registers (rtc_step), then calls
+# the ISR the way the hardware does for the enabled interrupts (rtc_tick).
+# Independent of drivers/rtca.c on purpose.
+RTC_TICK = """\
+void RTC_A_ISR(void);
+
+/* defined by openchronos.c, drivers/rtca.c numbers its events with it */
+uint16_t evqueue_seq;
+
+/* interrupts raised, only the enabled ones are */
+static unsigned long rtc_wakeups;
+
+static void rtc_step(void)
+{
+	static const uint8_t dim[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+	unsigned year = RTCYEARL | (RTCYEARH << 8);
+	unsigned days = dim[RTCMON - 1] + (RTCMON == 2 && year % 4 == 0
+					   && (year % 100 != 0 || year % 400 == 0));
+
+	if (++RTCSEC == 60) {
+		RTCSEC = 0;
+		if (++RTCMIN == 60) {
+			RTCMIN = 0;
+			if (++RTCHOUR == 24) {
+				RTCHOUR = 0;
+				RTCDOW = (RTCDOW + 1) % 7;
+				if (++RTCDAY > days) {
+					RTCDAY = 1;
+					if (++RTCMON > 12) {
+						RTCMON = 1;
+						year++;
+						RTCYEARL = year & 0xff;
+						RTCYEARH = year >> 8;
+					}
+				}
+			}
+		}
+	}
+}
+
+static void rtc_tick(void)
+{
+	rtc_step();
+
+	if (RTCCTL01 & RTCRDYIE) {
+		RTCIV = RTCIV_RTCRDYIFG;
+		RTC_A_ISR();
+		rtc_wakeups++;
+	}
+	if (RTCSEC == 0 && (RTCCTL01 & RTCTEVIE)) {
+		RTCIV = RTCIV_RTCTEVIFG;
+		RTC_A_ISR();
+		rtc_wakeups++;
+	}
+}
+"""
+
+ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
+
+
+def compiler():
+    """host C compiler, None if there is none"""
+    for cc in (os.environ.get("HOSTCC"), "gcc", "cc", "clang"):
+        if cc and which(cc):
+            return cc
+    return None
+
+
+class HostBuild:
+    """
+        Compiles main (the test program source) with the given firmware
+        sources, relative to the repository root. 'config' lists the
+        CONFIG_ defines written to the stub config.h, 'files' maps the names
+        of extra headers and sources to their contents, the sources are
+        compiled too.
+    """
+    def __init__(self, main, sources, config=(), files={}):
+        self.dir = tempfile.mkdtemp(prefix="hostcc")
+        self.exe = os.path.join(self.dir, "test")
+        self._write("msp430.h", STUB_MSP430_H % {"registers": "\n".join(
+            "extern volatile %s %s;" % r for r in REGISTERS)})
+        self._write("registers.c", "#include <msp430.h>\n" + "".join(
+            "volatile %s %s;\n" % r for r in REGISTERS + [("uint16_t", "host_lpm_exit")]))
+        self._write("config.h", "".join("#define %s\n" % c for c in config))
+        self._write("rtca_now.h", RTCA_NOW_H)
+        self._write("main.c", main)
+        for name, contents in files.items():
+            self._write(name, contents)
+
+        cmd = [compiler(), "-std=gnu99", "-fcommon", "-Wall", "-Wno-unused",
+               "-I" + self.dir, "-I" + ROOT, "-I" + os.path.join(ROOT, "drivers"),
+               "-o", self.exe, os.path.join(self.dir, "main.c"), os.path.join(self.dir, "registers.c")]
+        cmd += [os.path.join(self.dir, name) for name in sorted(files) if name.endswith(".c")]
+        cmd += [os.path.join(ROOT, s) for s in sources]
+        subprocess.check_call(cmd)
+
+    def _write(self, name, contents):
+        f = open(os.path.join(self.dir, name), "w")
+        f.write(contents)
+        f.close()
+
+    def run(self, *args):
+        """runs the test program, returns its output lines"""
+        out = subprocess.check_output([self.exe] + list(args))
+        return out.decode().splitlines()
+
+    def close(self):
+        shutil.rmtree(self.dir, ignore_errors=True)
@@ -0,0 +1,263 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+"""
+Delta images for the wireless bootloader (contrib/ChronosTool.py rfbsl).
+
+The new firmware is compared section by section with the image that was
+flashed last; only the flash segments whose contents changed are sent again.
+A segment is always rewritten as a whole because flash can only be erased
+per segment: the bootloader must erase a segment the first time it is
+written during a session and leave untouched segments alone.
+
+SimulatedBSL replays the bursts exactly as ChronosTool sends them, so a
+delta can be checked byte by byte before a watch is involved.
+"""
+
+import sys
+import elf
+import memory
+
+MAIN_FLASH_START = 0x8000
+MAIN_SEGMENT_SIZE = 512
+INFO_SEGMENT_SIZE = 128
+
+# WBSL burst: type and length byte in front of the data
+BURST_HEADER = 2
+# Radio framing around every burst: preamble, sync word, length and CRC
+RF_PACKET_OVERHEAD = 11
+# Gaps shorter than the cost of starting a new chunk are sent as filler
+CHUNK_OVERHEAD = 2 + BURST_HEADER + RF_PACKET_OVERHEAD
+
+
+class Section:
+    """named block of memory contents at its load address"""
+    def __init__(self, name, address, data):
+        self.name = name
+        self.address = address
+        self.data = bytearray(data)
+
+    def __repr__(self):
+        return "Section(%r, address=0x%04x, %d bytes)" % (self.name, self.address, len(self.data))
+
+
+def load_sections(filename):
+    """read the loadable sections of an ELF file, or the blocks of a TI-Text/Intel-Hex file"""
+    fileobj = open(filename, "rb")
+    try:
+        if fileobj.read(4) == b"\x7fELF":
+            fileobj.seek(0)
+            obj = elf.ELFObject()
+            obj.fromFile(fileobj)
+            return [Section(s.name, s.lma, s.data) for s in obj.getSections() if len(s.data)]
+    finally:
+        fileobj.close()
+    mem = memory.Memory(filename)
+    return [Section("@%04x" % s.startaddress, s.startaddress, s.data) for s in mem.segments]
+
+
+def segment_of(address):
+    """start address and size of the flash segment holding address"""
+    if address >= MAIN_FLASH_START:
+        size = MAIN_SEGMENT_SIZE
+    else:
+        size = INFO_SEGMENT_SIZE
+    return address - address % size, size
+
+
+def flatten(sections):
+    mem = {}
+    for s in sections:
+        for i, b in enumerate(s.data):
+            mem[s.address + i] = b
+    return mem
+
+
+def _segments_covered(section):
+    res = set()
+    address = section.address
+    end = section.address + len(section.data)
+    while address < end:
+        start, size = segment_of(address)
+        res.add(start)
+        address = start + size
+    return res
+
+
+def changed_sections(old, new):
+    """names of the sections that were added, removed, moved or modified"""
+    oldmap = dict((s.name, s) for s in old)
+    newnames = set(s.name for s in new)
+    res = []
+    for s in new:
+        o = oldmap.get(s.name)
+        if o is None or o.address != s.address or o.data != s.data:
+            res.append(s.name)
+    res += [s.name for s in old if s.name not in newnames]
+    return res
+
+
+def dirty_segments(old, new):
+    """sorted start addresses of the flash segments whose contents differ"""
+    changed = set(changed_sections(old, new))
+    candidates = set()
+    for s in list(old) + list(new):
+        if s.name in changed:
+            candidates |= _segments_covered(s)
+
+    oldmem = flatten(old)
+    newmem = flatten(new)
+    dirty = []
+    for start in sorted(candidates):
+        size = segment_of(start)[1]
+        for a in range(start, start + size):
+            if oldmem.get(a, 0xff) != newmem.get(a, 0xff):
+                dirty.append(start)
+                break
+    return dirty
+
+
+def _runs(mem, addresses):
+    """(start, end) of the even aligned runs of programmed bytes among addresses"""
+    runs = []
+    for a in addresses:
+        if mem.get(a, 0xff) == 0xff:
+            continue
+        a -= a % 2
+        if runs and a <= runs[-1][1]:
+            runs[-1][1] = max(runs[-1][1], a + 2)
+        else:
+            runs.append([a, a + 2])
+    return runs
+
+
+def _chunks(mem, runs):
+    return [(start, bytearray(mem.get(a, 0xff) for a in range(start, end))) for start, end in runs]
+
+
+def full_chunks(new):
+    """(address, data) chunks for the whole image, contiguous sections joined"""
+    runs = []
+    for s in sorted(new, key=lambda s: s.address):
+        end = s.address + len(s.data)
+        if runs and s.address == runs[-1][1]:
+            runs[-1][1] = end
+        else:
+            runs.append([s.address, end])
+    return _chunks(flatten(new), runs)
+
+
+def delta_chunks(old, new):
+    """(address, data) chunks rewriting only the dirty segments of new"""
+    newmem = flatten(new)
+    dirty = dirty_segments(old, new)
+    dirtyset = set(dirty)
+    runs = []
+    for start in dirty:
+        size = segment_of(start)[1]
+        segruns = _runs(newmem, range(start, start + size))
+        if not segruns:
+            # segment became empty: a single erased word still makes the bootloader erase it
+            segruns = [[start, start + 2]]
+        for run in segruns:
+            if runs:
+                gap_start = runs[-1][1]
+                gap_fits = run[0] - gap_start <= CHUNK_OVERHEAD
+                gap_dirty = all(segment_of(a)[0] in dirtyset for a in range(gap_start, run[0]))
+                if gap_fits and gap_dirty:
+                    runs[-1][1] = run[1]
+                    continue
+            runs.append(run)
+    return _chunks(newmem, runs)
+
+
+def tobursts(chunks, max_burst_len):
+    """split chunks into (type, data) bursts like CBMchunk.tobursts in ChronosTool"""
+    bursts = []
+    for address, data in chunks:
+        chunk = bytearray([address >> 8, address & 0xff]) + data
+        burst_id = 0x01
+        while chunk:
+            bursts.append((burst_id, chunk[:max_burst_len]))
+            chunk = chunk[max_burst_len:]
+            burst_id = 0x02
+    return bursts
+
+
+def bytes_on_air(bursts):
+    """estimated radio bytes for a list of bursts, including the size header burst"""
+    total = BURST_HEADER + 2 + RF_PACKET_OVERHEAD
+    for burst_id, data in bursts:
+        total += BURST_HEADER + len(data) + RF_PACKET_OVERHEAD
+    return total
+
+
+class SimulatedBSL:
+    """
+        Models the flash behaviour behind the wireless bootloader.
+        erase='segment': a segment is erased the first time it is written.
+        erase='mass': the whole main flash is erased when the session starts.
+        Programming can only clear bits, as on the real flash.
+    """
+    def __init__(self, sections=[], erase="segment"):
+        self.flash = flatten(sections)
+        self.erase = erase
+        self.erased = set()
+        self.address = None
+        if erase == "mass":
+            for a in [a for a in self.flash if a >= MAIN_FLASH_START]:
+                del self.flash[a]
+
+    def burst(self, burst_id, data):
+        data = bytearray(data)
+        if burst_id == 0x01:
+            self.address = (data[0] << 8) | data[1]
+            data = data[2:]
+        for b in data:
+            self._program(self.address, b)
+            self.address += 1
+
+    def _program(self, address, value):
+        start, size = segment_of(address)
+        if self.erase == "segment" and start not in self.erased:
+            for a in range(start, start + size):
+                self.flash.pop(a, None)
+            self.erased.add(start)
+        self.flash[address] = self.flash.get(address, 0xff) & value
+
+    def mismatches(self, sections):
+        """addresses whose contents differ from the given image"""
+        expected = flatten(sections)
+        res = []
+        for a in sorted(set(expected) | set(self.flash)):
+            if self.flash.get(a, 0xff) != expected.get(a, 0xff):
+                res.append(a)
+        return res
+
+
+if __name__ == "__main__":
+    from optparse import OptionParser
+    parser = OptionParser(usage="%prog [options] <last flashed image> <new image>")
+    parser.add_option("-m", "--maxpayload", dest="maxpayload", type="int", default=0xf7,
+                      help="burst length reported by wbsl_getmaxpayload")
+    (options, args) = parser.parse_args()
+    if len(args) != 2:
+        parser.error("two images are required")
+
+    old = load_sections(args[0])
+    new = load_sections(args[1])
+    full = tobursts(full_chunks(new), options.maxpayload)
+    delta = tobursts(delta_chunks(old, new), options.maxpayload)
+
+    bsl = SimulatedBSL(old)
+    for burst in delta:
+        bsl.burst(*burst)
+    errors = bsl.mismatches(new)
+
+    print "changed sections: %s" % ", ".join(changed_sections(old, new))
+    print "dirty segments:   %s" % ", ".join("0x%04x" % a for a in dirty_segments(old, new))
+    print "full image:       %6d bytes on air, %d bursts" % (bytes_on_air(full), len(full))
+    print "delta image:      %6d bytes on air, %d bursts" % (bytes_on_air(delta), len(delta))
+    if errors:
+        print "verification FAILED at %d addresses, first 0x%04x" % (len(errors), errors[0])
+        sys.exit(1)
+    print "verification ok"
@@ -0,0 +1,107 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+
+import os
+import struct
+import tempfile
+import unittest
+import imagediff
+from imagediff import Section
+
+
+def write_elf(filename, sections):
+    """write a minimal ELF32 executable holding the given (name, address, data) sections"""
+    names = "\0" + "".join(name + "\0" for name, _, _ in sections) + ".shstrtab\0"
+    body = ""
+    headers = [struct.pack("<IIIIIIIIII", *[0] * 10)]
+    offset = 52
+    nameoff = 1
+    for name, address, data in sections:
+        headers.append(struct.pack("<IIIIIIIIII", nameoff, 1, 0x6, address, offset, len(data), 0, 0, 2, 0))
+        body += data
+        offset += len(data)
+        nameoff += len(name) + 1
+    headers.append(struct.pack("<IIIIIIIIII", nameoff, 3, 0, 0, offset, len(names), 0, 0, 1, 0))
+    body += names
+    shoff = offset + len(names)
+    ehdr = struct.pack("<16sHHIIIIIHHHHHH", "\x7fELF\x01\x01\x01" + "\0" * 9, 2, 105, 1, 0x8000,
+                       0, shoff, 0, 52, 32, 0, 40, len(headers), len(headers) - 1)
+    fp = open(filename, "wb")
+    fp.write(ehdr + body + "".join(headers))
+    fp.close()
+
+
+class ImageDiffTests(unittest.TestCase):
+    def setUp(self):
+        text = bytearray((i * 7) & 0xff for i in range(3000))
+        self.old = [Section(".text", 0x8000, text),
+                    Section(".rodata", 0x8000 + len(text), "hello world\0"),
+                    Section(".vectors", 0xff80, "\x30\x80" * 64)]
+
+    def patched(self, address, data):
+        new = [Section(s.name, s.address, s.data) for s in self.old]
+        new[0].data[address - 0x8000:address - 0x8000 + len(data)] = data
+        return new
+
+    def replay(self, base, chunks, erase="segment"):
+        bsl = imagediff.SimulatedBSL(base, erase)
+        for burst in imagediff.tobursts(chunks, 0xf7):
+            bsl.burst(*burst)
+        return bsl
+
+    def test_identical_images(self):
+        self.assertEqual(imagediff.changed_sections(self.old, self.old), [])
+        self.assertEqual(imagediff.delta_chunks(self.old, self.old), [])
+
+    def test_small_patch_rewrites_one_segment(self):
+        new = self.patched(0x8410, "\x00\x43")
+        self.assertEqual(imagediff.changed_sections(self.old, new), [".text"])
+        self.assertEqual(imagediff.dirty_segments(self.old, new), [0x8400])
+        chunks = imagediff.delta_chunks(self.old, new)
+        self.assertEqual(chunks[0][0], 0x8400)
+        self.assertEqual(self.replay(self.old, chunks).mismatches(new), [])
+
+        full = imagediff.bytes_on_air(imagediff.tobursts(imagediff.full_chunks(new), 0xf7))
+        delta = imagediff.bytes_on_air(imagediff.tobursts(chunks, 0xf7))
+        self.assertLess(delta * 5, full)
+
+    def test_shrinking_section(self):
+        new = [Section(".text", 0x8000, self.old[0].data[:1000]), self.old[2]]
+        chunks = imagediff.delta_chunks(self.old, new)
+        self.assertEqual(self.replay(self.old, chunks).mismatches(new), [])
+
+    def test_moved_section(self):
+        new = self.patched(0x8000, "\xff\xff")
+        new[1] = Section(".rodata", 0x9000, new[1].data)
+        chunks = imagediff.delta_chunks(self.old, new)
+        self.assertEqual(self.replay(self.old, chunks).mismatches(new), [])
+
+    def test_mass_erase_bootloader_needs_full_image(self):
+        """a delta is only valid if the bootloader erases segment by segment"""
+        new = self.patched(0x8410, "\x00\x43")
+        delta = self.replay(self.old, imagediff.delta_chunks(self.old, new), "mass")
+        self.assertNotEqual(delta.mismatches(new), [])
+        full = self.replay(self.old, imagediff.full_chunks(new), "mass")
+        self.assertEqual(full.mismatches(new), [])
+
+    def test_load_elf_and_titext(self):
+        directory = tempfile.mkdtemp()
+        elfname = os.path.join(directory, "openchronos.elf")
+        txtname = os.path.join(directory, "openchronos.txt")
+        write_elf(elfname, [(s.name, s.address, str(s.data)) for s in self.old])
+        sections = imagediff.load_sections(elfname)
+        self.assertEqual([s.name for s in sections], [".text", ".rodata", ".vectors"])
+        self.assertEqual(sections[2].data, self.old[2].data)
+
+        mem = imagediff.memory.Memory()
+        for s in sections:
+            mem.append(imagediff.memory.Segment(s.address, str(s.data)))
+        fp = open(txtname, "w")
+        mem.saveTIText(fp)
+        fp.close()
+        reloaded = imagediff.load_sections(txtname)
+        self.assertEqual(imagediff.flatten(reloaded), imagediff.flatten(self.old))
+
+if __name__ == '__main__':
+    imagediff.memory.DEBUG = 0
+    unittest.main()
@@ -0,0 +1,398 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+"""
+Records and replays interrupt traces, see drivers/irqtrace.h.
+
+A trace is a list of (ticks, source, data) records: the TA0 ticks
+(1/16384 s) since the previous record, what raised the interrupt and one
+byte of data. The firmware built with CONFIG_IRQ_TRACE keeps them in RAM;
+save the struct irqtrace with mspdebug and convert it to text with
+
+    irqtrace.py -o trace.txt trace.bin
+
+The text format has one record per line, '#' starts a comment:
+
+    # ticks  source     data
+    16384    rtc        0x41     # RTCIV / 2 in bits 7-6, RTCSEC in bits 5-0
+    120      p2in       0x10     # P2IN levels
+    0        port2      0x10     # P2IFG, the up button
+    819      timer0_a0  0        # the 20Hz timer of the buttons
+    400      timer0_a1  8        # TA0IV, the delay compare
+    65535    wait       0        # only time passes
+
+'ticks' may exceed 65535 in text traces written by scripts, rtc() below
+packs the RTC data byte.
+
+Replaying builds the drivers behind the main loop for the host: message
+bus, protothreads, RTC, timer and ports, with a main loop mirroring
+openchronos.c and one listener counting every message. Each time the
+firmware goes to sleep, the next record sets up the registers and calls
+its interrupt handler, until a handler leaves the low power mode. The
+same trace therefore gives the same run, and the counts below can be
+compared before and after a change:
+
+    records    records replayed
+    wakeups    main loop passes
+    msg_*      messages sent per type
+    calls      callbacks run by the message bus
+    buttons    button presses the menu got
+    latency    worst ticks from a button edge until the menu got it
+    dropped    events lost by full interrupt queues
+    ticks      length of the trace
+
+With -b the counts are compared against a previous run and the exit status
+is 1 when wakeups, calls, latency or dropped grew or buttons were lost.
+"""
+
+import os
+import sys
+import json
+import struct
+import hostcc
+
+SOURCES = ["wait", "p2in", "rtc", "port2", "timer0_a0", "timer0_a1"]
+
+# sys_message bits, see messagebus.h
+MESSAGES = ["alarm", "second", "minute", "hour", "day", "month", "year",
+            "timer_4s", "timer_20hz", "timer_prog", "as_int", "ps_int", "batt", "button"]
+
+# worse when they grow
+GROWTH = ["wakeups", "calls", "latency", "dropped"]
+
+HOST_SOURCES = ["messagebus.c", "pt.c", "drivers/rtca.c", "drivers/ports.c", "drivers/timer.c"]
+
+# the config.h defaults the drivers above need
+HOST_CONFIG = ["CONFIG_RTC_IRQ", "CONFIG_BUTTONS_LONG_PRESS_TIME 20"]
+
+MAIN = """\
+#include <stdio.h>
+#include <stdlib.h>
+#include "openchronos.h"
+#include "messagebus.h"
+#include "pool.h"
+#include "pt.h"
+#include "drivers/rtca.h"
+#include "drivers/ports.h"
+#include "drivers/timer.h"
+#include "drivers/lpm.h"
+#include "drivers/irqtrace.h"
+
+""" + hostcc.RTC_TICK + """
+
+void PORT2_ISR(void);
+void timer0_A0_ISR(void);
+void timer0_A1_ISR(void);
+
+struct pool messagebus_pool;
+
+void *pool_alloc(struct pool *pool)
+{
+	return malloc(sizeof(struct sys_messagebus));
+}
+
+void pool_free(struct pool *pool, void *blk)
+{
+	free(blk);
+}
+
+void wdt_poll(void)
+{
+}
+
+extern volatile enum ports_buttons ports_down_btns;
+extern volatile enum ports_buttons ports_pressed_btns;
+
+static FILE *trace;
+static unsigned long now, records, wakeups, calls, buttons, latency;
+static unsigned long msgs[16];
+/* time of the button edge the menu has not seen yet */
+static unsigned long pressed_at;
+static uint8_t pressed;
+
+static void finish(void)
+{
+	int i;
+
+	printf("records %lu\\n", records);
+	printf("wakeups %lu\\n", wakeups);
+	for (i = 0; i < 16; i++)
+		if (msgs[i])
+			printf("msg %d %lu\\n", i, msgs[i]);
+	printf("calls %lu\\n", calls);
+	printf("buttons %lu\\n", buttons);
+	printf("latency %lu\\n", latency);
+	printf("dropped %u\\n", rtca_events.dropped + timer0_events.dropped + ports_events.dropped);
+	printf("ticks %lu\\n", now);
+#ifdef CONFIG_IRQ_TRACE
+	/* what the recorder saw of the replay */
+	for (i = 0; i < irqtrace.count; i++)
+		printf("rec %u %u %u\\n", irqtrace.records[i].ticks,
+		       irqtrace.records[i].source, irqtrace.records[i].data);
+#endif
+	exit(0);
+}
+
+/* the next interrupt of the trace, ends the replay after the last one */
+static void replay_next(void)
+{
+	unsigned long ticks;
+	unsigned source, data;
+
+	if (fscanf(trace, "%lu %u %u", &ticks, &source, &data) != 3)
+		finish();
+
+	now += ticks;
+	TA0R += ticks;
+	records++;
+
+	switch (source) {
+	case 1:
+		P2IN = data;
+		break;
+	case 2:
+		/* the calendar moved on while the RTC didn't interrupt */
+		while (RTCSEC != (data & 0x3f))
+			rtc_step();
+		RTCIV = (data >> 6) * 2;
+		RTC_A_ISR();
+		break;
+	case 3:
+		P2IFG = data;
+		if ((data & 0x1f) && !pressed) {
+			pressed = 1;
+			pressed_at = now;
+		}
+		PORT2_ISR();
+		break;
+	case 4:
+		timer0_A0_ISR();
+		break;
+	case 5:
+		TA0IV = data;
+		timer0_A1_ISR();
+		break;
+	}
+}
+
+void enter_lpm_gie(uint16_t LPM_bits)
+{
+	host_lpm_exit = 0;
+	while (!(host_lpm_exit & LPM_bits))
+		replay_next();
+}
+
+static void count(enum sys_message msg)
+{
+	int i;
+
+	calls++;
+	for (i = 0; i < 16; i++)
+		if (msg & (1 << i))
+			msgs[i]++;
+}
+
+/* openchronos.c */
+static const struct {
+	struct evqueue *queue;
+	uint8_t shift;
+} event_sources[] = {
+	{ &rtca_events, 0 },
+	{ &timer0_events, 7 },
+	{ &ports_events, 10 },
+};
+
+#define EVENT_SOURCES (sizeof(event_sources) / sizeof(event_sources[0]))
+
+static void handle_events(void)
+{
+	struct sys_event ev;
+	uint8_t i, oldest;
+	uint16_t seq;
+
+	while (1) {
+		oldest = EVENT_SOURCES;
+		seq = 0;
+		for (i = 0; i < EVENT_SOURCES; i++) {
+			struct sys_event *e = evqueue_peek(event_sources[i].queue);
+			if (e && (oldest == EVENT_SOURCES || (int16_t)(e->seq - seq) < 0)) {
+				seq = e->seq;
+				oldest = i;
+			}
+		}
+		if (oldest == EVENT_SOURCES)
+			break;
+
+		ev = *evqueue_peek(event_sources[oldest].queue);
+		evqueue_pop(event_sources[oldest].queue);
+
+		send_event(&ev, (enum sys_message)ev.ev << event_sources[oldest].shift);
+	}
+
+	if (is_ports_button_pressed())
+		send_events(SYS_MSG_BUTTON);
+}
+
+/* menu.c takes one press per pass and clears the rest */
+static void menu_check_buttons(void)
+{
+	if (ports_down_btns || (ports_pressed_btns & ~0x1f)) {
+		buttons++;
+		if (pressed && now - pressed_at > latency)
+			latency = now - pressed_at;
+		pressed = 0;
+	}
+	ports_buttons_clear();
+}
+
+int main(int argc, char **argv)
+{
+	trace = fopen(argv[1], "r");
+
+	rtca_init();
+	init_buttons();
+	timer0_init();
+	sys_messagebus_register(count, 0xffff);
+
+	while (1) {
+		enter_lpm_gie(LPM3_bits);
+		wakeups++;
+		ports_buttons_poll();
+		handle_events();
+		menu_check_buttons();
+		sys_messagebus_background();
+		pt_run();
+		rtca_set_second_events(sys_messagebus_listens() & SYS_MSG_RTC_SECOND);
+	}
+}
+"""
+
+
+def rtc(sec, iv=2):
+    """data byte of an RTC record, iv being RTCIV (2 second, 4 minute, 6 alarm)"""
+    return (iv // 2) << 6 | sec
+
+
+def read_binary(data):
+    """records of a struct irqtrace saved from the watch, and the dropped count"""
+    count, dropped = struct.unpack_from("<HH", data)
+    records = [struct.unpack_from("<HBB", data, 4 + 4 * i) for i in range(count)]
+    return records, dropped
+
+
+def read_text(lines):
+    records = []
+    for line in lines:
+        fields = line.split("#", 1)[0].split()
+        if not fields:
+            continue
+        if len(fields) < 3 or fields[1] not in SOURCES:
+            raise ValueError("bad trace line: %s" % line.strip())
+        records.append((int(fields[0], 0), SOURCES.index(fields[1]), int(fields[2], 0)))
+    return records
+
+
+def write_text(records, out, dropped=0):
+    if dropped:
+        out.write("# the trace was full, %d interrupts are missing at the end\n" % dropped)
+    out.write("# ticks  source     data\n")
+    for ticks, source, data in records:
+        out.write("%-8d %-10s 0x%02x\n" % (ticks, SOURCES[source], data))
+
+
+def read(filename):
+    """records of a binary or text trace, and the interrupts it dropped"""
+    f = open(filename, "rb")
+    data = f.read()
+    f.close()
+    try:
+        return read_text(data.decode("ascii").splitlines()), 0
+    except (UnicodeDecodeError, ValueError):
+        return read_binary(data)
+
+
+def _run(records, sources, config):
+    build = hostcc.HostBuild(MAIN, sources, config=config)
+    try:
+        filename = os.path.join(build.dir, "trace")
+        f = open(filename, "w")
+        f.write("".join("%d %d %d\n" % r for r in records))
+        f.close()
+        return [line.split() for line in build.run(filename)]
+    finally:
+        build.close()
+
+
+def replay(records, config=HOST_CONFIG):
+    """runs the records through the host build, returns the counts"""
+    counts = {}
+    for fields in _run(records, HOST_SOURCES, config):
+        if fields[0] == "msg":
+            counts["msg_" + MESSAGES[int(fields[1])]] = int(fields[2])
+        else:
+            counts[fields[0]] = int(fields[1])
+    return counts
+
+
+def rerecord(records, config=HOST_CONFIG):
+    """replays with drivers/irqtrace recording, returns what it recorded"""
+    lines = _run(records, HOST_SOURCES + ["drivers/irqtrace.c"],
+                 list(config) + ["CONFIG_IRQ_TRACE", "CONFIG_IRQ_TRACE_RECORDS %d" % (len(records) + 1)])
+    return [tuple(int(v) for v in fields[1:]) for fields in lines if fields[0] == "rec"]
+
+
+def report(counts, previous=None, out=sys.stdout):
+    """prints the counts, False if they got worse than previous"""
+    ok = True
+    for name in sorted(set(counts) | set(previous or {})):
+        line = "%-16s %10d" % (name, counts.get(name, 0))
+        if previous is not None:
+            delta = counts.get(name, 0) - previous.get(name, 0)
+            line += " %+9d" % delta
+            if (name in GROWTH and delta > 0) or (name == "buttons" and delta < 0):
+                line += "  WORSE"
+                ok = False
+        out.write(line + "\n")
+    if not ok:
+        out.write("ERROR: the replay got worse than the baseline\n")
+    return ok
+
+
+if __name__ == "__main__":
+    from optparse import OptionParser
+    parser = OptionParser(usage="%prog [options] trace")
+    parser.add_option("-o", "--output", dest="output",
+                      help="only convert the trace to text")
+    parser.add_option("-c", "--config", dest="config", action="append", default=[],
+                      help="CONFIG_ define of the host build, may be repeated")
+    parser.add_option("-b", "--baseline", dest="baseline",
+                      help="counts of a previous replay to compare with")
+    parser.add_option("-u", "--update", dest="update", action="store_true",
+                      help="write the counts to the baseline instead of comparing")
+    (options, args) = parser.parse_args()
+    if len(args) != 1:
+        parser.error("one trace expected")
+
+    records, dropped = read(args[0])
+
+    if options.output:
+        f = open(options.output, "w")
+        write_text(records, f, dropped)
+        f.close()
+        sys.exit(0)
+
+    config = dict((c.split()[0], c) for c in HOST_CONFIG + options.config)
+    counts = replay(records, sorted(config.values()))
+
+    previous = None
+    if options.baseline and not options.update and os.path.isfile(options.baseline):
+        previous = json.load(open(options.baseline))
+
+    ok = report(counts, previous)
+
+    if options.baseline and options.update:
+        f = open(options.baseline, "w")
+        json.dump(counts, f, indent=1, sort_keys=True)
+        f.close()
+
+    if not ok:
+        sys.exit(1)
@@ -0,0 +1,101 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+
+import os
+import struct
+import unittest
+import hostcc
+import irqtrace
+from irqtrace import rtc
+
+try:
+    from StringIO import StringIO
+except ImportError:
+    from io import StringIO
+
+SECOND = 16384
+# TIMER0_TICKS_FROM_MS(50), the period of the button timer
+TICK_20HZ = 819
+
+WAIT, P2IN, RTC, PORT2, TIMER0_A0, TIMER0_A1 = range(6)
+
+
+def seconds(n, start=1):
+    return [(SECOND, RTC, rtc((start + i) % 60)) for i in range(n)]
+
+
+def press(button=0x10, held=2):
+    """an edge of button, held for some 20Hz periods, as the recorder sees it"""
+    return [(100, P2IN, button), (0, PORT2, button)] + \
+        [(TICK_20HZ, TIMER0_A0, 0)] * held + \
+        [(TICK_20HZ, P2IN, 0), (0, TIMER0_A0, 0)]
+
+
+class TraceFormatTests(unittest.TestCase):
+    def test_binary(self):
+        """A struct irqtrace saved from RAM converts to the text format and back"""
+        records = [(SECOND, RTC, rtc(1)), (100, P2IN, 0x10), (0, PORT2, 0x10), (TICK_20HZ, TIMER0_A0, 0)]
+        data = struct.pack("<HH", len(records), 3) + b"".join(struct.pack("<HBB", *r) for r in records)
+        self.assertEqual(irqtrace.read_binary(data + b"\0" * 16), (records, 3))
+        out = StringIO()
+        irqtrace.write_text(records, out, 3)
+        self.assertEqual(irqtrace.read_text(out.getvalue().splitlines()), records)
+
+    def test_text(self):
+        """Comments and names in the text format"""
+        lines = ["# a script made this", "", "16384 rtc 0x41 # the second", "70000 wait 0"]
+        self.assertEqual(irqtrace.read_text(lines), [(16384, RTC, 0x41), (70000, WAIT, 0)])
+        self.assertRaises(ValueError, irqtrace.read_text, ["12 adc 0"])
+
+
+@unittest.skipIf(hostcc.compiler() is None, "no host C compiler")
+class ReplayTests(unittest.TestCase):
+    def test_seconds(self):
+        """Every RTC record wakes the main loop up once"""
+        counts = irqtrace.replay(seconds(10))
+        self.assertEqual(counts["records"], 10)
+        self.assertEqual(counts["wakeups"], 10)
+        self.assertEqual(counts["msg_second"], 10)
+        self.assertEqual(counts["ticks"], 10 * SECOND)
+
+    def test_minute_after_silence(self):
+        """The calendar follows the RTC records, seconds skipped included"""
+        counts = irqtrace.replay([(58 * SECOND, RTC, rtc(59)), (SECOND, RTC, rtc(0)), (0, RTC, rtc(0, 4))])
+        self.assertEqual(counts["msg_second"], 2)
+        self.assertEqual(counts["msg_minute"], 1)
+
+    def test_button(self):
+        """A short press reaches the menu on the next 20Hz poll"""
+        counts = irqtrace.replay(seconds(1) + press() + seconds(1, 2))
+        self.assertEqual(counts["buttons"], 1)
+        self.assertEqual(counts["latency"], TICK_20HZ)
+        self.assertEqual(counts["msg_button"], 1)
+        self.assertEqual(counts["msg_timer_20hz"], 3)
+
+    def test_overflow_keeps_sleeping(self):
+        """Interrupts that don't leave the low power mode don't wake the main loop"""
+        counts = irqtrace.replay([(65535, WAIT, 0), (1, TIMER0_A1, 0x0e)] + seconds(1))
+        self.assertEqual(counts["wakeups"], 1)
+        self.assertEqual(counts["records"], 3)
+
+    def test_replay_is_deterministic(self):
+        """The same trace gives the same counts, and a lost button fails the comparison"""
+        trace = seconds(3) + press() + seconds(3, 4) + press(0x04, 5)
+        counts = irqtrace.replay(trace)
+        self.assertEqual(irqtrace.replay(trace), counts)
+        self.assertEqual(counts["buttons"], 2)
+        out = open(os.devnull, "w")
+        self.assertTrue(irqtrace.report(counts, dict(counts), out))
+        self.assertFalse(irqtrace.report(dict(counts, buttons=1), counts, out))
+        self.assertFalse(irqtrace.report(dict(counts, wakeups=counts["wakeups"] + 1), counts, out))
+        out.close()
+
+    def test_bit_exact(self):
+        """drivers/irqtrace records the replay of a trace as that same trace"""
+        trace = seconds(2) + press() + [(400, TIMER0_A1, 8), (SECOND, TIMER0_A1, 0x0e)] + \
+            seconds(2, 3) + [(4 * SECOND - 1, TIMER0_A1, 0x0e)] * 13 + [(SECOND, RTC, rtc(0)), (0, RTC, rtc(0, 4))]
+        self.assertEqual(irqtrace.rerecord(trace), trace)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -18,29 +18,109 @@
 # Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 #
 
-import modules
-from config import OpenChronosApp
+import re
+import glob
 
 initcode = "\
 /* This file is autogenerated by tools/make_modinit.py, do not edit! */\n\
 \n\
-void mod_init(void)\n\
-{\n\
+#include \"pool.h\"\n\
+#include \"messagebus.h\"\n\
+#include \"menu.h\"\n\
+#include \"drivers/display.h\"\n\
+\n\
 "
 
-app = OpenChronosApp()
-app.load_config()
-cfg = app.get_config()
-
-f = open('modinit.c', 'w')
-
-f.write(initcode)
-for mod in modules.get_modules():
-    MOD = mod.upper()
-    try:
-        if cfg["CONFIG_MOD_%s" % MOD]["value"]:
-            f.write("    mod_%s_init();\n" % (mod) )
-    except KeyError:
-        pass
-f.write("}\n")
-f.close()
+
+def count_calls(src, fn):
+    return len(re.findall(r"\b%s\s*\(" % fn, src))
+
+
+def bus_nodes(src):
+    """message bus nodes the calls in src can hold, one per registration
+    call, sys_messagebus_register_every() and the like included"""
+    return count_calls(src, r"sys_messagebus_register\w*")
+
+
+def defines(src, symbol):
+    return re.search(r"\b%s\b\s*(\(|=)" % symbol, src) is not None
+
+
+def max_screens(src):
+    nrs = [int(n) for n in re.findall(r"\blcd_screens_create\s*\(\s*(\d+)\s*\)", src)]
+    return max(nrs + [0])
+
+
+if __name__ == "__main__":
+    import modules
+    from config import OpenChronosApp
+
+    app = OpenChronosApp()
+    app.load_config()
+    cfg = app.get_config()
+
+    enabled = []
+    for mod in modules.get_modules():
+        MOD = mod.upper()
+        try:
+            if cfg["CONFIG_MOD_%s" % MOD]["value"]:
+                enabled.append(mod)
+        except KeyError:
+            pass
+
+    # The bus pool gets one node per sys_messagebus_register*() call in the
+    # core and the enabled modules, so every listener fits even when all are
+    # registered at once. messagebus.c only defines those functions.
+    core = [f for f in glob.glob("*.c") + glob.glob("drivers/*.c")
+            if f not in ("messagebus.c", "menu.c", "modinit.c")]
+    srcs = core + ["modules/%s.c" % mod for mod in enabled]
+
+    nodes = 0
+    screens = 0
+    sources = {}
+    for name in srcs:
+        try:
+            src = open(name).read()
+        except IOError:
+            continue
+        sources[name] = src
+        nodes += bus_nodes(src)
+        screens = max(screens, max_screens(src))
+
+    # Modules only need an init function when they do more than showing up in
+    # the menu, which they do by defining mod_<name>_menu.
+    inits = []
+    menus = []
+    for mod in enabled:
+        src = sources.get("modules/%s.c" % mod, "")
+        if defines(src, "void\\s+mod_%s_init" % mod):
+            inits.append(mod)
+        if defines(src, "struct\\s+menu\\s+mod_%s_menu" % mod):
+            menus.append(mod)
+
+    f = open('modinit.c', 'w')
+
+    f.write(initcode)
+    f.write("/* one node per sys_messagebus_register*() call */\n")
+    f.write("POOL_DEFINE(messagebus_pool, \"BUS\", sizeof(struct sys_messagebus), %d);\n" % max(nodes, 1))
+    f.write("POOL_DEFINE(lcd_screen_pool, \"SCRN\", sizeof(struct lcd_screen) * %d, 1);\n" % max(screens, 1))
+    # lcd_screen_activate() copies the old screen out before releasing the buffers
+    # of the new one, so one more buffer pair than virtual screens is needed
+    f.write("POOL_DEFINE(lcd_buffer_pool, \"LCDBF\", LCD_MEM_LEN, %d);\n" % max(2 * screens, 1))
+    f.write("\n")
+    for mod in inits:
+        f.write("void mod_%s_init(void);\n" % mod)
+    for mod in menus:
+        f.write("extern const struct menu mod_%s_menu;\n" % mod)
+    f.write("\nconst struct menu *const menu_table[] = {\n")
+    for mod in menus:
+        f.write("    &mod_%s_menu,\n" % mod)
+    if not menus:
+        f.write("    NULL\n")
+    f.write("};\n")
+    f.write("const uint8_t menu_table_len = %d;\n" % len(menus))
+    f.write("\nvoid mod_init(void)\n{\n")
+    for mod in inits:
+        f.write("    mod_%s_init();\n" % (mod) )
+    f.write("}\n")
+    f.close()
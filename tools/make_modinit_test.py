@@ -0,0 +1,42 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+
+import os
+import unittest
+import make_modinit
+
+ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
+
+SRC = """\
+static void activate(void)
+{
+     sys_messagebus_register(&clock_event, SYS_MSG_RTC_MINUTE);
+     sys_messagebus_register_every (&update, SYS_MSG_RTC_SECOND,
+				    CONFIG_MOD_ALTIMETER_REFRESH, 0);
+}
+
+static void deactivate(void)
+{
+     sys_messagebus_unregister_all(&update);
+     sys_messagebus_unregister(&clock_event);
+}
+"""
+
+
+class ModinitTests(unittest.TestCase):
+    def test_bus_nodes(self):
+        """Every registration variant holds a node, unregistering doesn't"""
+        self.assertEqual(make_modinit.bus_nodes(SRC), 2)
+        self.assertEqual(make_modinit.bus_nodes("sys_messagebus_listens();"), 0)
+
+    def test_modules(self):
+        """The modules registering with a divider are counted"""
+        for mod in ("altimeter", "boil", "crickets", "soundspeed"):
+            src = open(os.path.join(ROOT, "modules", mod + ".c")).read()
+            self.assertEqual(make_modinit.bus_nodes(src), 1, mod)
+        src = open(os.path.join(ROOT, "modules", "alarm.c")).read()
+        self.assertEqual(make_modinit.bus_nodes(src), 2)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,397 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+"""
+Flash/RAM budget report for openchronos.elf.
+
+The sizes of .text, .rodata, .data and .bss are read from the linker map
+(-Wl,-Map=output.map) and charged to the object file that contributed each
+input section, so every module and driver shows what it costs.
+
+When the objects were compiled with -fstack-usage, the frame sizes from the
+.su files are combined with the call graph taken from 'objdump -dr' of each
+object, giving the worst-case stack depth of main(), of every interrupt
+handler and of the callbacks each module lists in its struct menu or hands
+to sys_messagebus_register(). Calls through function pointers can't be
+followed; the menu and message bus callbacks are therefore reported as
+separate roots and added on top of main().
+
+The report is saved and the next run prints what changed. The exit status
+is 1 when the image doesn't fit into the flash or RAM budget.
+"""
+
+import os
+import re
+import sys
+import json
+import subprocess
+
+FLASH_BUDGET = 32768
+RAM_BUDGET = 4096
+
+# return address pushed by a call, PC and SR pushed when entering an interrupt
+CALL_OVERHEAD = 2
+ISR_OVERHEAD = 4
+
+KINDS = ("text", "rodata", "data", "bss")
+
+_output_re = re.compile(r"^(\S+)(?:\s+0x([0-9a-f]+)\s+0x([0-9a-f]+))?")
+_input_re = re.compile(r"^ (\S+)(?:\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*))?$")
+_cont_re = re.compile(r"^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$")
+
+
+def section_kind(name):
+    """text, rodata, data, bss or None for an output section name"""
+    name = name.lstrip(".")
+    for prefix in ("lower.", "upper.", "either."):
+        if name.startswith(prefix):
+            name = name[len(prefix):]
+    if name.startswith("text") or name.startswith("crt") or name.startswith("init") \
+            or name.startswith("fini") or name.startswith("ctors") or name.startswith("dtors"):
+        return "text"
+    if name.startswith("rodata"):
+        return "rodata"
+    if name.startswith("data"):
+        return "data"
+    if name.startswith("bss") or name.startswith("noinit"):
+        return "bss"
+    if name.startswith("__interrupt_vector") or name.startswith("resetvec"):
+        return "rodata"
+    return None
+
+
+def unit_name(filename):
+    """modules/clock.o -> modules/clock, /path/libc.a(lib_a-memcpy.o) -> libc.a"""
+    filename = filename.strip()
+    if "(" in filename:
+        return os.path.basename(filename[:filename.index("(")])
+    # objects built by cmake: CMakeFiles/<target>.dir/modules/clock.c.o
+    filename = re.sub(r"^CMakeFiles/[^/]+\.dir/", "", filename)
+    for ext in (".o", ".c"):
+        if filename.endswith(ext):
+            filename = filename[:-len(ext)]
+    if os.path.isabs(filename):
+        return os.path.basename(filename)
+    return os.path.normpath(filename)
+
+
+def parse_map(lines):
+    """{unit: {kind: bytes}} and the list of linked object files"""
+    units = {}
+    objects = []
+    started = False
+    kind = None
+    pending = None
+    for line in lines:
+        line = line.rstrip("\n")
+        if not started:
+            started = line.startswith("Linker script and memory map")
+            continue
+        if pending is not None:
+            pending = None
+            m = _cont_re.match(line)
+            if m:
+                _account(units, objects, kind, int(m.group(2), 16), m.group(3))
+                continue
+        if not line.strip():
+            continue
+        if not line[0].isspace():
+            m = _output_re.match(line)
+            if m and not line.startswith("LOAD") and not line.startswith("OUTPUT"):
+                kind = section_kind(m.group(1))
+            continue
+        if kind is None or line.startswith(" *"):
+            continue
+        m = _input_re.match(line)
+        if not m:
+            continue
+        if m.group(2) is None:
+            # section name too long, address, size and file on the next line
+            pending = m.group(1)
+            continue
+        _account(units, objects, kind, int(m.group(3), 16), m.group(4))
+    return units, objects
+
+
+def _account(units, objects, kind, size, filename):
+    if filename.strip() not in objects:
+        objects.append(filename.strip())
+    if not size:
+        return
+    unit = units.setdefault(unit_name(filename), dict((k, 0) for k in KINDS))
+    unit[kind] += size
+
+
+def flash_of(sizes):
+    return sizes["text"] + sizes["rodata"] + sizes["data"]
+
+
+def ram_of(sizes):
+    return sizes["data"] + sizes["bss"]
+
+
+def parse_su(lines):
+    """{function: bytes} from a gcc -fstack-usage file"""
+    frames = {}
+    for line in lines:
+        fields = line.rstrip("\n").split("\t")
+        if len(fields) < 2:
+            continue
+        frames[fields[0].split(":")[-1]] = int(fields[1])
+    return frames
+
+
+_func_re = re.compile(r"^([0-9a-f]+) <([^>]+)>:$")
+_section_re = re.compile(r"^Disassembly of section (\S+):$")
+_call_re = re.compile(r"^\s*([0-9a-f]+):.*\tcalla?\s+(\S+)")
+_reloc_re = re.compile(r"^\s*[0-9a-f]+: R_MSP430\S*\s+(\S+)")
+
+
+def parse_objdump(lines):
+    """{function: set of callees}; indirect calls are recorded as None"""
+    calls = {}
+    starts = {}
+    func = None
+    section = None
+    pending = False
+    for line in lines:
+        line = line.rstrip("\n")
+        m = _section_re.match(line)
+        if m:
+            section = m.group(1)
+            continue
+        m = _func_re.match(line)
+        if m:
+            func = m.group(2)
+            starts[(section, int(m.group(1), 16))] = func
+            calls.setdefault(func, set())
+            pending = False
+            continue
+        if func is None:
+            continue
+        m = _reloc_re.match(line)
+        if m and pending:
+            calls[func].add(m.group(1))
+            pending = False
+            continue
+        m = _call_re.match(line)
+        if m:
+            if m.group(2).startswith("#"):
+                pending = True
+            else:
+                calls[func].add(None)
+                pending = False
+
+    # calls to static functions are relocated against their section
+    for func in calls:
+        resolved = set()
+        for target in calls[func]:
+            if target is not None:
+                sym, _, offset = target.partition("+")
+                offset = int(offset, 16) if offset else 0
+                if (sym, offset) in starts:
+                    target = starts[(sym, offset)]
+                elif sym.startswith(".text."):
+                    target = sym[len(".text."):]
+                else:
+                    target = sym
+            resolved.add(target)
+        calls[func] = resolved
+    return calls
+
+
+class StackAnalysis:
+    def __init__(self, frames, calls):
+        self.frames = frames
+        self.calls = calls
+        self.memo = {}
+
+    def depth(self, func, path=()):
+        """(worst depth in bytes, flags) of the calls starting at func"""
+        if func in self.memo:
+            return self.memo[func]
+        if func in path:
+            return 0, set(["recursion"])
+        flags = set()
+        if func not in self.frames:
+            flags.add("unknown")
+        worst = 0
+        for callee in self.calls.get(func, ()):
+            if callee is None:
+                flags.add("indirect")
+                continue
+            d, f = self.depth(callee, path + (func,))
+            worst = max(worst, d + CALL_OVERHEAD)
+            flags |= f
+        res = (self.frames.get(func, 0) + worst, flags)
+        if "recursion" not in flags:
+            self.memo[func] = res
+        return res
+
+
+_isr_re = re.compile(r"interrupt\s*\(\s*\w+\s*\)\s*\)\s*\)?\s*(?:static\s+)?void\s+(\w+)")
+_menu_re = re.compile(r"\bstruct\s+menu\s+\w+\s*=\s*\{(.*?)\n\}\s*;", re.S)
+_fn_re = re.compile(r"_fn\s*=\s*&\s*(\w+)")
+_bus_re = re.compile(r"\bsys_messagebus_register\w*\s*\(\s*&?\s*(\w+)")
+
+
+def find_roots(sources, top="."):
+    """ISR names and {unit: callback names} from the C sources below top"""
+    isrs = []
+    callbacks = {}
+    for name in sources:
+        src = open(name).read()
+        isrs += _isr_re.findall(src)
+        unit = unit_name(os.path.relpath(name, top))
+        cbs = set(_bus_re.findall(src))
+        for body in _menu_re.findall(src):
+            cbs.update(_fn_re.findall(body))
+        if cbs:
+            callbacks[unit] = sorted(cbs)
+    return isrs, callbacks
+
+
+def analyse_stack(objects, sources, top, objdump, builddir="."):
+    frames = {}
+    calls = {}
+    for obj in objects:
+        if "(" in obj or not obj.endswith(".o"):
+            continue
+        obj = os.path.join(builddir, obj)
+        su = obj[:-2] + ".su"
+        if not os.path.isfile(su):
+            continue
+        frames.update(parse_su(open(su)))
+        try:
+            out = subprocess.check_output([objdump, "-dr", obj])
+        except (OSError, subprocess.CalledProcessError):
+            continue
+        calls.update(parse_objdump(out.decode("ascii", "replace").splitlines()))
+    if not frames:
+        return None
+
+    analysis = StackAnalysis(frames, calls)
+    isrs, callbacks = find_roots(sources, top)
+    res = {"main": analysis.depth("main"), "isr": {}, "callbacks": {}}
+    for isr in isrs:
+        d, flags = analysis.depth(isr)
+        res["isr"][isr] = (d + ISR_OVERHEAD, flags)
+    for unit, cbs in callbacks.items():
+        worst = (0, set())
+        for cb in cbs:
+            d, flags = analysis.depth(cb)
+            if d > worst[0]:
+                worst = (d, flags)
+        res["callbacks"][unit] = worst
+    return res
+
+
+def worst_stack(stack):
+    """main, plus the deepest callback it calls through a pointer, plus the deepest ISR"""
+    cb = max([d for d, f in stack["callbacks"].values()] + [0])
+    isr = max([d for d, f in stack["isr"].values()] + [0])
+    return stack["main"][0] + CALL_OVERHEAD + cb + isr
+
+
+def _flags(flags):
+    flags = set(flags) - set(["indirect"])
+    return (" (" + ", ".join(sorted(flags)) + ")") if flags else ""
+
+
+def report(units, stack, previous, flash_budget, ram_budget, out=sys.stdout):
+    """prints the report and returns False when a budget is exceeded"""
+    old = previous.get("units", {}) if previous else {}
+
+    out.write("%-24s %6s %6s %6s %6s %7s %6s %6s\n" %
+              ("unit", "text", "rodata", "data", "bss", "flash", "ram", "stack"))
+    for name in sorted(units, key=lambda n: -flash_of(units[n])):
+        s = units[name]
+        depth = ""
+        if stack and name in stack["callbacks"]:
+            depth = "%d" % stack["callbacks"][name][0]
+        out.write("%-24s %6d %6d %6d %6d %7d %6d %6s\n" %
+                  (name, s["text"], s["rodata"], s["data"], s["bss"], flash_of(s), ram_of(s), depth))
+
+    flash = sum(flash_of(s) for s in units.values())
+    ram = sum(ram_of(s) for s in units.values())
+
+    if stack:
+        out.write("\nworst-case stack depth\n")
+        out.write("  %-22s %6d%s\n" % ("main", stack["main"][0], _flags(stack["main"][1])))
+        for isr in sorted(stack["isr"]):
+            d, flags = stack["isr"][isr]
+            out.write("  %-22s %6d%s\n" % (isr, d, _flags(flags)))
+        out.write("  %-22s %6d  main + deepest callback + deepest ISR\n" % ("total", worst_stack(stack)))
+
+    out.write("\nflash: %5d of %5d bytes (%d%%)\n" % (flash, flash_budget, 100 * flash // flash_budget))
+    out.write("ram:   %5d of %5d bytes (%d%%) static" % (ram, ram_budget, 100 * ram // ram_budget))
+    if stack:
+        out.write(", %d with the worst-case stack" % (ram + worst_stack(stack)))
+    out.write("\n")
+
+    if previous:
+        out.write("\nchanges since the last build:\n")
+        changed = False
+        for name in sorted(set(units) | set(old)):
+            zero = dict((k, 0) for k in KINDS)
+            new_s, old_s = units.get(name, zero), old.get(name, zero)
+            df, dr = flash_of(new_s) - flash_of(old_s), ram_of(new_s) - ram_of(old_s)
+            if df or dr:
+                changed = True
+                tag = " (new)" if name not in old else " (removed)" if name not in units else ""
+                out.write("  %-22s flash %+6d  ram %+5d%s\n" % (name, df, dr, tag))
+        if not changed:
+            out.write("  none\n")
+        out.write("  %-22s flash %+6d  ram %+5d\n" %
+                  ("total", flash - previous.get("flash", 0), ram - previous.get("ram", 0)))
+
+    ok = True
+    if flash > flash_budget:
+        out.write("ERROR: image exceeds the flash budget by %d bytes\n" % (flash - flash_budget))
+        ok = False
+    if ram > ram_budget:
+        out.write("ERROR: static data exceeds the RAM budget by %d bytes\n" % (ram - ram_budget))
+        ok = False
+    elif stack and ram + worst_stack(stack) > ram_budget:
+        out.write("WARNING: the worst-case stack may not fit into the free RAM\n")
+    return ok
+
+
+if __name__ == "__main__":
+    from optparse import OptionParser
+    import glob
+    parser = OptionParser(usage="%prog [options]")
+    parser.add_option("-m", "--map", dest="map", default="output.map",
+                      help="linker map file [default: %default]")
+    parser.add_option("-o", "--output", dest="output", default="openchronos.size",
+                      help="report of the last build, compared and then replaced [default: %default]")
+    parser.add_option("--objdump", dest="objdump", default="msp430-elf-objdump",
+                      help="objdump used for the call graph [default: %default]")
+    parser.add_option("--flash", dest="flash", type="int", default=FLASH_BUDGET,
+                      help="flash budget in bytes [default: %default]")
+    parser.add_option("--ram", dest="ram", type="int", default=RAM_BUDGET,
+                      help="RAM budget in bytes [default: %default]")
+    (options, args) = parser.parse_args()
+
+    units, objects = parse_map(open(options.map))
+    top = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+    sources = [f for d in ("", "drivers", "modules") for f in glob.glob(os.path.join(top, d, "*.c"))]
+    # object paths in the map are relative to where the linker ran
+    stack = analyse_stack(objects, sources, top, options.objdump, os.path.dirname(options.map))
+
+    previous = None
+    if os.path.isfile(options.output):
+        try:
+            previous = json.load(open(options.output))
+        except ValueError:
+            pass
+
+    ok = report(units, stack, previous, options.flash, options.ram)
+
+    f = open(options.output, "w")
+    json.dump({"units": units,
+               "flash": sum(flash_of(s) for s in units.values()),
+               "ram": sum(ram_of(s) for s in units.values())}, f, indent=1, sort_keys=True)
+    f.close()
+
+    if not ok:
+        sys.exit(1)
@@ -0,0 +1,140 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+
+import os
+import shutil
+import tempfile
+import unittest
+import memreport
+
+MAP = """\
+Archive member included to satisfy reference by file (symbol)
+
+Discarded input sections
+
+ .text.unused   0x0000000000000000       0x40 modules/clock.o
+
+Memory Configuration
+
+Name             Origin             Length             Attributes
+RAM              0x0000000000001c00 0x0000000000001000 xw
+
+Linker script and memory map
+
+LOAD modules/clock.o
+.text           0x0000000000008000      0x1a0
+ *(.text .text.*)
+ .text          0x0000000000008000       0x60 openchronos.o
+                0x0000000000008000                main
+ .text.clock_event
+                0x0000000000008060      0x100 modules/clock.o
+ *fill*         0x0000000000008160        0x2 
+ .text          0x0000000000008162       0x3e /opt/msp430/lib/libc.a(lib_a-memcpy.o)
+.rodata         0x00000000000081a0       0x20
+ .rodata.font   0x00000000000081a0       0x20 drivers/display.o
+.data           0x0000000000001c00        0x4 load address 0x00000000000081c0
+ .data          0x0000000000001c00        0x4 modules/clock.o
+.bss            0x0000000000001c04       0x16
+ .bss.menu_head
+                0x0000000000001c04        0x2 menu.o
+ COMMON         0x0000000000001c06       0x14 modules/clock.o
+__interrupt_vector_55
+                0x000000000000ffec        0x2
+ __interrupt_vector_55
+                0x000000000000ffec        0x2 drivers/ports.o
+.debug_info     0x0000000000000000      0x999
+ .debug_info    0x0000000000000000      0x999 modules/clock.o
+"""
+
+OBJDUMP = """\
+modules/clock.o:     file format elf32-msp430
+
+Disassembly of section .text.clock_event:
+
+00000000 <clock_event>:
+   0:	b0 12 00 00 	call	#0		;
+			2: R_MSP430_16	_printf
+   4:	b0 12 00 00 	call	#0		;
+			6: R_MSP430_16	.text.update_screen
+   8:	8f 12       	call	r15		;
+   a:	30 41       	ret
+
+Disassembly of section .text.update_screen:
+
+00000000 <update_screen>:
+   0:	b0 12 00 00 	call	#0		;
+			2: R_MSP430_16	_printf
+   4:	30 41       	ret
+"""
+
+
+class MemReportTests(unittest.TestCase):
+    def test_map_attribution(self):
+        units, objects = memreport.parse_map(MAP.splitlines(True))
+        clock = units["modules/clock"]
+        self.assertEqual(clock, {"text": 0x100, "rodata": 0, "data": 4, "bss": 0x14})
+        self.assertEqual(units["openchronos"]["text"], 0x60)
+        self.assertEqual(units["libc.a"]["text"], 0x3e)
+        self.assertEqual(units["drivers/display"]["rodata"], 0x20)
+        self.assertEqual(units["drivers/ports"]["rodata"], 2)
+        self.assertEqual(units["menu"]["bss"], 2)
+        self.assertTrue("modules/clock.o" in objects)
+        # discarded and debug sections cost nothing
+        self.assertEqual(memreport.flash_of(clock), 0x104)
+        self.assertEqual(memreport.ram_of(clock), 0x18)
+
+    def test_call_graph(self):
+        calls = memreport.parse_objdump(OBJDUMP.splitlines(True))
+        self.assertEqual(calls["clock_event"], set(["_printf", "update_screen", None]))
+        self.assertEqual(calls["update_screen"], set(["_printf"]))
+
+        frames = memreport.parse_su(["modules/clock.c:50:13:clock_event\t10\tstatic\n",
+                                     "modules/clock.c:90:13:update_screen\t6\tstatic\n",
+                                     "drivers/display.c:700:6:_printf\t20\tstatic\n"])
+        analysis = memreport.StackAnalysis(frames, calls)
+        depth, flags = analysis.depth("clock_event")
+        self.assertEqual(depth, 10 + 2 + 6 + 2 + 20)
+        self.assertEqual(flags, set(["indirect"]))
+
+    def test_recursion(self):
+        analysis = memreport.StackAnalysis({"a": 4, "b": 6}, {"a": set(["b"]), "b": set(["a"])})
+        depth, flags = analysis.depth("a")
+        self.assertEqual(depth, 4 + 2 + 6 + 2)
+        self.assertTrue("recursion" in flags)
+
+    def test_roots(self):
+        """Callbacks of every registration call and of the menus are stack roots"""
+        top = tempfile.mkdtemp()
+        try:
+            os.mkdir(os.path.join(top, "modules"))
+            name = os.path.join(top, "modules", "alti.c")
+            f = open(name, "w")
+            f.write("static void alti_activate(void) {\n"
+                    "     sys_messagebus_register(&time_callback, SYS_MSG_RTC_MINUTE);\n"
+                    "     sys_messagebus_register_every(&update_altitude, SYS_MSG_RTC_SECOND,\n"
+                    "                                   CONFIG_MOD_ALTIMETER_REFRESH, 0);\n"
+                    "}\n"
+                    "struct menu mod_alti_menu = {\n"
+                    "     .activate_fn = &alti_activate,\n"
+                    "};\n")
+            f.close()
+            isrs, callbacks = memreport.find_roots([name], top)
+        finally:
+            shutil.rmtree(top)
+        self.assertEqual(isrs, [])
+        self.assertEqual(callbacks, {"modules/alti": ["alti_activate", "time_callback", "update_altitude"]})
+
+    def test_budget(self):
+        units = {"modules/big": {"text": 30000, "rodata": 3000, "data": 10, "bss": 100}}
+
+        class Null:
+            def write(self, s):
+                pass
+
+        self.assertFalse(memreport.report(units, None, None, 32768, 4096, Null()))
+        self.assertTrue(memreport.report(units, None, None, 40000, 4096, Null()))
+        units["modules/big"]["bss"] = 5000
+        self.assertFalse(memreport.report(units, None, None, 40000, 4096, Null()))
+
+if __name__ == '__main__':
+    unittest.main()
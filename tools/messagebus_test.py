@@ -0,0 +1,194 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+
+import unittest
+import hostcc
+
+# Host test program for messagebus.c on top of the emulated RTC, it runs the
+# main loop for the given seconds and prints "node epoch msg" per delivery,
+# then "end epoch wakeups" and "class worst overruns" per priority class.
+# Nodes are "listens:divider:phase[:prio:ticks[:rereg]]", a callback
+# advances TA0R by ticks, and with rereg unregisters and registers again.
+MAIN = """\
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "messagebus.h"
+#include "pool.h"
+#include "drivers/rtca.h"
+
+""" + hostcc.RTC_TICK + """
+
+struct pool messagebus_pool;
+
+void *pool_alloc(struct pool *pool)
+{
+	return malloc(sizeof(struct sys_messagebus));
+}
+
+void pool_free(struct pool *pool, void *blk)
+{
+	/* a node read after its release leads nowhere */
+	memset(blk, 0xa5, sizeof(struct sys_messagebus));
+	free(blk);
+}
+
+static uint16_t cost[6];
+static unsigned node_listens[6], node_divider[6], node_phase[6], rereg[6];
+static void (*const nodes[])(enum sys_message);
+
+static void show(int n, enum sys_message msg)
+{
+	printf("%d %lu %d\\n", n, (unsigned long)rtca_time.epoch, msg);
+	TA0R += cost[n];
+	if (rereg[n]) {
+		sys_messagebus_unregister_all(nodes[n]);
+		sys_messagebus_register_every(nodes[n], node_listens[n], node_divider[n], node_phase[n]);
+	}
+}
+
+static void node0(enum sys_message msg) { show(0, msg); }
+static void node1(enum sys_message msg) { show(1, msg); }
+static void node2(enum sys_message msg) { show(2, msg); }
+static void node3(enum sys_message msg) { show(3, msg); }
+static void node4(enum sys_message msg) { show(4, msg); }
+static void node5(enum sys_message msg) { show(5, msg); }
+static void (*const nodes[])(enum sys_message) = { node0, node1, node2, node3, node4, node5 };
+
+int main(int argc, char **argv)
+{
+	unsigned long i, seconds = strtoul(argv[1], NULL, 10);
+	struct sys_event *ev;
+	int n;
+
+	rtca_init();
+	rtca_time.year = 2026;
+	rtca_time.mon = 3;
+	rtca_time.day = 1;
+	rtca_time.hour = 12;
+	rtca_time.min = 7;
+	rtca_time.sec = 57;
+	rtca_set_time();
+	rtca_set_date();
+
+	for (n = 2; n < argc; n++) {
+		unsigned listens, divider, phase, prio, ticks;
+		if (sscanf(argv[n], "%u:%u:%u:%u:%u:%u", &listens, &divider, &phase, &prio, &ticks,
+			   &rereg[n - 2]) < 5)
+			prio = SYS_PRIO_DISPLAY, ticks = 0;
+		node_listens[n - 2] = listens;
+		node_divider[n - 2] = divider;
+		node_phase[n - 2] = phase;
+		sys_messagebus_register_every(nodes[n - 2], listens, divider, phase);
+		sys_messagebus_set_priority(nodes[n - 2], prio, 0);
+		cost[n - 2] = ticks;
+	}
+
+	for (i = 0; i < seconds; i++) {
+		rtc_tick();
+		while ((ev = evqueue_peek(&rtca_events))) {
+			enum sys_message msg = ev->ev;
+			evqueue_pop(&rtca_events);
+			send_events(msg);
+		}
+		sys_messagebus_background();
+		rtca_set_second_events(sys_messagebus_listens() & SYS_MSG_RTC_SECOND);
+	}
+	printf("end %lu %lu\\n", (unsigned long)rtca_time.epoch, rtc_wakeups);
+	for (n = 0; n < SYS_PRIO_CLASSES; n++)
+		printf("class %u %u\\n", sys_messagebus_stats[n].worst, sys_messagebus_stats[n].overruns);
+
+	return 0;
+}
+"""
+
+SECOND = 2
+MINUTE = 4
+INPUT, DISPLAY, BACKGROUND = range(3)
+START = 1772366877  # 2026-03-01 12:07:57 as rtca_time.epoch
+
+
+class MessagebusTests(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.build = hostcc.HostBuild(MAIN, ["messagebus.c", "drivers/rtca.c"], ["CONFIG_RTC_IRQ"])
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.build.close()
+
+    def run_bus(self, seconds, *nodes):
+        lines = self.build.run(str(seconds), *[":".join(str(v) for v in n) for n in nodes])
+        self.order = []
+        self.classes = [tuple(int(v) for v in l.split()[1:]) for l in lines[-3:]]
+        deliveries = {}
+        for line in lines[:-4]:
+            node, epoch, msg = [int(v) for v in line.split()]
+            deliveries.setdefault(node, []).append((epoch, msg))
+            self.order.append(node)
+        end, epoch, wakeups = lines[-4].split()
+        return deliveries, int(epoch), int(wakeups)
+
+    def test_divider_and_phase(self):
+        """Deliveries happen on the seconds where epoch % divider is phase"""
+        deliveries, epoch, wakeups = self.run_bus(600, (SECOND, 1, 0), (SECOND, 5, 0), (SECOND, 30, 15),
+                                                  (SECOND, 7, 3), (MINUTE, 15, 0))
+        seconds = range(START + 1, START + 601)
+        self.assertEqual([e for e, m in deliveries[0]], list(seconds))
+        self.assertEqual([e for e, m in deliveries[1]], [s for s in seconds if s % 5 == 0])
+        self.assertEqual([e for e, m in deliveries[2]], [s for s in seconds if s % 30 == 15])
+        self.assertEqual(set(m for e, m in deliveries[1]), set([SECOND]))
+        # 7 does not divide a minute, the phase is aligned to the current minute only: 59 - 3 = 7 * 8
+        self.assertEqual([e for e, m in deliveries[3]], list(range(START + 2, START + 601, 7)))
+        self.assertEqual([e for e, m in deliveries[4]], [s for s in seconds if s % (15 * 60) == 0])
+        self.assertEqual(epoch, START + 600)
+        self.assertEqual(wakeups, 600 + 10)
+
+    def test_zero_divider(self):
+        """A divider of 0 delivers every message like a divider of 1"""
+        deliveries, epoch, wakeups = self.run_bus(130, (SECOND, 0, 0), (MINUTE, 0, 0))
+        seconds = range(START + 1, START + 131)
+        self.assertEqual([e for e, m in deliveries[0]], list(seconds))
+        self.assertEqual([e for e, m in deliveries[1]], [s for s in seconds if s % 60 == 0])
+
+    def test_whole_minutes_sleep(self):
+        """Minute multiples are served by minute events, without second wakeups"""
+        deliveries, epoch, wakeups = self.run_bus(3 * 3600 + 3, (SECOND, 60, 0), (SECOND, 120, 0),
+                                                  (MINUTE, 1, 0))
+        seconds = range(START + 1, START + 3 * 3600 + 4)
+        self.assertEqual([e for e, m in deliveries[0]], [s for s in seconds if s % 60 == 0])
+        self.assertEqual([e for e, m in deliveries[1]], [s for s in seconds if s % 120 == 0])
+        self.assertEqual(set(m for e, m in deliveries[0]), set([MINUTE]))
+        self.assertEqual(epoch, START + 3 * 3600 + 3)
+        # the first second, before the loop saw nobody needs them, then every :00
+        self.assertEqual(wakeups, 1 + 3 * 60 + 1)
+
+    def test_priority(self):
+        """Nodes are called by priority class, background ones after the others"""
+        # background, display, input, display, registered in this order
+        deliveries, epoch, wakeups = self.run_bus(3, (SECOND, 1, 0, BACKGROUND, 1000), (SECOND, 1, 0, DISPLAY, 10),
+                                                  (SECOND, 1, 0, INPUT, 40), (SECOND, 1, 0, DISPLAY, 200))
+        self.assertEqual(self.order, [2, 1, 3, 0] * 3)
+        # worst ticks and overruns: 2 ms are 32 ticks, 10 ms 163 and 50 ms 819
+        self.assertEqual(self.classes, [(40, 3), (200, 3), (1000, 3)])
+
+    def test_reregister_in_callback(self):
+        """A callback unregistering and registering itself again is called once per message"""
+        deliveries, epoch, wakeups = self.run_bus(5, (SECOND, 1, 0, DISPLAY, 0, 1), (SECOND, 1, 0, DISPLAY, 0),
+                                                  (SECOND, 1, 0, DISPLAY, 0, 1), (SECOND, 1, 0, BACKGROUND, 0, 1))
+        seconds = list(range(START + 1, START + 6))
+        for node in range(4):
+            self.assertEqual([e for e, m in deliveries[node]], seconds)
+        # each one moves to the end of its class
+        self.assertEqual(self.order[:8], [0, 1, 2, 3, 1, 0, 2, 3])
+
+    def test_no_listeners(self):
+        """Without listeners the time is kept by minute events"""
+        deliveries, epoch, wakeups = self.run_bus(123)
+        self.assertEqual(deliveries, {})
+        self.assertEqual(epoch, START + 123)
+        self.assertEqual(wakeups, 1 + 3)
+
+
+if __name__ == '__main__':
+    unittest.main()
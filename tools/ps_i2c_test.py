@@ -0,0 +1,280 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+
+import unittest
+import hostcc
+
+BMP_085_CHIP_ID = 0x55
+
+# Host test program for drivers/ps.c and drivers/bmp_ps.c against a BMP085
+# on the bit-banged bus. The model samples SCL and SDA in __delay_cycles(),
+# which the driver calls after each edge.
+MAIN = """\
+#include <stdio.h>
+#include <string.h>
+#include "openchronos.h"
+#include "drivers/ps.h"
+#include "drivers/bmp_ps.h"
+
+extern bmp_085_calibration_param_t bmp_cal_param;
+
+/* BMP085 datasheet example, 15.0 degrees C */
+static const uint16_t prom[11] = {408, -72, -14383, 32741, 32757, 23153, 6190, 4, -32768, -8711, 2868};
+#define UT 27898
+static uint16_t up = 23843;
+
+static uint8_t regs[256];
+static uint8_t address = 0x77;
+static int eoc = 1;
+
+enum { IDLE, ADDRESS, REGISTER, WRITE, READ };
+static int state, nbit, sending, master_ack;
+static uint8_t shift, pointer, slave_sda = 1, scl0 = 1, sda0 = 1;
+static unsigned transactions, clocks;
+
+static void received(void)
+{
+	if (state == ADDRESS) {
+		if (shift >> 1 != address) {
+			state = IDLE;
+			return;
+		}
+		state = shift & 1 ? READ : REGISTER;
+	} else if (state == REGISTER) {
+		pointer = shift;
+		state = WRITE;
+	} else if (state == WRITE) {
+		regs[pointer] = shift;
+		/* conversions are done at once, EOC goes high unless the sensor hangs */
+		if (pointer++ == BMP_085_CTRL_MEAS_REG) {
+			uint32_t adc = shift == BMP_085_T_MEASURE ? (uint32_t) UT << 8 : (uint32_t) up << 8;
+			regs[0xf6] = adc >> 16;
+			regs[0xf7] = adc >> 8;
+			regs[0xf8] = adc;
+			if (eoc)
+				P2IN |= PS_INT_PIN;
+		}
+	}
+	slave_sda = 0;
+}
+
+void __delay_cycles(unsigned long cycles)
+{
+	uint8_t scl = !!(PJOUT & PS_SCL_PIN);
+	uint8_t sda = PJDIR & PS_SDA_PIN ? !!(PJOUT & PS_SDA_PIN) : slave_sda;
+
+	PJIN = sda ? PS_SDA_PIN : 0;
+	if (scl && scl0 && sda != sda0) {
+		/* start or stop condition */
+		if (!sda && state == IDLE)
+			transactions++;
+		state = sda ? IDLE : ADDRESS;
+		nbit = sending = 0;
+		slave_sda = 1;
+	} else if (scl && !scl0) {
+		clocks++;
+		if (nbit == 8)
+			master_ack = !sda;
+		else if (!sending)
+			shift = shift << 1 | sda;
+		nbit = (nbit + 1) % 9;
+	} else if (!scl && scl0 && state != IDLE) {
+		slave_sda = 1;
+		if (nbit == 8 && !sending) {
+			received();
+		} else if (nbit == 0 && state == READ) {
+			if (sending && !master_ack) {
+				state = IDLE;
+			} else {
+				sending = 1;
+				shift = regs[pointer++];
+				slave_sda = shift >> 7;
+			}
+		} else if (nbit < 8 && sending) {
+			slave_sda = shift >> (7 - nbit) & 1;
+		}
+	}
+	scl0 = scl;
+	sda0 = sda;
+}
+
+unsigned long waits;
+
+void timer0_delay(uint16_t duration, uint16_t LPM_bits)
+{
+	waits++;
+}
+
+static void show(const char *what)
+{
+	printf("%s %u %u %lu %d", what, transactions, clocks, waits,
+	       !memcmp(&bmp_cal_param, prom, sizeof(prom)));
+	/* a bus left busy or SDA held low breaks the next start */
+	printf(" %d %d\\n", state, !!(PJOUT & PS_SDA_PIN) && !!(PJOUT & PS_SCL_PIN));
+	transactions = clocks = waits = 0;
+}
+
+static void measure(const char *what, uint8_t oss, uint8_t window)
+{
+	bmp_ps_sample_t sample;
+
+	bmp_ps_set_mode(oss, window);
+	P2IN = 0;
+	bmp_ps_measure(&sample);
+	printf("%s %u %u %lu\\n", what, regs[BMP_085_CTRL_MEAS_REG], sample.kelvin, (unsigned long) sample.pa);
+}
+
+int main(int argc, char **argv)
+{
+	bmp_ps_sample_t sample;
+	int i;
+
+	for (i = 0; i < 11; i++) {
+		regs[0xaa + 2 * i] = prom[i] >> 8;
+		regs[0xab + 2 * i] = prom[i];
+	}
+	regs[BMP_085_CHIP_ID_REG] = BMP_085_CHIP_ID;
+
+	if (strcmp(argv[1], "absent") == 0) {
+		address = 0x76;
+		bmp_ps_init();
+		show("absent");
+		address = 0x77;
+	}
+	bmp_ps_init();
+	show("cold");
+	bmp_ps_init();
+	show("warm");
+
+	/* a bit flip in RAM is not taken for a calibration */
+	bmp_cal_param.md ^= 0x100;
+	bmp_ps_init();
+	show("corrupt");
+
+	printf("read %u %u\\n", ps_read_register(BMP_085_I2C_ADDR << 1, BMP_085_CHIP_ID_REG, PS_I2C_8BIT_ACCESS),
+	       ps_read_register(BMP_085_I2C_ADDR << 1, 0xaa, PS_I2C_16BIT_ACCESS));
+	show("registers");
+
+	P2IN = 0;
+	printf("kelvin %u\\n", bmp_ps_get_temp());
+	show("temp");
+	P2IN = 0;
+	printf("pascal %lu\\n", (unsigned long) bmp_ps_get_pa());
+	show("pa");
+
+	/* the same pressure at each oversampling, the sensor adds a bit per step */
+	for (i = 0; i < 4; i++) {
+		char what[] = "oss0";
+
+		what[3] += i;
+		measure(what, i, 1);
+	}
+	show("modes");
+
+	up = 24843;
+	measure("higher", 0, 1);
+	up = 23843;
+	measure("window", 0, 2);
+	up = 24843;
+	P2IN = 0;
+	bmp_ps_measure(&sample);
+	printf("averaged %lu\\n", (unsigned long) sample.pa);
+	show("averaging");
+
+	/* EOC stuck low gives up after the timeout, the window keeps its readings */
+	eoc = 0;
+	P2IN = 0;
+	i = bmp_ps_measure(&sample);
+	printf("hung %d %u\\n", i, bmp_ps_get_temp());
+	show("timeout");
+	eoc = 1;
+	P2IN = 0;
+	bmp_ps_set_mode(0, 2);
+	up = 23843;
+	i = bmp_ps_measure(&sample);
+	printf("recovered %d %lu\\n", i, (unsigned long) sample.pa);
+
+	return 0;
+}
+"""
+
+
+@unittest.skipIf(hostcc.compiler() is None, "no host C compiler")
+class PsI2cTests(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.build = hostcc.HostBuild(MAIN, ["drivers/ps.c", "drivers/bmp_ps.c"])
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.build.close()
+
+    def results(self, *args):
+        """{what: (transactions, SCL clocks, timer0 waits, calibration matches, state, bus idle)}"""
+        res = {}
+        for line in self.build.run(*args):
+            fields = line.split()
+            res[fields[0]] = tuple(int(f) for f in fields[1:])
+        return res
+
+    def test_calibration(self):
+        """The chip id and the whole PROM take two transactions, warm restarts none"""
+        res = self.results("present")
+        # chip id: 3 address bytes and 1 data byte, PROM: 3 and 22, each
+        # with 9 clocks, plus one for the restart and one for the stop
+        self.assertEqual(res["cold"], (2, 4 * 9 + 2 + 25 * 9 + 2, 1, 1, 0, 1))
+        self.assertEqual(res["warm"], (0, 0, 0, 1, 0, 1))
+        self.assertEqual(res["corrupt"], (2, 265, 1, 1, 0, 1))
+
+    def test_registers(self):
+        """The single register reads go through the burst read"""
+        res = self.results("present")
+        self.assertEqual(res["read"], (BMP_085_CHIP_ID, 408))
+        self.assertEqual(res["registers"][:2], (2, 2 * 3 * 9 + 4 + 9 + 2 * 9))
+
+    def test_measure(self):
+        """Conversions are one write and one read, ADC_OUT in a single burst"""
+        res = self.results("present")
+        self.assertEqual(res["kelvin"], (2882,))
+        # the datasheet has 69964, bmp_ps_calc_pa() divides the negative
+        # term where the datasheet shifts
+        self.assertEqual(res["pascal"], (69965,))
+        # the write of CTRL_MEAS with its stop, then the read
+        self.assertEqual(res["temp"][:2], (2, 3 * 9 + 1 + 3 * 9 + 2 * 9 + 2))
+        self.assertEqual(res["pa"][:2], (2, 3 * 9 + 1 + 3 * 9 + 3 * 9 + 2))
+
+    def test_modes(self):
+        """Each oversampling setting waits for its conversion and compensates alike"""
+        res = self.results("present")
+        for oss in range(4):
+            ctrl, kelvin, pa = res["oss%d" % oss]
+            self.assertEqual((ctrl, kelvin), (0x34 | oss << 6, 2882))
+            # B3 is rounded after the shift by OSS
+            self.assertAlmostEqual(pa, 69965, delta=2)
+        # a paired reading is two conversions, each slept through
+        self.assertEqual(res["modes"][0], 4 * 4)
+        self.assertEqual(res["modes"][2], 4 * 2)
+
+    def test_window(self):
+        """The window averages the pressure of the last readings"""
+        res = self.results("present")
+        self.assertEqual(res["window"][2], 69965)
+        self.assertEqual(res["averaged"], ((69965 + res["higher"][2] + 1) // 2,))
+
+    def test_timeout(self):
+        """A sensor that never raises EOC fails the reading after a bounded wait"""
+        res = self.results("present")
+        self.assertEqual(res["hung"], (0, 0))
+        # two temperature conversions, each the conversion time and 5 more sleeps
+        self.assertEqual(res["timeout"][2], 2 * (1 + 5))
+        self.assertEqual(res["recovered"], (1, 69965))
+
+    def test_absent(self):
+        """Without the acknowledge the read stops, and the calibration is read later"""
+        res = self.results("absent")
+        self.assertEqual(res["absent"][:2], (2, 2 * 9 + 2))
+        self.assertEqual(res["absent"][4:], (0, 1))
+        self.assertEqual(res["cold"][0], 2)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,143 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+
+import unittest
+import hostcc
+
+# Host test program for pt.c, TA0R advances by one tick per loop and the
+# main loop runs pt_run() while woken up. Prints "tick task step" as the
+# threads go, then "end wakeups armed running" after stopping the last task.
+MAIN = """\
+#include <stdio.h>
+#include <stdlib.h>
+#include "pt.h"
+
+static uint16_t wakeup;
+static uint8_t armed;
+static unsigned long wakeups;
+
+void timer0_wakeup_at(uint16_t at)
+{
+	wakeup = at;
+	armed = 1;
+}
+
+void timer0_wakeup_cancel(void)
+{
+	armed = 0;
+}
+
+static void show(const char *task, int step)
+{
+	printf("%u %s %d\\n", TA0R, task, step);
+}
+
+static PT_THREAD(child(struct pt *pt))
+{
+	PT_BEGIN(pt);
+	show("child", 0);
+	PT_SLEEP(pt, 10);
+	show("child", 1);
+	PT_END(pt);
+}
+
+static PT_THREAD(sleeper(struct pt *pt))
+{
+	static struct pt sub;
+	static int i;
+
+	PT_BEGIN(pt);
+	for (i = 0; i < 3; i++) {
+		show("sleeper", i);
+		PT_SLEEP(pt, 100);
+	}
+	PT_SPAWN(pt, &sub, child(&sub));
+	show("sleeper", i);
+	PT_END(pt);
+}
+
+static PT_THREAD(yielder(struct pt *pt))
+{
+	static int i;
+
+	PT_BEGIN(pt);
+	for (i = 0; i < 3; i++) {
+		show("yielder", i);
+		PT_YIELD(pt);
+	}
+	PT_END(pt);
+}
+
+static PT_THREAD(forever(struct pt *pt))
+{
+	PT_BEGIN(pt);
+	while (1) {
+		show("forever", 0);
+		PT_SLEEP(pt, 1000);
+	}
+	PT_END(pt);
+}
+
+static PT_TASK_DEFINE(sleeper_task, sleeper);
+static PT_TASK_DEFINE(yielder_task, yielder);
+static PT_TASK_DEFINE(forever_task, forever);
+
+int main(int argc, char **argv)
+{
+	unsigned long ticks = strtoul(argv[1], NULL, 10);
+	int woken = 1;
+
+	TA0R = 60000;
+	pt_start(&sleeper_task);
+	pt_start(&yielder_task);
+	pt_start(&forever_task);
+	pt_start(&forever_task);
+
+	for (; ticks > 0; ticks--) {
+		if (woken) {
+			wakeups++;
+			pt_run();
+		}
+		TA0R++;
+		woken = armed && TA0R == wakeup;
+	}
+	pt_stop(&forever_task);
+	pt_run();
+	printf("end %lu %u %u\\n", wakeups, armed, pt_running(&forever_task));
+
+	return 0;
+}
+"""
+
+
+@unittest.skipIf(hostcc.compiler() is None, "no host C compiler")
+class PtTests(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.build = hostcc.HostBuild(MAIN, ["pt.c"])
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.build.close()
+
+    def test_run(self):
+        """Threads continue after their sleeps, yields and spawned children"""
+        lines = self.build.run("40000")
+        steps = {}
+        for line in lines[:-1]:
+            tick, task, step = line.split()
+            steps.setdefault(task, []).append((int(tick), int(step)))
+        # 100 ms are 1638 ticks, 10 ms 163
+        self.assertEqual(steps["sleeper"], [(60000, 0), (61638, 1), (63276, 2), (65077, 3)])
+        self.assertEqual(steps["child"], [(64914, 0), (65077, 1)])
+        # yields run again on the next tick
+        self.assertEqual(steps["yielder"], [(60000, 0), (60001, 1), (60002, 2)])
+        # started twice runs once, the sleep of 1 s goes across the TA0R wrap
+        self.assertEqual(steps["forever"], [(60000, 0), (10848, 0), (27232, 0)])
+        # one wakeup per step, plus the one where the yielder ends, and
+        # nothing is left armed after the stop
+        self.assertEqual(lines[-1], "end 10 0 0")
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,165 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+
+import datetime
+import os
+import unittest
+import dstrules
+import hostcc
+
+try:
+    import zoneinfo
+except ImportError:
+    zoneinfo = None
+
+# Host test program for drivers/rtc_dst.c, included to reach the transitions
+MAIN = """\
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "drivers/rtca.h"
+#include "drivers/rtc_dst.c"
+
+""" + hostcc.RTC_TICK + """
+
+static void set(unsigned y, unsigned mo, unsigned d, unsigned h)
+{
+	rtca_time.year = y;
+	rtca_time.mon = mo;
+	rtca_time.day = d;
+	rtca_time.hour = h;
+	rtca_time.min = 0;
+	rtca_time.sec = 0;
+	rtca_set_time();
+	rtca_set_date();
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long i;
+	unsigned y;
+
+	rtca_init();
+	rtc_dst_set_zone(atoi(argv[2]));
+
+	if (strcmp(argv[1], "dates") == 0) {
+		/* "year start end" as local epoch seconds */
+		for (y = 2000; y < 2100; y++) {
+			set(y, 1, 1, 0);
+			printf("%u %lu %lu\\n", y, (unsigned long)transitions[0],
+			       (unsigned long)transitions[1]);
+		}
+	} else if (strcmp(argv[1], "run") == 0) {
+		/* "elapsed seconds, local epoch, DST state" every hour */
+		set(atoi(argv[3]), 1, 1, 0);
+		for (i = 1; i <= strtoul(argv[4], NULL, 10); i++) {
+			rtc_tick();
+			if (RTCSEC == 0 && RTCMIN == 0)
+				printf("%lu %lu %u\\n", i, (unsigned long)rtca_time.epoch, rtc_dst_state);
+		}
+	}
+
+	return 0;
+}
+"""
+
+RULES = os.path.join(hostcc.ROOT, "drivers", "rtc_dst.rules")
+# written by tools/dstrules.py -t, regenerate it when the rules or tzdata change
+REFERENCE = os.path.join(hostcc.ROOT, "tools", "rtc_dst_tzdata.txt")
+
+
+class DstRulesTests(unittest.TestCase):
+    def test_rules(self):
+        """The rules file keeps the zone numbers of CONFIG_RTC_DST_ZONE"""
+        zones = dstrules.read_rules(RULES)
+        self.assertEqual([z.name for z in zones][:6], ["US", "MEX", "BRZ", "EU", "AUS", "NZ"])
+        header = dstrules.generate_header(zones)
+        self.assertTrue("#define DST_EU 4\n" in header)
+        self.assertTrue("#define RTC_DST_ZONES %u\n" % len(zones) in header)
+
+    def test_parse(self):
+        zone = dstrules.parse_zone("XX M3.5.0,M10.5.0/3 Europe/Paris 2000-2010")
+        self.assertEqual((zone.start.month, zone.start.week, zone.start.wday, zone.start.hour), (3, 5, 0, 2))
+        self.assertEqual(zone.end.hour, 3)
+        self.assertEqual((zone.tzname, zone.years), ("Europe/Paris", (2000, 2010)))
+        for bad in ("XX M3.5.0", "XXXXX M3.5.0,M10.5.0", "XX M13.1.0,M10.5.0",
+                    "XX M3.6.0,M10.5.0", "XX M3.5.0/23,M10.5.0", "XX M3.5.0,M10.5.0/0"):
+            self.assertRaises(ValueError, dstrules.parse_zone, bad)
+
+
+    @unittest.skipIf(zoneinfo is None, "no zoneinfo module")
+    def test_reference(self):
+        """The committed reference is what tzdata says"""
+        zones = dstrules.read_rules(RULES)
+        self.assertEqual(dstrules.read_reference(REFERENCE), dstrules.tzdata_reference(zones))
+
+
+@unittest.skipIf(hostcc.compiler() is None, "no host C compiler")
+class RtcDstTests(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.zones = dstrules.read_rules(RULES)
+        cls.reference = dstrules.read_reference(REFERENCE)
+        cls.build = hostcc.HostBuild(MAIN, ["drivers/rtca.c"],
+                                     ["CONFIG_RTC_IRQ", "CONFIG_RTC_DST", "CONFIG_RTC_DST_ZONE 0"],
+                                     {"rtc_dst_rules.h": dstrules.generate_header(cls.zones)})
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.build.close()
+
+    def test_tzdata(self):
+        """The precomputed changes of every zone match tzdata, 2000-2099"""
+        expected = dict(((name, year), (start, end)) for name, year, start, end in self.reference)
+        checked = 0
+        for number, zone in enumerate(self.zones, 1):
+            if not zone.tzname:
+                continue
+            for line in self.build.run("dates", str(number)):
+                year, start, end = [int(v) for v in line.split()]
+                if zone.years[0] <= year <= zone.years[1]:
+                    self.assertEqual((start, end), expected[(zone.name, year)], (zone.name, year))
+                    checked += 1
+        self.assertTrue(checked > 500)
+
+    def check_run(self, name, year, hours):
+        number = [z.name for z in self.zones].index(name) + 1
+        # the changes as standard time, the end happens an hour before its DST time
+        changes = []
+        for zone, y, start, end in self.reference:
+            if zone == name:
+                changes += [(start, 1), (end - 3600, 0)]
+                if y == year:
+                    dst = int(start > end)
+        changes.sort()
+        base = dstrules.local_epoch(datetime.datetime(year, 1, 1)) - 3600 * dst
+        lines = self.build.run("run", str(number), str(year), str(hours * 3600))
+        self.assertTrue(len(lines) >= hours - 1)
+        for line in lines:
+            elapsed, epoch, state = [int(v) for v in line.split()]
+            standard = base + elapsed
+            local_dst = dst
+            for when, value in changes:
+                if when > standard:
+                    break
+                local_dst = value
+            self.assertEqual(epoch, standard + 3600 * local_dst, line)
+            self.assertEqual(state, local_dst, line)
+
+    def test_run_north(self):
+        """The watch follows Europe/Berlin hour by hour over two years"""
+        self.check_run("EU", 2026, 2 * 365 * 24)
+
+    def test_run_south(self):
+        """The watch follows Australia/Sydney hour by hour over two years"""
+        self.check_run("AUS", 2026, 2 * 365 * 24)
+
+    def test_none(self):
+        """Without a zone the time is never changed"""
+        lines = self.build.run("run", "0", "2026", str(365 * 86400))
+        self.assertTrue(all(int(l.split()[0]) == int(l.split()[1]) - dstrules.local_epoch(datetime.datetime(2026, 1, 1))
+                            for l in lines))
+
+
+if __name__ == '__main__':
+    unittest.main()
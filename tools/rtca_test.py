@@ -0,0 +1,150 @@
+#!/usr/bin/env python2
+# encoding: utf-8
+
+import calendar
+import datetime
+import unittest
+import hostcc
+
+# Host test program for drivers/rtca.c, the printed lines are
+# "year mon day hour min sec epoch yday dow".
+MAIN = """\
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "drivers/rtca.h"
+
+""" + hostcc.RTC_TICK + """
+
+static void drain(void)
+{
+	struct sys_event *ev;
+
+	while ((ev = evqueue_peek(&rtca_events))) {
+		printf("ev %u\\n", ev->ev);
+		evqueue_pop(&rtca_events);
+	}
+}
+
+static void show(void)
+{
+	printf("%u %u %u %u %u %u %lu %u %u\\n", rtca_time.year, rtca_time.mon,
+	       rtca_time.day, rtca_time.hour, rtca_time.min, rtca_time.sec,
+	       (unsigned long)rtca_time.epoch, rtca_time.yday, rtca_time.dow);
+}
+
+static void set(unsigned y, unsigned mo, unsigned d, unsigned h, unsigned mi, unsigned s)
+{
+	rtca_time.year = y;
+	rtca_time.mon = mo;
+	rtca_time.day = d;
+	rtca_time.hour = h;
+	rtca_time.min = mi;
+	rtca_time.sec = s;
+	rtca_set_time();
+	rtca_set_date();
+}
+
+int main(int argc, char **argv)
+{
+	unsigned y, m, d, i;
+
+	rtca_init();
+
+	if (strcmp(argv[1], "set") == 0) {
+		/* full recompute of every day, at a varying time of day */
+		for (y = 2000, i = 0; y < 2100; y++)
+			for (m = 1; m <= 12; m++)
+				for (d = 1; d <= rtca_get_max_days(m, y); d++, i++) {
+					set(y, m, d, i % 24, i % 60, i * 7 % 60);
+					show();
+				}
+	} else if (strcmp(argv[1], "months") == 0) {
+		/* incremental update over every month and year change */
+		for (y = 2000; y < 2100; y++)
+			for (m = 1; m <= 12; m++) {
+				set(y, m, rtca_get_max_days(m, y), 23, 59, 0);
+				for (i = 0; i < 120; i++) {
+					rtc_tick();
+					if (RTCSEC == 0)
+						show();
+				}
+			}
+	} else if (strcmp(argv[1], "overflow") == 0) {
+		/* an alarm finding the queue full comes with the next event */
+		set(2024, 1, 1, 0, 0, 10);
+		drain();
+		rtca_set_second_events(1);
+		for (i = 0; i < 8; i++)
+			rtc_tick();
+		RTCIV = RTCIV_RTCAIFG;
+		RTC_A_ISR();
+		drain();
+		rtc_tick();
+		drain();
+	} else if (strcmp(argv[1], "run") == 0) {
+		/* incremental update second by second, showing every hour */
+		set(atoi(argv[2]), 1, 1, 0, 0, 0);
+		for (i = atoi(argv[3]); i > 0; i--) {
+			rtc_tick();
+			if (RTCSEC == 0 && RTCMIN == 0)
+				show();
+		}
+	}
+
+	return 0;
+}
+"""
+
+
+def check_line(test, line):
+    year, mon, day, hour, minute, sec, epoch, yday, dow = [int(v) for v in line.split()]
+    date = datetime.date(year, mon, day)
+    test.assertEqual(epoch, calendar.timegm((year, mon, day, hour, minute, sec)), line)
+    test.assertEqual(yday, date.timetuple().tm_yday - 1, line)
+    test.assertEqual(dow, (date.weekday() + 1) % 7, line)
+
+
+@unittest.skipIf(hostcc.compiler() is None, "no host C compiler")
+class RtcaTests(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.build = hostcc.HostBuild(MAIN, ["drivers/rtca.c"], ["CONFIG_RTC_IRQ"])
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.build.close()
+
+    def test_set_date(self):
+        """The epoch recomputed when setting the date matches timegm, 2000-2099"""
+        lines = self.build.run("set")
+        self.assertEqual(len(lines), (datetime.date(2100, 1, 1) - datetime.date(2000, 1, 1)).days)
+        for line in lines:
+            check_line(self, line)
+
+    def test_month_changes(self):
+        """The ISR keeps epoch, day of year and day of week across month and year changes"""
+        lines = self.build.run("months")
+        self.assertEqual(len(lines), 100 * 12 * 2)
+        for line in lines:
+            check_line(self, line)
+
+    def test_full_queue(self):
+        """Events finding the queue full are merged into the next one, the alarm isn't lost"""
+        lines = self.build.run("overflow")
+        alarm, second = 1, 2
+        # the alarms posted by setting the time and the date, seven seconds
+        # fill the queue, the eighth second and the alarm ride along with the ninth
+        self.assertEqual(lines, ["ev %d" % alarm] * 2 + ["ev %d" % second] * 7 + ["ev %d" % (alarm | second)])
+
+    def test_leap_year(self):
+        """The ISR keeps the epoch second by second over a leap year"""
+        lines = self.build.run("run", "2024", str(366 * 86400))
+        self.assertEqual(len(lines), 366 * 24)
+        for line in lines:
+            check_line(self, line)
+        self.assertEqual(lines[-1].split()[:3], ["2025", "1", "1"])
+
+
+if __name__ == '__main__':
+    unittest.main()